@@ -0,0 +1,638 @@
+//===- BitwidthNarrowing.cpp - Narrow integers proven small by RA --------===//
+//
+// This pass rewrites integer computations to the narrowest legal width that
+// the interprocedural range analysis proves can hold their values.
+//
+// Additions, subtractions, multiplications, bitwise operations and left
+// shifts produce the same low bits whatever the high bits of their operands
+// are. So, if the range of such an instruction fits in N bits, it can be
+// computed on the low N bits of its operands and sign extended back. Phis
+// and local variables whose stored values fit in N bits are narrowed in the
+// same way.
+//
+// Instructions connected by def-use edges form a chain that is narrowed as
+// a whole, to the widest width needed by any of its members. Truncations are
+// inserted where a chain reads a value from outside, and one sign extension
+// per member where its value leaves the chain. Comparisons between members,
+// truncations and sign extensions of members read the narrow values
+// directly. A chain is only narrowed if, according to the target cost
+// model, the narrow code plus these conversions is not more expensive than
+// the original code.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "bitwidth-narrowing"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+
+using namespace llvm;
+
+static cl::opt<bool, false>
+IgnoreCost("bwn-ignore-cost", cl::desc("Narrow every chain proven safe, even the ones the cost model rejects."), cl::NotHidden);
+
+STATISTIC(NumNarrowed, "Number of instructions narrowed");
+STATISTIC(NumAllocasNarrowed, "Number of local variables narrowed");
+STATISTIC(NumBitsSaved, "Number of bits saved by narrowing");
+STATISTIC(NumChains, "Number of chains narrowed");
+STATISTIC(NumChainsRejected, "Number of chains kept wide by the cost model");
+STATISTIC(NumTruncs, "Number of truncations inserted");
+STATISTIC(NumExts, "Number of sign extensions inserted");
+STATISTIC(NumAbsorbed, "Number of comparisons and casts that read narrow values");
+
+namespace {
+	/// Chain - Instructions that are narrowed together. All of them have the
+	/// same integer type, because they are linked by def-use edges of
+	/// instructions whose operands and result have a single type.
+	struct Chain {
+		unsigned Width;       // Width of the members in the original code
+		unsigned NarrowWidth; // Width the members are computed in
+		SmallVector<Instruction*, 8> Members;
+		SmallPtrSet<Instruction*, 16> MemberSet;
+		SmallVector<StoreInst*, 4> Stores;     // Stores into member allocas
+		SmallVector<Instruction*, 4> Absorbed; // Users that read narrow values
+
+		bool contains(Value *V) const {
+			Instruction *I = dyn_cast<Instruction>(V);
+			return I && MemberSet.count(I);
+		}
+	};
+
+	class BitwidthNarrowing : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		const TargetTransformInfo *TTI;
+		const DataLayout *DL;
+		bool HasNativeIntegers;
+		APInt Min, Max;
+
+		// Legal width each candidate would need on its own
+		DenseMap<Instruction*, unsigned> Needed;
+		// Narrow version of each member of the chain being rewritten
+		DenseMap<Value*, Value*> NarrowOf;
+
+	public:
+		static char ID;
+		BitwidthNarrowing() : ModulePass(ID), RA(NULL), TTI(NULL), DL(NULL),
+				HasNativeIntegers(false) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool runOnFunction(Function &F);
+
+		bool isLegalWidth(unsigned Width) const;
+		unsigned getLegalWidth(unsigned Bits, unsigned Width) const;
+		unsigned getNeededWidth(Value *V) const;
+		unsigned getCandidateWidth(Instruction *I) const;
+		bool isNarrowableAlloca(AllocaInst *AI) const;
+
+		bool isAbsorbed(Instruction *U, const Chain &C) const;
+		bool isProfitable(Chain &C);
+		void rewrite(Chain &C);
+		Value *buildNarrow(Instruction *I, const Chain &C);
+		Value *castToNarrow(Value *V, Instruction *InsertBefore, const Chain &C);
+	};
+}
+
+char BitwidthNarrowing::ID = 0;
+static RegisterPass<BitwidthNarrowing> X("bitwidth-narrowing",
+"Narrow integer computations using range analysis", false, false);
+
+void BitwidthNarrowing::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+	AU.addRequired<TargetTransformInfo>();
+}
+
+bool BitwidthNarrowing::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+	TTI = &getAnalysis<TargetTransformInfo>();
+
+	DataLayoutPass *DLP = getAnalysisIfAvailable<DataLayoutPass>();
+	DL = DLP ? &DLP->getDataLayout() : NULL;
+
+	// Without native integer widths in the data layout, assume the usual ones
+	HasNativeIntegers = false;
+	if (DL)
+		for (unsigned w = 8; w <= 64 && !HasNativeIntegers; w *= 2)
+			HasNativeIntegers = DL->isLegalInteger(w);
+
+	Min = RA->getMin();
+	Max = RA->getMax();
+
+	bool Changed = false;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		// There is nothing to narrow in declarations
+		if (Fit->isDeclaration())
+			continue;
+
+		Changed |= runOnFunction(*Fit);
+	}
+
+	return Changed;
+}
+
+bool BitwidthNarrowing::isLegalWidth(unsigned Width) const {
+	if (HasNativeIntegers)
+		return DL->isLegalInteger(Width);
+
+	return Width >= 8 && isPowerOf2_32(Width);
+}
+
+// Narrowest legal width that holds Bits bits and is smaller than Width, or 0
+unsigned BitwidthNarrowing::getLegalWidth(unsigned Bits, unsigned Width) const {
+	for (unsigned w = Bits; w < Width; ++w)
+		if (isLegalWidth(w))
+			return w;
+
+	return 0;
+}
+
+// Legal width that holds every value of V, or 0 if V must stay as it is
+unsigned BitwidthNarrowing::getNeededWidth(Value *V) const {
+	IntegerType *Ty = dyn_cast<IntegerType>(V->getType());
+	if (!Ty)
+		return 0;
+
+	if (ConstantInt *C = dyn_cast<ConstantInt>(V))
+		return getLegalWidth(C->getValue().getMinSignedBits(), Ty->getBitWidth());
+
+	Range R = RA->getRange(V);
+	if (!R.isRegular() || R.getLower().eq(Min) || R.getUpper().eq(Max))
+		return 0;
+
+	// Members are sign extended back, so we count the sign bit
+	unsigned Bits = std::max(R.getLower().getMinSignedBits(),
+			R.getUpper().getMinSignedBits());
+
+	return getLegalWidth(Bits, Ty->getBitWidth());
+}
+
+// Only loads and stores of the variable itself, so its address never escapes
+bool BitwidthNarrowing::isNarrowableAlloca(AllocaInst *AI) const {
+	if (AI->isArrayAllocation() || !AI->getAllocatedType()->isIntegerTy())
+		return false;
+
+	for (Value::use_iterator UI = AI->use_begin(), E = AI->use_end(); UI != E; ++UI) {
+		if (LoadInst *LI = dyn_cast<LoadInst>(*UI)) {
+			if (LI->isVolatile())
+				return false;
+		} else if (StoreInst *SI = dyn_cast<StoreInst>(*UI)) {
+			if (SI->isVolatile() || SI->getValueOperand() == AI)
+				return false;
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Width I needs to be narrowed on its own, or 0 if it is not a candidate
+unsigned BitwidthNarrowing::getCandidateWidth(Instruction *I) const {
+	if (!I->getType()->isIntegerTy() && !isa<AllocaInst>(I))
+		return 0;
+
+	switch (I->getOpcode()) {
+	case Instruction::Add:
+	case Instruction::Sub:
+	case Instruction::Mul:
+	case Instruction::And:
+	case Instruction::Or:
+	case Instruction::Xor:
+		return getNeededWidth(I);
+	case Instruction::PHI: {
+		// The truncation of an incoming value goes before the terminator of
+		// its block, so it cannot read the result of that terminator (invoke)
+		PHINode *PN = cast<PHINode>(I);
+		for (unsigned i = 0, e = PN->getNumIncomingValues(); i < e; ++i)
+			if (PN->getIncomingValue(i) == PN->getIncomingBlock(i)->getTerminator())
+				return 0;
+
+		return getNeededWidth(I);
+	}
+	case Instruction::Shl: {
+		// A narrow shift by its width or more would be undefined
+		unsigned Width = getNeededWidth(I);
+		if (!Width)
+			return 0;
+
+		if (ConstantInt *C = dyn_cast<ConstantInt>(I->getOperand(1)))
+			return C->getValue().ult(Width) ? Width : 0;
+
+		Range Amount = RA->getRange(I->getOperand(1));
+		if (!Amount.isRegular() || Amount.getLower().isNegative()
+				|| Amount.getUpper().sge(APInt(Amount.getUpper().getBitWidth(), Width)))
+			return 0;
+
+		return Width;
+	}
+	case Instruction::Alloca: {
+		AllocaInst *AI = cast<AllocaInst>(I);
+		if (!isNarrowableAlloca(AI))
+			return 0;
+
+		// The variable needs the width of the widest value stored into it
+		unsigned Width = getLegalWidth(1, AI->getAllocatedType()->getIntegerBitWidth());
+		for (Value::use_iterator UI = AI->use_begin(), E = AI->use_end(); UI != E; ++UI) {
+			if (StoreInst *SI = dyn_cast<StoreInst>(*UI)) {
+				unsigned Stored = getNeededWidth(SI->getValueOperand());
+				if (!Stored)
+					return 0;
+
+				Width = std::max(Width, Stored);
+			}
+		}
+
+		return Width;
+	}
+	case Instruction::Load: {
+		AllocaInst *AI = dyn_cast<AllocaInst>(I->getOperand(0));
+		if (!AI || !Needed.count(AI))
+			return 0;
+
+		return Needed.lookup(AI);
+	}
+	default:
+		return 0;
+	}
+}
+
+// Users outside the chain that can read the narrow values of its members
+bool BitwidthNarrowing::isAbsorbed(Instruction *U, const Chain &C) const {
+	if (ICmpInst *Cmp = dyn_cast<ICmpInst>(U)) {
+		for (unsigned i = 0; i < 2; ++i) {
+			Value *Op = Cmp->getOperand(i);
+			if (C.contains(Op))
+				continue;
+
+			ConstantInt *CI = dyn_cast<ConstantInt>(Op);
+			if (!CI || CI->getValue().getMinSignedBits() > C.NarrowWidth)
+				return false;
+		}
+		return true;
+	}
+
+	if (TruncInst *TI = dyn_cast<TruncInst>(U))
+		return TI->getType()->getIntegerBitWidth() <= C.NarrowWidth;
+
+	return isa<SExtInst>(U);
+}
+
+// Compares the cost of the chain, with the conversions it needs, before and
+// after narrowing. Also collects the stores and absorbed users of the chain.
+bool BitwidthNarrowing::isProfitable(Chain &C) {
+	LLVMContext &Ctx = C.Members.front()->getContext();
+	Type *WideTy = IntegerType::get(Ctx, C.Width);
+	Type *NarrowTy = IntegerType::get(Ctx, C.NarrowWidth);
+
+	unsigned WideCost = 0, NarrowCost = 0;
+	SmallPtrSet<Instruction*, 8> Absorbed;
+
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i) {
+		Instruction *I = C.Members[i];
+
+		if (BinaryOperator *BO = dyn_cast<BinaryOperator>(I)) {
+			WideCost += TTI->getArithmeticInstrCost(BO->getOpcode(), WideTy);
+			NarrowCost += TTI->getArithmeticInstrCost(BO->getOpcode(), NarrowTy);
+		} else if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+			WideCost += TTI->getMemoryOpCost(Instruction::Load, WideTy,
+					LI->getAlignment(), LI->getPointerAddressSpace());
+			NarrowCost += TTI->getMemoryOpCost(Instruction::Load, NarrowTy,
+					0, LI->getPointerAddressSpace());
+		}
+
+		// Values that come from outside the chain must be truncated
+		if (isa<BinaryOperator>(I) || isa<PHINode>(I))
+			for (unsigned j = 0, ej = I->getNumOperands(); j < ej; ++j) {
+				Value *Op = I->getOperand(j);
+				if (!C.contains(Op) && !isa<ConstantInt>(Op) && !isa<UndefValue>(Op))
+					NarrowCost += TTI->getCastInstrCost(Instruction::Trunc, NarrowTy, WideTy);
+			}
+
+		bool NeedsExt = false;
+		for (Value::use_iterator UI = I->use_begin(), E = I->use_end(); UI != E; ++UI) {
+			Instruction *U = cast<Instruction>(*UI);
+
+			if (C.contains(U))
+				continue;
+
+			if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+				if (isa<AllocaInst>(I)) {
+					C.Stores.push_back(SI);
+					continue;
+				}
+				if (C.contains(SI->getPointerOperand()))
+					continue;
+			}
+
+			if (isAbsorbed(U, C)) {
+				if (Absorbed.insert(U))
+					C.Absorbed.push_back(U);
+				continue;
+			}
+
+			NeedsExt = true;
+		}
+
+		if (NeedsExt)
+			NarrowCost += TTI->getCastInstrCost(Instruction::SExt, WideTy, NarrowTy);
+	}
+
+	for (unsigned i = 0, e = C.Stores.size(); i < e; ++i) {
+		StoreInst *SI = C.Stores[i];
+		WideCost += TTI->getMemoryOpCost(Instruction::Store, WideTy,
+				SI->getAlignment(), SI->getPointerAddressSpace());
+		NarrowCost += TTI->getMemoryOpCost(Instruction::Store, NarrowTy,
+				0, SI->getPointerAddressSpace());
+
+		Value *V = SI->getValueOperand();
+		if (!C.contains(V) && !isa<ConstantInt>(V) && !isa<UndefValue>(V))
+			NarrowCost += TTI->getCastInstrCost(Instruction::Trunc, NarrowTy, WideTy);
+	}
+
+	for (unsigned i = 0, e = C.Absorbed.size(); i < e; ++i) {
+		Instruction *U = C.Absorbed[i];
+		Type *DestTy = U->getType();
+
+		if (isa<ICmpInst>(U)) {
+			WideCost += TTI->getCmpSelInstrCost(Instruction::ICmp, WideTy);
+			NarrowCost += TTI->getCmpSelInstrCost(Instruction::ICmp, NarrowTy);
+		} else if (isa<TruncInst>(U)) {
+			WideCost += TTI->getCastInstrCost(Instruction::Trunc, DestTy, WideTy);
+			if (DestTy != NarrowTy)
+				NarrowCost += TTI->getCastInstrCost(Instruction::Trunc, DestTy, NarrowTy);
+		} else {
+			WideCost += TTI->getCastInstrCost(Instruction::SExt, DestTy, WideTy);
+			NarrowCost += TTI->getCastInstrCost(Instruction::SExt, DestTy, NarrowTy);
+		}
+	}
+
+	DEBUG(dbgs() << "Chain of " << C.Members.size() << " from i" << C.Width
+			<< " to i" << C.NarrowWidth << ": cost " << WideCost << " -> "
+			<< NarrowCost << "\n");
+
+	return NarrowCost <= WideCost;
+}
+
+// Narrow value of V, inserting a truncation before InsertBefore if V comes
+// from outside the chain
+Value *BitwidthNarrowing::castToNarrow(Value *V, Instruction *InsertBefore,
+		const Chain &C) {
+	IntegerType *NarrowTy = IntegerType::get(V->getContext(), C.NarrowWidth);
+
+	if (C.contains(V))
+		return buildNarrow(cast<Instruction>(V), C);
+
+	if (ConstantInt *CI = dyn_cast<ConstantInt>(V))
+		return ConstantInt::get(NarrowTy, CI->getValue().trunc(C.NarrowWidth));
+
+	if (isa<UndefValue>(V))
+		return UndefValue::get(NarrowTy);
+
+	++NumTruncs;
+	return new TruncInst(V, NarrowTy, V->getName() + ".nrw", InsertBefore);
+}
+
+// Narrow version of the member I. Phis and allocas are created before any
+// other member, so operands are always built before their users.
+Value *BitwidthNarrowing::buildNarrow(Instruction *I, const Chain &C) {
+	Value *&NV = NarrowOf[I];
+	if (NV)
+		return NV;
+
+	Value *New = NULL;
+	if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+		New = new LoadInst(NarrowOf.lookup(LI->getPointerOperand()),
+				LI->getName() + ".nrw", LI);
+	} else {
+		BinaryOperator *BO = cast<BinaryOperator>(I);
+		Value *A = castToNarrow(BO->getOperand(0), BO, C);
+		Value *B = castToNarrow(BO->getOperand(1), BO, C);
+
+		// No wrap flags do not hold for the narrow operands
+		New = BinaryOperator::Create(BO->getOpcode(), A, B, BO->getName() + ".nrw", BO);
+	}
+
+	// Building the operands may have grown the map
+	NarrowOf[I] = New;
+	return New;
+}
+
+void BitwidthNarrowing::rewrite(Chain &C) {
+	LLVMContext &Ctx = C.Members.front()->getContext();
+	IntegerType *WideTy = IntegerType::get(Ctx, C.Width);
+	IntegerType *NarrowTy = IntegerType::get(Ctx, C.NarrowWidth);
+
+	NarrowOf.clear();
+
+	// Members whose narrow versions are used before they are complete
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i) {
+		Instruction *I = C.Members[i];
+
+		if (AllocaInst *AI = dyn_cast<AllocaInst>(I)) {
+			NarrowOf[AI] = new AllocaInst(NarrowTy, AI->getName() + ".nrw", AI);
+			++NumAllocasNarrowed;
+		} else if (PHINode *PN = dyn_cast<PHINode>(I)) {
+			NarrowOf[PN] = PHINode::Create(NarrowTy, PN->getNumIncomingValues(),
+					PN->getName() + ".nrw", PN);
+		}
+	}
+
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i) {
+		Instruction *I = C.Members[i];
+
+		if (isa<BinaryOperator>(I) || isa<LoadInst>(I))
+			buildNarrow(I, C);
+
+		if (!isa<AllocaInst>(I))
+			++NumNarrowed;
+
+		NumBitsSaved += C.Width - C.NarrowWidth;
+	}
+
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i) {
+		PHINode *PN = dyn_cast<PHINode>(C.Members[i]);
+		if (!PN)
+			continue;
+
+		// A block may reach the phi through several edges, with the same value
+		PHINode *NPN = cast<PHINode>(NarrowOf[PN]);
+		DenseMap<BasicBlock*, Value*> PerBlock;
+		for (unsigned j = 0, ej = PN->getNumIncomingValues(); j < ej; ++j) {
+			BasicBlock *BB = PN->getIncomingBlock(j);
+			Value *&V = PerBlock[BB];
+			if (!V)
+				V = castToNarrow(PN->getIncomingValue(j), BB->getTerminator(), C);
+
+			NPN->addIncoming(V, BB);
+		}
+	}
+
+	for (unsigned i = 0, e = C.Stores.size(); i < e; ++i) {
+		StoreInst *SI = C.Stores[i];
+		new StoreInst(castToNarrow(SI->getValueOperand(), SI, C),
+				NarrowOf.lookup(SI->getPointerOperand()), SI);
+	}
+
+	// Comparisons and casts that read the narrow values directly
+	for (unsigned i = 0, e = C.Absorbed.size(); i < e; ++i) {
+		Instruction *U = C.Absorbed[i];
+		Value *NV = NarrowOf.lookup(U->getOperand(0));
+		Instruction *New = NULL;
+
+		if (ICmpInst *Cmp = dyn_cast<ICmpInst>(U)) {
+			New = new ICmpInst(Cmp, Cmp->getPredicate(),
+					castToNarrow(Cmp->getOperand(0), Cmp, C),
+					castToNarrow(Cmp->getOperand(1), Cmp, C));
+		} else if (isa<TruncInst>(U)) {
+			if (U->getType() != NarrowTy)
+				New = new TruncInst(NV, U->getType(), "", U);
+		} else {
+			New = new SExtInst(NV, U->getType(), "", U);
+		}
+
+		if (New) {
+			New->takeName(U);
+			U->replaceAllUsesWith(New);
+		} else {
+			U->replaceAllUsesWith(NV);
+		}
+		U->eraseFromParent();
+		++NumAbsorbed;
+	}
+
+	for (unsigned i = 0, e = C.Stores.size(); i < e; ++i)
+		C.Stores[i]->eraseFromParent();
+
+	// Users outside the chain read the sign extension of the narrow value
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i) {
+		Instruction *I = C.Members[i];
+		if (isa<AllocaInst>(I))
+			continue;
+
+		SmallVector<Instruction*, 8> Outside;
+		for (Value::use_iterator UI = I->use_begin(), E = I->use_end(); UI != E; ++UI)
+			if (!C.contains(*UI))
+				Outside.push_back(cast<Instruction>(*UI));
+
+		if (Outside.empty())
+			continue;
+
+		Instruction *InsertPt = I;
+		if (isa<PHINode>(I))
+			InsertPt = I->getParent()->getFirstInsertionPt();
+
+		Instruction *Ext = new SExtInst(NarrowOf.lookup(I), WideTy,
+				I->getName() + ".ext", InsertPt);
+		++NumExts;
+
+		for (unsigned j = 0, ej = Outside.size(); j < ej; ++j)
+			Outside[j]->replaceUsesOfWith(I, Ext);
+	}
+
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i)
+		C.Members[i]->dropAllReferences();
+
+	for (unsigned i = 0, e = C.Members.size(); i < e; ++i)
+		C.Members[i]->eraseFromParent();
+
+	NarrowOf.clear();
+}
+
+bool BitwidthNarrowing::runOnFunction(Function &F) {
+	Needed.clear();
+
+	// Allocas first, because the loads take the width of their variable
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+		if (isa<AllocaInst>(*I))
+			if (unsigned Width = getCandidateWidth(&*I))
+				Needed[&*I] = Width;
+
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+		if (!isa<AllocaInst>(*I))
+			if (unsigned Width = getCandidateWidth(&*I))
+				Needed[&*I] = Width;
+
+	if (Needed.empty())
+		return false;
+
+	// Chains are the connected components of the def-use edges between
+	// candidates, plus the operands of comparisons, which can only read narrow
+	// values if both operands are narrowed to the same width
+	EquivalenceClasses<Instruction*> Chains;
+	for (DenseMap<Instruction*, unsigned>::iterator it = Needed.begin(),
+			end = Needed.end(); it != end; ++it) {
+		Instruction *I = it->first;
+		Chains.insert(I);
+
+		for (Value::use_iterator UI = I->use_begin(), E = I->use_end(); UI != E; ++UI) {
+			Instruction *U = cast<Instruction>(*UI);
+
+			if (Needed.count(U)) {
+				Chains.unionSets(I, U);
+			} else if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+				Instruction *Ptr = dyn_cast<Instruction>(SI->getPointerOperand());
+				if (Ptr && Needed.count(Ptr))
+					Chains.unionSets(I, Ptr);
+			} else if (isa<ICmpInst>(U)) {
+				Instruction *Other = dyn_cast<Instruction>(U->getOperand(U->getOperand(0) == I));
+				if (Other && Needed.count(Other))
+					Chains.unionSets(I, Other);
+			}
+		}
+	}
+
+	SmallVector<Chain*, 8> Narrowed;
+	for (EquivalenceClasses<Instruction*>::iterator it = Chains.begin(),
+			end = Chains.end(); it != end; ++it) {
+		if (!it->isLeader())
+			continue;
+
+		Chain *C = new Chain();
+		C->Width = 0;
+		C->NarrowWidth = 0;
+		for (EquivalenceClasses<Instruction*>::member_iterator MI = Chains.member_begin(it),
+				ME = Chains.member_end(); MI != ME; ++MI) {
+			Instruction *I = *MI;
+			Type *Ty = isa<AllocaInst>(I) ? cast<AllocaInst>(I)->getAllocatedType() : I->getType();
+
+			C->Members.push_back(I);
+			C->MemberSet.insert(I);
+			C->Width = Ty->getIntegerBitWidth();
+			C->NarrowWidth = std::max(C->NarrowWidth, Needed.lookup(I));
+		}
+
+		if (isProfitable(*C) || IgnoreCost) {
+			Narrowed.push_back(C);
+		} else {
+			++NumChainsRejected;
+			delete C;
+		}
+	}
+
+	// Chains are disjoint and only read each other's original values, so they
+	// can be rewritten one after the other
+	for (unsigned i = 0, e = Narrowed.size(); i < e; ++i) {
+		rewrite(*Narrowed[i]);
+		++NumChains;
+		delete Narrowed[i];
+	}
+
+	Needed.clear();
+	return !Narrowed.empty();
+}
@@ -0,0 +1,270 @@
+//===- BoundsCheckElimination.cpp - Remove checks proven by range analysis ===//
+//
+// This pass removes the bounds checks that the range analysis proves always
+// pass. A bounds check is a conditional branch on a comparison between an
+// index and a length, or between an index and zero, where one of the
+// destinations only leads to a trap: a block that calls a function that
+// does not return and ends in unreachable.
+//
+// A check of the form idx < len is proven in two ways:
+//
+// - The ranges of idx and len do not overlap.
+// - Some sigma that copies idx, perhaps before a decrement, has a symbolic
+//   interval whose bound is a copy of len, and the comparison that created
+//   the sigma tells that its value is below the bound. This is the case of
+//   an access inside a loop guarded by idx < len.
+//
+// A check of the form idx >= 0 is proven by the lower bound of idx. Unsigned
+// checks of the form idx <u len check both bounds at once.
+//
+// The analysis must run on e-SSA form, either with sigmas in the IR or with
+// -ra-essa-overlay, since without sigmas there are no symbolic intervals.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "ra-bce"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+
+using namespace llvm;
+
+static cl::opt<bool, false>
+PrintReport("bce-report", cl::desc("Print every bounds check found, and why it was kept."), cl::NotHidden);
+
+STATISTIC(NumChecks, "Number of bounds checks found");
+STATISTIC(NumRemovedByRanges, "Number of checks removed because the ranges do not overlap");
+STATISTIC(NumRemovedBySymbols, "Number of checks removed by symbolic intervals");
+STATISTIC(NumKeptNegative, "Number of checks kept because the index may be negative");
+STATISTIC(NumKeptUpper, "Number of checks kept because the index may reach the length");
+STATISTIC(NumKeptForm, "Number of checks kept because the comparison is not understood");
+STATISTIC(NumTrapsDeleted, "Number of blocks deleted after removing checks");
+
+namespace {
+	enum CheckResult {
+		RemovedByRanges,
+		RemovedBySymbols,
+		KeptNegative,
+		KeptUpper,
+		KeptForm
+	};
+
+	class BoundsCheckElimination : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		ConstraintGraph *CG;
+		APInt Min, Max;
+
+	public:
+		static char ID;
+		BoundsCheckElimination() : ModulePass(ID), RA(NULL), CG(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool runOnFunction(Function &F);
+		CheckResult prove(const BoundsCheck &Check);
+
+		bool isNonNegative(const Value *V);
+		void findSymbolicBounds(const Value *Idx, const Value *Len,
+				bool &SignedLT, bool &UnsignedLT, bool &UnsignedLTBelow) const;
+		void report(const BoundsCheck &Check, CheckResult Result) const;
+	};
+}
+
+char BoundsCheckElimination::ID = 0;
+static RegisterPass<BoundsCheckElimination> X("ra-bce",
+"Bounds check elimination using symbolic range analysis", false, false);
+
+void BoundsCheckElimination::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool BoundsCheckElimination::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+	CG = RA->getConstraintGraph();
+	Min = RA->getMin();
+	Max = RA->getMax();
+
+	bool Changed = false;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		// There is nothing to check in declarations
+		if (Fit->isDeclaration())
+			continue;
+
+		Changed |= runOnFunction(*Fit);
+	}
+
+	return Changed;
+}
+
+bool BoundsCheckElimination::isNonNegative(const Value *V) {
+	Range R = RA->getRange(V);
+	return R.isRegular() && !R.getLower().isNegative();
+}
+
+// Walks back from Idx through sigmas, which copy their source, and through
+// decrements that cannot wrap, looking for sigmas bounded by a copy of Len.
+// UnsignedLTBelow is set for unsigned bounds found after a decrement, which
+// only hold if Idx is not negative.
+void BoundsCheckElimination::findSymbolicBounds(const Value *Idx, const Value *Len,
+		bool &SignedLT, bool &UnsignedLT, bool &UnsignedLTBelow) const {
+	DefMap *Defs = CG->getDefMap();
+	const Value *LenRoot = stripCopies(CG, Len);
+	bool Decremented = false;
+
+	SignedLT = UnsignedLT = UnsignedLTBelow = false;
+
+	const Value *V = Idx;
+	for (unsigned Steps = 0; V && Steps < 64; ++Steps) {
+		DefMap::iterator it = Defs->find(V);
+		BasicOp *Op = it == Defs->end() ? NULL : it->second;
+
+		if (SigmaOp *Sigma = dyn_cast_or_null<SigmaOp>(Op)) {
+			SymbInterval *SI = dyn_cast<SymbInterval>(Sigma->getIntersect());
+
+			if (SI && stripCopies(CG, SI->getBound()) == LenRoot) {
+				CmpInst::Predicate P = getSigmaPredicate(CG, Sigma);
+				if (P == ICmpInst::ICMP_SLT)
+					SignedLT = true;
+				else if (P == ICmpInst::ICMP_ULT && !Decremented)
+					UnsignedLT = true;
+				else if (P == ICmpInst::ICMP_ULT)
+					UnsignedLTBelow = true;
+			}
+
+			V = Sigma->getSource()->getValue();
+			continue;
+		}
+
+		// V = X - C or V = X + (-C), with C >= 0, so V <= X
+		const BinaryOperator *BO = dyn_cast<BinaryOperator>(V);
+		if (!BO || !BO->hasNoSignedWrap())
+			break;
+
+		const ConstantInt *C = dyn_cast<ConstantInt>(CG->getUsedValue(BO->getOperandUse(1)));
+		if (!C)
+			break;
+
+		if ((BO->getOpcode() == Instruction::Add && !C->getValue().isStrictlyPositive())
+				|| (BO->getOpcode() == Instruction::Sub && !C->getValue().isNegative())) {
+			V = CG->getUsedValue(BO->getOperandUse(0));
+			Decremented = true;
+			continue;
+		}
+
+		break;
+	}
+}
+
+CheckResult BoundsCheckElimination::prove(const BoundsCheck &Check) {
+	bool IdxNonNeg = isNonNegative(Check.Idx);
+
+	if (!Check.Len)
+		return IdxNonNeg ? RemovedByRanges : KeptNegative;
+
+	if (Check.Pred != ICmpInst::ICMP_SLT && Check.Pred != ICmpInst::ICMP_ULT)
+		return KeptForm;
+
+	bool Unsigned = Check.Pred == ICmpInst::ICMP_ULT;
+
+	// The ranges do not overlap
+	Range RI = RA->getRange(Check.Idx);
+	Range RL = RA->getRange(Check.Len);
+	if (RI.isRegular() && RL.isRegular() && RI.getUpper().slt(RL.getLower())
+			&& (!Unsigned || IdxNonNeg))
+		return RemovedByRanges;
+
+	bool SignedLT, UnsignedLT, UnsignedLTBelow;
+	findSymbolicBounds(Check.Idx, Check.Len, SignedLT, UnsignedLT, UnsignedLTBelow);
+
+	if (Unsigned) {
+		// 0 <= idx < len implies idx <u len
+		if (UnsignedLT || (IdxNonNeg && (SignedLT || UnsignedLTBelow)))
+			return RemovedBySymbols;
+
+		return (SignedLT || UnsignedLTBelow) ? KeptNegative : KeptUpper;
+	}
+
+	// idx <u len with len >= 0 implies idx < len
+	if (SignedLT || (UnsignedLT && isNonNegative(Check.Len)))
+		return RemovedBySymbols;
+
+	return KeptUpper;
+}
+
+void BoundsCheckElimination::report(const BoundsCheck &Check, CheckResult Result) const {
+	const char *Why = "";
+	switch (Result) {
+	case RemovedByRanges:  Why = "removed, the ranges do not overlap"; break;
+	case RemovedBySymbols: Why = "removed, a symbolic interval bounds the index"; break;
+	case KeptNegative:     Why = "kept, the index may be negative"; break;
+	case KeptUpper:        Why = "kept, the index may reach the length"; break;
+	case KeptForm:         Why = "kept, the comparison is not understood"; break;
+	}
+
+	BasicBlock *BB = Check.Br->getParent();
+	errs() << BB->getParent()->getName() << "\t" << BB->getName();
+
+	unsigned Line = Check.Br->getDebugLoc().getLine();
+	if (Line)
+		errs() << ":" << Line;
+
+	errs() << "\t" << Why << "\n";
+}
+
+bool BoundsCheckElimination::runOnFunction(Function &F) {
+	// Decide every check before changing the code
+	SmallVector<BoundsCheck, 16> Removed;
+	for (Function::iterator BBit = F.begin(), BBend = F.end(); BBit != BBend; ++BBit) {
+		BranchInst *Br = dyn_cast<BranchInst>(BBit->getTerminator());
+		BoundsCheck Check;
+		if (!Br || !matchBoundsCheck(CG, Br, Check))
+			continue;
+
+		++NumChecks;
+		CheckResult Result = prove(Check);
+		switch (Result) {
+		case RemovedByRanges:  ++NumRemovedByRanges; break;
+		case RemovedBySymbols: ++NumRemovedBySymbols; break;
+		case KeptNegative:     ++NumKeptNegative; break;
+		case KeptUpper:        ++NumKeptUpper; break;
+		case KeptForm:         ++NumKeptForm; break;
+		}
+
+		if (PrintReport)
+			report(Check, Result);
+
+		if (Result == RemovedByRanges || Result == RemovedBySymbols)
+			Removed.push_back(Check);
+	}
+
+	if (Removed.empty())
+		return false;
+
+	// A check that always passes keeps the facts the other checks rely on
+	// true, so they can be removed in any order
+	for (unsigned i = 0, e = Removed.size(); i < e; ++i) {
+		BranchInst *Br = Removed[i].Br;
+		Value *Cond = Br->getCondition();
+
+		Removed[i].getTrap()->removePredecessor(Br->getParent());
+		BranchInst::Create(Removed[i].getPass(), Br);
+		Br->eraseFromParent();
+		RecursivelyDeleteTriviallyDeadInstructions(Cond);
+	}
+
+	unsigned Before = F.size();
+	removeUnreachableBlocks(F);
+	NumTrapsDeleted += Before - F.size();
+
+	return true;
+}
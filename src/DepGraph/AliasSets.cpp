@@ -4,9 +4,19 @@
 using namespace llvm;
 
 bool AliasSets::runOnModule(Module &M) {
-	PADriver &PD = getAnalysis<PADriver> ();
+	build(getAnalysis<PADriver> ());
+	return false;
+}
+
+void AliasSets::build(PADriver &PD) {
 	PointerAnalysis* PA = PD.pointerAnalysis;
 
+	// The sets may be built again, in place, by DepGraphCache
+	disjointSet.clear();
+	disjointSets.clear();
+	valueDisjointSet.clear();
+	valueDisjointSets.clear();
+
 
 
 	std::map<int, std::set<int> > allPointsTo = PA->allPointsTo(); // sets of alias represented as ints
@@ -105,8 +115,6 @@ bool AliasSets::runOnModule(Module &M) {
 	}
 
 	//printSets();
-
-	return false;
 }
 
 
@@ -47,6 +47,8 @@ private:
 		;
 
 		void getAnalysisUsage(AnalysisUsage &AU) const;
+		// Builds the sets from the results of the pointer analysis
+		void build(PADriver &PD);
 		llvm::DenseMap<int, std::set<Value*> > getValueSets();
 		llvm::DenseMap<int, std::set<int> > getMemSets();
 		int getValueSetKey(const Value* v);
@@ -0,0 +1,150 @@
+#define DEBUG_TYPE "depgraph-cache"
+#include "DepGraphCache.h"
+
+using namespace llvm;
+
+STATISTIC(NumSetsHits, "Number of alias sets reused");
+STATISTIC(NumSetsMisses, "Number of alias sets built");
+STATISTIC(NumFunctionGraphHits, "Number of function dependence graphs reused");
+STATISTIC(NumFunctionGraphMisses, "Number of function dependence graphs built");
+STATISTIC(NumModuleGraphHits, "Number of module dependence graphs reused");
+STATISTIC(NumModuleGraphMisses, "Number of module dependence graphs built");
+
+char DepGraphCache::ID = 0;
+static RegisterPass<DepGraphCache> X("depgraph-cache",
+                "Alias sets and dependence graphs kept across passes", false, true);
+
+DepGraphCache::DepGraphCache() :
+        ImmutablePass(ID), Sets(NULL), SetsValid(false), ModuleGraph(NULL),
+                        ModuleValid(false) {
+}
+
+DepGraphCache::~DepGraphCache() {
+        for (DenseMap<const Function*, FunctionGraph>::iterator it = Functions.begin(),
+                        e = Functions.end(); it != e; ++it) {
+                delete it->second.Pass->depGraph;
+                delete it->second.Pass;
+        }
+
+        if (ModuleGraph) {
+                delete ModuleGraph->depGraph;
+                delete ModuleGraph;
+        }
+
+        delete Sets;
+}
+
+AliasSets& DepGraphCache::getAliasSets(Module &M) {
+
+        hash_code H = codeFingerprint(M);
+
+        if (SetsValid && SetsModuleFingerprint == H) {
+                ++NumSetsHits;
+                return *Sets;
+        }
+
+        ++NumSetsMisses;
+
+        PADriver* PD = new PADriver();
+        PD->runOnModule(M);
+
+        //The graphs point to the sets, so they are built again in the same object
+        if (!Sets)
+                Sets = new AliasSets();
+        Sets->build(*PD);
+
+        delete PD->pointerAnalysis;
+        delete PD;
+
+        SetsModuleFingerprint = H;
+        SetsValid = true;
+        return *Sets;
+}
+
+//Changes whenever a pointer used by F moves to another alias set
+hash_code DepGraphCache::setsFingerprint(Function &F) {
+
+        hash_code H = hash_value(&F);
+
+        for (Function::arg_iterator A = F.arg_begin(), E = F.arg_end(); A != E; ++A)
+                if (A->getType()->isPointerTy())
+                        H = hash_combine(H, &*A, Sets->getValueSetKey(&*A));
+
+        for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+                if (I->getType()->isPointerTy())
+                        H = hash_combine(H, &*I, Sets->getValueSetKey(&*I));
+
+                for (unsigned i = 0, e = I->getNumOperands(); i < e; ++i) {
+                        Value* Op = I->getOperand(i);
+                        if (Op->getType()->isPointerTy())
+                                H = hash_combine(H, Op, Sets->getValueSetKey(Op));
+                }
+        }
+
+        return H;
+}
+
+DepGraph& DepGraphCache::getFunctionDepGraph(Function &F) {
+
+        AliasSets &AS = getAliasSets(*F.getParent());
+        hash_code H = codeFingerprint(F);
+        hash_code S = setsFingerprint(F);
+
+        FunctionGraph &G = Functions[&F];
+        if (G.Pass && G.Fingerprint == H && G.SetsFingerprint == S) {
+                ++NumFunctionGraphHits;
+                return *G.Pass->depGraph;
+        }
+
+        ++NumFunctionGraphMisses;
+
+        if (G.Pass) {
+                delete G.Pass->depGraph;
+                delete G.Pass;
+        }
+
+        G.Pass = new functionDepGraph();
+        G.Pass->build(F, &AS);
+        G.Fingerprint = H;
+        G.SetsFingerprint = S;
+        return *G.Pass->depGraph;
+}
+
+DepGraph& DepGraphCache::getModuleDepGraph(Module &M) {
+
+        AliasSets &AS = getAliasSets(M);
+        hash_code H = codeFingerprint(M);
+
+        if (ModuleValid && ModuleFingerprint == H) {
+                ++NumModuleGraphHits;
+                return *ModuleGraph->depGraph;
+        }
+
+        ++NumModuleGraphMisses;
+
+        if (ModuleGraph) {
+                delete ModuleGraph->depGraph;
+                delete ModuleGraph;
+        }
+
+        ModuleGraph = new moduleDepGraph();
+        ModuleGraph->build(M, &AS);
+        ModuleFingerprint = H;
+        ModuleValid = true;
+        return *ModuleGraph->depGraph;
+}
+
+void DepGraphCache::forget(const Function &F) {
+
+        DenseMap<const Function*, FunctionGraph>::iterator it = Functions.find(&F);
+        if (it != Functions.end()) {
+                delete it->second.Pass->depGraph;
+                delete it->second.Pass;
+                Functions.erase(it);
+        }
+
+        //The alias sets and the module graph hold values of F. They are built
+        //again by the next call.
+        SetsValid = false;
+        ModuleValid = false;
+}
@@ -0,0 +1,66 @@
+#ifndef __DEPGRAPH_CACHE_H__
+#define __DEPGRAPH_CACHE_H__
+
+#include "DepGraph.h"
+#include "../RangeAnalysis/CodeFingerprint.h"
+
+namespace llvm {
+
+/*
+ * Class DepGraphCache
+ *
+ * Immutable pass that keeps the alias sets and the dependence graphs for the
+ * whole run of the pass manager, so a transform that needs them does not
+ * compute them again after another transform ran. Each result carries a
+ * fingerprint of the code it was built for (see CodeFingerprint.h):
+ *
+ * - the alias sets come from a pointer analysis of the whole module, so they
+ *   are built again, in place, after any function changed;
+ * - the graph of a function, as built by functionDepGraph, is built again
+ *   only if the function changed, or if its pointers moved to other alias
+ *   sets, since the memory nodes of the graph are the alias sets;
+ * - the graph of moduleDepGraph connects the functions through their calls,
+ *   so it is built again after any function changed.
+ *
+ * The graphs are shared by every pass that asks for them: a pass that
+ * changes a graph must work on a clone.
+ */
+class DepGraphCache: public ImmutablePass {
+public:
+        static char ID; // Pass identification, replacement for typeid.
+        DepGraphCache();
+        ~DepGraphCache();
+
+        AliasSets& getAliasSets(Module &M);
+        DepGraph& getFunctionDepGraph(Function &F);
+        DepGraph& getModuleDepGraph(Module &M);
+
+        //Drops the graph of F, and marks the module-wide results out of date.
+        //Must be called before F is deleted, since another function may be
+        //created at its address, with the same fingerprint.
+        void forget(const Function &F);
+
+private:
+        struct FunctionGraph {
+                functionDepGraph* Pass;
+                hash_code Fingerprint;
+                hash_code SetsFingerprint;
+                FunctionGraph() : Pass(NULL) {}
+        };
+
+        hash_code setsFingerprint(Function &F);
+
+        AliasSets* Sets;
+        hash_code SetsModuleFingerprint;
+        bool SetsValid;
+
+        DenseMap<const Function*, FunctionGraph> Functions;
+
+        moduleDepGraph* ModuleGraph;
+        hash_code ModuleFingerprint;
+        bool ModuleValid;
+};
+
+}
+
+#endif
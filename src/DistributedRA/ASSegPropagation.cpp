@@ -17,6 +17,15 @@ STATISTIC(NumHitQueries, "The number of pointer queries that yield a range");
 
 using namespace llvm;
 
+// Whether node is labelled with the target of index t
+static bool reaches(llvm::DenseMap<GraphNode*, BitVector> &labels,
+		GraphNode *node, unsigned t) {
+
+	llvm::DenseMap<GraphNode*, BitVector>::iterator l = labels.find(node);
+	return l != labels.end() && l->second.test(t);
+
+}
+
 bool ASSegPropagation::runOnModule(Module &M) {
 
 	//Here we compute the propagation of the big tables
@@ -53,39 +62,42 @@ bool ASSegPropagation::runOnModule(Module &M) {
 	std::set<GraphNode*> mem1 = dg->getMemNodes1();
 	std::set<GraphNode*> mem2 = dg->getMemNodes2();
 
-	std::set<GraphNode*> mem2send1;
-	std::set<GraphNode*> mem2send2;
-
-	std::set<GraphNode*> visited;
 	std::set<SegmentationTable*> tablesOfSend;
 	SegmentationTable *rat;
 	SegmentationTable *rat2;
 	SegmentationTable *bigtable;
 
-	// Iterates over every memory node |M| and over every send node |S|. Calls dfsVisit O(|M| * |S|) times
-	errs()
-			<< "Iterates over every memory node |M| and over every send node |S| ... ";
-	// Loop for P1
+	// Every reachability decision below comes from backward labellings of the
+	// graph: one traversal from all the targets of a phase labels each node
+	// with the set of targets it reaches, instead of one dfsVisit per pair of
+	// nodes.
+	errs() << "Iterates over the memory nodes that reach each send node ... ";
+
+	std::vector<GraphNode*> sendP1Vec(sendP1.begin(), sendP1.end());
+	std::vector<GraphNode*> sendP2Vec(sendP2.begin(), sendP2.end());
+	llvm::DenseMap<GraphNode*, BitVector> reachSendP1;
+	llvm::DenseMap<GraphNode*, BitVector> reachSendP2;
+	labelReachingNodes(sendP1Vec, reachSendP1);
+	labelReachingNodes(sendP2Vec, reachSendP2);
 
-	for (std::set<GraphNode*>::iterator send1it = sendP1.begin(), send1end =
-			sendP1.end(); send1it != send1end; ++send1it) {
+	// Loop for P1
+	for (unsigned s = 0; s < sendP1Vec.size(); ++s) {
 
 		for (std::set<GraphNode*>::iterator mem1it = mem1.begin(), mem1end =
 				mem1.end(); mem1it != mem1end; ++mem1it) {
 			// Get the reachable memnodes' tables
 
-			if (dg->dfsVisit(*mem1it, *send1it, visited)) {
+			if (!reaches(reachSendP1, *mem1it, s))
+				continue;
 
-				// Get table of mem1it
-				MemNode *m = dyn_cast<MemNode>(*mem1it);
+			// Get table of mem1it
+			MemNode *m = dyn_cast<MemNode>(*mem1it);
 
-				rat = ass.getTable(m->getAliasSetId());
+			rat = ass.getTable(m->getAliasSetId());
 
-				if(rat != NULL){
+			if(rat != NULL){
 
-					tablesOfSend.insert(rat);
-
-				}
+				tablesOfSend.insert(rat);
 
 			}
 
@@ -94,90 +106,76 @@ bool ASSegPropagation::runOnModule(Module &M) {
 		// Merge the tables building the big table of the send
 		if (tablesOfSend.size() > 0) {
 
-			rat = *tablesOfSend.begin();
-
 			if (tablesOfSend.size() > 1) {
 
-				std::set<SegmentationTable*>::iterator t1 =
-						tablesOfSend.begin(), tend = tablesOfSend.end();
-				for (++t1, tend = tablesOfSend.end(); t1 != tend; ++t1) {
-
-					rat2 = *t1;
+				// As before the merges were batched, the table of a send
+				// merges only the first and the last of its tables
+				rat = *tablesOfSend.begin();
+				rat2 = *tablesOfSend.rbegin();
+				bigtable = ass.UnionMerge(rat, rat2);
+				ass.ContentMerge(bigtable, rat, rat2);
 
-					bigtable = ass.UnionMerge(rat, rat2);
-					ass.ContentMerge(bigtable, rat, rat2);
-
-				}
 			} else {
 
-				bigtable = rat;
+				bigtable = *tablesOfSend.begin();
 
 			}
 
 			// Put the big table in the map sendP1Table
-			sendP1Table[*send1it] = bigtable;
+			sendP1Table[sendP1Vec[s]] = bigtable;
 
 		}
 		tablesOfSend.clear();
-		visited.clear();
 
 	}
 
-	visited.clear();
 	tablesOfSend.clear();
 
 	// Loop for P2
-	for (std::set<GraphNode*>::iterator send2it = sendP2.begin(), send2end =
-			sendP2.end(); send2it != send2end; ++send2it) {
+	for (unsigned s = 0; s < sendP2Vec.size(); ++s) {
 
 		for (std::set<GraphNode*>::iterator mem2it = mem2.begin(), mem2end =
 				mem2.end(); mem2it != mem2end; ++mem2it) {
 			// Get the reachable memnodes' tables
 
-			if (dg->dfsVisit(*mem2it, *send2it, visited)) {
+			if (!reaches(reachSendP2, *mem2it, s))
+				continue;
 
-				// Get table of mem1it
-				MemNode *m = dyn_cast<MemNode>(*mem2it);
-				rat = ass.getTable(m->getAliasSetId());
+			// Get table of mem1it
+			MemNode *m = dyn_cast<MemNode>(*mem2it);
+			rat = ass.getTable(m->getAliasSetId());
 
-				// Insert the table in the set
-				tablesOfSend.insert(rat);
-
-			}
+			// Insert the table in the set
+			tablesOfSend.insert(rat);
 
 		}
 
 		// Merge the tables building the big table of the send
 		if (tablesOfSend.size() > 0) {
 
-			rat = *tablesOfSend.begin();
-
 			if (tablesOfSend.size() > 1) {
 
-				std::set<SegmentationTable*>::iterator t2 =
-						tablesOfSend.begin(), tend = tablesOfSend.end();
-				for (++t2, tend = tablesOfSend.end(); t2 != tend; ++t2) {
-					rat2 = *t2;
-
-					bigtable = ass.UnionMerge(rat, rat2);
-					ass.ContentMerge(bigtable, rat, rat2);
+				// As before the merges were batched, the table of a send
+				// merges only the first and the last of its tables
+				rat = *tablesOfSend.begin();
+				rat2 = *tablesOfSend.rbegin();
+				bigtable = ass.UnionMerge(rat, rat2);
+				ass.ContentMerge(bigtable, rat, rat2);
 
-				}
 			} else {
-				bigtable = rat;
+
+				bigtable = *tablesOfSend.begin();
 
 			}
 
 			// Put the big table in the map sendP2Table
-			sendP2Table[*send2it] = bigtable;
+			sendP2Table[sendP2Vec[s]] = bigtable;
 
 		}
 		tablesOfSend.clear();
-		visited.clear();
 
 	}
 
-	visited.clear();
 	errs() << "Done\n";
 
 	std::map<GraphNode*, SegmentationTable*> allSendsToRecvTableMap1;
@@ -186,20 +184,25 @@ bool ASSegPropagation::runOnModule(Module &M) {
 	std::map<GraphNode*, SegmentationTable*> allSendsToRecvTableMap2;
 	std::set<SegmentationTable*> allSendsToRecvTables2;
 
+	// The recvs of P1 are the first targets of the labelling, followed by
+	// those of P2
+	std::vector<GraphNode*> recvVec(recvP1.begin(), recvP1.end());
+	recvVec.insert(recvVec.end(), recvP2.begin(), recvP2.end());
+	llvm::DenseMap<GraphNode*, BitVector> reachRecv;
+	labelReachingNodes(recvVec, reachRecv);
+
 	// Check the Sends that reach directly each Recv
 	errs() << "Check the Sends that reach directly each Recv ... ";
-	// Iterates over every Send node |S| and over every Recv node |R|. Calls dfsVisit O(|S| * |R|) times
 
 	// Loop P1
+	unsigned r = 0;
 	for (std::set<GraphNode*>::iterator recv1it = recvP1.begin(), recv1end =
-			recvP1.end(); recv1it != recv1end; ++recv1it) {
+			recvP1.end(); recv1it != recv1end; ++recv1it, ++r) {
 
 		for (std::set<GraphNode*>::iterator send2it = sendP2.begin(), send2end =
 				sendP2.end(); send2it != send2end; ++send2it) {
 
-			dg->dfsVisit(*send2it, *recv1it, visited);
-
-			if (visited.count(*recv1it) > 0) {
+			if (reaches(reachRecv, *send2it, r)) {
 
 				rat = sendP2Table[*send2it];
 				allSendsToRecvTables1.insert(rat);
@@ -211,26 +214,17 @@ bool ASSegPropagation::runOnModule(Module &M) {
 
 		if (allSendsToRecvTables1.size() > 0) {
 
-			rat = *allSendsToRecvTables1.begin();
-
 			if (allSendsToRecvTables1.size() > 1) {
 
-				std::set<SegmentationTable*>::iterator t1 =
-						allSendsToRecvTables1.begin(), tend1 =
-						allSendsToRecvTables1.end();
-
-				for (++t1; t1 != tend1; ++t1) {
-					rat2 = *t1;
-
-					bigtable = ass.UnionMerge(rat, rat2);
-					ass.ContentMerge(bigtable, rat, rat2);
-					rat = bigtable;
-
-				}
+				std::vector<SegmentationTable*> tables(
+						allSendsToRecvTables1.begin(),
+						allSendsToRecvTables1.end());
+				bigtable = ass.UnionMerge(tables);
+				ass.ContentMerge(bigtable, tables);
 
 			} else {
 
-				bigtable = rat;
+				bigtable = *allSendsToRecvTables1.begin();
 
 			}
 
@@ -244,14 +238,12 @@ bool ASSegPropagation::runOnModule(Module &M) {
 
 	// Loop P2
 	for (std::set<GraphNode*>::iterator recv2it = recvP2.begin(), recv2end =
-			recvP2.end(); recv2it != recv2end; ++recv2it) {
+			recvP2.end(); recv2it != recv2end; ++recv2it, ++r) {
 
 		for (std::set<GraphNode*>::iterator send1it = sendP1.begin(), send1end =
 				sendP1.end(); send1it != send1end; ++send1it) {
 
-			dg->dfsVisit(*send1it, *recv2it, visited);
-
-			if (visited.count(*recv2it) > 0) {
+			if (reaches(reachRecv, *send1it, r)) {
 
 				rat = sendP1Table[*send1it];
 				allSendsToRecvTables2.insert(rat);
@@ -264,27 +256,17 @@ bool ASSegPropagation::runOnModule(Module &M) {
 
 		if (allSendsToRecvTables2.size() > 0) {
 
-			rat = *allSendsToRecvTables2.begin();
-
 			if (allSendsToRecvTables2.size() > 1) {
 
-				std::set<SegmentationTable*>::iterator t2 =
-						allSendsToRecvTables2.begin(), tend2 =
-						allSendsToRecvTables2.end();
-
-				for (++t2; t2 != tend2; ++t2) {
-
-					rat2 = *t2;
-
-					bigtable = ass.UnionMerge(rat, rat2);
-					ass.ContentMerge(bigtable, rat, rat2);
-					rat = bigtable;
-
-				}
+				std::vector<SegmentationTable*> tables(
+						allSendsToRecvTables2.begin(),
+						allSendsToRecvTables2.end());
+				bigtable = ass.UnionMerge(tables);
+				ass.ContentMerge(bigtable, tables);
 
 			} else {
 
-				bigtable = rat;
+				bigtable = *allSendsToRecvTables2.begin();
 
 			}
 
@@ -300,43 +282,34 @@ bool ASSegPropagation::runOnModule(Module &M) {
 	errs() << "Done\n";
 
 	//========================================================================================================================================================
-	// For each recv, propagate the big table to the memnode the recv sets
-	// Possible performance improvement here
+	// For each recv, propagate the big table to the memnodes the recv sets.
+	// These are its direct successors, so they are always reached from it.
 	errs() << "Propagate the Recv tables to MemNodes ... ";
 	for (std::set<GraphNode*>::iterator recv1it = recvP1.begin(), recv1end =
 			recvP1.end(); recv1it != recv1end; ++recv1it) {
 
-		for (std::set<GraphNode*>::iterator mem1it = mem1.begin(), mem1end =
-				mem1.end(); mem1it != mem1end; ++mem1it) {
-
-			if ((*recv1it)->getSuccessors().count(*mem1it)) {
-
-				if (dg->dfsVisit(*recv1it, *mem1it, visited)
-						&& visited.count(*mem1it) > 0) {
-
-					int key = ((MemNode*) (*mem1it))->getAliasSetId();
-
-					SegmentationTable *destMemSegTab = ass.getTable(key);
-					SegmentationTable *recvMemSegTab = allSendsToRecvTableMap1[(*recv1it)];
+		const std::map<GraphNode*, edgeType> &succs = (*recv1it)->getSuccessors();
 
-					if(destMemSegTab != NULL && recvMemSegTab != NULL){
+		for (std::map<GraphNode*, edgeType>::const_iterator succ = succs.begin(),
+				succend = succs.end(); succ != succend; ++succ) {
 
-						SegmentationTable *auxTab = ass.UnionMerge(destMemSegTab, recvMemSegTab);
-						ass.ContentMerge(auxTab, destMemSegTab, recvMemSegTab);
+			if (!mem1.count(succ->first))
+				continue;
 
-						memToTable[key] = auxTab;
-						propagatedP1++;
+			int key = ((MemNode*) (succ->first))->getAliasSetId();
 
-					}
+			SegmentationTable *destMemSegTab = ass.getTable(key);
+			SegmentationTable *recvMemSegTab = allSendsToRecvTableMap1[(*recv1it)];
 
+			if(destMemSegTab != NULL && recvMemSegTab != NULL){
 
+				SegmentationTable *auxTab = ass.UnionMerge(destMemSegTab, recvMemSegTab);
+				ass.ContentMerge(auxTab, destMemSegTab, recvMemSegTab);
 
-				}
-
-
+				memToTable[key] = auxTab;
+				propagatedP1++;
 
 			}
-			visited.clear();
 
 		}
 
@@ -345,35 +318,29 @@ bool ASSegPropagation::runOnModule(Module &M) {
 	for (std::set<GraphNode*>::iterator recv2it = recvP2.begin(), recv2end =
 			recvP2.end(); recv2it != recv2end; ++recv2it) {
 
-		for (std::set<GraphNode*>::iterator mem2it = mem2.begin(), mem2end =
-				mem2.end(); mem2it != mem2end; ++mem2it) {
-
-			if ((*recv2it)->getSuccessors().count(*mem2it)) {
-
-				if (dg->dfsVisit(*recv2it, *mem2it, visited)
-						&& visited.count(*mem2it)) {
+		const std::map<GraphNode*, edgeType> &succs = (*recv2it)->getSuccessors();
 
-					int key = ((MemNode*) (*mem2it))->getAliasSetId();
+		for (std::map<GraphNode*, edgeType>::const_iterator succ = succs.begin(),
+				succend = succs.end(); succ != succend; ++succ) {
 
-					SegmentationTable *destMemSegTab = ass.getTable(key);
-					SegmentationTable *recvMemSegTab = allSendsToRecvTableMap1[(*recv2it)];
+			if (!mem2.count(succ->first))
+				continue;
 
-					if(destMemSegTab != NULL && recvMemSegTab != NULL){
+			int key = ((MemNode*) (succ->first))->getAliasSetId();
 
-						SegmentationTable *auxTab = ass.UnionMerge(destMemSegTab, recvMemSegTab);
-						ass.ContentMerge(auxTab, destMemSegTab, recvMemSegTab);
+			SegmentationTable *destMemSegTab = ass.getTable(key);
+			SegmentationTable *recvMemSegTab = allSendsToRecvTableMap1[(*recv2it)];
 
-						memToTable[key] = auxTab;
-						propagatedP2++;
+			if(destMemSegTab != NULL && recvMemSegTab != NULL){
 
-					}
+				SegmentationTable *auxTab = ass.UnionMerge(destMemSegTab, recvMemSegTab);
+				ass.ContentMerge(auxTab, destMemSegTab, recvMemSegTab);
 
-				}
+				memToTable[key] = auxTab;
+				propagatedP2++;
 
 			}
 
-			visited.clear();
-
 		}
 
 	}
@@ -402,7 +369,7 @@ bool ASSegPropagation::runOnModule(Module &M) {
 
 		NumPropSegments += it->second->row_num;
 
-		for (set<SegmentationTableRow*>::iterator r =
+		for (std::vector<SegmentationTableRow*>::iterator r =
 				(*it).second->rows.begin(), e = (*it).second->rows.end();
 				r != e; ++r) {
 			if (!(*r)->content.getLower().isMinSignedValue()
@@ -416,6 +383,50 @@ bool ASSegPropagation::runOnModule(Module &M) {
 	return false;
 }
 
+// Labels every node that reaches some of the targets with the set of targets
+// it reaches. Bit i of a label stands for targets[i]. Labels only grow, so
+// each node is revisited at most once per target it reaches.
+void ASSegPropagation::labelReachingNodes(std::vector<GraphNode*> &targets,
+		llvm::DenseMap<GraphNode*, BitVector> &labels) {
+
+	unsigned numTargets = targets.size();
+	std::vector<GraphNode*> worklist;
+
+	for (unsigned t = 0; t < numTargets; ++t) {
+		BitVector &label = labels[targets[t]];
+		label.resize(numTargets);
+		label.set(t);
+		worklist.push_back(targets[t]);
+	}
+
+	while (!worklist.empty()) {
+
+		GraphNode *node = worklist.back();
+		worklist.pop_back();
+
+		// Copied, as inserting new labels may move the map's buckets
+		BitVector label = labels[node];
+
+		const std::map<GraphNode*, edgeType> &preds = node->getPredecessors();
+
+		for (std::map<GraphNode*, edgeType>::const_iterator pred = preds.begin(),
+				predend = preds.end(); pred != predend; ++pred) {
+
+			BitVector &predLabel = labels[pred->first];
+			if (predLabel.size() == 0)
+				predLabel.resize(numTargets);
+
+			if (label.test(predLabel)) {
+				predLabel |= label;
+				worklist.push_back(pred->first);
+			}
+
+		}
+
+	}
+
+}
+
 Range ASSegPropagation::getRange(Value* Pointer) {
 
 	Range range;
@@ -424,34 +435,45 @@ Range ASSegPropagation::getRange(Value* Pointer) {
 	AliasSets &as = getAnalysis<AliasSets>();
 	int key = as.getValueSetKey(Pointer);
 
-	llvm::DenseMap<int, std::set<llvm::Value*> > sets = as.getValueSets();
-	std::set<llvm::Value*> set = sets[key];
-
 	if (!memToTable.count(key)) {
 		return range;
 	} else {
 		NumHitQueries++;
 	}
 
-	errs() << "===============================================\n";
-	errs() << "Pointer name: " << Pointer->getName() << "\n";
+	// Pointers are matched by name, so the rows of each table are indexed by
+	// pointer name the first time the table is queried
+	std::map<int, StringMap<Range> >::iterator cached = rangesByName.find(key);
 
-	SegmentationTable* seg = memToTable[key];
+	if (cached == rangesByName.end()) {
 
-	for(std::set<SegmentationTableRow*>::iterator it = seg->rows.begin(), itend = seg->rows.end(); it != itend; ++it){
+		SegmentationTable* seg = memToTable[key];
+		StringMap<Range> &ranges = rangesByName[key];
 
-		for(std::set<Value*>::iterator itval = (*it)->pointers.begin(), itvalend = (*it)->pointers.end(); itval != itvalend; ++itval){
+		for(std::vector<SegmentationTableRow*>::iterator it = seg->rows.begin(), itend = seg->rows.end(); it != itend; ++it){
 
-			if((*itval)->getName() == Pointer->getName() ){
-				errs() << "Pointer here. Row Range: "; (*it)->content.print(errs()); errs() << "\n";
-				range = range.unionWith((*it)->content);
-				errs() << "New range: "; range.print(errs()); errs() << "\n";
-			}
+			for(std::set<Value*>::iterator itval = (*it)->pointers.begin(), itvalend = (*it)->pointers.end(); itval != itvalend; ++itval){
 
+				StringMap<Range>::iterator r = ranges.find((*itval)->getName());
+				if (r == ranges.end()) {
+					Range unknown;
+					unknown.setUnknown();
+					r = ranges.insert(std::make_pair((*itval)->getName(), unknown)).first;
+				}
+				r->second = r->second.unionWith((*it)->content);
+
+			}
 		}
+
+		cached = rangesByName.find(key);
 	}
 
-	errs() << "Pointer new range: "; range.print(errs()); errs() << "\n";
+	StringMap<Range>::iterator r = cached->second.find(Pointer->getName());
+	if (r != cached->second.end())
+		range = r->second;
+
+	DEBUG(errs() << "Pointer name: " << Pointer->getName() << " new range: ";
+			range.print(errs()); errs() << "\n");
 
 	return range;
 
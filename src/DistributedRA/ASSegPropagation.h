@@ -16,6 +16,9 @@
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Module.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "AliasSetSegmentation.h"
 
 #include "../NetDepGraph/DepGraph.h"
@@ -51,6 +54,8 @@ public:
 
 private:
 
+	// Content ranges of each propagated table, by pointer name
+	std::map<int, StringMap<Range> > rangesByName;
 
 	bool isSend(GraphNode *node);
 
@@ -58,6 +63,9 @@ private:
 
 	bool isNodeP1(GraphNode *node);
 
+	void labelReachingNodes(std::vector<GraphNode*> &targets,
+			llvm::DenseMap<GraphNode*, BitVector> &labels);
+
 };
 
 } /* namespace llvm */
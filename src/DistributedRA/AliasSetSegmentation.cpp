@@ -49,37 +49,41 @@ bool AliasSetSegmentation::intersection(Range i, Range j)
 * Merge functions
 */
 
-void AliasSetSegmentation::ContentMerge (SegmentationTable* result, SegmentationTable* one, SegmentationTable* two)
+//Unions into each row of result the contents of the rows of table it
+//intersects. Rows of both tables are sorted and disjoint, so the rows of
+//table intersecting a row of result follow the ones intersecting the
+//previous row, and a single sweep over both vectors does it.
+void AliasSetSegmentation::ContentSweep (SegmentationTable* result, SegmentationTable* table)
 {
-	//for each row of result
-	for(std::set<SegmentationTableRow*>::iterator i = result->rows.begin(), e = result->rows.end(); i != e; i++)
+	std::vector<SegmentationTableRow*>::iterator ii = table->rows.begin(), ee = table->rows.end();
+	for(std::vector<SegmentationTableRow*>::iterator i = result->rows.begin(), e = result->rows.end(); i != e; i++)
 	{
 		SegmentationTableRow* result_row = *i;
-		//make its content Unknown
-		result_row->content.setUnknown();
-		//for each row of one
-		for(std::set<SegmentationTableRow*>::iterator ii = one->rows.begin(), ee = one->rows.end(); ii != ee; ii++)
-		{
-			SegmentationTableRow* one_row = *ii;
-			//if rows have intersection
-			if( intersection(result_row->offset, one_row->offset) )
-			{
-				//union with content
-				result_row->content = result_row->content.unionWith(one_row->content);
-			}
-		}		
-		//for each row of two
-		for(std::set<SegmentationTableRow*>::iterator ii = two->rows.begin(), ee = two->rows.end(); ii != ee; ii++)
-		{
-			SegmentationTableRow* two_row = *ii;
-			//if rows have intersection
-			if( intersection(result_row->offset, two_row->offset) )
-			{
-				//union with content
-				result_row->content = result_row->content.unionWith(two_row->content);
-			}
-		}
-	}	
+		//skip the rows that end before this one starts
+		while(ii != ee and (*ii)->offset.getUpper().slt(result_row->offset.getLower()))
+			ii++;
+		//union with content of every row that starts before this one ends
+		for(std::vector<SegmentationTableRow*>::iterator ij = ii; ij != ee and (*ij)->offset.getLower().sle(result_row->offset.getUpper()); ij++)
+			result_row->content = result_row->content.unionWith((*ij)->content);
+	}
+}
+
+void AliasSetSegmentation::ContentMerge (SegmentationTable* result, SegmentationTable* one, SegmentationTable* two)
+{
+	//make contents of result Unknown
+	for(std::vector<SegmentationTableRow*>::iterator i = result->rows.begin(), e = result->rows.end(); i != e; i++)
+		(*i)->content.setUnknown();
+	ContentSweep(result, one);
+	ContentSweep(result, two);
+}
+
+void AliasSetSegmentation::ContentMerge (SegmentationTable* result, std::vector<SegmentationTable*> &tables)
+{
+	//make contents of result Unknown
+	for(std::vector<SegmentationTableRow*>::iterator i = result->rows.begin(), e = result->rows.end(); i != e; i++)
+		(*i)->content.setUnknown();
+	for(std::vector<SegmentationTable*>::iterator t = tables.begin(), te = tables.end(); t != te; t++)
+		ContentSweep(result, *t);
 }
 
 bool AliasSetSegmentation::CommonPointers(SegmentationTable* one, SegmentationTable* two)
@@ -93,75 +97,7 @@ bool AliasSetSegmentation::CommonPointers(SegmentationTable* one, SegmentationTa
 
 void AliasSetSegmentation::BuildTable(SegmentationTable* result)
 {
-	APInt MinusOne = Zero;
-	MinusOne--;
-	APInt One = Zero;
-	One++;
-	APInt lower_range = Min;
-	APInt higher_range = Min;
-	result->row_num = 0;
-	//adding entries to the table
-	while(true)
-	{
-		/////////////////////////////
-		//Calculating new lower range
-		
-		APInt new_lower_range = Min;
-		
-		//if lower_range hasn't been calculated before than we should find
-		//the lowest lower range, if not the next lower range is higher+1
-		if(higher_range != Min)
-		{
-			new_lower_range = higher_range + One;
-		}
-		
-		//////////////////////////////
-		//Calculating new higher range
-		
-		APInt new_higher_range1 = Max;
-		APInt new_higher_range2 = Max;
-		
-		for (std::set<RangedPointer*>::iterator ii = result->ranged_pointers.begin(), 
-		ee = result->ranged_pointers.end(); ii != ee; ++ii)
-    {
-    	if((*ii)->offset.getUpper().slt(new_higher_range1) and (*ii)->offset.getUpper().sgt(higher_range))
-    		new_higher_range1 = (*ii)->offset.getUpper();
-    	
-    	if((*ii)->offset.getLower().slt(new_higher_range2) and (*ii)->offset.getLower().sgt(new_lower_range))
-    		new_higher_range2 = (*ii)->offset.getLower() - One;
-    }
-		
-		//refreshing ranges
-		lower_range = new_lower_range;
-		higher_range = new_higher_range1.slt(new_higher_range2) ? new_higher_range1 : new_higher_range2;
-		
-		////////////////////
-		//Adding row members
-    SegmentationTableRow* table_row = new SegmentationTableRow();
-    table_row->offset.setLower(lower_range);
-    table_row->offset.setUpper(higher_range);
-    
-    bool mrk = false;
-    for (std::set<RangedPointer*>::iterator ii = result->ranged_pointers.begin(), ee = result->ranged_pointers.end(); 
-    ii != ee; ++ii)
-    {
-     	if((*ii)->offset.getLower().sle(higher_range) and (*ii)->offset.getUpper().sge(lower_range))
-     	{
-     		table_row->pointers.insert((*ii)->pointer);		
-     		result->pointer_to_rows[(*ii)->pointer].insert(table_row);
-     		mrk = true;
-     	}
-    }
-			
-		/////////////////////
-		//finishing loop turn
-		result->rows.insert(table_row);
-    if(mrk == true) result->row_num++;
-     
-    //evaluate break point
-    if(higher_range == Max)
-     	break;      
-  }
+	result->BuildRows();
 }
 
 SegmentationTable* AliasSetSegmentation::OneLineTransformation (SegmentationTable* Table)
@@ -191,6 +127,10 @@ SegmentationTable* AliasSetSegmentation::OneLineTransformation (SegmentationTabl
 	return result;
 }
 
+//Both tables partition [-inf, +inf] at the ends of their own pointers, so
+//the rows of the union are the intersections of their rows, and each one
+//holds the pointers of the two rows it comes from. Walking both sorted row
+//vectors at once builds the result in a single linear sweep.
 SegmentationTable* AliasSetSegmentation::UnionMerge (SegmentationTable* one, SegmentationTable* two)
 {
 	SegmentationTable* result = new SegmentationTable();
@@ -199,8 +139,44 @@ SegmentationTable* AliasSetSegmentation::UnionMerge (SegmentationTable* one, Seg
 		result->ranged_pointers.insert(*i);
 	for(std::set<RangedPointer*>::iterator i = two->ranged_pointers.begin(), e = two->ranged_pointers.end(); i != e; i++)
 		result->ranged_pointers.insert(*i);
+	
 	//building result table
-	BuildTable(result);
+	if(one->rows.empty() or two->rows.empty())
+	{
+		BuildTable(result);
+	}
+	else
+	{
+		APInt One = Zero;
+		One++;
+		APInt lower_range = Min;
+		result->row_num = 0;
+		std::vector<SegmentationTableRow*>::iterator i = one->rows.begin(), e = one->rows.end();
+		std::vector<SegmentationTableRow*>::iterator ii = two->rows.begin(), ee = two->rows.end();
+		while(i != e and ii != ee)
+		{
+			APInt one_upper = (*i)->offset.getUpper();
+			APInt two_upper = (*ii)->offset.getUpper();
+			APInt higher_range = one_upper.slt(two_upper) ? one_upper : two_upper;
+			
+			SegmentationTableRow* table_row = new SegmentationTableRow();
+			table_row->offset.setLower(lower_range);
+			table_row->offset.setUpper(higher_range);
+			table_row->pointers = (*i)->pointers;
+			table_row->pointers.insert((*ii)->pointers.begin(), (*ii)->pointers.end());
+			for(std::set<Value*>::iterator pi = table_row->pointers.begin(), pe = table_row->pointers.end(); pi != pe; pi++)
+				result->pointer_to_rows[*pi].insert(table_row);
+			
+			result->rows.push_back(table_row);
+			if(!table_row->pointers.empty()) result->row_num++;
+			
+			if(higher_range == Max)
+				break;
+			if(one_upper == higher_range) i++;
+			if(two_upper == higher_range) ii++;
+			lower_range = higher_range + One;
+		}
+	}
   
 	//passing associations
 	result->base = NULL;
@@ -221,6 +197,45 @@ SegmentationTable* AliasSetSegmentation::UnionMerge (SegmentationTable* one, Seg
   return result;
 }
 
+//Merges many tables at once: their pointers are gathered and the rows are
+//built a single time, instead of once per pairwise merge.
+SegmentationTable* AliasSetSegmentation::UnionMerge (std::vector<SegmentationTable*> &tables)
+{
+	SegmentationTable* first = tables.front();
+	if(tables.size() == 1)
+		return first;
+	
+	SegmentationTable* result = new SegmentationTable();
+	bool same_function = true;
+	bool same_alias_set = true;
+	//go through tables ranged pointers adding them to the result
+	for(std::vector<SegmentationTable*>::iterator t = tables.begin(), te = tables.end(); t != te; t++)
+	{
+		result->ranged_pointers.insert((*t)->ranged_pointers.begin(), (*t)->ranged_pointers.end());
+		if((*t)->function != first->function) same_function = false;
+		if((*t)->AliasSet != first->AliasSet) same_alias_set = false;
+	}
+	//building result table
+	BuildTable(result);
+	
+	//passing associations
+	result->base = NULL;
+	result->aloc_base = first->aloc_base;
+	if(same_function)
+	{
+		result->function = first->function;
+		result->recursive_func = first->recursive_func;
+	}
+	else
+	{
+		result->function = NULL;
+	}
+	if(same_alias_set)
+		result->AliasSet = first->AliasSet;
+	
+	return result;
+}
+
 SegmentationTable* 
 AliasSetSegmentation::OffsetMerge 
 (SegmentationTable* one, SegmentationTable* two, Range Offset)
@@ -637,16 +652,12 @@ bool AliasSetSegmentation::runOnModule(Module &M){
 //																														/**/
 																														
 		//UnionMerge all remaining tables
-		std::set<SegmentationTable*>::iterator ti = tables_to_merge.begin();
-		std::set<SegmentationTable*>::iterator te = tables_to_merge.end();
 		master_tables[i->first] = NULL;
-		if(ti != te)
+		if(!tables_to_merge.empty())
 		{
-			master_tables[i->first] = *ti;
-			ti++;
-			for(; ti != te; ti++)
-				master_tables[i->first] = UnionMerge(master_tables[i->first], *ti);
-			}
+			std::vector<SegmentationTable*> remaining(tables_to_merge.begin(), tables_to_merge.end());
+			master_tables[i->first] = UnionMerge(remaining);
+		}
 					
 	}//end of alias sets
 	
@@ -725,7 +736,7 @@ bool AliasSetSegmentation::runOnModule(Module &M){
 				//add it as a ranged pointer to the master table
 				master_tables[i->first]->ranged_pointers.insert( new RangedPointer((*ii), Min, Max, NULL, NULL) );		
 				//for each row in the master table
-				for(set<SegmentationTableRow*>::iterator iii = master_tables[i->first]->rows.begin(), eee = master_tables[i->first]->rows.end(); iii != eee; iii++)
+				for(std::vector<SegmentationTableRow*>::iterator iii = master_tables[i->first]->rows.begin(), eee = master_tables[i->first]->rows.end(); iii != eee; iii++)
 				{
 					//add it to row
 					(*iii)->pointers.insert((*ii));		
@@ -752,7 +763,7 @@ bool AliasSetSegmentation::runOnModule(Module &M){
 	for(llvm::DenseMap<int, std::set<Value*> >::iterator i = vs.begin(), e = vs.end(); i != e; i++)
 	{
 		//for each row in it's master table
-		for(std::set<SegmentationTableRow*>::iterator ii = master_tables[i->first]->rows.begin(), ee = master_tables[i->first]->rows.end(); ii != ee; ii++)
+		for(std::vector<SegmentationTableRow*>::iterator ii = master_tables[i->first]->rows.begin(), ee = master_tables[i->first]->rows.end(); ii != ee; ii++)
 		{
 			//make content Unknown
 			(*ii)->content.setUnknown();
@@ -819,7 +830,7 @@ bool AliasSetSegmentation::runOnModule(Module &M){
 		int nms = 0;
 		SegmentationTable* table = i->second;
 		nt++;
-		for(std::set<SegmentationTableRow*>::iterator ri = table->rows.begin(), re = table->rows.end(); ri != re; ri++)
+		for(std::vector<SegmentationTableRow*>::iterator ri = table->rows.begin(), re = table->rows.end(); ri != re; ri++)
 		{
 			SegmentationTableRow* r  = *ri;
 			if(!r->pointers.empty())
@@ -867,7 +878,7 @@ static RegisterPass<AliasSetSegmentation> X("as-segmentation",
 	SegmentationTable* r = UnionMerge(t[1], t[0]);		
 		errs() << "TEST\n";
 		errs() << "Table: " << *(r->base) << "\n";
-  	for(set<SegmentationTableRow*>::iterator ii = r->rows.begin(),
+  	for(std::vector<SegmentationTableRow*>::iterator ii = r->rows.begin(),
   	ee = r->rows.end(); ii != ee; ii++)
   	{
   		errs() << "Row: ["; 
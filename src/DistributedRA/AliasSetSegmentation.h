@@ -40,9 +40,11 @@ public:
 	SegmentationTable* getTable(int AliasSetID);
 	
 	SegmentationTable* UnionMerge (SegmentationTable* one, SegmentationTable* two);
+	SegmentationTable* UnionMerge (std::vector<SegmentationTable*> &tables);
 	SegmentationTable* OffsetMerge (SegmentationTable* one, SegmentationTable* two, Range Offset);
 	SegmentationTable* MultiplicationMerge (SegmentationTable* one, SegmentationTable* two);
 	void ContentMerge (SegmentationTable* result, SegmentationTable* one, SegmentationTable* two);
+	void ContentMerge (SegmentationTable* result, std::vector<SegmentationTable*> &tables);
 	
 private:
 	llvm::DenseMap<int, SegmentationTable* > master_tables;
@@ -50,6 +52,7 @@ private:
 	
 	bool CommonPointers(SegmentationTable* one, SegmentationTable* two);
 	void BuildTable(SegmentationTable* result);
+	void ContentSweep(SegmentationTable* result, SegmentationTable* table);
 	SegmentationTable* OneLineTransformation (SegmentationTable* Table);
 	
 	bool intersection(Range i, Range j);
@@ -9,8 +9,12 @@
 
 using namespace llvm;
 
+//Global Variables Declarations
+extern APInt Min;
+extern APInt Max;
+
 cl::opt<std::string> DumpFilename("dump-filename",
-		                          cl::desc("Specify dump filename"),
+		                          cl::desc("Specify dump filename (binary format; stderr prints text)"),
 		                          cl::value_desc("filename"),
 		                          cl::init("stderr"),
 		                          cl::NotHidden);
@@ -24,25 +28,90 @@ std::string llvm::DistributedRangeDump::getOriginalFunctionName(Function* F) {
 	return F->getName();
 }
 
-bool DistributedRangeDump::runOnModule(Module &M){
+//Converts a bound to the 64 bits of the dump, saturating at -inf and +inf
+int64_t DistributedRangeDump::toDumpBound(const APInt &v) {
+
+	if (v == Min || (v.getMinSignedBits() > 64 && v.isNegative()))
+		return INT64_MIN;
+	if (v == Max || v.getMinSignedBits() > 64)
+		return INT64_MAX;
+	return v.getSExtValue();
+}
+
+uint8_t DistributedRangeDump::toDumpFlags(const Range &r) {
+
+	if (r.isUnknown()) return RangeDump::Unknown;
+	if (r.isEmpty()) return RangeDump::Empty;
+	return RangeDump::Regular;
+}
+
+//Sends a record either to the binary writer or, for stderr, to its text form
+void DistributedRangeDump::emitRange(RangeDumpWriter *Writer,
+		const std::string &FunctionName, const std::string &ValueName,
+		const Range &r) {
+
+	if (Writer) {
+		uint32_t function = Writer->getStringId(FunctionName);
+		uint32_t value = Writer->getStringId(ValueName);
+		Writer->writeRange(function, value, toDumpFlags(r),
+				toDumpBound(r.getLower()), toDumpBound(r.getUpper()));
+		return;
+	}
+
+	RangeDumpRecord R;
+	R.kind = RangeDump::RangeKind;
+	R.function = FunctionName;
+	R.value = ValueName;
+	R.flags = toDumpFlags(r);
+	R.lower = toDumpBound(r.getLower());
+	R.upper = toDumpBound(r.getUpper());
+	errs() << formatRangeDumpRecord(R);
+}
+
+void DistributedRangeDump::emitTable(RangeDumpWriter *Writer, int AliasSetId,
+		SegmentationTable *Table) {
 
-	raw_ostream *outputStream = NULL;
-	raw_fd_ostream* File = NULL;
+	RangeDumpRecord R;
+	R.kind = RangeDump::TableKind;
+	R.aliasSetId = AliasSetId;
 
-	//Define the output stream
-	if(DumpFilename.compare("stderr") == 0) outputStream = &errs();
-	else {
-		std::string ErrorInfo;
+	for (std::vector<SegmentationTableRow*>::iterator r = Table->rows.begin(),
+			rend = Table->rows.end(); r != rend; ++r) {
 
-		File = new raw_fd_ostream(DumpFilename.c_str(), ErrorInfo);
+		RangeDumpRow row;
+		row.flags = toDumpFlags((*r)->content);
+		row.offsetLower = toDumpBound((*r)->offset.getLower());
+		row.offsetUpper = toDumpBound((*r)->offset.getUpper());
+		row.contentLower = toDumpBound((*r)->content.getLower());
+		row.contentUpper = toDumpBound((*r)->content.getUpper());
+		R.rows.push_back(row);
+	}
+
+	if (Writer) {
+		Writer->beginTable(R.aliasSetId, R.rows.size());
+		for (unsigned i = 0; i < R.rows.size(); ++i)
+			Writer->writeRow(R.rows[i]);
+		return;
+	}
+
+	errs() << formatRangeDumpRecord(R);
+}
+
+bool DistributedRangeDump::runOnModule(Module &M){
+
+	RangeDumpWriter *Writer = NULL;
+
+	//Define the output: text to stderr, or the binary format to a file
+	if(DumpFilename.compare("stderr") != 0) {
 
-        if (!ErrorInfo.empty()) {
-                errs() << "Error opening file " << DumpFilename
-                       << " for writing! Error Info: " << ErrorInfo << " \n";
-                return false;
-        }
+		Writer = new RangeDumpWriter();
 
-        outputStream = File;
+		if (!Writer->open(DumpFilename)) {
+			errs() << "Error opening file " << DumpFilename
+			       << " for writing!\n";
+			delete Writer;
+			return false;
+		}
 	}
 
 	ASSegPropagation& ASP = getAnalysis<ASSegPropagation>();
@@ -66,21 +135,23 @@ bool DistributedRangeDump::runOnModule(Module &M){
 				if(LoadInst* LI = dyn_cast<LoadInst>(I)){
 
 					Range r = ASP.getRange(LI->getPointerOperand());
-					//errs() << "Pointer: " << LI->getPointerOperand()->getName() << "\n";
-					/*(*outputStream) << FunctionName  << "|"
-									<< LI->getName() << "|"
-									<< r.getLower()  << "|"
-									<< r.getUpper()  << "\n";
-					*/
+					emitRange(Writer, FunctionName, LI->getName(), r);
 
 				}
 			}
 		}
 	}
 
-	if (File) {
-		File->close();
-		delete File;
+	//Segment information of every propagated alias set
+	for (std::map<int, SegmentationTable*>::iterator it = ASP.memToTable.begin(),
+			itend = ASP.memToTable.end(); it != itend; ++it) {
+		emitTable(Writer, it->first, it->second);
+	}
+
+	if (Writer) {
+		if (!Writer->close())
+			errs() << "Error writing file " << DumpFilename << "!\n";
+		delete Writer;
 	}
 
 	return false;
@@ -19,12 +19,19 @@
 
 #include "../RangeAnalysis/RangeAnalysis.h"
 #include "ASSegPropagation.h"
+#include "RangeDumpFormat.h"
 
 namespace llvm {
 
 class DistributedRangeDump: public llvm::ModulePass {
 private:
 	std::string getOriginalFunctionName(Function* F);
+	int64_t toDumpBound(const APInt &v);
+	uint8_t toDumpFlags(const Range &r);
+	void emitRange(RangeDumpWriter *Writer, const std::string &FunctionName,
+			const std::string &ValueName, const Range &r);
+	void emitTable(RangeDumpWriter *Writer, int AliasSetId,
+			SegmentationTable *Table);
 public:
 	static char ID;
 
@@ -0,0 +1,54 @@
+/*
+ * RangeDumpConverter.cpp
+ *
+ *  Converts the binary dumps written by DistributedRangeDump
+ *  (-dump-filename) into text, one line per value range and one block per
+ *  segmentation table.
+ *
+ *  Usage: dist-range-dump-converter <dump> [<output>]
+ */
+
+#include "../RangeDumpFormat.h"
+
+#include <stdio.h>
+
+using namespace llvm;
+
+int main(int argc, char **argv) {
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <dump> [<output>]\n", argv[0]);
+		return 1;
+	}
+
+	RangeDumpReader Reader;
+	if (!Reader.open(argv[1])) {
+		fprintf(stderr, "Error: %s is not a distributed range dump\n", argv[1]);
+		return 1;
+	}
+
+	FILE *Out = stdout;
+	if (argc == 3) {
+		Out = fopen(argv[2], "w");
+		if (!Out) {
+			fprintf(stderr, "Error opening file %s for writing!\n", argv[2]);
+			return 1;
+		}
+	}
+
+	RangeDumpRecord R;
+	while (Reader.next(R)) {
+		std::string Text = formatRangeDumpRecord(R);
+		fwrite(Text.data(), 1, Text.size(), Out);
+	}
+
+	if (Out != stdout)
+		fclose(Out);
+
+	if (Reader.hasError()) {
+		fprintf(stderr, "Error: %s is truncated or malformed\n", argv[1]);
+		return 1;
+	}
+
+	return 0;
+}
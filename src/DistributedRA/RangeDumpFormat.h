@@ -0,0 +1,367 @@
+/*
+ * RangeDumpFormat.h
+ *
+ *  Binary format of the files written by DistributedRangeDump, with the
+ *  writer used by the pass and the reader used by the dump converter.
+ *  It only depends on the C++ library, so that tools that post-process
+ *  the dumps do not need to link against LLVM.
+ *
+ *  Layout (all integers are little-endian):
+ *    header     "DRDB" u32 version
+ *    records    u8 kind, followed by
+ *      String   u32 id, u32 length, bytes
+ *      Range    u32 function id, u32 value id, u8 flags, i64 lower, i64 upper
+ *      Table    i32 alias set id, u32 number of rows, and for each row
+ *               u8 flags, i64 offset lower, i64 offset upper,
+ *               i64 content lower, i64 content upper
+ *      End
+ *  Strings are written once, right before the first record that uses them.
+ *  The bounds -inf and +inf are written as INT64_MIN and INT64_MAX.
+ */
+
+#ifndef RANGEDUMPFORMAT_H_
+#define RANGEDUMPFORMAT_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+namespace RangeDump {
+
+	static const char Magic[4] = { 'D', 'R', 'D', 'B' };
+	static const uint32_t Version = 1;
+
+	enum RecordKind {
+		EndKind = 0,
+		StringKind = 1,
+		RangeKind = 2,
+		TableKind = 3
+	};
+
+	enum RangeFlags {
+		Regular = 0,
+		Unknown = 1,
+		Empty = 2
+	};
+
+}
+
+//One row of a segmentation table
+struct RangeDumpRow {
+	uint8_t flags;
+	int64_t offsetLower;
+	int64_t offsetUpper;
+	int64_t contentLower;
+	int64_t contentUpper;
+};
+
+//A Range or Table record, with its strings already resolved
+struct RangeDumpRecord {
+	RangeDump::RecordKind kind;
+	//Range records
+	std::string function;
+	std::string value;
+	uint8_t flags;
+	int64_t lower;
+	int64_t upper;
+	//Table records
+	int32_t aliasSetId;
+	std::vector<RangeDumpRow> rows;
+};
+
+//Encodes records into a single buffer that is written to the file only
+//when it fills up, so a dump costs a handful of write calls.
+class RangeDumpWriter {
+private:
+	FILE *file;
+	std::vector<char> buffer;
+	std::map<std::string, uint32_t> strings;
+	bool error;
+
+	void flush() {
+		if (!buffer.empty()) {
+			if (fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size())
+				error = true;
+			buffer.clear();
+		}
+	}
+
+	void put8(uint8_t v) {
+		buffer.push_back((char) v);
+	}
+
+	void put32(uint32_t v) {
+		for (int i = 0; i < 4; ++i)
+			buffer.push_back((char) ((v >> (8 * i)) & 0xff));
+	}
+
+	void put64(int64_t v) {
+		uint64_t u = (uint64_t) v;
+		for (int i = 0; i < 8; ++i)
+			buffer.push_back((char) ((u >> (8 * i)) & 0xff));
+	}
+
+	void endRecord() {
+		if (buffer.size() >= BufferSize)
+			flush();
+	}
+
+public:
+	static const size_t BufferSize = 1 << 20;
+
+	RangeDumpWriter(): file(NULL), error(false) {}
+	~RangeDumpWriter() { close(); }
+
+	bool open(const std::string &filename) {
+		file = fopen(filename.c_str(), "wb");
+		error = false;
+		if (!file)
+			return false;
+		buffer.reserve(BufferSize + 256);
+		buffer.insert(buffer.end(), RangeDump::Magic, RangeDump::Magic + 4);
+		put32(RangeDump::Version);
+		return true;
+	}
+
+	//Returns false if any part of the dump could not be written
+	bool close() {
+		if (!file)
+			return !error;
+		put8(RangeDump::EndKind);
+		flush();
+		if (fclose(file) != 0)
+			error = true;
+		file = NULL;
+		return !error;
+	}
+
+	//Returns the id of s, writing it to the dump the first time it is seen
+	uint32_t getStringId(const std::string &s) {
+		std::map<std::string, uint32_t>::iterator it = strings.find(s);
+		if (it != strings.end())
+			return it->second;
+
+		uint32_t id = strings.size();
+		strings[s] = id;
+		put8(RangeDump::StringKind);
+		put32(id);
+		put32(s.size());
+		buffer.insert(buffer.end(), s.begin(), s.end());
+		endRecord();
+		return id;
+	}
+
+	void writeRange(uint32_t function, uint32_t value, uint8_t flags,
+			int64_t lower, int64_t upper) {
+		put8(RangeDump::RangeKind);
+		put32(function);
+		put32(value);
+		put8(flags);
+		put64(lower);
+		put64(upper);
+		endRecord();
+	}
+
+	//Must be followed by numRows calls to writeRow
+	void beginTable(int32_t aliasSetId, uint32_t numRows) {
+		put8(RangeDump::TableKind);
+		put32((uint32_t) aliasSetId);
+		put32(numRows);
+	}
+
+	void writeRow(const RangeDumpRow &row) {
+		put8(row.flags);
+		put64(row.offsetLower);
+		put64(row.offsetUpper);
+		put64(row.contentLower);
+		put64(row.contentUpper);
+		endRecord();
+	}
+};
+
+//Reads a dump back record by record, loading the file in large chunks
+class RangeDumpReader {
+private:
+	FILE *file;
+	std::vector<char> buffer;
+	size_t pos;
+	std::vector<std::string> strings;
+	bool error;
+
+	//Makes sure n bytes are available in the buffer. The buffer only grows
+	//by what is actually read, so a corrupt length cannot make it huge.
+	bool fill(size_t n) {
+		if (pos + n <= buffer.size())
+			return true;
+		buffer.erase(buffer.begin(), buffer.begin() + pos);
+		pos = 0;
+		while (buffer.size() < n) {
+			size_t old = buffer.size();
+			buffer.resize(old + BufferSize);
+			size_t got = fread(&buffer[old], 1, BufferSize, file);
+			buffer.resize(old + got);
+			if (got == 0) {
+				error = true;
+				return false;
+			}
+		}
+		return true;
+	}
+
+	uint8_t get8() {
+		if (!fill(1)) return 0;
+		return (uint8_t) buffer[pos++];
+	}
+
+	uint32_t get32() {
+		if (!fill(4)) return 0;
+		uint32_t v = 0;
+		for (int i = 0; i < 4; ++i)
+			v |= ((uint32_t) (uint8_t) buffer[pos++]) << (8 * i);
+		return v;
+	}
+
+	int64_t get64() {
+		if (!fill(8)) return 0;
+		uint64_t v = 0;
+		for (int i = 0; i < 8; ++i)
+			v |= ((uint64_t) (uint8_t) buffer[pos++]) << (8 * i);
+		return (int64_t) v;
+	}
+
+	const std::string &getString(uint32_t id) {
+		static const std::string Missing = "<unknown>";
+		if (id >= strings.size()) {
+			error = true;
+			return Missing;
+		}
+		return strings[id];
+	}
+
+public:
+	static const size_t BufferSize = 1 << 20;
+
+	RangeDumpReader(): file(NULL), pos(0), error(false) {}
+	~RangeDumpReader() { if (file) fclose(file); }
+
+	//Opens filename and checks its header
+	bool open(const std::string &filename) {
+		file = fopen(filename.c_str(), "rb");
+		if (!file || !fill(8) || memcmp(&buffer[0], RangeDump::Magic, 4)) {
+			error = true;
+			return false;
+		}
+		pos = 4;
+		if (get32() != RangeDump::Version) {
+			error = true;
+			return false;
+		}
+		return true;
+	}
+
+	//True if the file is malformed or was cut short
+	bool hasError() const { return error; }
+
+	//Reads the next Range or Table record. Returns false at the end of the dump
+	bool next(RangeDumpRecord &R) {
+		while (!error) {
+			uint8_t kind = get8();
+			if (error || kind == RangeDump::EndKind)
+				return false;
+
+			if (kind == RangeDump::StringKind) {
+				uint32_t id = get32();
+				uint32_t length = get32();
+				if (error || id != strings.size() || !fill(length)) {
+					error = true;
+					return false;
+				}
+				strings.push_back(std::string(buffer.begin() + pos,
+						buffer.begin() + pos + length));
+				pos += length;
+			} else if (kind == RangeDump::RangeKind) {
+				R.kind = RangeDump::RangeKind;
+				R.function = getString(get32());
+				R.value = getString(get32());
+				R.flags = get8();
+				R.lower = get64();
+				R.upper = get64();
+				R.rows.clear();
+				return !error;
+			} else if (kind == RangeDump::TableKind) {
+				R.kind = RangeDump::TableKind;
+				R.aliasSetId = (int32_t) get32();
+				uint32_t numRows = get32();
+				//The count is not trusted: rows are added as they are read
+				R.rows.clear();
+				for (uint32_t i = 0; i < numRows && !error; ++i) {
+					RangeDumpRow Row;
+					Row.flags = get8();
+					Row.offsetLower = get64();
+					Row.offsetUpper = get64();
+					Row.contentLower = get64();
+					Row.contentUpper = get64();
+					if (!error)
+						R.rows.push_back(Row);
+				}
+				return !error;
+			} else {
+				error = true;
+			}
+		}
+		return false;
+	}
+};
+
+//Text form of a single bound, using -inf and +inf for the extremes
+inline std::string formatRangeDumpBound(int64_t v) {
+	if (v == INT64_MIN) return "-inf";
+	if (v == INT64_MAX) return "+inf";
+	std::ostringstream ss;
+	ss << v;
+	return ss.str();
+}
+
+inline std::string formatRangeDumpInterval(uint8_t flags, int64_t lower,
+		int64_t upper) {
+	if (flags & RangeDump::Unknown) return "unknown";
+	if (flags & RangeDump::Empty) return "empty";
+	return "[" + formatRangeDumpBound(lower) + ", "
+			+ formatRangeDumpBound(upper) + "]";
+}
+
+//Text form of a record. Ranges keep the old "function|value|lower|upper"
+//lines, tables list one "offset - content" line per row.
+inline std::string formatRangeDumpRecord(const RangeDumpRecord &R) {
+	std::ostringstream ss;
+	if (R.kind == RangeDump::RangeKind) {
+		ss << R.function << "|" << R.value << "|";
+		if (R.flags & RangeDump::Unknown)
+			ss << "unknown|unknown\n";
+		else if (R.flags & RangeDump::Empty)
+			ss << "empty|empty\n";
+		else
+			ss << formatRangeDumpBound(R.lower) << "|"
+					<< formatRangeDumpBound(R.upper) << "\n";
+	} else if (R.kind == RangeDump::TableKind) {
+		ss << "Table of alias set " << R.aliasSetId << ":\n";
+		for (size_t i = 0; i < R.rows.size(); ++i) {
+			const RangeDumpRow &row = R.rows[i];
+			ss << "  " << formatRangeDumpInterval(RangeDump::Regular,
+					row.offsetLower, row.offsetUpper) << " - "
+					<< formatRangeDumpInterval(row.flags, row.contentLower,
+							row.contentUpper) << "\n";
+		}
+	}
+	return ss.str();
+}
+
+}
+
+#endif /* RANGEDUMPFORMAT_H_ */
@@ -193,19 +193,6 @@ RangedPointer::FindByValue //Name
 * Calculate Primitive Layouts and Number of elements.
 */
 
-//Returns the sum of previous elements of vector
-int 
-SegmentationTables::getSumBehind
-(std::vector<int> v, int i)
-{
-	int s = 0;
-	if(i > v.size())
-		i = v.size();
-	for(int j = i-1; j >= 0; j--)
-		s += v[j];
-	return s;
-}
-
 //Returns the type of the ith element inside type
 Type* 
 SegmentationTables::getTypeInside
@@ -223,102 +210,6 @@ SegmentationTables::getTypeInside
 		return NULL;	
 }
 	
-//Returns the number of primitive elements of type
-int //returns
-SegmentationTables::getNumPrimitives //Name
-(Type* type) //Parameter
-{
-	//Verifies if this number of primitives was calculated already
-	for(int i = 0; i < NumPrimitives.size(); i++)
-		if(NumPrimitives[i]->type == type)
-			return NumPrimitives[i]->num;
-	
-	//if not
-	int np = 1;
-	if(type->isArrayTy())
-	{
-		int num = type->getArrayNumElements();
-		Type* arrtype = type->getArrayElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		np = num * arrtypenum;
-	}
-	else if(type->isStructTy())
-	{
-		int num = type->getStructNumElements();
-		np = 0;
-		for(int i = 0; i < num; i++)
-		{
-			Type* structelemtype = type->getStructElementType(i);
-			np += getNumPrimitives(structelemtype);
-		}
-	}
-	else if(type->isVectorTy())
-	{
-		int num = type->getVectorNumElements();
-		Type* arrtype = type->getVectorElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		np = num * arrtypenum;
-	}
-	
-	NumPrimitives.insert(NumPrimitives.end(), new NumPrimitive(type, np));
-	return np;
-}
-
-//Returns a vector with the primitive layout of type
-std::vector<int> //returns
-SegmentationTables::getPrimitiveLayout //Name
-(Type* type) //Parameter
-{
-	//Verifies if this layout was calculated already
-	for(int i = 0; i < PrimitiveLayouts.size(); i++)
-		if(PrimitiveLayouts[i]->type == type)
-			return PrimitiveLayouts[i]->layout;
-	
-	//if not
-		
-	if(type->isArrayTy())
-	{
-		int num = type->getArrayNumElements();
-		std::vector<int> pm (num);
-		Type* arrtype = type->getArrayElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		for(int i = 0; i < num; i++)
-			pm[i] = arrtypenum;
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}
-	else if(type->isStructTy())
-	{
-		int num = type->getStructNumElements();
-		std::vector<int> pm (num);
-		for(int i = 0; i < num; i++)
-		{
-			Type* structelemtype = type->getStructElementType(i);
-			pm[i] = getNumPrimitives(structelemtype);
-		}
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}
-	else if(type->isVectorTy())
-	{
-		int num = type->getVectorNumElements();
-		std::vector<int> pm (num);
-		Type* arrtype = type->getVectorElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		for(int i = 0; i < num; i++)
-			pm[i] = arrtypenum;
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}
-	else
-	{
-		std::vector<int> pm (1);
-		pm[0] = 1;
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}	
-}
-
 /*
 * Debug Functions
 */
@@ -382,22 +273,6 @@ SegmentationTables::printNotUsedPointers
 	errs() << "-------------------------\n\n";
 }
 
-void //Returns Nothing 
-SegmentationTables::printPrimitiveLayouts //Name
-(std::vector<PrimitiveLayout*> PrimitiveLayouts) //Parameters
-{
-	errs() << "\n-------------------------\nPrimitive Layouts:" << "\n";
-	for(int i = 0; i < PrimitiveLayouts.size(); i++)
-	{
-		errs() << *(PrimitiveLayouts[i]->type) << ":\n";
-		for(int j = 0; j < PrimitiveLayouts[i]->layout.size(); j++)
-			errs() << PrimitiveLayouts[i]->layout[j] << "  ";
-		errs() << "\n";
-	}
-	
-	errs() << "-------------------------\n\n";
-}
-
 void 
 SegmentationTables::printSegmentationTableMap
 ()
@@ -408,7 +283,7 @@ SegmentationTables::printSegmentationTableMap
 	i = SegmentationTableMap.begin(), e = SegmentationTableMap.end(); i != e; i++)
 	{
   	errs() << "Table: " << *(i->first) << "\n";
-  	for(set<SegmentationTableRow*>::iterator ii = i->second->rows.begin(),
+  	for(std::vector<SegmentationTableRow*>::iterator ii = i->second->rows.begin(),
   	ee = i->second->rows.end(); ii != ee; ii++)
   	{
   		errs() << "Row: ["; 
@@ -441,7 +316,7 @@ void
 SegmentationTable::PrintPointers()
 {
 	errs() << "\nTable: " << *(base) << "\n";
-  for(set<SegmentationTableRow*>::iterator ii = rows.begin(),
+  for(std::vector<SegmentationTableRow*>::iterator ii = rows.begin(),
   ee = rows.end(); ii != ee; ii++)
   {
   	errs() << "Row: ["; 
@@ -465,7 +340,7 @@ void
 SegmentationTable::PrintContent()
 {
 	errs() << "\nTable: " << *(base) << "\n";
-  for(set<SegmentationTableRow*>::iterator ii = rows.begin(),
+  for(std::vector<SegmentationTableRow*>::iterator ii = rows.begin(),
   ee = rows.end(); ii != ee; ii++)
   {
   	errs() << "Row: ["; 
@@ -491,6 +366,76 @@ SegmentationTable::PrintContent()
   errs() << "\n";
 }
 
+static bool
+rowEndsBefore
+(SegmentationTableRow* row, const APInt &offset)
+{
+	return row->offset.getUpper().slt(offset);
+}
+
+//Returns the first row that ends at or after offset
+std::vector<SegmentationTableRow*>::iterator
+SegmentationTable::FindRow
+(const APInt &offset)
+{
+	return std::lower_bound(rows.begin(), rows.end(), offset, rowEndsBefore);
+}
+
+//A row ends at each pointer's upper bound and right before each pointer's
+//lower bound, so the rows are found by sorting those ends once. Each pointer
+//is then placed, by binary search, in the contiguous rows it covers.
+void
+SegmentationTable::BuildRows
+()
+{
+	APInt One = Zero;
+	One++;
+	
+	rows.clear();
+	pointer_to_rows.clear();
+	row_num = 0;
+	
+	std::vector<APInt> ends;
+	for (std::set<RangedPointer*>::iterator ii = ranged_pointers.begin(), 
+	ee = ranged_pointers.end(); ii != ee; ++ii)
+	{
+		if((*ii)->offset.getUpper().sgt(Min))
+			ends.push_back((*ii)->offset.getUpper());
+		if((*ii)->offset.getLower().sgt(Min))
+			ends.push_back((*ii)->offset.getLower() - One);
+	}
+	ends.push_back(Max);
+	std::sort(ends.begin(), ends.end(), compAPInt);
+	ends.erase(std::unique(ends.begin(), ends.end()), ends.end());
+	
+	APInt lower_range = Min;
+	for(unsigned i = 0; i < ends.size(); i++)
+	{
+		SegmentationTableRow* table_row = new SegmentationTableRow();
+		table_row->offset.setLower(lower_range);
+		table_row->offset.setUpper(ends[i]);
+		rows.push_back(table_row);
+		if(ends[i] == Max)
+			break;
+		lower_range = ends[i] + One;
+	}
+	
+	for (std::set<RangedPointer*>::iterator ii = ranged_pointers.begin(), 
+	ee = ranged_pointers.end(); ii != ee; ++ii)
+	{
+		for(std::vector<SegmentationTableRow*>::iterator r = FindRow((*ii)->offset.getLower()),
+		re = rows.end(); r != re and (*r)->offset.getLower().sle((*ii)->offset.getUpper()); r++)
+		{
+			(*r)->pointers.insert((*ii)->pointer);
+			pointer_to_rows[(*ii)->pointer].insert(*r);
+		}
+	}
+	
+	for(std::vector<SegmentationTableRow*>::iterator r = rows.begin(), re = rows.end(); r != re; r++)
+		if(!(*r)->pointers.empty())
+			row_num++;
+}
+
 /*
 * SegmentationTables support functions
 */
@@ -686,7 +631,7 @@ SegmentationTables::runOnModule //Name
        	
        	//Number of primitive elements
        	Type* base_ptr_type = base_ptr->getType();
-       	int base_ptr_num_primitive = getNumPrimitives(base_ptr_type->getPointerElementType());
+       	int base_ptr_num_primitive = PrimitiveLayouts.getNumPrimitives(base_ptr_type->getPointerElementType());
        	
        	//parse first index
        	User::op_iterator idx = ((GetElementPtrInst*)i)->idx_begin();
@@ -747,7 +692,7 @@ SegmentationTables::runOnModule //Name
        	{
        		//Calculating Primitive Layout
        		base_ptr_type = getTypeInside(base_ptr_type, index.getSExtValue());
-     			std::vector<int> base_ptr_primitive_layout = getPrimitiveLayout(base_ptr_type);
+     			PrimitiveLayout* base_ptr_primitive_layout = PrimitiveLayouts.getPrimitiveLayout(base_ptr_type);
      			
      			Value* indx = idx->get();
         	if(isa<ConstantInt>(*indx))
@@ -766,8 +711,8 @@ SegmentationTables::runOnModule //Name
 		      	higher_range = higher_range.sextOrTrunc(higher_bitwidth);
 		      	constant = constant.sextOrTrunc(higher_bitwidth);
 		      	
-						lower_range = safe_addition( lower_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
-						higher_range = safe_addition( higher_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
+						lower_range = safe_addition( lower_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
+						higher_range = safe_addition( higher_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
 
 		      	index = constant;
         	}
@@ -793,8 +738,8 @@ SegmentationTables::runOnModule //Name
 		      		rl = rl.sextOrTrunc(higher_bitwidth);
 		      		ru = ru.sextOrTrunc(higher_bitwidth);
 		        
-		        	lower_range = safe_addition( lower_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, rl.getSExtValue()) ) );
-							higher_range = safe_addition( higher_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, ru.getSExtValue()) ) );
+		        	lower_range = safe_addition( lower_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, rl.getSExtValue()) ) );
+							higher_range = safe_addition( higher_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, ru.getSExtValue()) ) );
 		        
 		        	index = Zero;
 		    	  }
@@ -816,7 +761,7 @@ SegmentationTables::runOnModule //Name
 	
 	DEBUG(printRangedPointerMap());
 	DEBUG(printNotUsedPointers());
-	DEBUG(printPrimitiveLayouts(PrimitiveLayouts));
+	DEBUG(PrimitiveLayouts.print());
 	
 	/*
 	* Separating pointers for table construction
@@ -841,80 +786,9 @@ SegmentationTables::runOnModule //Name
 	for (llvm::DenseMap<Value*, std::set<RangedPointer*> >::iterator 
 	i = RangedPointerSets.begin(), e = RangedPointerSets.end(); i != e; ++i)
 	{
-		APInt MinusOne = Zero;
-		MinusOne--;
-		APInt One = Zero;
-		One++;
-		APInt lower_range = Min;
-		APInt higher_range = Min;
-		
 		SegmentationTableMap[i->first] = new SegmentationTable();
-		SegmentationTableMap[i->first]->row_num = 0;
 		SegmentationTableMap[i->first]->ranged_pointers = i->second;
-		
-		//adding entries to the table
-		while(true)
-		{
-			/////////////////////////////
-			//Calculating new lower range
-			
-			APInt new_lower_range = Min;
-			
-			//if lower_range hasn't been calculated before than we should find
-			//the lowest lower range, if not the next lower range is higher+1
-			if(higher_range != Min)
-			{
-				new_lower_range = higher_range + One;
-			}
-			
-			//////////////////////////////
-			//Calculating new higher range
-			
-			APInt new_higher_range1 = Max;
-			APInt new_higher_range2 = Max;
-			
-			for (std::set<RangedPointer*>::iterator ii = i->second.begin(), 
-			ee = i->second.end(); ii != ee; ++ii)
-	    {
-	    	if((*ii)->offset.getUpper().slt(new_higher_range1) and (*ii)->offset.getUpper().sgt(higher_range))
-	    		new_higher_range1 = (*ii)->offset.getUpper();
-	    	
-	    	if((*ii)->offset.getLower().slt(new_higher_range2) and (*ii)->offset.getLower().sgt(new_lower_range))
-	    		new_higher_range2 = (*ii)->offset.getLower() - One;
-	    }
-			
-			//refreshing ranges
-			lower_range = new_lower_range;
-			higher_range = new_higher_range1.slt(new_higher_range2) ? new_higher_range1 : new_higher_range2;
-			
-			////////////////////
-			//Adding row members
-	    SegmentationTableRow* table_row = new SegmentationTableRow();
-	    table_row->offset.setLower(lower_range);
-	    table_row->offset.setUpper(higher_range);
-	    
-	    bool mrk = false;
-	    for (std::set<RangedPointer*>::iterator ii = i->second.begin(), ee = i->second.end(); 
-      ii != ee; ++ii)
-      {
-      	if((*ii)->offset.getLower().sle(higher_range) and (*ii)->offset.getUpper().sge(lower_range))
-      	{
-      		table_row->pointers.insert((*ii)->pointer);		
-      		SegmentationTableMap[i->first]->pointer_to_rows[(*ii)->pointer].insert(table_row);
-      		mrk = true;
-      	}
-      }
-			
-			/////////////////////
-			//finishing loop turn
-			SegmentationTableMap[i->first]->rows.insert(table_row);
-      if(mrk == true) SegmentationTableMap[i->first]->row_num++;
-      
-      //evaluate break point
-      if(higher_range == Max)
-      	break;      
-    }
-	  
+		SegmentationTableMap[i->first]->BuildRows();
 	}
 	DEBUG(printSegmentationTableMap());
 
@@ -15,6 +15,7 @@
 #include <vector>
 #include <algorithm>
 #include "../RangeAnalysis/RangeAnalysis.h"
+#include "../RangeBasedAliasAnalysis/PrimitiveLayouts.h"
 
 using namespace std;
 
@@ -53,7 +54,8 @@ namespace llvm
 
 	struct SegmentationTable
 	{
-		set<SegmentationTableRow*> rows;
+		//Disjoint rows, sorted by offset, covering [-inf, +inf]
+		std::vector<SegmentationTableRow*> rows;
 		//RangedPointer present in this table
 		std::set<RangedPointer*> ranged_pointers;
 		//A map that tells which rows each pointer is present
@@ -86,39 +88,18 @@ namespace llvm
 		
 		void PrintPointers();
 		void PrintContent();
+		//Builds rows, pointer_to_rows and row_num from ranged_pointers
+		void BuildRows();
+		//Returns the first row that ends at or after offset
+		std::vector<SegmentationTableRow*>::iterator FindRow(const APInt &offset);
 	
 	};
 
 	class SegmentationTables: public ModulePass
 	{
 		private:
-			//Holds a Primitive Layout for a determined Type
-			struct PrimitiveLayout
-			{
-				Type * type;
-				std::vector<int> layout;
-				PrimitiveLayout(Type* ty, std::vector<int> lay)
-				{
-					type = ty;
-					layout = lay;
-				}
-			};
-			struct NumPrimitive
-			{
-				Type * type;
-				int num;
-				NumPrimitive(Type* ty, int n)
-				{
-					type = ty;
-					num = n;
-				}
-			};
-			std::vector<PrimitiveLayout*> PrimitiveLayouts;
-			std::vector<NumPrimitive*> NumPrimitives;
-			std::vector<int> getPrimitiveLayout(Type* type);
-			int getNumPrimitives(Type* type);
+			PrimitiveLayoutTable PrimitiveLayouts;
 			llvm::Type* getTypeInside(Type* type, int i);
-			int getSumBehind(std::vector<int> v, int i);
 		
 			//Persistent maps
 			llvm::DenseMap<Value*, RangedPointer*> RangedPointerMap;
@@ -130,7 +111,6 @@ namespace llvm
 			void printRangeAnalysis(InterProceduralRA<Cousot> *ra, Module *M);
 			void printRangedPointerMap();
 			void printNotUsedPointers();
-			void printPrimitiveLayouts(std::vector<PrimitiveLayout*> PrimitiveLayouts);
 			void printSegmentationTableMap();
 			
 		public:
@@ -0,0 +1,220 @@
+//===- DivisionReduction.cpp - Cheaper divisions using range analysis -----===//
+//
+// This pass replaces integer divisions and remainders by cheaper code, using
+// the ranges computed by the interprocedural range analysis. When the ranges
+// show that:
+//
+// - the divisor is a single power of two, the division becomes a right shift
+//   and the remainder becomes a mask;
+// - the dividend is less than twice the divisor, the quotient is 0 or 1, so
+//   the division becomes a comparison and the remainder becomes a comparison
+//   and a subtraction;
+// - both operands fit in 32 bits, a wider operation is done in 32 bits;
+// - both operands are not negative, a signed operation becomes unsigned,
+//   which needs no sign fix up.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-div-reduction"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+
+using namespace llvm;
+
+STATISTIC(NumDivisions, "Number of divisions and remainders found");
+STATISTIC(NumShifts, "Number of divisions by powers of two turned into shifts and masks");
+STATISTIC(NumCompares, "Number of divisions turned into comparisons and subtractions");
+STATISTIC(NumFolded, "Number of divisions with a known result");
+STATISTIC(NumNarrowed, "Number of divisions done in 32 bits");
+STATISTIC(NumUnsigned, "Number of signed divisions turned into unsigned ones");
+
+namespace {
+	class DivisionReduction : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+
+	public:
+		static char ID;
+		DivisionReduction() : ModulePass(ID), RA(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		Value *reduce(BinaryOperator *BO);
+		Value *reduceUnsigned(BinaryOperator *BO, const APInt &UA, const APInt &LB,
+				const APInt &UB);
+		Value *narrow(BinaryOperator *BO, bool Signed);
+	};
+}
+
+char DivisionReduction::ID = 0;
+static RegisterPass<DivisionReduction> X("range-div-reduction",
+"Replace divisions and remainders using range analysis", false, false);
+
+void DivisionReduction::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool DivisionReduction::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+
+	// Decide with the ranges of the original code, then change it
+	SmallVector<BinaryOperator*, 16> Divisions;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			BinaryOperator *BO = dyn_cast<BinaryOperator>(&*I);
+			if (!BO || !BO->getType()->isIntegerTy())
+				continue;
+
+			switch (BO->getOpcode()) {
+			case Instruction::UDiv:
+			case Instruction::SDiv:
+			case Instruction::URem:
+			case Instruction::SRem:
+				Divisions.push_back(BO);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	NumDivisions += Divisions.size();
+
+	bool Changed = false;
+	for (unsigned i = 0, e = Divisions.size(); i < e; ++i) {
+		BinaryOperator *BO = Divisions[i];
+		Value *New = reduce(BO);
+		if (!New)
+			continue;
+
+		// Remainders of small dividends are the dividends themselves
+		if (Instruction *NewI = dyn_cast<Instruction>(New))
+			if (New != BO->getOperand(0))
+				NewI->takeName(BO);
+
+		BO->replaceAllUsesWith(New);
+		BO->eraseFromParent();
+		Changed = true;
+	}
+
+	return Changed;
+}
+
+// The code that computes the same value as BO, inserted before it, or NULL
+// if the ranges do not help
+Value *DivisionReduction::reduce(BinaryOperator *BO) {
+	unsigned Width = BO->getType()->getIntegerBitWidth();
+
+	APInt LA, UA, LB, UB;
+	if (!getBounds(RA, BO->getOperand(0), Width, LA, UA)
+			|| !getBounds(RA, BO->getOperand(1), Width, LB, UB))
+		return NULL;
+
+	bool Signed = BO->getOpcode() == Instruction::SDiv
+		|| BO->getOpcode() == Instruction::SRem;
+
+	// Operands that are not negative have the same value as unsigned numbers,
+	// so signed and unsigned operations agree on them
+	if (LA.isNegative() || LB.isNegative()) {
+		if (!Signed || Width <= 32)
+			return NULL;
+
+		// The minimum divided by minus one is undefined in 32 bits only
+		APInt Min = APInt::getSignedMinValue(32).sext(LA.getBitWidth());
+		APInt Max = APInt::getSignedMaxValue(32).sext(LA.getBitWidth());
+		if (LA.sle(Min) || LB.sle(Min) || UA.sgt(Max) || UB.sgt(Max))
+			return NULL;
+
+		++NumNarrowed;
+		return narrow(BO, true);
+	}
+
+	if (Value *New = reduceUnsigned(BO, UA, LB, UB))
+		return New;
+
+	if (!Signed)
+		return NULL;
+
+	Instruction::BinaryOps Opcode = BO->getOpcode() == Instruction::SDiv ?
+		Instruction::UDiv : Instruction::URem;
+	++NumUnsigned;
+	return BinaryOperator::Create(Opcode, BO->getOperand(0), BO->getOperand(1), "", BO);
+}
+
+// Reduces BO, knowing that its operands are not negative
+Value *DivisionReduction::reduceUnsigned(BinaryOperator *BO, const APInt &UA,
+		const APInt &LB, const APInt &UB) {
+	Value *A = BO->getOperand(0), *B = BO->getOperand(1);
+	IntegerType *Ty = cast<IntegerType>(BO->getType());
+	unsigned Width = Ty->getBitWidth();
+	bool Rem = BO->getOpcode() == Instruction::URem
+		|| BO->getOpcode() == Instruction::SRem;
+
+	if (LB.eq(UB) && LB.isPowerOf2()) {
+		++NumShifts;
+		if (Rem)
+			return BinaryOperator::CreateAnd(A,
+					ConstantInt::get(Ty, (LB - 1).trunc(Width)), "", BO);
+
+		return BinaryOperator::CreateLShr(A,
+				ConstantInt::get(Ty, LB.logBase2()), "", BO);
+	}
+
+	// The dividend is always less than the divisor
+	if (UA.ult(LB)) {
+		++NumFolded;
+		return Rem ? A : ConstantInt::get(Ty, 0);
+	}
+
+	// The quotient is at most one: A - B < B, without overflow
+	if ((UA - LB).ult(LB)) {
+		++NumCompares;
+		Instruction *GE = new ICmpInst(BO, ICmpInst::ICMP_UGE, A, B, "");
+		if (!Rem)
+			return new ZExtInst(GE, Ty, "", BO);
+
+		Instruction *Sub = BinaryOperator::CreateSub(A, B, "", BO);
+		return SelectInst::Create(GE, Sub, A, "", BO);
+	}
+
+	if (Width > 32 && UA.isIntN(32) && UB.isIntN(32)) {
+		++NumNarrowed;
+		return narrow(BO, false);
+	}
+
+	return NULL;
+}
+
+// Does BO in 32 bits. The operands must fit, as signed numbers if Signed,
+// as unsigned numbers otherwise.
+Value *DivisionReduction::narrow(BinaryOperator *BO, bool Signed) {
+	Type *NarrowTy = Type::getInt32Ty(BO->getContext());
+	Value *Ops[2];
+	for (unsigned i = 0; i < 2; ++i) {
+		Value *Op = BO->getOperand(i);
+		if (ConstantInt *CI = dyn_cast<ConstantInt>(Op))
+			Ops[i] = ConstantInt::get(NarrowTy, CI->getValue().trunc(32));
+		else
+			Ops[i] = new TruncInst(Op, NarrowTy, Op->getName() + ".nrw", BO);
+	}
+
+	Instruction::BinaryOps Opcode = BO->getOpcode();
+	if (!Signed && Opcode == Instruction::SDiv)
+		Opcode = Instruction::UDiv;
+	else if (!Signed && Opcode == Instruction::SRem)
+		Opcode = Instruction::URem;
+
+	Instruction *New = BinaryOperator::Create(Opcode, Ops[0], Ops[1],
+			BO->getName() + ".nrw", BO);
+	if (Signed)
+		return new SExtInst(New, BO->getType(), "", BO);
+
+	return new ZExtInst(New, BO->getType(), "", BO);
+}
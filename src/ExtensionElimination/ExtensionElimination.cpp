@@ -0,0 +1,378 @@
+//===- ExtensionElimination.cpp - Remove extensions using range analysis --===//
+//
+// This pass uses the ranges computed by the interprocedural range analysis to
+// remove the sign and zero extensions that keep 64-bit code from folding
+// indices into addressing modes:
+//
+// - A sign extension of a value that is never negative becomes a zero
+//   extension.
+// - An extension of a truncation is removed when the truncated value fits the
+//   narrow type, because then it is the value itself.
+// - An induction variable whose users are all extensions, comparisons and
+//   indices of getelementptrs is rewritten in the type it is extended to, so
+//   the loop no longer extends it in every iteration. The ranges show that
+//   the variable never wraps, so the wide variable has the same values.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-ext-elimination"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+
+using namespace llvm;
+
+STATISTIC(NumSExtToZExt, "Number of sign extensions turned into zero extensions");
+STATISTIC(NumTruncsRemoved, "Number of extensions of truncations removed");
+STATISTIC(NumIVsWidened, "Number of induction variables widened");
+STATISTIC(NumExtsRemoved, "Number of extensions of induction variables removed");
+
+namespace {
+	// An induction variable Phi, updated by Inc, which adds a constant to it
+	struct InductionVariable {
+		PHINode *Phi;
+		BinaryOperator *Inc;
+		IntegerType *WideTy;
+	};
+
+	// Extension Ext is replaced by an integer cast of Source
+	struct Replacement {
+		CastInst *Ext;
+		Value *Source;
+	};
+
+	class ExtensionElimination : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+
+	public:
+		static char ID;
+		ExtensionElimination() : ModulePass(ID), RA(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool fitsSigned(Value *V, unsigned Width);
+		bool isNonNegative(Value *V);
+		BinaryOperator *getIncrement(PHINode *Phi);
+		bool isWidenable(PHINode *Phi, InductionVariable &IV);
+		void widen(InductionVariable &IV);
+		Value *getSourceOf(CastInst *Ext);
+	};
+}
+
+char ExtensionElimination::ID = 0;
+static RegisterPass<ExtensionElimination> X("range-ext-elimination",
+"Remove sign and zero extensions using range analysis", false, false);
+
+void ExtensionElimination::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool ExtensionElimination::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+
+	// Decide with the ranges of the original code, then change it. The
+	// extensions of the variables that are widened go away with them.
+	SmallVector<InductionVariable, 8> IVs;
+	SmallPtrSet<Instruction*, 16> Widened;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		for (Function::iterator BBit = Fit->begin(), BBend = Fit->end(); BBit != BBend; ++BBit) {
+			for (BasicBlock::iterator I = BBit->begin(); PHINode *Phi = dyn_cast<PHINode>(I); ++I) {
+				InductionVariable IV;
+				if (!isWidenable(Phi, IV))
+					continue;
+
+				IVs.push_back(IV);
+				for (Value::use_iterator UI = Phi->use_begin(), E = Phi->use_end(); UI != E; ++UI)
+					Widened.insert(cast<Instruction>(*UI));
+				for (Value::use_iterator UI = IV.Inc->use_begin(), E = IV.Inc->use_end(); UI != E; ++UI)
+					Widened.insert(cast<Instruction>(*UI));
+			}
+		}
+	}
+
+	SmallVector<Replacement, 16> Replacements;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			CastInst *Ext = dyn_cast<CastInst>(&*I);
+			if (!Ext || Widened.count(Ext))
+				continue;
+
+			if (!isa<SExtInst>(Ext) && !isa<ZExtInst>(Ext))
+				continue;
+
+			if (Value *Source = getSourceOf(Ext)) {
+				Replacement R = { Ext, Source };
+				Replacements.push_back(R);
+			}
+		}
+	}
+
+	for (unsigned i = 0, e = IVs.size(); i < e; ++i)
+		widen(IVs[i]);
+
+	// Extensions replaced so far, which may be the sources of later ones
+	DenseMap<Value*, Value*> Replaced;
+	for (unsigned i = 0, e = Replacements.size(); i < e; ++i) {
+		CastInst *Ext = Replacements[i].Ext;
+		Value *Source = Replacements[i].Source;
+		if (Value *New = Replaced.lookup(Source))
+			Source = New;
+
+		// A sign extension of a value that is not negative
+		if (Source == Ext->getOperand(0)) {
+			Instruction *ZExt = new ZExtInst(Source, Ext->getType(), "", Ext);
+			ZExt->takeName(Ext);
+			Ext->replaceAllUsesWith(ZExt);
+			Replaced[Ext] = ZExt;
+			Ext->eraseFromParent();
+			++NumSExtToZExt;
+			continue;
+		}
+
+		// The value under a truncation, which is not negative if the
+		// extension is a zero extension
+		Value *New = Source;
+		if (Source->getType() != Ext->getType()) {
+			New = CastInst::CreateIntegerCast(Source, Ext->getType(),
+					isa<SExtInst>(Ext), "", Ext);
+			New->takeName(Ext);
+		}
+
+		TruncInst *Trunc = cast<TruncInst>(Ext->getOperand(0));
+		Ext->replaceAllUsesWith(New);
+		Replaced[Ext] = New;
+		Ext->eraseFromParent();
+		if (Trunc->use_empty())
+			Trunc->eraseFromParent();
+		++NumTruncsRemoved;
+	}
+
+	return !IVs.empty() || !Replacements.empty();
+}
+
+bool ExtensionElimination::fitsSigned(Value *V, unsigned Width) {
+	APInt Lower, Upper;
+	return getBounds(RA, V, Width, Lower, Upper);
+}
+
+bool ExtensionElimination::isNonNegative(Value *V) {
+	APInt Lower, Upper;
+	return getBounds(RA, V, Lower, Upper) && !Lower.isNegative()
+		&& Upper.sle(APInt::getSignedMaxValue(V->getType()->getIntegerBitWidth())
+				.sext(Upper.getBitWidth()));
+}
+
+// The value whose cast replaces Ext, or NULL if Ext has to stay. It is the
+// operand of Ext if Ext only has to become a zero extension.
+Value *ExtensionElimination::getSourceOf(CastInst *Ext) {
+	Value *Op = Ext->getOperand(0);
+
+	if (TruncInst *Trunc = dyn_cast<TruncInst>(Op)) {
+		Value *Source = Trunc->getOperand(0);
+		unsigned Width = Trunc->getType()->getIntegerBitWidth();
+
+		if (isa<SExtInst>(Ext) && fitsSigned(Source, Width))
+			return Source;
+
+		// Not negative, and below the sign bit of the narrow type, so that
+		// both extensions agree
+		if (isa<ZExtInst>(Ext) && isNonNegative(Source) && fitsSigned(Source, Width))
+			return Source;
+	}
+
+	if (isa<SExtInst>(Ext) && !isa<Constant>(Op) && isNonNegative(Op))
+		return Op;
+
+	return NULL;
+}
+
+// The instruction that adds a constant to Phi in every iteration, if it is
+// the only incoming value of Phi that depends on Phi itself
+BinaryOperator *ExtensionElimination::getIncrement(PHINode *Phi) {
+	BinaryOperator *Inc = NULL;
+
+	for (unsigned i = 0, e = Phi->getNumIncomingValues(); i < e; ++i) {
+		if (Phi->getIncomingValue(i) == Phi)
+			return NULL;
+
+		BinaryOperator *BO = dyn_cast<BinaryOperator>(Phi->getIncomingValue(i));
+		if (!BO || BO == Inc)
+			continue;
+
+		bool Add = BO->getOpcode() == Instruction::Add;
+		if (!Add && BO->getOpcode() != Instruction::Sub)
+			continue;
+
+		Value *Step = NULL;
+		if (BO->getOperand(0) == Phi)
+			Step = BO->getOperand(1);
+		else if (Add && BO->getOperand(1) == Phi)
+			Step = BO->getOperand(0);
+
+		if (!Step)
+			continue;
+
+		if (Inc || !isa<ConstantInt>(Step))
+			return NULL;
+
+		Inc = BO;
+	}
+
+	return Inc;
+}
+
+// Phi can be computed in a wider type if the ranges show that neither it
+// nor its increment wraps, and if every other user extends it, compares it,
+// or uses it as an index
+bool ExtensionElimination::isWidenable(PHINode *Phi, InductionVariable &IV) {
+	IntegerType *Ty = dyn_cast<IntegerType>(Phi->getType());
+	if (!Ty)
+		return false;
+
+	BinaryOperator *Inc = getIncrement(Phi);
+	if (!Inc)
+		return false;
+
+	// The extension of an incoming value goes before the terminator of its
+	// block, so it cannot read the result of that terminator (invoke)
+	for (unsigned i = 0, e = Phi->getNumIncomingValues(); i < e; ++i)
+		if (Phi->getIncomingValue(i) == Phi->getIncomingBlock(i)->getTerminator())
+			return false;
+
+	unsigned Width = Ty->getBitWidth();
+	if (!fitsSigned(Phi, Width) || !fitsSigned(Inc, Width))
+		return false;
+
+	IntegerType *WideTy = NULL;
+	Value *Values[] = { Phi, Inc };
+	for (unsigned v = 0; v < 2; ++v) {
+		Value *V = Values[v];
+		for (Value::use_iterator UI = V->use_begin(), E = V->use_end(); UI != E; ++UI) {
+			Instruction *U = cast<Instruction>(*UI);
+			if (U == Phi || U == Inc || isa<ICmpInst>(U) || isa<GetElementPtrInst>(U))
+				continue;
+
+			// Zero extensions agree with the sign extensions of the wide
+			// variable only if it is not negative
+			if (isa<ZExtInst>(U) && !isNonNegative(V))
+				return false;
+
+			if (!isa<SExtInst>(U) && !isa<ZExtInst>(U))
+				return false;
+
+			if (WideTy && U->getType() != WideTy)
+				return false;
+
+			WideTy = cast<IntegerType>(U->getType());
+		}
+	}
+
+	// Without extensions to remove there is nothing to gain
+	if (!WideTy)
+		return false;
+
+	IV.Phi = Phi;
+	IV.Inc = Inc;
+	IV.WideTy = WideTy;
+	return true;
+}
+
+// Rewrites IV in its wide type, and its users to use the wide variable
+void ExtensionElimination::widen(InductionVariable &IV) {
+	PHINode *Phi = IV.Phi;
+	BinaryOperator *Inc = IV.Inc;
+	IntegerType *WideTy = IV.WideTy;
+
+	PHINode *WidePhi = PHINode::Create(WideTy, Phi->getNumIncomingValues(),
+			Phi->getName() + ".wide", Phi);
+
+	unsigned StepIdx = Inc->getOperand(0) == Phi ? 1 : 0;
+	ConstantInt *Step = cast<ConstantInt>(Inc->getOperand(StepIdx));
+	Constant *WideStep = ConstantInt::get(WideTy, Step->getValue().sext(WideTy->getBitWidth()));
+	BinaryOperator *WideInc = BinaryOperator::Create(Inc->getOpcode(),
+			StepIdx ? (Value*)WidePhi : WideStep, StepIdx ? (Value*)WideStep : WidePhi,
+			Inc->getName() + ".wide", Inc);
+	WideInc->setHasNoSignedWrap(true);
+
+	DenseMap<Value*, Value*> WideOf;
+	WideOf[Phi] = WidePhi;
+	WideOf[Inc] = WideInc;
+
+	// A block may reach Phi through more than one edge, and then it has to
+	// bring the same value through each of them
+	DenseMap<BasicBlock*, Value*> Incoming;
+	for (unsigned i = 0, e = Phi->getNumIncomingValues(); i < e; ++i) {
+		Value *V = Phi->getIncomingValue(i);
+		BasicBlock *BB = Phi->getIncomingBlock(i);
+
+		Value *&WideV = Incoming[BB];
+		if (!WideV) {
+			if (V == Inc)
+				WideV = WideInc;
+			else if (ConstantInt *CI = dyn_cast<ConstantInt>(V))
+				WideV = ConstantInt::get(WideTy, CI->getValue().sext(WideTy->getBitWidth()));
+			else
+				WideV = new SExtInst(V, WideTy, V->getName() + ".wide", BB->getTerminator());
+		}
+
+		WidePhi->addIncoming(WideV, BB);
+	}
+
+	SmallPtrSet<Instruction*, 8> Seen;
+	SmallVector<Instruction*, 8> Users;
+	Value *Values[] = { Phi, Inc };
+	for (unsigned v = 0; v < 2; ++v)
+		for (Value::use_iterator UI = Values[v]->use_begin(), E = Values[v]->use_end(); UI != E; ++UI) {
+			Instruction *U = cast<Instruction>(*UI);
+			if (U != Phi && U != Inc && Seen.insert(U))
+				Users.push_back(U);
+		}
+
+	for (unsigned i = 0, e = Users.size(); i < e; ++i) {
+		Instruction *U = Users[i];
+
+		if (isa<CastInst>(U)) {
+			U->replaceAllUsesWith(WideOf.lookup(U->getOperand(0)));
+			U->eraseFromParent();
+			++NumExtsRemoved;
+		} else if (ICmpInst *Cmp = dyn_cast<ICmpInst>(U)) {
+			// Sign extensions keep both the signed and the unsigned order
+			Value *Ops[2];
+			for (unsigned o = 0; o < 2; ++o) {
+				Value *Op = Cmp->getOperand(o);
+				if (Value *WideOp = WideOf.lookup(Op))
+					Ops[o] = WideOp;
+				else if (ConstantInt *CI = dyn_cast<ConstantInt>(Op))
+					Ops[o] = ConstantInt::get(WideTy, CI->getValue().sext(WideTy->getBitWidth()));
+				else
+					Ops[o] = new SExtInst(Op, WideTy, Op->getName() + ".wide", Cmp);
+			}
+
+			Instruction *New = new ICmpInst(Cmp, Cmp->getPredicate(), Ops[0], Ops[1], "");
+			New->takeName(Cmp);
+			Cmp->replaceAllUsesWith(New);
+			Cmp->eraseFromParent();
+		} else {
+			// Indices of getelementptrs are sign extended anyway
+			for (unsigned o = 1, e = U->getNumOperands(); o < e; ++o)
+				if (Value *WideOp = WideOf.lookup(U->getOperand(o)))
+					U->setOperand(o, WideOp);
+		}
+	}
+
+	// Only the cycle between the variable and its increment is left
+	Phi->dropAllReferences();
+	Inc->dropAllReferences();
+	Phi->eraseFromParent();
+	Inc->eraseFromParent();
+	++NumIVsWidened;
+}
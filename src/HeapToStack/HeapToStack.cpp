@@ -0,0 +1,349 @@
+//===- HeapToStack.cpp - Promote small mallocs to the stack ---------------===//
+//
+// This pass replaces calls to malloc by buffers in the stack frame, and
+// removes the calls to free that release them, when:
+//
+// - the range analysis bounds the size below -h2s-max-size bytes;
+// - the pointer does not escape the function: it only reaches loads,
+//   stores to the memory it points to, comparisons, free, the memory
+//   intrinsics and functions that do the same with it;
+// - every pointer the alias sets of the pointer analysis put together with
+//   it is one of the pointers derived from it.
+//
+// The buffer has the size of the upper bound, so a malloc of a size only
+// known at run time still gets a fixed-size buffer, allocated in the entry
+// block. A malloc inside a loop is hoisted in this way: every iteration
+// uses the same buffer. This is safe because no pointer derived from the
+// malloc of one iteration reaches the next one, which would need a phi
+// after the malloc in the loop, and those are not accepted.
+//
+// The buffers of a function take at most -h2s-max-frame bytes.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-heap-to-stack"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../../Analysis/DepGraph/DepGraphCache.h"
+#include <algorithm>
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+MaxSize("h2s-max-size", cl::desc("Largest malloc, in bytes, that is moved to the stack."), cl::init(256));
+
+static cl::opt<unsigned>
+MaxFrame("h2s-max-frame", cl::desc("Largest number of bytes moved to the stack frame of a function."), cl::init(4096));
+
+STATISTIC(NumMallocs, "Number of calls to malloc found");
+STATISTIC(NumPromoted, "Number of mallocs moved to the stack");
+STATISTIC(NumHoisted, "Number of mallocs in loops moved to the stack");
+STATISTIC(NumFreesRemoved, "Number of calls to free removed");
+STATISTIC(NumBytes, "Number of bytes moved to the stack");
+STATISTIC(NumKeptSize, "Number of mallocs kept because their size is not small");
+STATISTIC(NumKeptEscape, "Number of mallocs kept because their pointer escapes");
+
+namespace {
+	// Frees of the memory given by Malloc, whose size is at most Size
+	struct Promotion {
+		CallInst *Malloc;
+		uint64_t Size;
+		bool InLoop;
+		SmallVector<CallInst*, 4> Frees;
+	};
+
+	class HeapToStack : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		AliasSets *AS;
+		DenseMap<int, std::set<Value*> > Sets;
+
+	public:
+		static char ID;
+		HeapToStack() : ModulePass(ID), RA(NULL), AS(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool getSize(CallInst *Malloc, uint64_t &Size);
+		bool collectUses(Value *Root, Function *F, bool InLoop, unsigned Depth,
+				SmallPtrSet<Value*, 16> &Derived, SmallVectorImpl<CallInst*> &Frees);
+		bool isMergedOnlyWith(const SmallPtrSet<Value*, 16> &Derived) const;
+		bool isAliasedOnlyWith(Value *V, const SmallPtrSet<Value*, 16> &Derived);
+		void promote(Promotion &P);
+	};
+}
+
+char HeapToStack::ID = 0;
+static RegisterPass<HeapToStack> X("range-heap-to-stack",
+"Move small mallocs to the stack using range analysis", false, false);
+
+void HeapToStack::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+	AU.addRequired<DepGraphCache>();
+}
+
+static bool isCallTo(const Instruction *I, StringRef Name) {
+	const CallInst *CI = dyn_cast<CallInst>(I);
+	if (!CI)
+		return false;
+
+	const Function *Callee = CI->getCalledFunction();
+	return Callee && Callee->isDeclaration() && Callee->getName() == Name
+		&& CI->getNumArgOperands() == 1;
+}
+
+// True if BB is in a cycle of the CFG
+static bool isInLoop(BasicBlock *BB) {
+	SmallPtrSet<BasicBlock*, 32> Visited;
+	SmallVector<BasicBlock*, 32> Worklist;
+
+	TerminatorInst *TI = BB->getTerminator();
+	for (unsigned i = 0, e = TI->getNumSuccessors(); i < e; ++i)
+		Worklist.push_back(TI->getSuccessor(i));
+
+	while (!Worklist.empty()) {
+		BasicBlock *Succ = Worklist.pop_back_val();
+		if (Succ == BB)
+			return true;
+		if (!Visited.insert(Succ))
+			continue;
+
+		TI = Succ->getTerminator();
+		for (unsigned i = 0, e = TI->getNumSuccessors(); i < e; ++i)
+			Worklist.push_back(TI->getSuccessor(i));
+	}
+
+	return false;
+}
+
+bool HeapToStack::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+	AS = &getAnalysis<DepGraphCache>().getAliasSets(M);
+	Sets = AS->getValueSets();
+
+	bool Changed = false;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		if (Fit->isDeclaration())
+			continue;
+
+		// Decide every malloc of the function before changing it
+		SmallVector<Promotion, 8> Promotions;
+		uint64_t FrameBytes = 0;
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			if (!isCallTo(&*I, "malloc"))
+				continue;
+
+			++NumMallocs;
+			Promotion P;
+			P.Malloc = cast<CallInst>(&*I);
+			if (!getSize(P.Malloc, P.Size) || FrameBytes + P.Size > MaxFrame) {
+				++NumKeptSize;
+				continue;
+			}
+
+			P.InLoop = isInLoop(P.Malloc->getParent());
+
+			SmallPtrSet<Value*, 16> Derived;
+			if (!collectUses(P.Malloc, Fit, P.InLoop, 0, Derived, P.Frees)
+					|| !isMergedOnlyWith(Derived)
+					|| !isAliasedOnlyWith(P.Malloc, Derived)) {
+				++NumKeptEscape;
+				continue;
+			}
+
+			FrameBytes += P.Size;
+			Promotions.push_back(P);
+		}
+
+		for (unsigned i = 0, e = Promotions.size(); i < e; ++i)
+			promote(Promotions[i]);
+
+		Changed |= !Promotions.empty();
+	}
+
+	return Changed;
+}
+
+// Upper bound of the size allocated by Malloc. Fails if the size may be
+// larger than MaxSize, or negative, i.e. huge as an unsigned number.
+bool HeapToStack::getSize(CallInst *Malloc, uint64_t &Size) {
+	Value *V = Malloc->getArgOperand(0);
+	if (!V->getType()->isIntegerTy())
+		return false;
+
+	APInt Lower, Upper;
+	if (ConstantInt *CI = dyn_cast<ConstantInt>(V)) {
+		Lower = Upper = CI->getValue();
+	} else {
+		Range R = RA->getRange(V);
+		if (!R.isRegular() || R.getLower().eq(RA->getMin()) || R.getUpper().eq(RA->getMax()))
+			return false;
+
+		Lower = R.getLower();
+		Upper = R.getUpper();
+	}
+
+	if (Lower.isNegative() || Upper.ugt(MaxSize))
+		return false;
+
+	// malloc(0) still returns a pointer that can be compared
+	Size = std::max<uint64_t>(Upper.getZExtValue(), 1);
+	return true;
+}
+
+// Adds to Derived the pointers computed from Root in F, and to Frees the
+// calls that release them. Fails if one of them escapes. Pointers passed to
+// a defined function are followed into it, with Depth the number of calls
+// followed; the callee must not free them.
+bool HeapToStack::collectUses(Value *Root, Function *F, bool InLoop, unsigned Depth,
+		SmallPtrSet<Value*, 16> &Derived, SmallVectorImpl<CallInst*> &Frees) {
+	SmallVector<Value*, 16> Worklist;
+	Derived.insert(Root);
+	Worklist.push_back(Root);
+
+	while (!Worklist.empty()) {
+		Value *V = Worklist.pop_back_val();
+
+		for (Value::use_iterator UI = V->use_begin(), E = V->use_end(); UI != E; ++UI) {
+			Instruction *I = dyn_cast<Instruction>(*UI);
+			if (!I)
+				return false;
+
+			// Only the latest pointer of a malloc in a loop may be live
+			if (isa<PHINode>(I) && InLoop)
+				return false;
+
+			if (isa<BitCastInst>(I) || isa<GetElementPtrInst>(I)
+					|| isa<PHINode>(I) || isa<SelectInst>(I)) {
+				if (isa<SelectInst>(I) && I->getOperand(0) == V)
+					return false;
+				if (Derived.insert(I))
+					Worklist.push_back(I);
+				continue;
+			}
+
+			if (isa<LoadInst>(I) || isa<ICmpInst>(I))
+				continue;
+
+			if (StoreInst *SI = dyn_cast<StoreInst>(I)) {
+				if (SI->getValueOperand() == V)
+					return false;
+				continue;
+			}
+
+			CallInst *CI = dyn_cast<CallInst>(I);
+			if (!CI || CI->getCalledValue() == V)
+				return false;
+
+			if (isa<MemIntrinsic>(CI) || isa<DbgInfoIntrinsic>(CI))
+				continue;
+
+			if (IntrinsicInst *II = dyn_cast<IntrinsicInst>(CI)) {
+				if (II->getIntrinsicID() == Intrinsic::lifetime_start
+						|| II->getIntrinsicID() == Intrinsic::lifetime_end)
+					continue;
+				return false;
+			}
+
+			if (isCallTo(CI, "free")) {
+				if (Depth > 0)
+					return false;
+				Frees.push_back(CI);
+				continue;
+			}
+
+			Function *Callee = CI->getCalledFunction();
+			if (!Callee || Callee->isDeclaration() || Callee->isVarArg()
+					|| Callee == F || Depth >= 2)
+				return false;
+
+			unsigned ArgNo = 0;
+			for (Function::arg_iterator Ait = Callee->arg_begin(), Aend = Callee->arg_end();
+					Ait != Aend; ++Ait, ++ArgNo) {
+				if (CI->getArgOperand(ArgNo) != V || Derived.count(Ait))
+					continue;
+
+				if (!collectUses(Ait, Callee, false, Depth + 1, Derived, Frees))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// True if the phis and selects of Derived only merge pointers of Derived
+// and null, so a free of one of them only releases the malloc
+bool HeapToStack::isMergedOnlyWith(const SmallPtrSet<Value*, 16> &Derived) const {
+	for (SmallPtrSet<Value*, 16>::const_iterator it = Derived.begin(), e = Derived.end(); it != e; ++it) {
+		const Instruction *I = dyn_cast<Instruction>(*it);
+		if (!I || (!isa<PHINode>(I) && !isa<SelectInst>(I)))
+			continue;
+
+		for (unsigned i = isa<SelectInst>(I) ? 1 : 0, n = I->getNumOperands(); i < n; ++i) {
+			const Value *Op = I->getOperand(i);
+			if (!Derived.count(const_cast<Value*>(Op))
+					&& !isa<ConstantPointerNull>(Op) && !isa<UndefValue>(Op))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// True if the alias set of V only holds pointers of Derived. Arguments of
+// declarations are not taken into account: the only ones Derived reaches
+// are those of free and of the intrinsics, which do not keep the pointer.
+bool HeapToStack::isAliasedOnlyWith(Value *V, const SmallPtrSet<Value*, 16> &Derived) {
+	int Key = AS->getValueSetKey(V);
+	if (!Key)
+		return true;
+
+	const std::set<Value*> &Set = Sets[Key];
+	for (std::set<Value*>::const_iterator it = Set.begin(), e = Set.end(); it != e; ++it) {
+		if (Derived.count(*it) || isa<Constant>(*it))
+			continue;
+
+		Argument *A = dyn_cast<Argument>(*it);
+		if (A && A->getParent()->isDeclaration())
+			continue;
+
+		return false;
+	}
+
+	return true;
+}
+
+void HeapToStack::promote(Promotion &P) {
+	CallInst *Malloc = P.Malloc;
+	LLVMContext &Ctx = Malloc->getContext();
+	Instruction *InsertPt = Malloc->getParent()->getParent()->getEntryBlock().getFirstInsertionPt();
+
+	// malloc returns memory aligned for any type
+	Type *BufferTy = ArrayType::get(Type::getInt8Ty(Ctx), P.Size);
+	AllocaInst *Buffer = new AllocaInst(BufferTy, NULL, 16, Malloc->getName() + ".stack", InsertPt);
+	Instruction *Ptr = new BitCastInst(Buffer, Malloc->getType(), "", InsertPt);
+
+	Ptr->takeName(Malloc);
+	Malloc->replaceAllUsesWith(Ptr);
+	Malloc->eraseFromParent();
+
+	for (unsigned i = 0, e = P.Frees.size(); i < e; ++i)
+		P.Frees[i]->eraseFromParent();
+
+	++NumPromoted;
+	if (P.InLoop)
+		++NumHoisted;
+	NumFreesRemoved += P.Frees.size();
+	NumBytes += P.Size;
+}
@@ -0,0 +1,308 @@
+//===- MemSpecialization.cpp - Specialize memory calls by length ----------===//
+//
+// This pass specializes the calls to memcpy, memmove and memset, either the
+// intrinsics or the C library functions, whose lengths are not constant but
+// have ranges the range analysis bounds:
+//
+// - a length with a single value becomes a constant, so the code generator
+//   expands the call into moves;
+// - a length of at most 31 bytes is dispatched on its size class. A length
+//   in [k, 2k - 1], with k a power of two up to 16, is copied by two moves
+//   of k bytes, one at the beginning and one at the end, that overlap. All
+//   the loads are done before the stores, so memmove is also correct. Only
+//   the classes the range reaches are tested;
+// - a length with at most -ms-max-cases values goes through a switch, with
+//   one call of constant length per value, and the original call for any
+//   other value.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-mem-specialization"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include <algorithm>
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+MaxCases("ms-max-cases", cl::desc("Largest number of lengths a call is specialized for with a switch."), cl::init(8));
+
+STATISTIC(NumCalls, "Number of memcpy, memmove and memset calls with variable lengths");
+STATISTIC(NumConstant, "Number of calls whose length became a constant");
+STATISTIC(NumClasses, "Number of calls dispatched on size classes");
+STATISTIC(NumSwitched, "Number of calls specialized with a switch");
+
+// Largest length the size classes handle: two moves of 16 bytes
+static const uint64_t MaxClassLength = 31;
+
+namespace {
+	// A call to memcpy, memmove or memset, and the bounds of its length
+	struct MemCall {
+		CallInst *Call;
+		bool IsSet;
+		uint64_t Lower, Upper;
+	};
+
+	class MemSpecialization : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+
+	public:
+		static char ID;
+		MemSpecialization() : ModulePass(ID), RA(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool match(Instruction *I, MemCall &MC);
+		void dispatchClasses(const MemCall &MC);
+		void emitClass(IRBuilder<> &Builder, const MemCall &MC, unsigned K,
+				Value *Dst, Value *Src);
+		void dispatchSwitch(const MemCall &MC);
+	};
+}
+
+char MemSpecialization::ID = 0;
+static RegisterPass<MemSpecialization> X("range-mem-specialization",
+"Specialize memcpy, memmove and memset for the ranges of their lengths", false, false);
+
+void MemSpecialization::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool MemSpecialization::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+
+	// Decide with the ranges of the original code, then change it
+	SmallVector<MemCall, 16> Calls;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			MemCall MC;
+			if (match(&*I, MC))
+				Calls.push_back(MC);
+		}
+	}
+
+	bool Changed = false;
+	for (unsigned i = 0, e = Calls.size(); i < e; ++i) {
+		MemCall &MC = Calls[i];
+		Value *Len = MC.Call->getArgOperand(2);
+
+		if (MC.Lower == MC.Upper) {
+			MC.Call->setArgOperand(2, ConstantInt::get(Len->getType(), MC.Lower));
+			++NumConstant;
+		} else if (MC.Upper <= MaxClassLength) {
+			dispatchClasses(MC);
+			++NumClasses;
+		} else if (MC.Upper - MC.Lower < MaxCases) {
+			dispatchSwitch(MC);
+			++NumSwitched;
+		} else {
+			continue;
+		}
+
+		Changed = true;
+	}
+
+	return Changed;
+}
+
+// Matches calls to memcpy, memmove and memset with a variable length that
+// the ranges bound
+bool MemSpecialization::match(Instruction *I, MemCall &MC) {
+	CallInst *CI = dyn_cast<CallInst>(I);
+	if (!CI)
+		return false;
+
+	if (MemIntrinsic *MI = dyn_cast<MemIntrinsic>(CI)) {
+		if (MI->isVolatile())
+			return false;
+		MC.IsSet = isa<MemSetInst>(MI);
+	} else {
+		Function *Callee = CI->getCalledFunction();
+		if (!Callee || !Callee->isDeclaration() || CI->getNumArgOperands() != 3)
+			return false;
+
+		StringRef Name = Callee->getName();
+		if (Name != "memcpy" && Name != "memmove" && Name != "memset")
+			return false;
+		MC.IsSet = Name == "memset";
+
+		// The library functions return their destination
+		if (!CI->use_empty() && CI->getType() != CI->getArgOperand(0)->getType())
+			return false;
+	}
+
+	if (!CI->getArgOperand(0)->getType()->isPointerTy()
+			|| (!MC.IsSet && !CI->getArgOperand(1)->getType()->isPointerTy())
+			|| (MC.IsSet && !CI->getArgOperand(1)->getType()->isIntegerTy()))
+		return false;
+
+	Value *Len = CI->getArgOperand(2);
+	if (isa<Constant>(Len) || !Len->getType()->isIntegerTy())
+		return false;
+
+	++NumCalls;
+
+	Range R = RA->getRange(Len);
+	if (!R.isRegular() || R.getLower().eq(RA->getMin()) || R.getUpper().eq(RA->getMax()))
+		return false;
+
+	// A negative length is a huge unsigned one
+	if (R.getLower().isNegative() || !R.getUpper().isIntN(64))
+		return false;
+
+	MC.Call = CI;
+	MC.Lower = R.getLower().getZExtValue();
+	MC.Upper = R.getUpper().getZExtValue();
+	return true;
+}
+
+// Replaces the call by a chain of tests of its length, one per size class
+// that the range of the length reaches
+void MemSpecialization::dispatchClasses(const MemCall &MC) {
+	CallInst *Call = MC.Call;
+	Function *F = Call->getParent()->getParent();
+	LLVMContext &Ctx = Call->getContext();
+	Value *Len = Call->getArgOperand(2);
+	Type *LenTy = Len->getType();
+
+	if (!Call->use_empty())
+		Call->replaceAllUsesWith(Call->getArgOperand(0));
+
+	BasicBlock *BB = Call->getParent();
+	BasicBlock *Tail = BB->splitBasicBlock(Call, "mem.tail");
+	BB->getTerminator()->eraseFromParent();
+
+	IRBuilder<> Builder(BB);
+	Type *Int8PtrTy = Builder.getInt8PtrTy(Call->getArgOperand(0)->getType()->getPointerAddressSpace());
+	Value *Dst = Builder.CreatePointerCast(Call->getArgOperand(0), Int8PtrTy);
+	Value *Src = NULL;
+	if (!MC.IsSet) {
+		Type *SrcTy = Builder.getInt8PtrTy(Call->getArgOperand(1)->getType()->getPointerAddressSpace());
+		Src = Builder.CreatePointerCast(Call->getArgOperand(1), SrcTy);
+	}
+
+	if (MC.Lower == 0) {
+		BasicBlock *Next = BasicBlock::Create(Ctx, "mem.check", F, Tail);
+		Builder.CreateCondBr(Builder.CreateICmpEQ(Len, ConstantInt::get(LenTy, 0)), Tail, Next);
+		Builder.SetInsertPoint(Next);
+	}
+
+	// Class K holds the lengths in [K, 2K - 1]
+	SmallVector<unsigned, 5> Classes;
+	for (unsigned K = 1; K <= 16; K *= 2)
+		if (K <= MC.Upper && 2 * K - 1 >= std::max<uint64_t>(MC.Lower, 1))
+			Classes.push_back(K);
+
+	for (unsigned i = 0, e = Classes.size(); i < e; ++i) {
+		unsigned K = Classes[i];
+		BasicBlock *ClassBB = BasicBlock::Create(Ctx, "mem.class" + Twine(K), F, Tail);
+
+		if (i + 1 < e) {
+			BasicBlock *Next = BasicBlock::Create(Ctx, "mem.check", F, Tail);
+			Value *InClass = Builder.CreateICmpULT(Len, ConstantInt::get(LenTy, 2 * K));
+			Builder.CreateCondBr(InClass, ClassBB, Next);
+			Builder.SetInsertPoint(Next);
+		} else {
+			Builder.CreateBr(ClassBB);
+		}
+
+		IRBuilder<> ClassBuilder(ClassBB);
+		emitClass(ClassBuilder, MC, K, Dst, Src);
+		ClassBuilder.CreateBr(Tail);
+	}
+
+	Call->eraseFromParent();
+}
+
+// Moves, or sets, the first K and the last K bytes of a length in
+// [K, 2K - 1]
+void MemSpecialization::emitClass(IRBuilder<> &Builder, const MemCall &MC, unsigned K,
+		Value *Dst, Value *Src) {
+	Value *Len = MC.Call->getArgOperand(2);
+	IntegerType *IntTy = Builder.getIntNTy(K * 8);
+
+	// The last K bytes start at Len - K, the first ones when K is 1
+	Value *Last = K > 1 ? Builder.CreateSub(Len, ConstantInt::get(Len->getType(), K)) : NULL;
+
+	Value *DstPtr = Builder.CreatePointerCast(Dst,
+			IntTy->getPointerTo(Dst->getType()->getPointerAddressSpace()));
+
+	Value *First, *Second = NULL;
+	if (MC.IsSet) {
+		// The byte, repeated K times
+		Value *Byte = MC.Call->getArgOperand(1);
+		APInt Ones = APInt::getSplat(K * 8, APInt(8, 1));
+		if (ConstantInt *CI = dyn_cast<ConstantInt>(Byte)) {
+			First = ConstantInt::get(IntTy, Ones * CI->getValue().zextOrTrunc(8).zext(K * 8));
+		} else {
+			Byte = Builder.CreateZExtOrTrunc(Builder.CreateZExtOrTrunc(Byte, Builder.getInt8Ty()), IntTy);
+			First = Builder.CreateMul(Byte, ConstantInt::get(IntTy, Ones));
+		}
+		Second = First;
+	} else {
+		Value *SrcPtr = Builder.CreatePointerCast(Src,
+				IntTy->getPointerTo(Src->getType()->getPointerAddressSpace()));
+		First = Builder.CreateAlignedLoad(SrcPtr, 1);
+		if (Last) {
+			Value *SrcEnd = Builder.CreatePointerCast(Builder.CreateGEP(Src, Last),
+					SrcPtr->getType());
+			Second = Builder.CreateAlignedLoad(SrcEnd, 1);
+		}
+	}
+
+	Builder.CreateAlignedStore(First, DstPtr, 1);
+	if (Last) {
+		Value *DstEnd = Builder.CreatePointerCast(Builder.CreateGEP(Dst, Last),
+				DstPtr->getType());
+		Builder.CreateAlignedStore(Second, DstEnd, 1);
+	}
+}
+
+// Switches on the length, with a call of constant length for each value of
+// its range. The original call handles any other value.
+void MemSpecialization::dispatchSwitch(const MemCall &MC) {
+	CallInst *Call = MC.Call;
+	Function *F = Call->getParent()->getParent();
+	LLVMContext &Ctx = Call->getContext();
+	Value *Len = Call->getArgOperand(2);
+	IntegerType *LenTy = cast<IntegerType>(Len->getType());
+
+	if (!Call->use_empty())
+		Call->replaceAllUsesWith(Call->getArgOperand(0));
+
+	BasicBlock *BB = Call->getParent();
+	BasicBlock::iterator Next = Call;
+	++Next;
+	BasicBlock *Tail = BB->splitBasicBlock(Next, "mem.tail");
+	BasicBlock *Generic = BB->splitBasicBlock(Call, "mem.generic");
+	BB->getTerminator()->eraseFromParent();
+
+	SwitchInst *SI = SwitchInst::Create(Len, Generic, MC.Upper - MC.Lower + 1, BB);
+	for (uint64_t V = MC.Lower; V <= MC.Upper; ++V) {
+		ConstantInt *Length = ConstantInt::get(LenTy, V);
+
+		// Nothing to do for an empty length
+		if (V == 0) {
+			SI->addCase(Length, Tail);
+			continue;
+		}
+
+		BasicBlock *Case = BasicBlock::Create(Ctx, "mem.len" + Twine(V), F, Tail);
+		Instruction *Clone = Call->clone();
+		Clone->setOperand(2, Length);
+		Case->getInstList().push_back(Clone);
+		BranchInst::Create(Tail, Case);
+		SI->addCase(Length, Case);
+	}
+}
@@ -0,0 +1,438 @@
+//===- ProfileSpecialization.cpp - Specialize for profiled ranges ---------===//
+//
+// This pass clones functions for the ranges their arguments took in runs of
+// the program instrumented by RAInstrumentation. The profiles are the
+// RARealValues files that tests/Instrumentation/CompileCharts.sh builds, with
+// one "module.function.value min max" line per value. Lines that name the
+// same value, e.g. from several runs, are merged.
+//
+// An argument is specialized when its profiled range is small, and narrower
+// than the range the static analysis finds. The functions with the most
+// comparisons that depend on such arguments are cloned first, as long as the
+// clones fit in the code growth budget. Each direct call becomes a chain of
+// checks, one comparison per bound, that calls the clone if the arguments are
+// in their profiled ranges, and the original function otherwise. The checks
+// come with sigmas, so the range analysis that runs after this pass binds
+// the arguments of the clones to the profiled ranges, and the passes that
+// use it, such as -range-branch-folding, optimize the clones.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "profile-specialization"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include <algorithm>
+#include <fstream>
+
+using namespace llvm;
+
+static cl::list<std::string>
+ProfileFiles("ps-profile", cl::desc("RARealValues file with the profiled ranges (may be repeated)."), cl::ZeroOrMore);
+
+static cl::opt<unsigned>
+Budget("ps-budget", cl::desc("Code growth allowed for clones, in percent of the instructions of the module."), cl::init(10));
+
+static cl::opt<unsigned>
+MaxRange("ps-max-range", cl::desc("Largest profiled range an argument is specialized for."), cl::init(1024));
+
+static cl::opt<bool, false>
+PrintReport("ps-report", cl::desc("Print the functions specialized and the comparisons the clones decide."), cl::NotHidden);
+
+static const std::string SigmaName = "vSSA_sigma";
+
+STATISTIC(NumArgsProfiled, "Number of arguments with profiled ranges");
+STATISTIC(NumFunctionsCloned, "Number of functions specialized");
+STATISTIC(NumArgsSpecialized, "Number of arguments specialized");
+STATISTIC(NumCallsGuarded, "Number of calls that check for the specialized ranges");
+STATISTIC(NumInstsCloned, "Number of instructions in the clones");
+
+namespace {
+	// Observed range of a value
+	struct Profile {
+		int64_t Min, Max;
+	};
+
+	// A function, the arguments to specialize it for, and their ranges
+	struct Candidate {
+		Function *F;
+		Function *Clone;
+		SmallVector<unsigned, 4> Args;
+		SmallVector<Profile, 4> Ranges;
+		unsigned Size;
+		// Comparisons that depend on the arguments
+		unsigned Gain;
+		unsigned Calls;
+		unsigned DecidedBefore, DecidedAfter;
+	};
+
+	struct ByGain {
+		bool operator()(const Candidate *A, const Candidate *B) const {
+			// Gain per instruction, without dividing
+			return (uint64_t)A->Gain * B->Size > (uint64_t)B->Gain * A->Size;
+		}
+	};
+
+	class ProfileSpecialization : public ModulePass {
+		StringMap<Profile> Profiles;
+		SmallVector<Candidate*, 16> Candidates;
+
+	public:
+		static char ID;
+		ProfileSpecialization() : ModulePass(ID) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool readProfile(const std::string &Filename);
+		Candidate *getCandidate(Function &F, const std::string &Prefix,
+				InterProceduralRA<Cousot> *RA);
+		unsigned countDependentCmps(Candidate *C);
+		unsigned countDecidedCmps(Function *F, InterProceduralRA<Cousot> *RA);
+		void guardCall(CallInst *Call, Candidate *C);
+		void printReport();
+	};
+}
+
+char ProfileSpecialization::ID = 0;
+static RegisterPass<ProfileSpecialization> X("profile-specialization",
+"Specialize functions for the profiled ranges of their arguments", false, false);
+
+void ProfileSpecialization::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool ProfileSpecialization::runOnModule(Module &M) {
+	InterProceduralRA<Cousot> *RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+
+	Profiles.clear();
+	for (unsigned i = 0, e = ProfileFiles.size(); i < e; ++i)
+		if (!readProfile(ProfileFiles[i]))
+			errs() << "Error reading range profile " << ProfileFiles[i] << "\n";
+
+	if (Profiles.empty())
+		return false;
+
+	// Values are named after the module as RAInstrumentation names them
+	std::string Prefix = M.getModuleIdentifier();
+	size_t Pos = Prefix.rfind("/");
+	if (Pos != std::string::npos && Pos > 0)
+		Prefix = Prefix.substr(Pos + 1);
+
+	unsigned ModuleSize = 0;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		if (Fit->isDeclaration())
+			continue;
+
+		for (Function::iterator BBit = Fit->begin(), BBend = Fit->end(); BBit != BBend; ++BBit)
+			ModuleSize += BBit->size();
+
+		if (Candidate *C = getCandidate(*Fit, Prefix, RA))
+			Candidates.push_back(C);
+	}
+
+	std::stable_sort(Candidates.begin(), Candidates.end(), ByGain());
+
+	// Clone the best candidates that fit in the budget
+	uint64_t Left = (uint64_t)ModuleSize * Budget / 100;
+	SmallVector<Candidate*, 16> Chosen;
+	for (unsigned i = 0, e = Candidates.size(); i < e; ++i) {
+		Candidate *C = Candidates[i];
+		if (C->Size > Left)
+			continue;
+
+		Left -= C->Size;
+		C->DecidedBefore = countDecidedCmps(C->F, RA);
+		Chosen.push_back(C);
+	}
+
+	// Clone everything first, so that the calls in the clones are guarded too
+	for (unsigned i = 0, e = Chosen.size(); i < e; ++i) {
+		Candidate *C = Chosen[i];
+		ValueToValueMapTy VMap;
+		C->Clone = CloneFunction(C->F, VMap, false);
+		C->Clone->setName(C->F->getName() + ".spec");
+		C->Clone->setLinkage(GlobalValue::InternalLinkage);
+		M.getFunctionList().push_back(C->Clone);
+
+		++NumFunctionsCloned;
+		NumArgsSpecialized += C->Args.size();
+		NumInstsCloned += C->Size;
+	}
+
+	for (unsigned i = 0, e = Chosen.size(); i < e; ++i) {
+		Candidate *C = Chosen[i];
+
+		SmallVector<CallInst*, 16> Calls;
+		for (Value::use_iterator UI = C->F->use_begin(), E = C->F->use_end(); UI != E; ++UI) {
+			CallInst *Call = dyn_cast<CallInst>(*UI);
+			if (!Call || Call->getCalledValue() != C->F || Call->isMustTailCall())
+				continue;
+
+			// Recursive calls stay in the function they recurse on
+			Function *Caller = Call->getParent()->getParent();
+			if (Caller != C->F && Caller != C->Clone)
+				Calls.push_back(Call);
+		}
+
+		for (unsigned c = 0, ce = Calls.size(); c < ce; ++c)
+			guardCall(Calls[c], C);
+		C->Calls = Calls.size();
+		NumCallsGuarded += Calls.size();
+	}
+
+	// The gains are measured with the ranges of the specialized module
+	if (PrintReport && !Chosen.empty()) {
+		// Kept by the cache, for the passes that run next
+		InterProceduralRA<Cousot> *Fresh = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+		for (unsigned i = 0, e = Chosen.size(); i < e; ++i)
+			Chosen[i]->DecidedAfter = countDecidedCmps(Chosen[i]->Clone, Fresh);
+
+		printReport();
+	}
+
+	bool Changed = !Chosen.empty();
+	for (unsigned i = 0, e = Candidates.size(); i < e; ++i)
+		delete Candidates[i];
+	Candidates.clear();
+
+	return Changed;
+}
+
+bool ProfileSpecialization::readProfile(const std::string &Filename) {
+	std::ifstream File(Filename.c_str());
+	if (!File)
+		return false;
+
+	std::string Name;
+	int64_t Min, Max;
+	while (File >> Name >> Min >> Max) {
+		StringMap<Profile>::iterator it = Profiles.find(Name);
+		if (it == Profiles.end()) {
+			Profile P = { Min, Max };
+			Profiles[Name] = P;
+			continue;
+		}
+
+		it->second.Min = std::min(it->second.Min, Min);
+		it->second.Max = std::max(it->second.Max, Max);
+	}
+
+	return true;
+}
+
+// F, with the arguments whose profiled ranges are small and narrower than
+// their static ranges, or NULL if there are none
+Candidate *ProfileSpecialization::getCandidate(Function &F, const std::string &Prefix,
+		InterProceduralRA<Cousot> *RA) {
+	if (F.isDeclaration() || F.isVarArg())
+		return NULL;
+
+	// Only direct calls from other functions can reach the clone
+	bool Called = false;
+	for (Value::use_iterator UI = F.use_begin(), E = F.use_end(); UI != E && !Called; ++UI) {
+		CallInst *Call = dyn_cast<CallInst>(*UI);
+		Called = Call && Call->getCalledValue() == &F && Call->getParent()->getParent() != &F;
+	}
+
+	if (!Called)
+		return NULL;
+
+	Candidate *C = new Candidate();
+	C->F = &F;
+	C->Clone = NULL;
+	C->Size = 0;
+	C->Calls = C->DecidedBefore = C->DecidedAfter = 0;
+
+	unsigned Idx = 0;
+	for (Function::arg_iterator A = F.arg_begin(), E = F.arg_end(); A != E; ++A, ++Idx) {
+		if (!A->getType()->isIntegerTy() || !A->hasName())
+			continue;
+
+		StringMap<Profile>::iterator it = Profiles.find(Prefix + "." + F.getName().str()
+				+ "." + A->getName().str());
+		if (it == Profiles.end())
+			continue;
+
+		++NumArgsProfiled;
+		const Profile &P = it->second;
+		unsigned Width = A->getType()->getIntegerBitWidth();
+		if (P.Min > P.Max || (uint64_t)(P.Max - P.Min) >= MaxRange || Width > 64)
+			continue;
+
+		// The profile must fit the type, and tell more than the analysis
+		APInt Min = APInt::getSignedMinValue(Width), Max = APInt::getSignedMaxValue(Width);
+		if (P.Min < Min.getSExtValue() || P.Max > Max.getSExtValue())
+			continue;
+
+		Range R = RA->getRange(&*A);
+		if (R.isRegular()) {
+			APInt Lower = APInt(R.getLower().getBitWidth(), P.Min, true);
+			APInt Upper = APInt(R.getUpper().getBitWidth(), P.Max, true);
+			if (R.getLower().sge(Lower) && R.getUpper().sle(Upper))
+				continue;
+		}
+
+		C->Args.push_back(Idx);
+		C->Ranges.push_back(P);
+	}
+
+	if (C->Args.empty()) {
+		delete C;
+		return NULL;
+	}
+
+	for (Function::iterator BBit = F.begin(), BBend = F.end(); BBit != BBend; ++BBit)
+		C->Size += BBit->size();
+
+	C->Gain = countDependentCmps(C);
+	if (!C->Gain) {
+		delete C;
+		return NULL;
+	}
+
+	return C;
+}
+
+// Comparisons of C->F whose operands depend on the specialized arguments
+unsigned ProfileSpecialization::countDependentCmps(Candidate *C) {
+	SmallPtrSet<Value*, 32> Dependent;
+	SmallVector<Value*, 32> Worklist;
+
+	Function::arg_iterator A = C->F->arg_begin();
+	for (unsigned i = 0, Idx = 0, e = C->Args.size(); i < e; ++A, ++Idx) {
+		if (Idx != C->Args[i])
+			continue;
+
+		Dependent.insert(&*A);
+		Worklist.push_back(&*A);
+		++i;
+	}
+
+	unsigned Cmps = 0;
+	while (!Worklist.empty()) {
+		Value *V = Worklist.pop_back_val();
+		for (Value::use_iterator UI = V->use_begin(), E = V->use_end(); UI != E; ++UI) {
+			Instruction *U = cast<Instruction>(*UI);
+			if (!U->getType()->isIntegerTy() || !Dependent.insert(U))
+				continue;
+
+			if (isa<ICmpInst>(U))
+				++Cmps;
+			else
+				Worklist.push_back(U);
+		}
+	}
+
+	return Cmps;
+}
+
+// Comparisons of F that the ranges of RA decide
+unsigned ProfileSpecialization::countDecidedCmps(Function *F, InterProceduralRA<Cousot> *RA) {
+	unsigned Decided = 0;
+
+	for (inst_iterator I = inst_begin(*F), E = inst_end(*F); I != E; ++I) {
+		ICmpInst *Cmp = dyn_cast<ICmpInst>(&*I);
+		if (!Cmp || (!Cmp->isSigned() && !Cmp->isEquality()))
+			continue;
+
+		Range A = RA->getRange(Cmp->getOperand(0));
+		Range B = RA->getRange(Cmp->getOperand(1));
+		if (!A.isRegular() || !B.isRegular())
+			continue;
+
+		// Decided if the ranges are apart, or the same single value
+		if (A.getUpper().slt(B.getLower()) || B.getUpper().slt(A.getLower()))
+			++Decided;
+		else if (A.getLower().eq(A.getUpper()) && B.getLower().eq(B.getUpper()))
+			++Decided;
+	}
+
+	return Decided;
+}
+
+// Replaces Call by checks of the specialized arguments, which call the
+// clone if all of them are in their ranges, and the function otherwise. Each
+// check compares one bound, and the value checked gets a sigma, as vSSA
+// would have built for it.
+void ProfileSpecialization::guardCall(CallInst *Call, Candidate *C) {
+	BasicBlock *Head = Call->getParent();
+	Function *Caller = Head->getParent();
+	LLVMContext &Ctx = Caller->getContext();
+
+	BasicBlock *Tail = Head->splitBasicBlock(Call, "spec.tail");
+	Head->getTerminator()->eraseFromParent();
+
+	BasicBlock *Orig = BasicBlock::Create(Ctx, "spec.orig", Caller, Tail);
+	Call->removeFromParent();
+	Orig->getInstList().push_back(Call);
+	BranchInst::Create(Tail, Orig);
+
+	SmallVector<Value*, 8> Args(Call->op_begin(), Call->op_begin() + Call->getNumArgOperands());
+	BasicBlock *Current = Head;
+	for (unsigned i = 0, e = C->Args.size(); i < e; ++i) {
+		unsigned Idx = C->Args[i];
+		IntegerType *Ty = cast<IntegerType>(Args[Idx]->getType());
+		Constant *Bounds[] = {
+			ConstantInt::get(Ty, C->Ranges[i].Min, true),
+			ConstantInt::get(Ty, C->Ranges[i].Max, true)
+		};
+		ICmpInst::Predicate Preds[] = { ICmpInst::ICMP_SGE, ICmpInst::ICMP_SLE };
+
+		for (unsigned b = 0; b < 2; ++b) {
+			Value *Cmp = new ICmpInst(*Current, Preds[b], Args[Idx], Bounds[b],
+					Args[Idx]->getName() + ".inrange");
+			BasicBlock *Next = BasicBlock::Create(Ctx, "spec.check", Caller, Orig);
+			BranchInst::Create(Next, Orig, Cmp, Current);
+
+			PHINode *Sigma = PHINode::Create(Ty, 1, SigmaName, Next);
+			Sigma->addIncoming(Args[Idx], Current);
+			Args[Idx] = Sigma;
+			Current = Next;
+		}
+	}
+
+	CallInst *Spec = CallInst::Create(C->Clone, Args, "", Current);
+	Spec->setCallingConv(Call->getCallingConv());
+	Spec->setAttributes(Call->getAttributes());
+	Spec->setTailCall(Call->isTailCall());
+	Spec->setDebugLoc(Call->getDebugLoc());
+	BranchInst::Create(Tail, Current);
+
+	if (Call->getType()->isVoidTy())
+		return;
+
+	PHINode *Result = PHINode::Create(Call->getType(), 2, "", &Tail->front());
+	Call->replaceAllUsesWith(Result);
+	Result->takeName(Call);
+	Result->addIncoming(Spec, Current);
+	Result->addIncoming(Call, Orig);
+}
+
+void ProfileSpecialization::printReport() {
+	errs() << "Function\tArguments\tSize\tCalls\tDecided before\tDecided in clone\n";
+
+	for (unsigned i = 0, e = Candidates.size(); i < e; ++i) {
+		Candidate *C = Candidates[i];
+		if (!C->Clone)
+			continue;
+
+		errs() << C->F->getName() << "\t";
+		for (unsigned a = 0, ae = C->Args.size(); a < ae; ++a)
+			errs() << (a ? " " : "") << "#" << C->Args[a] << "[" << C->Ranges[a].Min
+					<< ", " << C->Ranges[a].Max << "]";
+		errs() << "\t" << C->Size << "\t" << C->Calls << "\t" << C->DecidedBefore
+				<< "\t" << C->DecidedAfter << "\n";
+	}
+}
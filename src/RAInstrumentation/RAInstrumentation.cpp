@@ -129,7 +129,34 @@ bool RAInstrumentation::runOnModule(Module &M) {
 		// Empty functions include externally linked ones (i.e. abort, printf, scanf, ...)
 		if (Fit->begin() == Fit->end())
 			continue;
-        
+
+		// Arguments are recorded once, at the entry of the function
+		Instruction* entryInstruction = Fit->getEntryBlock().getFirstInsertionPt();
+
+		for (Function::arg_iterator Ait = Fit->arg_begin(), Aend = Fit->arg_end(); Ait != Aend; ++Ait) {
+
+			if (!Ait->getType()->isIntegerTy(BIT_WIDTH))
+				continue;
+
+			File << mIdentifier
+				 << "." << Fit->getName()
+				 << "." << Ait->getName()
+				 << " " << (int)cast<Value>(Ait) << "\n";
+
+			Constant* constInt = ConstantInt::get(Type::getInt32Ty(*context), (uint64_t)cast<Value>(Ait));
+			Value* constPtr = ConstantExpr::getIntToPtr(constInt, PointerType::getUnqual(Type::getInt8Ty(*context)));
+
+			std::vector<Value*> setCurrentMinMaxArgs;
+			setCurrentMinMaxArgs.push_back(constPtr);
+			setCurrentMinMaxArgs.push_back(Ait);
+
+			Function& setCurrentMinMax = GetSetCurrentMinMaxFunction();
+			CallInst* callSetCurrentMinMax = CallInst::Create(&setCurrentMinMax, setCurrentMinMaxArgs, "", entryInstruction);
+			MarkAsNotOriginal(*callSetCurrentMinMax);
+
+			++raInstrumentationNumInstructions;
+		}
+
 		// Iterate through basic blocks		
 		for (Function::iterator BBit = Fit->begin(), BBend = Fit->end(); BBit != BBend; ++BBit) {
 
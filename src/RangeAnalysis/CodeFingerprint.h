@@ -0,0 +1,65 @@
+//===-------------------------- CodeFingerprint.h -------------------------===//
+//===-----Hashes of the code read by the analyses that are kept around-----===//
+//
+//					 The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// The caches of the range analysis, of the dependence graphs and of the
+// ranged alias tables live in libraries of their own, so the fingerprint is
+// defined in the header.
+//
+// It covers what the analyses read: the instructions, their operands, types,
+// predicates and names, since sigmas are recognized by name. Metadata is not
+// part of it, so passes that only annotate the code, such as -range-metadata,
+// do not invalidate the results.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_RANGEANALYSIS_CODEFINGERPRINT_H_
+#define LLVM_TRANSFORMS_RANGEANALYSIS_CODEFINGERPRINT_H_
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+
+/// Changes whenever the code of F changes.
+inline hash_code codeFingerprint(const Function &F) {
+	hash_code H = hash_combine(&F, F.getFunctionType(), F.getName());
+
+	for (Function::const_arg_iterator A = F.arg_begin(), E = F.arg_end(); A != E; ++A)
+		H = hash_combine(H, &*A);
+
+	for (Function::const_iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+		H = hash_combine(H, &*BB);
+
+		for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+			H = hash_combine(H, &*I, I->getOpcode(), I->getType(), I->getName());
+
+			if (const CmpInst *Cmp = dyn_cast<CmpInst>(I))
+				H = hash_combine(H, (unsigned)Cmp->getPredicate());
+
+			for (unsigned i = 0, e = I->getNumOperands(); i < e; ++i)
+				H = hash_combine(H, I->getOperand(i));
+		}
+	}
+
+	return H;
+}
+
+/// Changes whenever a function of M changes, or is added or removed.
+inline hash_code codeFingerprint(const Module &M) {
+	hash_code H = hash_value(&M);
+
+	for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
+		H = hash_combine(H, F->isDeclaration() ? hash_value(&*F) : codeFingerprint(*F));
+
+	return H;
+}
+
+#endif /* LLVM_TRANSFORMS_RANGEANALYSIS_CODEFINGERPRINT_H_ */
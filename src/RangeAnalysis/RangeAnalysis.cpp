@@ -15,9 +15,24 @@
 #define DEBUG_TYPE "range-analysis"
 
 #include "RangeAnalysis.h"
+#include "RangeSummaryFormat.h"
+#include "../vSSA/ESSAOverlay.h"
+#include "llvm/Support/CommandLine.h"
 
 using namespace llvm;
 
+static cl::opt<bool> RAEssaOverlay("ra-essa-overlay",
+		cl::desc("Build the constraint graph from a virtual e-SSA form instead of sigmas in the IR"),
+		cl::init(false));
+
+cl::opt<bool> RASeparateModules("ra-separate-modules",
+		cl::desc("Do not assume the module is the whole program: externally visible functions may be called from other modules"),
+		cl::init(false));
+
+cl::opt<std::string> RASummaryIndex("ra-summary-index",
+		cl::desc("Import the ranges of a range summary index built by range-summary-merge (implies -ra-separate-modules)"),
+		cl::value_desc("filename"), cl::init(""));
+
 // These macros are used to get stats regarding the precision of our analysis.
 STATISTIC(usedBits, "Initial number of bits.");
 STATISTIC(needBits, "Needed bits.");
@@ -76,7 +91,7 @@ static void printVarName(const Value *V, raw_ostream& OS) {
 
 	if ((A = dyn_cast<Argument>(V))) {
 		OS << A->getParent()->getName() << "." << A->getName();
-	} else if ((I = dyn_cast<Instruction>(V))) {
+	} else if ((I = dyn_cast<Instruction>(V)) && I->getParent()) {
 		OS << I->getParent()->getParent()->getName() << "."
 			<< I->getParent()->getName() << "." << I->getName();
 	} else {
@@ -280,6 +295,7 @@ bool InterProceduralRA<CGT>::runOnModule(Module &M) {
 
 	MAX_BIT_INT = getMaxBitWidth(M);
 	updateMinMax(MAX_BIT_INT);
+	importRanges(M);
 
 	// Build the Constraint Graph by running on each function
 #ifdef STATS
@@ -295,6 +311,12 @@ bool InterProceduralRA<CGT>::runOnModule(Module &M) {
 	}
 	CG->buildVarNodes();
 
+	// The values that come from other modules are not defined in the graph,
+	// and keep the ranges they were given
+	for (DenseMap<const Value*, Range>::iterator it = Imported.begin(),
+			e = Imported.end(); it != e; ++it)
+		CG->addVarNode(it->first)->setRange(it->second);
+
 #ifdef STATS
 	Profile::TimeValue elapsed = prof.timenow() - before;
 	prof.updateTime("BuildGraph", elapsed);
@@ -320,6 +342,67 @@ void InterProceduralRA<CGT>::getAnalysisUsage(AnalysisUsage &AU) const {
 	AU.setPreservesAll();
 }
 
+// Converts a bound of the summary index to the width of the analysis
+static APInt toAnalysisBound(int64_t v) {
+	if (v == INT64_MIN || (MAX_BIT_INT < 64 && v <= Min.getSExtValue()))
+		return Min;
+	if (v == INT64_MAX || (MAX_BIT_INT < 64 && v >= Max.getSExtValue()))
+		return Max;
+	return APInt(MAX_BIT_INT, v, true);
+}
+
+static Range toAnalysisRange(const SummaryRange &R) {
+	// Nothing reaches the value in the index, so it is dead code
+	if (R.empty)
+		return Range(Min, Max);
+	return Range(toAnalysisBound(R.lower), toAnalysisBound(R.upper));
+}
+
+template<class CGT>
+void InterProceduralRA<CGT>::importRanges(Module &M) {
+	Imported.clear();
+	if (!RASeparateModules && RASummaryIndex.empty())
+		return;
+
+	// Without an index, values from other modules may take any value
+	RangeIndex Index;
+	if (!RASummaryIndex.empty() && !Index.read(RASummaryIndex)) {
+		errs() << "Error reading range summary index " << RASummaryIndex
+				<< ", its ranges are not imported\n";
+		// A failed read may leave the lines before the error in Index
+		Index = RangeIndex();
+	}
+
+	for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+		if (F->hasLocalLinkage() || F->isIntrinsic() || F->isVarArg())
+			continue;
+
+		if (!F->isDeclaration()) {
+			// F may be called from other modules: its arguments take the
+			// ranges of all the call sites of the program
+			unsigned i = 0;
+			for (Function::arg_iterator A = F->arg_begin(), AE = F->arg_end();
+					A != AE; ++A, ++i)
+				if (A->getType()->isIntegerTy())
+					Imported[A] = toAnalysisRange(Index.getArgument(F->getName().str(), i));
+			continue;
+		}
+
+		SummaryRange R = Index.getReturn(F->getName().str());
+		if (!F->getReturnType()->isIntegerTy() || R.isFull())
+			continue;
+
+		// F is defined in another module, and returns the values of the index
+		for (Value::use_iterator UI = F->use_begin(), UE = F->use_end();
+				UI != UE; ++UI) {
+			Use *U = &*UI;
+			CallSite CS(U->getUser());
+			if (CS && CS.isCallee(U))
+				Imported[CS.getInstruction()] = toAnalysisRange(R);
+		}
+	}
+}
+
 template<class CGT>
 void InterProceduralRA<CGT>::MatchParametersAndReturnValues(Function &F,
 		ConstraintGraph &G) {
@@ -362,7 +445,8 @@ void InterProceduralRA<CGT>::MatchParametersAndReturnValues(Function &F,
 				continue;
 
 			// Get the return value and insert in the data structure
-			ReturnValues.insert(RI->getReturnValue());
+			if (RI->getNumOperands() > 0)
+				ReturnValues.insert(G.getUsedValue(RI->getOperandUse(0)));
 		}
 	}
 
@@ -370,6 +454,10 @@ void InterProceduralRA<CGT>::MatchParametersAndReturnValues(Function &F,
 	std::vector<PhiOp*> matchers(F.arg_size(), NULL);
 
 	for (unsigned i = 0, e = Parameters.size(); i < e; ++i) {
+		// Imported arguments are not bound to the call sites of the module
+		if (Imported.count(Parameters[i].first))
+			continue;
+
 		VarNode *sink = G.addVarNode(Parameters[i].first);
 
 		matchers[i] = new PhiOp(new BasicInterval(), sink, NULL,
@@ -419,7 +507,7 @@ void InterProceduralRA<CGT>::MatchParametersAndReturnValues(Function &F,
 		CallSite::arg_iterator EI;
 
 		for (i = 0, AI = CS.arg_begin(), EI = CS.arg_end(); AI != EI; ++i, ++AI)
-			Parameters[i].second = *AI;
+			Parameters[i].second = G.getUsedValue(*AI);
 
 		// // Do the interprocedural construction of CG
 		VarNode* to = NULL;
@@ -427,6 +515,9 @@ void InterProceduralRA<CGT>::MatchParametersAndReturnValues(Function &F,
 
 		// Match formal and real parameters
 		for (i = 0; i < Parameters.size(); ++i) {
+			if (!matchers[i])
+				continue;
+
 			// Add real parameter to the CG
 			from = G.addVarNode(Parameters[i].second);
 
@@ -1836,10 +1927,12 @@ void ValueSwitchMap::clear() {
 
 ConstraintGraph::ConstraintGraph() {
 	this->func = NULL;
+	this->overlay = NULL;
 }
 
 /// The dtor.
 ConstraintGraph::~ConstraintGraph() {
+	delete overlay;
 
 	for (VarNodes::iterator vit = vars.begin(), vend = vars.end();
 			vit != vend; ++vit) {
@@ -1892,6 +1985,22 @@ Range ConstraintGraph::getRange(const Value *v) {
 	return vit->second->getRange();
 }
 
+Value *ConstraintGraph::getOperand(const Instruction *I, unsigned i) const {
+	return overlay ? overlay->getOperand(I, i) : I->getOperand(i);
+}
+
+unsigned ConstraintGraph::getNumOperands(const Instruction *I) const {
+	return overlay ? overlay->getNumOperands(I) : I->getNumOperands();
+}
+
+const BasicBlock *ConstraintGraph::getParentBlock(const Instruction *I) const {
+	return overlay ? overlay->getParent(I) : I->getParent();
+}
+
+Value *ConstraintGraph::getUsedValue(const Use &U) const {
+	return overlay ? overlay->getUsedValue(U) : U.get();
+}
+
 /// Adds a VarNode to the graph.
 VarNode* ConstraintGraph::addVarNode(const Value* V) {
 	VarNodes::iterator vit = this->vars.find(V);
@@ -1923,7 +2032,7 @@ void ConstraintGraph::addUnaryOp(const Instruction* I) {
 		case Instruction::Add:
 #endif
 		case Instruction::SExt:
-			source = addVarNode(I->getOperand(0));
+			source = addVarNode(getOperand(I, 0));
 			break;
 		default:
 			return;
@@ -2043,8 +2152,8 @@ void ConstraintGraph::addBinaryOp(const Instruction* I) {
 	VarNode* sink = addVarNode(I);
 
 	// Create the sources.
-	VarNode *source1 = addVarNode(I->getOperand(0));
-	VarNode *source2 = addVarNode(I->getOperand(1));
+	VarNode *source1 = addVarNode(getOperand(I, 0));
+	VarNode *source2 = addVarNode(getOperand(I, 1));
 
 	// Create the operation using the intersect to constrain sink's interval.
 	BasicInterval* BI = new BasicInterval();
@@ -2074,9 +2183,8 @@ void ConstraintGraph::addPhiOp(const PHINode* Phi) {
 	this->defMap[sink->getValue()] = phiOp;
 
 	// Create the sources.
-	for (User::const_op_iterator it = Phi->op_begin(), e = Phi->op_end();
-			it != e; ++it) {
-		VarNode* source = addVarNode(*it);
+	for (unsigned i = 0, e = getNumOperands(Phi); i < e; ++i) {
+		VarNode* source = addVarNode(getOperand(Phi, i));
 		phiOp->addSource(source);
 
 		// Inserts the sources of the operation in the use map list.
@@ -2090,12 +2198,11 @@ void ConstraintGraph::addSigmaOp(const PHINode* Sigma) {
 	BasicInterval* BItv = NULL;
 	SigmaOp* sigmaOp = NULL;
 
-	const BasicBlock *thisbb = Sigma->getParent();
+	const BasicBlock *thisbb = getParentBlock(Sigma);
 
 	// Create the sources (FIXME: sigma has only 1 source. This 'for' may not be needed)
-	for (User::const_op_iterator it = Sigma->op_begin(), e = Sigma->op_end();
-			it != e; ++it) {
-		Value *operand = *it;
+	for (unsigned i = 0, e = getNumOperands(Sigma); i < e; ++i) {
+		Value *operand = getOperand(Sigma, i);
 		VarNode* source = addVarNode(operand);
 
 		// Create the operation (two cases from: branch or switch)
@@ -2196,10 +2303,10 @@ void ConstraintGraph::buildOperations(const Instruction* I) {
 }
 
 void ConstraintGraph::buildValueSwitchMap(const SwitchInst *sw) {
-	const Value *condition = sw->getCondition();
+	const Value *condition = getOperand(sw, 0);
 
 	// Verify conditions
-	const Type* opType = sw->getCondition()->getType();
+	const Type* opType = condition->getType();
 	if (!opType->isIntegerTy()) {
 		return;
 	}
@@ -2213,7 +2320,7 @@ void ConstraintGraph::buildValueSwitchMap(const SwitchInst *sw) {
 	const CastInst *castinst = NULL;
 	const Value *Op0_0 = NULL;
 	if ((castinst = dyn_cast<CastInst>(condition))) {
-		Op0_0 = castinst->getOperand(0);
+		Op0_0 = getOperand(castinst, 0);
 	}
 
 	// Handle 'default', if there is any
@@ -2287,16 +2394,16 @@ void ConstraintGraph::buildValueBranchMap(const BranchInst *br) {
 	}
 
 	// Create VarNodes for comparison operands explicitly (need to do this when inlining is used!)
-	addVarNode(ici->getOperand(0));
-	addVarNode(ici->getOperand(1));
+	addVarNode(getOperand(ici, 0));
+	addVarNode(getOperand(ici, 1));
 
 	// Gets the successors of the current basic block.
 	const BasicBlock *TBlock = br->getSuccessor(0);
 	const BasicBlock *FBlock = br->getSuccessor(1);
 
 	// We have a Variable-Constant comparison.
-	const Value *Op0 = ici->getOperand(0);
-	const Value *Op1 = ici->getOperand(1);
+	const Value *Op0 = getOperand(ici, 0);
+	const Value *Op1 = getOperand(ici, 1);
 	const ConstantInt *constant = NULL;
 	const Value *variable = NULL;
 
@@ -2375,7 +2482,7 @@ void ConstraintGraph::buildValueBranchMap(const BranchInst *br) {
 		// Do the same for the operand of variable (if variable is a cast instruction)
 		const CastInst *castinst = NULL;
 		if ((castinst = dyn_cast<CastInst>(variable))) {
-			const Value *variable_0 = castinst->getOperand(0);
+			const Value *variable_0 = getOperand(castinst, 0);
 
 			BasicInterval* BT = new BasicInterval(TValues);
 			BasicInterval* BF = new BasicInterval(FValues);
@@ -2402,7 +2509,7 @@ void ConstraintGraph::buildValueBranchMap(const BranchInst *br) {
 		// Symbolic intervals for operand of op0 (if op0 is a cast instruction)
 		const CastInst *castinst = NULL;
 		if ((castinst = dyn_cast<CastInst>(Op0))) {
-			const Value* Op0_0 = castinst->getOperand(0);
+			const Value* Op0_0 = getOperand(castinst, 0);
 
 			SymbInterval* STOp1_1 = new SymbInterval(CR, Op1, pred);
 			SymbInterval* SFOp1_1 = new SymbInterval(CR, Op1, invPred);
@@ -2420,7 +2527,7 @@ void ConstraintGraph::buildValueBranchMap(const BranchInst *br) {
 		// Symbolic intervals for operand of op1 (if op1 is a cast instruction)
 		castinst = NULL;
 		if ((castinst = dyn_cast<CastInst>(Op1))) {
-			const Value* Op0_0 = castinst->getOperand(0);
+			const Value* Op0_0 = getOperand(castinst, 0);
 
 			SymbInterval* STOp1_1 = new SymbInterval(CR, Op1, pred);
 			SymbInterval* SFOp1_1 = new SymbInterval(CR, Op1, invPred);
@@ -2613,6 +2720,15 @@ void ConstraintGraph::buildConstantVector(const SmallPtrSet<VarNode*, 32> &compo
 /// Iterates through all instructions in the function and builds the graph.
 void ConstraintGraph::buildGraph(const Function& F) {
 	this->func = &F;
+
+	if (RAEssaOverlay) {
+		if (!overlay) {
+			overlay = new ESSAOverlay();
+		}
+		// The overlay only reads the function
+		overlay->build(const_cast<Function&>(F));
+	}
+
 	buildValueMaps(F);
 
 	for (const_inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
@@ -2632,6 +2748,25 @@ void ConstraintGraph::buildGraph(const Function& F) {
 
 		buildOperations(inst);
 	}
+
+	// Sigmas and phis of the overlay are not in the function
+	if (overlay) {
+		ArrayRef<ESSAOverlay::VirtualDef*> defs = overlay->getVirtualDefs(&F);
+
+		for (unsigned i = 0, e = defs.size(); i < e; ++i) {
+			const PHINode *Phi = defs[i]->Placeholder;
+
+			if (!Phi->getType()->isIntegerTy()) {
+				continue;
+			}
+
+			if (defs[i]->IsSigma) {
+				addSigmaOp(Phi);
+			} else {
+				addPhiOp(Phi);
+			}
+		}
+	}
 }
 
 void ConstraintGraph::buildVarNodes() {
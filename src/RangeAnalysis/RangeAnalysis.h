@@ -763,6 +763,8 @@ typedef DenseMap<const Value*, ValueBranchMap> ValuesBranchMap;
 
 typedef DenseMap<const Value*, ValueSwitchMap> ValuesSwitchMap;
 
+class ESSAOverlay;
+
 /// This class represents our constraint graph. This graph is used to
 /// perform all computations in our analysis.
 class ConstraintGraph {
@@ -790,6 +792,14 @@ class ConstraintGraph {
 		// Vector containing the constants from a SCC
 		// It is cleared at the beginning of every SCC resolution
 		SmallVector<APInt, 2> constantvector;
+		// Virtual e-SSA form of the functions, used instead of sigmas in the
+		// IR when -ra-essa-overlay is given
+		ESSAOverlay *overlay;
+
+		/// Operands and blocks as seen in e-SSA form, through the overlay
+		/// when there is one. Also accept the placeholders of the overlay.
+		Value *getOperand(const Instruction *I, unsigned i) const;
+		unsigned getNumOperands(const Instruction *I) const;
 
 		/// Adds a BinaryOp in the graph.
 		void addBinaryOp(const Instruction* I);
@@ -835,6 +845,10 @@ class ConstraintGraph {
 		virtual ~ConstraintGraph();
 		/// Adds a VarNode in the graph.
 		VarNode* addVarNode(const Value* V);
+		/// The definition that reaches U in e-SSA form.
+		Value *getUsedValue(const Use &U) const;
+		/// The block of I, which may be a placeholder of the overlay.
+		const BasicBlock *getParentBlock(const Instruction *I) const;
 
 		GenOprs* getOprs() {return &oprs;}
 		DefMap* getDefMap() {return &defMap;}
@@ -961,7 +975,16 @@ class InterProceduralRA: public ModulePass, RangeAnalysis{
 		virtual APInt getMin();
 		virtual APInt getMax();
 		virtual Range getRange(const Value *v);
+		/// The solved graph, for clients that need more than the ranges.
+		ConstraintGraph *getConstraintGraph() { return CG; }
 	private:
+		/// Ranges of the values that come from other modules, when the module
+		/// is not the whole program (-ra-separate-modules): the arguments of
+		/// its externally visible functions and the results of calls to
+		/// functions it only declares.
+		DenseMap<const Value*, Range> Imported;
+
+		void importRanges(Module &M);
 		void MatchParametersAndReturnValues(Function &F, ConstraintGraph &G);
 };
 
@@ -977,6 +1000,8 @@ class IntraProceduralRA: public FunctionPass, RangeAnalysis{
 		virtual APInt getMin();
 		virtual APInt getMax();
 		virtual Range getRange(const Value *v);
+		/// The solved graph, for clients that need more than the ranges.
+		ConstraintGraph *getConstraintGraph() { return CG; }
 }; // end of class RangeAnalysis
 
 #endif /* LLVM_TRANSFORMS_RANGEANALYSIS_RANGEANALYSIS_H_ */
@@ -0,0 +1,143 @@
+//===---------------------- RangeAnalysisCache.cpp ------------------------===//
+//===-----Keeps the results of the range analysis across many passes------===//
+//
+//					 The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "ra-cache"
+#include "RangeAnalysisCache.h"
+
+using namespace llvm;
+
+STATISTIC(NumFunctionHits, "Number of function ranges reused");
+STATISTIC(NumFunctionMisses, "Number of function ranges computed");
+STATISTIC(NumModuleHits, "Number of inter-procedural analyses reused");
+STATISTIC(NumModuleMisses, "Number of inter-procedural analyses run");
+
+// The width of the analysis, shared by every analysis that ran
+extern unsigned MAX_BIT_INT;
+
+static void setWidth(unsigned Width) {
+	MAX_BIT_INT = Width;
+	RangeAnalysis::updateMinMax(Width);
+}
+
+// ========================================================================== //
+// FunctionRanges
+// ========================================================================== //
+Range FunctionRanges::getRange(const Value *V) const {
+	DenseMap<const Value*, Range>::const_iterator it = Ranges.find(V);
+	if (it != Ranges.end())
+		return it->second;
+
+	if (const ConstantInt *CI = dyn_cast<ConstantInt>(V)) {
+		APInt C = CI->getValue().sextOrTrunc(Min.getBitWidth());
+		return Range(C, C);
+	}
+
+	return Range(Min, Max, Unknown);
+}
+
+// ========================================================================== //
+// RangeAnalysisCache
+// ========================================================================== //
+char RangeAnalysisCache::ID = 0;
+static RegisterPass<RangeAnalysisCache> C("ra-cache",
+		"Range Analysis results kept across passes", false, true);
+
+RangeAnalysisCache::RangeAnalysisCache() : ImmutablePass(ID) {
+}
+
+RangeAnalysisCache::~RangeAnalysisCache() {
+	for (DenseMap<const Function*, FunctionRanges*>::iterator it = Functions.begin(),
+			e = Functions.end(); it != e; ++it)
+		delete it->second;
+
+	delete ModuleRA.RA;
+	delete ModuleCropRA.RA;
+}
+
+const FunctionRanges &RangeAnalysisCache::getFunctionRanges(const Function &F) {
+	hash_code H = codeFingerprint(F);
+
+	FunctionRanges *&FR = Functions[&F];
+	if (FR && FR->Fingerprint == H) {
+		++NumFunctionHits;
+		return *FR;
+	}
+
+	++NumFunctionMisses;
+	delete FR;
+	FR = new FunctionRanges();
+	FR->Fingerprint = H;
+
+	// The analysis of F must not change the width of the others
+	unsigned SavedWidth = MAX_BIT_INT;
+	setWidth(RangeAnalysis::getMaxBitWidth(F));
+	FR->Min = Min;
+	FR->Max = Max;
+
+	if (!F.isDeclaration()) {
+		Cousot CG;
+		CG.buildGraph(F);
+		CG.buildVarNodes();
+		CG.findIntervals();
+
+		for (Function::const_arg_iterator A = F.arg_begin(), E = F.arg_end(); A != E; ++A)
+			if (A->getType()->isIntegerTy())
+				FR->Ranges[&*A] = CG.getRange(&*A);
+
+		for (const_inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+			if (I->getType()->isIntegerTy())
+				FR->Ranges[&*I] = CG.getRange(&*I);
+	}
+
+	setWidth(SavedWidth);
+	return *FR;
+}
+
+template <class CGT>
+InterProceduralRA<CGT> &RangeAnalysisCache::getModuleResult(ModuleResult<CGT> &R,
+		Module &M) {
+	hash_code H = codeFingerprint(M);
+
+	if (R.Valid && R.Fingerprint == H) {
+		++NumModuleHits;
+		// Other analyses may have run since, with another width
+		setWidth(R.Width);
+		return *R.RA;
+	}
+
+	++NumModuleMisses;
+	delete R.RA;
+	R.RA = new InterProceduralRA<CGT>();
+	R.RA->runOnModule(M);
+	R.Fingerprint = H;
+	R.Width = MAX_BIT_INT;
+	R.Valid = true;
+	return *R.RA;
+}
+
+InterProceduralRA<Cousot> &RangeAnalysisCache::getModuleRA(Module &M) {
+	return getModuleResult(ModuleRA, M);
+}
+
+InterProceduralRA<CropDFS> &RangeAnalysisCache::getModuleCropRA(Module &M) {
+	return getModuleResult(ModuleCropRA, M);
+}
+
+void RangeAnalysisCache::forget(const Function &F) {
+	DenseMap<const Function*, FunctionRanges*>::iterator it = Functions.find(&F);
+	if (it != Functions.end()) {
+		delete it->second;
+		Functions.erase(it);
+	}
+
+	// The inter-procedural analyses hold values of F. They are run again by
+	// the next call, which frees them.
+	ModuleRA.Valid = false;
+	ModuleCropRA.Valid = false;
+}
@@ -0,0 +1,90 @@
+//===----------------------- RangeAnalysisCache.h -------------------------===//
+//===-----Keeps the results of the range analysis across many passes------===//
+//
+//					 The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// The range analyses are passes of the legacy pass manager, so their results
+// are thrown away by the first transform that does not preserve them, and
+// computed again, for the whole module, by the next pass that needs them.
+//
+// This file contains an immutable pass that keeps their results for the whole
+// run of the pass manager, each with a fingerprint of the code it was computed
+// for (see CodeFingerprint.h):
+//
+// - the intra-procedural ranges of ra-intra-cousot are kept per function, and
+//   only the functions that changed are analyzed again;
+// - the inter-procedural analyses of ra-inter-cousot and ra-inter-crop are
+//   kept per module. Their ranges flow through calls, so a change in any
+//   function may change the ranges of every other, and they run again, for
+//   the whole module, after any function changed.
+//
+// The transforms that use the ranges get them from here, so a pipeline of
+// them, or the rounds of -range-branch-folding, only analyze the code again
+// after it changed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_RANGEANALYSIS_RANGEANALYSISCACHE_H_
+#define LLVM_TRANSFORMS_RANGEANALYSIS_RANGEANALYSISCACHE_H_
+
+#include "RangeAnalysis.h"
+#include "CodeFingerprint.h"
+
+/// The ranges of the integer values of a function, as computed by the
+/// intra-procedural analysis, and the fingerprint of the code they hold for.
+class FunctionRanges {
+	public:
+		/// The range of V, unknown if V is not an integer of the function.
+		Range getRange(const Value *V) const;
+		APInt getMin() const {return Min;}
+		APInt getMax() const {return Max;}
+
+	private:
+		friend class RangeAnalysisCache;
+		hash_code Fingerprint;
+		APInt Min, Max;
+		DenseMap<const Value*, Range> Ranges;
+};
+
+class RangeAnalysisCache : public ImmutablePass {
+	public:
+		static char ID; // Pass identification, replacement for typeid
+		RangeAnalysisCache();
+		~RangeAnalysisCache();
+
+		/// The ranges of F, computed again only if F changed since they were
+		/// last computed.
+		const FunctionRanges &getFunctionRanges(const Function &F);
+		/// The inter-procedural analyses of M, run again only if a function of
+		/// M changed since they last ran. They are owned by the cache, and are
+		/// only valid until the next call.
+		InterProceduralRA<Cousot> &getModuleRA(Module &M);
+		InterProceduralRA<CropDFS> &getModuleCropRA(Module &M);
+		/// Drops the ranges of F, and marks the inter-procedural analyses out
+		/// of date. Must be called before F is deleted, since another function
+		/// may be created at its address, with the same fingerprint.
+		void forget(const Function &F);
+
+	private:
+		template <class CGT>
+		struct ModuleResult {
+			InterProceduralRA<CGT> *RA;
+			hash_code Fingerprint;
+			unsigned Width;
+			bool Valid;
+			ModuleResult() : RA(NULL), Width(0), Valid(false) {}
+		};
+
+		template <class CGT>
+		InterProceduralRA<CGT> &getModuleResult(ModuleResult<CGT> &R, Module &M);
+
+		DenseMap<const Function*, FunctionRanges*> Functions;
+		ModuleResult<Cousot> ModuleRA;
+		ModuleResult<CropDFS> ModuleCropRA;
+};
+
+#endif /* LLVM_TRANSFORMS_RANGEANALYSIS_RANGEANALYSISCACHE_H_ */
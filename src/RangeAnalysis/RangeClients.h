@@ -0,0 +1,204 @@
+//===--------------------------- RangeClients.h ---------------------------===//
+//===------Helpers shared by the passes that use the range analysis-------===//
+//
+//					 The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// Each client pass is loaded as a library of its own, so these helpers are
+// defined in the header. The bounds are read from anything with the
+// interface of the analyses, getRange, getMin and getMax, since
+// InterProceduralRA does not expose its RangeAnalysis base. Bounds checks
+// and sigmas are read from the solved constraint graph.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_RANGEANALYSIS_RANGECLIENTS_H_
+#define LLVM_TRANSFORMS_RANGEANALYSIS_RANGECLIENTS_H_
+
+#include "RangeAnalysis.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+
+/// Signed bounds of V, in the width of the analysis. Fails if the analysis
+/// knows nothing about V, or if V is never defined.
+template <class RA>
+inline bool getRegularBounds(RA *A, const Value *V, APInt &Lower, APInt &Upper) {
+	Range R = A->getRange(V);
+	if (!R.isRegular())
+		return false;
+
+	Lower = R.getLower();
+	Upper = R.getUpper();
+	return true;
+}
+
+/// Signed bounds of V, in the width of the analysis. Fails if a bound is
+/// unknown.
+template <class RA>
+inline bool getBounds(RA *A, const Value *V, APInt &Lower, APInt &Upper) {
+	if (const ConstantInt *CI = dyn_cast<ConstantInt>(V)) {
+		Lower = Upper = CI->getValue().sextOrTrunc(A->getMin().getBitWidth());
+		return true;
+	}
+
+	if (!getRegularBounds(A, V, Lower, Upper))
+		return false;
+
+	return !Lower.eq(A->getMin()) && !Upper.eq(A->getMax());
+}
+
+/// As getBounds, but also fails if a bound does not fit in Width bits.
+template <class RA>
+inline bool getBounds(RA *A, const Value *V, unsigned Width, APInt &Lower,
+		APInt &Upper) {
+	if (!getBounds(A, V, Lower, Upper))
+		return false;
+
+	unsigned RangeWidth = Lower.getBitWidth();
+	return Lower.sge(APInt::getSignedMinValue(Width).sext(RangeWidth))
+		&& Upper.sle(APInt::getSignedMaxValue(Width).sext(RangeWidth));
+}
+
+/// True if BB only leads, through unconditional branches, to a block that
+/// calls a function that does not return.
+inline bool isTrap(BasicBlock *BB) {
+	for (unsigned Steps = 0; BB && Steps < 4; ++Steps) {
+		TerminatorInst *TI = BB->getTerminator();
+
+		if (isa<UnreachableInst>(TI)) {
+			for (BasicBlock::iterator I = BB->begin(), E = BB->end(); I != E; ++I)
+				if (CallInst *CI = dyn_cast<CallInst>(I))
+					if (CI->doesNotReturn())
+						return true;
+			return false;
+		}
+
+		BranchInst *Br = dyn_cast<BranchInst>(TI);
+		if (!Br || Br->isConditional())
+			return false;
+
+		BB = Br->getSuccessor(0);
+	}
+
+	return false;
+}
+
+/// A branch that only goes on, to its successor PassIdx, if the check holds.
+/// Either Idx < Len, with Pred ult or slt, or Idx >= 0, with Len NULL. Other
+/// predicates are kept as found, with < and <= in place of > and >=.
+struct BoundsCheck {
+	BranchInst *Br;
+	unsigned PassIdx;
+	const Value *Idx;
+	const Value *Len;
+	CmpInst::Predicate Pred;
+
+	BasicBlock *getPass() const { return Br->getSuccessor(PassIdx); }
+	BasicBlock *getTrap() const { return Br->getSuccessor(1 - PassIdx); }
+};
+
+/// Matches a conditional branch on an integer comparison where one of the
+/// destinations is a trap. Operands are read through the sigmas of CG.
+inline bool matchBoundsCheck(ConstraintGraph *CG, BranchInst *Br,
+		BoundsCheck &Check) {
+	if (!Br->isConditional())
+		return false;
+
+	ICmpInst *Cmp = dyn_cast<ICmpInst>(Br->getCondition());
+	if (!Cmp || !Cmp->getOperand(0)->getType()->isIntegerTy())
+		return false;
+
+	bool TrapOnTrue = isTrap(Br->getSuccessor(0));
+	bool TrapOnFalse = isTrap(Br->getSuccessor(1));
+	if (TrapOnTrue == TrapOnFalse)
+		return false;
+
+	Check.Br = Br;
+	Check.PassIdx = TrapOnTrue ? 1 : 0;
+
+	// The condition under which the program goes on, as A Pred B
+	CmpInst::Predicate Pred = TrapOnTrue ? Cmp->getInversePredicate() : Cmp->getPredicate();
+	const Value *A = CG->getUsedValue(Cmp->getOperandUse(0));
+	const Value *B = CG->getUsedValue(Cmp->getOperandUse(1));
+
+	// We only look at < and <=
+	if (Pred == ICmpInst::ICMP_SGT || Pred == ICmpInst::ICMP_UGT
+			|| Pred == ICmpInst::ICMP_SGE || Pred == ICmpInst::ICMP_UGE) {
+		std::swap(A, B);
+		Pred = ICmpInst::getSwappedPredicate(Pred);
+	}
+
+	Check.Idx = A;
+	Check.Len = B;
+	Check.Pred = Pred;
+
+	// 0 <= idx and -1 < idx only check the lower bound
+	const ConstantInt *C = dyn_cast<ConstantInt>(A);
+	if (C && ((Pred == ICmpInst::ICMP_SLE && C->isZero())
+			|| (Pred == ICmpInst::ICMP_SLT && C->isMinusOne()))) {
+		Check.Idx = B;
+		Check.Len = NULL;
+	}
+
+	return true;
+}
+
+/// The value V copies: sigmas are copies of their source.
+inline const Value *stripCopies(ConstraintGraph *CG, const Value *V) {
+	DefMap *Defs = CG->getDefMap();
+
+	for (unsigned Steps = 0; Steps < 64; ++Steps) {
+		DefMap::iterator it = Defs->find(V);
+		if (it == Defs->end())
+			break;
+
+		SigmaOp *Sigma = dyn_cast<SigmaOp>(it->second);
+		if (!Sigma)
+			break;
+
+		V = Sigma->getSource()->getValue();
+	}
+
+	return V;
+}
+
+/// Relation between the source of Sigma and the bound of its symbolic
+/// interval, as Source Pred Bound, read from the branch that created it. The
+/// predicate stored in the interval is not used, because for the second
+/// operand of a comparison it does not tell whether the bound is strict.
+inline CmpInst::Predicate getSigmaPredicate(ConstraintGraph *CG,
+		const SigmaOp *Sigma) {
+	const SymbInterval *SI = cast<SymbInterval>(Sigma->getIntersect());
+	const BasicBlock *BB = CG->getParentBlock(Sigma->getInstruction());
+	const BasicBlock *Pred = BB ? BB->getSinglePredecessor() : NULL;
+	if (!Pred)
+		return CmpInst::BAD_ICMP_PREDICATE;
+
+	const BranchInst *Br = dyn_cast<BranchInst>(Pred->getTerminator());
+	if (!Br || !Br->isConditional() || Br->getSuccessor(0) == Br->getSuccessor(1))
+		return CmpInst::BAD_ICMP_PREDICATE;
+
+	const ICmpInst *Cmp = dyn_cast<ICmpInst>(Br->getCondition());
+	if (!Cmp)
+		return CmpInst::BAD_ICMP_PREDICATE;
+
+	CmpInst::Predicate P = Br->getSuccessor(0) == BB ? Cmp->getPredicate()
+			: Cmp->getInversePredicate();
+
+	const Value *Source = stripCopies(CG, Sigma->getSource()->getValue());
+	const Value *Bound = stripCopies(CG, SI->getBound());
+	const Value *Op0 = stripCopies(CG, CG->getUsedValue(Cmp->getOperandUse(0)));
+	const Value *Op1 = stripCopies(CG, CG->getUsedValue(Cmp->getOperandUse(1)));
+
+	if (Op0 == Source && Op1 == Bound)
+		return P;
+	if (Op1 == Source && Op0 == Bound)
+		return ICmpInst::getSwappedPredicate(P);
+
+	return CmpInst::BAD_ICMP_PREDICATE;
+}
+
+#endif /* LLVM_TRANSFORMS_RANGEANALYSIS_RANGECLIENTS_H_ */
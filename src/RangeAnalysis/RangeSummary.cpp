@@ -0,0 +1,335 @@
+//===-------------------------- RangeSummary.cpp --------------------------===//
+//===---Writes what the range analysis of a module tells other modules----===//
+//
+//					 The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+// The inter-procedural analysis only sees the call sites of one module, so
+// it needs the whole program linked into a single module. This pass lets
+// each module be analyzed apart instead:
+//
+// 1. Each module is analyzed with -ra-separate-modules, and -ra-summary
+//    writes its summary: how the externally visible functions it defines
+//    return values, and the arguments of its calls to externally visible
+//    functions (see RangeSummaryFormat.h).
+// 2. range-summary-merge reads the summaries of all the modules and solves
+//    the ranges of the arguments and return values across modules, without
+//    the code of any of them.
+// 3. Each module is analyzed again with -ra-summary-index, which imports
+//    those ranges. It may write a new summary, and the last two steps may be
+//    repeated while the index changes.
+//
+// The ranges of each step hold for any index that holds, so the flow may
+// stop after any of them.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "ra-summary"
+#include "RangeAnalysis.h"
+#include "RangeSummaryFormat.h"
+#include "llvm/Support/CommandLine.h"
+#include <map>
+
+using namespace llvm;
+
+static cl::opt<std::string> SummaryFile("ra-summary-file",
+		cl::desc("File where -ra-summary writes the summary of the module (default: <module>.rsum)"),
+		cl::value_desc("filename"), cl::init(""));
+
+// How many instructions findBase looks through
+static const unsigned MaxDepth = 8;
+
+STATISTIC(NumSummarized, "Number of functions summarized");
+STATISTIC(NumCallRecords, "Number of call arguments summarized");
+STATISTIC(NumSymbolic, "Number of values summarized relative to another");
+
+// Defined with the inter-procedural analysis
+extern cl::opt<bool> RASeparateModules;
+extern cl::opt<std::string> RASummaryIndex;
+
+namespace {
+	class ModuleRangeSummary : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+
+	public:
+		static char ID;
+		ModuleRangeSummary() : ModulePass(ID), RA(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		SummaryRange toSummaryRange(const Range &R, unsigned Width);
+		bool findBase(const Value *V, const Function *F, SummaryTransfer &T,
+				unsigned Depth);
+		SummaryTransfer getTransfer(const Value *V, const Function *F);
+	};
+}
+
+char ModuleRangeSummary::ID = 0;
+static RegisterPass<ModuleRangeSummary> X("ra-summary",
+"Write the range summary of a module compiled separately", false, true);
+
+void ModuleRangeSummary::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<InterProceduralRA<Cousot> >();
+	AU.setPreservesAll();
+}
+
+// The functions that other modules know by name
+static bool isSummarized(const Function *F) {
+	if (F->hasLocalLinkage() || F->isIntrinsic() || !F->hasName())
+		return false;
+
+	// Names are separated by blanks in the summary
+	StringRef Name = F->getName();
+	return Name.find_first_of(" \t\n") == StringRef::npos;
+}
+
+static unsigned getWidth(const Type *T) {
+	if (const IntegerType *IT = dyn_cast<IntegerType>(T))
+		return IT->getBitWidth();
+	return 0;
+}
+
+// Moves the range R by C, failing if a bound leaves the int64_t values
+static bool shift(SummaryRange &R, int64_t C) {
+	if (R.empty)
+		return true;
+	if (C > 0 && (R.upper > INT64_MAX - 1 - C))
+		return false;
+	if (C < 0 && (R.lower < INT64_MIN + 1 - C))
+		return false;
+	R.lower += C;
+	R.upper += C;
+	return true;
+}
+
+SummaryRange ModuleRangeSummary::toSummaryRange(const Range &R, unsigned Width) {
+	if (R.isEmpty())
+		return SummaryRange();
+	if (!R.isRegular())
+		return SummaryRange::full();
+
+	// The analysis works on its widest type, but the bounds of the summary
+	// are those of the type of the value
+	unsigned RAWidth = RA->getMin().getBitWidth();
+	APInt WMin = RA->getMin(), WMax = RA->getMax();
+	if (Width < RAWidth) {
+		WMin = APInt::getSignedMinValue(Width).sext(RAWidth);
+		WMax = APInt::getSignedMaxValue(Width).sext(RAWidth);
+	}
+	APInt L = R.getLower(), U = R.getUpper();
+
+	SummaryRange S = SummaryRange::full();
+	if (L.sgt(WMin) && L.getMinSignedBits() <= 64)
+		S.lower = L.getSExtValue();
+	if (U.slt(WMax) && U.getMinSignedBits() <= 64)
+		S.upper = U.getSExtValue();
+	return S;
+}
+
+// Finds whether V is a parameter of F, or the result of a call to a
+// summarized function, plus constants. Arithmetic wraps in the width of V, so
+// the sum is exact as long as it fits that width, which the merge checks.
+bool ModuleRangeSummary::findBase(const Value *V, const Function *F,
+		SummaryTransfer &T, unsigned Depth) {
+	// Also stops at the cycles of phis
+	if (Depth > MaxDepth)
+		return false;
+
+	if (const Argument *A = dyn_cast<Argument>(V)) {
+		if (!isSummarized(F) || F->isVarArg())
+			return false;
+		T.base = RangeSummary::ParamBase;
+		T.param = A->getArgNo();
+		T.offset = SummaryRange(0, 0);
+		return true;
+	}
+
+	const Instruction *I = dyn_cast<Instruction>(V);
+	if (!I)
+		return false;
+
+	ImmutableCallSite CS(I);
+	if (CS) {
+		const Function *Callee = CS.getCalledFunction();
+		if (!Callee || !isSummarized(Callee))
+			return false;
+		T.base = RangeSummary::ReturnBase;
+		T.callee = Callee->getName().str();
+		T.offset = SummaryRange(0, 0);
+		return true;
+	}
+
+	switch (I->getOpcode()) {
+	case Instruction::Add:
+	case Instruction::Sub: {
+		const Value *Op = I->getOperand(0);
+		const ConstantInt *C = dyn_cast<ConstantInt>(I->getOperand(1));
+		if (!C && I->getOpcode() == Instruction::Add) {
+			C = dyn_cast<ConstantInt>(Op);
+			Op = I->getOperand(1);
+		}
+		if (!C || C->getBitWidth() > 64)
+			return false;
+
+		int64_t Offset = C->getSExtValue();
+		if (I->getOpcode() == Instruction::Sub) {
+			if (Offset == INT64_MIN)
+				return false;
+			Offset = -Offset;
+		}
+		return findBase(Op, F, T, Depth + 1) && shift(T.offset, Offset);
+	}
+	case Instruction::PHI:
+	case Instruction::Select: {
+		// Sigmas only narrow their operand, so they are handled as phis
+		unsigned First = isa<SelectInst>(I) ? 1 : 0;
+		for (unsigned i = First, e = I->getNumOperands(); i < e; ++i) {
+			SummaryTransfer In;
+			if (!findBase(I->getOperand(i), F, In, Depth + 1))
+				return false;
+			if (i == First)
+				T = In;
+			else if (!T.sameBase(In))
+				return false;
+			else
+				T.offset.join(In.offset);
+		}
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+SummaryTransfer ModuleRangeSummary::getTransfer(const Value *V,
+		const Function *F) {
+	unsigned Width = getWidth(V->getType());
+
+	SummaryTransfer T;
+	if (const ConstantInt *C = dyn_cast<ConstantInt>(V)) {
+		if (Width <= 64)
+			T.range = SummaryRange(C->getSExtValue(), C->getSExtValue());
+		else
+			T.range = SummaryRange::full();
+		return T;
+	}
+
+	if (Width <= 64 && findBase(V, F, T, 0))
+		++NumSymbolic;
+	else
+		T = SummaryTransfer();
+
+	T.range = toSummaryRange(RA->getRange(V), Width);
+	return T;
+}
+
+bool ModuleRangeSummary::runOnModule(Module &M) {
+	// Summaries must not depend on the callers this module happens to have
+	if (!RASeparateModules && RASummaryIndex.empty()) {
+		errs() << "Error: -ra-summary needs -ra-separate-modules or "
+				"-ra-summary-index\n";
+		return false;
+	}
+
+	RA = &getAnalysis<InterProceduralRA<Cousot> >();
+
+	// The calls are merged per caller, callee and argument
+	typedef std::pair<std::pair<std::string, std::string>, unsigned> CallKey;
+	std::map<CallKey, SummaryCall> Calls;
+	ModuleSummary Summary;
+
+	for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+		if (isSummarized(F) && F->hasAddressTaken())
+			Summary.escaping.push_back(F->getName().str());
+
+		if (F->isDeclaration())
+			continue;
+
+		if (isSummarized(F)) {
+			++NumSummarized;
+			SummaryFunction SF;
+			SF.name = F->getName().str();
+			SF.vararg = F->isVarArg();
+			for (Function::arg_iterator A = F->arg_begin(), AE = F->arg_end();
+					A != AE; ++A)
+				SF.widths.push_back(getWidth(A->getType()));
+			Summary.functions.push_back(SF);
+
+			// The values returned by F, if the analysis handled it
+			unsigned Width = getWidth(F->getReturnType());
+			if (Width && !F->isVarArg()) {
+				SummaryReturn SR;
+				SR.function = SF.name;
+				SR.width = Width;
+				bool First = true;
+				for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+					ReturnInst *RI = dyn_cast<ReturnInst>(BB->getTerminator());
+					if (!RI || !RI->getReturnValue())
+						continue;
+
+					SummaryTransfer T = getTransfer(RI->getReturnValue(), F);
+					if (First)
+						SR.transfer = T;
+					else
+						SR.transfer.join(T);
+					First = false;
+				}
+				Summary.returns.push_back(SR);
+			}
+		}
+
+		// The arguments of the calls to functions other modules may define
+		std::string Caller = isSummarized(F) ? F->getName().str() : "-";
+		for (inst_iterator I = inst_begin(*F), IE = inst_end(*F); I != IE; ++I) {
+			CallSite CS(&*I);
+			if (!CS)
+				continue;
+
+			const Function *Callee = CS.getCalledFunction();
+			if (!Callee || !isSummarized(Callee) || Callee->isVarArg())
+				continue;
+
+			for (unsigned i = 0, e = CS.arg_size(); i < e; ++i) {
+				const Value *Arg = CS.getArgument(i);
+				unsigned Width = getWidth(Arg->getType());
+				if (!Width)
+					continue;
+
+				SummaryTransfer T = getTransfer(Arg, F);
+				CallKey Key = std::make_pair(std::make_pair(Caller,
+						Callee->getName().str()), i);
+
+				std::map<CallKey, SummaryCall>::iterator it = Calls.find(Key);
+				if (it != Calls.end()) {
+					it->second.transfer.join(T);
+					continue;
+				}
+
+				SummaryCall &SC = Calls[Key];
+				SC.caller = Caller;
+				SC.callee = Callee->getName().str();
+				SC.argument = i;
+				SC.width = Width;
+				SC.transfer = T;
+			}
+		}
+	}
+
+	for (std::map<CallKey, SummaryCall>::iterator it = Calls.begin(),
+			e = Calls.end(); it != e; ++it)
+		Summary.calls.push_back(it->second);
+	NumCallRecords += Summary.calls.size();
+
+	std::string Filename = SummaryFile;
+	if (Filename.empty())
+		Filename = M.getModuleIdentifier() + ".rsum";
+
+	if (!Summary.write(Filename))
+		errs() << "Error opening file " << Filename << " for writing!\n";
+
+	return false;
+}
@@ -0,0 +1,381 @@
+/*
+ * RangeSummaryFormat.h
+ *
+ *  Text format of the range summaries written for modules compiled apart
+ *  from each other (-ra-summary), and of the index that range-summary-merge
+ *  builds from them for the analysis to import (-ra-summary-index). Like
+ *  RangeDumpFormat.h, it only depends on the C++ library, so that the merge
+ *  tool does not need to link against LLVM.
+ *
+ *  A summary has one record per line:
+ *    RangeSummary 1
+ *    F <function> <vararg> <number of params> <width of each param>
+ *    R <function> <width> <transfer>
+ *    C <caller> <callee> <argument> <width> <transfer>
+ *    E <function>
+ *  F lists the externally visible functions defined in the module, with the
+ *  bit width of their integer parameters, and 0 for the others. R describes
+ *  the values they return, and C the actual arguments of the calls to
+ *  externally visible functions, merged per caller, callee and argument.
+ *  E marks the functions whose address is taken, which may be called from
+ *  anywhere.
+ *
+ *  A transfer is a range, "<lower> <upper>" or "empty", that may be followed
+ *  by "p <index> <lower> <upper>", if the value is a parameter of the caller
+ *  plus an offset in that range, or by "r <callee> <lower> <upper>", if it is
+ *  the value returned by a call to callee plus an offset. The value is within
+ *  both the range and the sum, which lets the merge propagate ranges from
+ *  function to function without analyzing them again.
+ *
+ *  The index lists the ranges that hold in the whole program:
+ *    RangeIndex 1
+ *    A <function> <argument> <lower> <upper>
+ *    R <function> <lower> <upper>
+ *  Arguments and return values that are not listed may take any value.
+ *
+ *  Bounds are decimal, with -inf and +inf for the extremes of the width.
+ */
+
+#ifndef RANGESUMMARYFORMAT_H_
+#define RANGESUMMARYFORMAT_H_
+
+#include <stdint.h>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+namespace RangeSummary {
+
+	static const unsigned Version = 1;
+
+	//What the offset of a transfer is added to
+	enum BaseKind {
+		NoBase = 0,
+		ParamBase = 1,
+		ReturnBase = 2
+	};
+
+}
+
+//An interval of int64_t, where INT64_MIN and INT64_MAX stand for -inf and +inf
+struct SummaryRange {
+	bool empty;
+	int64_t lower;
+	int64_t upper;
+
+	SummaryRange(): empty(true), lower(0), upper(0) {}
+	SummaryRange(int64_t l, int64_t u): empty(false), lower(l), upper(u) {}
+
+	static SummaryRange full() { return SummaryRange(INT64_MIN, INT64_MAX); }
+
+	bool isFull() const {
+		return !empty && lower == INT64_MIN && upper == INT64_MAX;
+	}
+
+	void join(const SummaryRange &R) {
+		if (R.empty)
+			return;
+		if (empty) {
+			*this = R;
+			return;
+		}
+		if (R.lower < lower) lower = R.lower;
+		if (R.upper > upper) upper = R.upper;
+	}
+
+	bool operator==(const SummaryRange &R) const {
+		if (empty || R.empty)
+			return empty == R.empty;
+		return lower == R.lower && upper == R.upper;
+	}
+
+	bool operator!=(const SummaryRange &R) const { return !(*this == R); }
+};
+
+//What a summary knows about an integer value
+struct SummaryTransfer {
+	SummaryRange range;
+	uint8_t base;
+	unsigned param;
+	std::string callee;
+	SummaryRange offset;
+
+	SummaryTransfer(): base(RangeSummary::NoBase), param(0) {}
+
+	bool sameBase(const SummaryTransfer &T) const {
+		return base == T.base && param == T.param && callee == T.callee;
+	}
+
+	//The transfer of a value that is either this one or T
+	void join(const SummaryTransfer &T) {
+		range.join(T.range);
+		if (base != RangeSummary::NoBase && sameBase(T)) {
+			offset.join(T.offset);
+		} else {
+			base = RangeSummary::NoBase;
+			callee.clear();
+		}
+	}
+};
+
+struct SummaryFunction {
+	std::string name;
+	bool vararg;
+	std::vector<unsigned> widths;
+};
+
+struct SummaryReturn {
+	std::string function;
+	unsigned width;
+	SummaryTransfer transfer;
+};
+
+struct SummaryCall {
+	std::string caller;
+	std::string callee;
+	unsigned argument;
+	unsigned width;
+	SummaryTransfer transfer;
+};
+
+inline std::string formatSummaryBound(int64_t v) {
+	if (v == INT64_MIN) return "-inf";
+	if (v == INT64_MAX) return "+inf";
+	std::ostringstream ss;
+	ss << v;
+	return ss.str();
+}
+
+inline bool parseSummaryBound(const std::string &s, int64_t &v) {
+	if (s == "-inf") {
+		v = INT64_MIN;
+		return true;
+	}
+	if (s == "+inf") {
+		v = INT64_MAX;
+		return true;
+	}
+	std::istringstream ss(s);
+	return (ss >> v) && ss.eof();
+}
+
+inline bool parseSummaryBound(std::istream &in, int64_t &v) {
+	std::string s;
+	return (in >> s) && parseSummaryBound(s, v);
+}
+
+inline std::string formatSummaryRange(const SummaryRange &R) {
+	if (R.empty)
+		return "empty";
+	return formatSummaryBound(R.lower) + " " + formatSummaryBound(R.upper);
+}
+
+inline bool parseSummaryRange(std::istream &in, SummaryRange &R) {
+	std::string s;
+	if (!(in >> s))
+		return false;
+	if (s == "empty") {
+		R = SummaryRange();
+		return true;
+	}
+	R.empty = false;
+	return parseSummaryBound(s, R.lower) && parseSummaryBound(in, R.upper);
+}
+
+inline std::string formatSummaryTransfer(const SummaryTransfer &T) {
+	std::ostringstream ss;
+	ss << formatSummaryRange(T.range);
+	if (T.base == RangeSummary::ParamBase)
+		ss << " p " << T.param << " " << formatSummaryRange(T.offset);
+	else if (T.base == RangeSummary::ReturnBase)
+		ss << " r " << T.callee << " " << formatSummaryRange(T.offset);
+	return ss.str();
+}
+
+inline bool parseSummaryTransfer(std::istream &in, SummaryTransfer &T) {
+	T = SummaryTransfer();
+	if (!parseSummaryRange(in, T.range))
+		return false;
+
+	std::string kind;
+	if (!(in >> kind))
+		return true;
+	if (kind == "p") {
+		T.base = RangeSummary::ParamBase;
+		if (!(in >> T.param))
+			return false;
+	} else if (kind == "r") {
+		T.base = RangeSummary::ReturnBase;
+		if (!(in >> T.callee))
+			return false;
+	} else {
+		return false;
+	}
+	return parseSummaryRange(in, T.offset);
+}
+
+//The summary of a module. Reading several files into the same summary
+//gathers the records of all of them.
+struct ModuleSummary {
+	std::vector<SummaryFunction> functions;
+	std::vector<SummaryReturn> returns;
+	std::vector<SummaryCall> calls;
+	std::vector<std::string> escaping;
+
+	bool write(const std::string &filename) const {
+		std::ofstream out(filename.c_str());
+		if (!out)
+			return false;
+
+		out << "RangeSummary " << RangeSummary::Version << "\n";
+		for (size_t i = 0; i < functions.size(); ++i) {
+			const SummaryFunction &F = functions[i];
+			out << "F " << F.name << " " << F.vararg << " " << F.widths.size();
+			for (size_t j = 0; j < F.widths.size(); ++j)
+				out << " " << F.widths[j];
+			out << "\n";
+		}
+		for (size_t i = 0; i < returns.size(); ++i) {
+			const SummaryReturn &R = returns[i];
+			out << "R " << R.function << " " << R.width << " "
+					<< formatSummaryTransfer(R.transfer) << "\n";
+		}
+		for (size_t i = 0; i < calls.size(); ++i) {
+			const SummaryCall &C = calls[i];
+			out << "C " << C.caller << " " << C.callee << " " << C.argument
+					<< " " << C.width << " " << formatSummaryTransfer(C.transfer)
+					<< "\n";
+		}
+		for (size_t i = 0; i < escaping.size(); ++i)
+			out << "E " << escaping[i] << "\n";
+		return out.good();
+	}
+
+	bool read(const std::string &filename) {
+		std::ifstream in(filename.c_str());
+		std::string line, magic;
+		unsigned version;
+		if (!std::getline(in, line))
+			return false;
+		std::istringstream header(line);
+		if (!(header >> magic >> version) || magic != "RangeSummary"
+				|| version != RangeSummary::Version)
+			return false;
+
+		while (std::getline(in, line)) {
+			std::istringstream ss(line);
+			std::string kind;
+			if (!(ss >> kind))
+				continue;
+
+			if (kind == "F") {
+				SummaryFunction F;
+				size_t n;
+				if (!(ss >> F.name >> F.vararg >> n))
+					return false;
+				F.widths.resize(n);
+				for (size_t j = 0; j < n; ++j)
+					if (!(ss >> F.widths[j]))
+						return false;
+				functions.push_back(F);
+			} else if (kind == "R") {
+				SummaryReturn R;
+				if (!(ss >> R.function >> R.width)
+						|| !parseSummaryTransfer(ss, R.transfer))
+					return false;
+				returns.push_back(R);
+			} else if (kind == "C") {
+				SummaryCall C;
+				if (!(ss >> C.caller >> C.callee >> C.argument >> C.width)
+						|| !parseSummaryTransfer(ss, C.transfer))
+					return false;
+				calls.push_back(C);
+			} else if (kind == "E") {
+				std::string name;
+				if (!(ss >> name))
+					return false;
+				escaping.push_back(name);
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+//The ranges that hold for the whole program
+struct RangeIndex {
+	std::map<std::pair<std::string, unsigned>, SummaryRange> arguments;
+	std::map<std::string, SummaryRange> returns;
+
+	SummaryRange getArgument(const std::string &function, unsigned i) const {
+		std::map<std::pair<std::string, unsigned>, SummaryRange>::const_iterator
+				it = arguments.find(std::make_pair(function, i));
+		return it != arguments.end() ? it->second : SummaryRange::full();
+	}
+
+	SummaryRange getReturn(const std::string &function) const {
+		std::map<std::string, SummaryRange>::const_iterator it =
+				returns.find(function);
+		return it != returns.end() ? it->second : SummaryRange::full();
+	}
+
+	bool write(const std::string &filename) const {
+		std::ofstream out(filename.c_str());
+		if (!out)
+			return false;
+
+		out << "RangeIndex " << RangeSummary::Version << "\n";
+		for (std::map<std::pair<std::string, unsigned>, SummaryRange>::const_iterator
+				it = arguments.begin(), e = arguments.end(); it != e; ++it)
+			out << "A " << it->first.first << " " << it->first.second << " "
+					<< formatSummaryRange(it->second) << "\n";
+		for (std::map<std::string, SummaryRange>::const_iterator
+				it = returns.begin(), e = returns.end(); it != e; ++it)
+			out << "R " << it->first << " " << formatSummaryRange(it->second)
+					<< "\n";
+		return out.good();
+	}
+
+	bool read(const std::string &filename) {
+		std::ifstream in(filename.c_str());
+		std::string line, magic;
+		unsigned version;
+		if (!std::getline(in, line))
+			return false;
+		std::istringstream header(line);
+		if (!(header >> magic >> version) || magic != "RangeIndex"
+				|| version != RangeSummary::Version)
+			return false;
+
+		while (std::getline(in, line)) {
+			std::istringstream ss(line);
+			std::string kind, name;
+			SummaryRange R;
+			if (!(ss >> kind))
+				continue;
+
+			if (kind == "A") {
+				unsigned i;
+				if (!(ss >> name >> i) || !parseSummaryRange(ss, R))
+					return false;
+				arguments[std::make_pair(name, i)] = R;
+			} else if (kind == "R") {
+				if (!(ss >> name) || !parseSummaryRange(ss, R))
+					return false;
+				returns[name] = R;
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+}
+
+#endif /* RANGESUMMARYFORMAT_H_ */
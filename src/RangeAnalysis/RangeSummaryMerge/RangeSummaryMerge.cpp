@@ -0,0 +1,317 @@
+/*
+ * RangeSummaryMerge.cpp
+ *
+ *  Merges the range summaries that -ra-summary writes for each module of a
+ *  program into the index that -ra-summary-index imports. The arguments of
+ *  each function take the ranges of all its call sites in the program, and
+ *  these ranges go through the summaries of the callers until nothing
+ *  changes, widening the bounds that keep growing.
+ *
+ *  The modules given must be the whole program: the functions that are
+ *  never called in them, whose address is taken, or that are variadic, may
+ *  be called from anywhere, and their arguments are not bound.
+ *
+ *  Usage: range-summary-merge [-widen <n>] -o <index> <summary>...
+ */
+
+#include "../RangeSummaryFormat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace llvm;
+
+//What the index knows about a function while it is being solved
+struct FunctionInfo {
+	bool defined;
+	bool open;
+	bool called;
+	std::vector<unsigned> widths;
+	std::vector<SummaryRange> arguments;
+	std::vector<unsigned> argumentUpdates;
+	bool returns;
+	unsigned returnWidth;
+	SummaryRange returned;
+	unsigned returnUpdates;
+
+	FunctionInfo(): defined(false), open(false), called(false), returns(false),
+			returnWidth(0), returnUpdates(0) {}
+};
+
+typedef std::map<std::string, FunctionInfo> FunctionMap;
+
+//Widths of 0, which are not integers, have no bounds either
+static int64_t minOfWidth(unsigned w) {
+	return w == 0 || w >= 64 ? INT64_MIN : -((int64_t) 1 << (w - 1));
+}
+
+static int64_t maxOfWidth(unsigned w) {
+	return w == 0 || w >= 64 ? INT64_MAX : ((int64_t) 1 << (w - 1)) - 1;
+}
+
+//Writes the extremes of the width as -inf and +inf
+static SummaryRange clampToWidth(SummaryRange R, unsigned w) {
+	if (R.empty)
+		return R;
+	if (R.lower <= minOfWidth(w))
+		R.lower = INT64_MIN;
+	if (R.upper >= maxOfWidth(w))
+		R.upper = INT64_MAX;
+	return R;
+}
+
+static bool checkedAdd(int64_t a, int64_t b, int64_t &r) {
+	if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b))
+		return false;
+	r = a + b;
+	return true;
+}
+
+//B + Offset in width w. The sum wraps around if it leaves the width, and
+//then may be anything.
+static SummaryRange add(const SummaryRange &B, const SummaryRange &Offset,
+		unsigned w) {
+	if (B.empty || Offset.empty)
+		return SummaryRange();
+
+	int64_t lower = B.lower == INT64_MIN ? minOfWidth(w) : B.lower;
+	int64_t upper = B.upper == INT64_MAX ? maxOfWidth(w) : B.upper;
+	if (minOfWidth(w) == INT64_MIN && (B.lower == INT64_MIN || B.upper == INT64_MAX))
+		return SummaryRange::full();
+
+	if (!checkedAdd(lower, Offset.lower, lower)
+			|| !checkedAdd(upper, Offset.upper, upper)
+			|| lower < minOfWidth(w) || upper > maxOfWidth(w))
+		return SummaryRange::full();
+
+	return clampToWidth(SummaryRange(lower, upper), w);
+}
+
+static SummaryRange intersect(const SummaryRange &A, const SummaryRange &B) {
+	if (A.empty || B.empty)
+		return SummaryRange();
+
+	SummaryRange R(A.lower > B.lower ? A.lower : B.lower,
+			A.upper < B.upper ? A.upper : B.upper);
+	if (R.lower > R.upper)
+		return SummaryRange();
+	return R;
+}
+
+//The range of the value described by T, in function Caller
+static SummaryRange evaluate(const SummaryTransfer &T, const std::string &Caller,
+		unsigned w, FunctionMap &Functions) {
+	SummaryRange R = clampToWidth(T.range, w);
+	if (T.base == RangeSummary::NoBase)
+		return R;
+
+	SummaryRange Base = SummaryRange::full();
+	if (T.base == RangeSummary::ParamBase) {
+		FunctionMap::iterator it = Functions.find(Caller);
+		if (it != Functions.end() && T.param < it->second.arguments.size()
+				&& it->second.widths[T.param] == w)
+			Base = it->second.arguments[T.param];
+	} else {
+		FunctionMap::iterator it = Functions.find(T.callee);
+		if (it != Functions.end() && it->second.returns
+				&& it->second.returnWidth == w)
+			Base = it->second.returned;
+	}
+
+	return intersect(R, add(Base, T.offset, w));
+}
+
+//The range that a call site gives to an argument of its callee
+static SummaryRange evaluateCall(const SummaryCall &C, FunctionMap &Functions) {
+	// A callee declared with another type gets anything
+	if (Functions[C.callee].widths[C.argument] != C.width)
+		return SummaryRange::full();
+	return evaluate(C.transfer, C.caller, C.width, Functions);
+}
+
+//The range of the values a function returns
+static SummaryRange evaluateReturn(const SummaryReturn &R,
+		FunctionMap &Functions) {
+	if (Functions[R.function].returnWidth != R.width)
+		return SummaryRange::full();
+	return evaluate(R.transfer, R.function, R.width, Functions);
+}
+
+//Joins V into R, widening the bounds of R that keep moving after Widen
+//updates. Returns true if R changed.
+static bool update(SummaryRange &R, unsigned &Updates, const SummaryRange &V,
+		unsigned Widen) {
+	SummaryRange New = R;
+	New.join(V);
+	if (New == R)
+		return false;
+
+	if (++Updates > Widen && !R.empty) {
+		if (New.lower < R.lower)
+			New.lower = INT64_MIN;
+		if (New.upper > R.upper)
+			New.upper = INT64_MAX;
+	}
+	R = New;
+	return true;
+}
+
+int main(int argc, char **argv) {
+
+	std::string Output;
+	unsigned Widen = 3;
+	std::vector<std::string> Inputs;
+
+	for (int i = 1; i < argc; ++i) {
+		if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			Output = argv[++i];
+		else if (!strcmp(argv[i], "-widen") && i + 1 < argc)
+			Widen = atoi(argv[++i]);
+		else
+			Inputs.push_back(argv[i]);
+	}
+
+	if (Output.empty() || Inputs.empty()) {
+		fprintf(stderr, "Usage: %s [-widen <n>] -o <index> <summary>...\n",
+				argv[0]);
+		return 1;
+	}
+
+	ModuleSummary Summary;
+	for (size_t i = 0; i < Inputs.size(); ++i) {
+		if (!Summary.read(Inputs[i])) {
+			fprintf(stderr, "Error: %s is not a range summary\n",
+					Inputs[i].c_str());
+			return 1;
+		}
+	}
+
+	FunctionMap Functions;
+
+	for (size_t i = 0; i < Summary.functions.size(); ++i) {
+		const SummaryFunction &F = Summary.functions[i];
+		FunctionInfo &Info = Functions[F.name];
+		// Functions defined in many modules, such as inline ones, must have
+		// the same signature in all of them
+		if (Info.defined && Info.widths != F.widths)
+			Info.open = true;
+		Info.defined = true;
+		Info.widths = F.widths;
+		Info.open |= F.vararg || F.name == "main";
+	}
+
+	for (size_t i = 0; i < Summary.escaping.size(); ++i)
+		Functions[Summary.escaping[i]].open = true;
+
+	for (size_t i = 0; i < Summary.calls.size(); ++i)
+		Functions[Summary.calls[i].callee].called = true;
+
+	for (size_t i = 0; i < Summary.returns.size(); ++i) {
+		const SummaryReturn &R = Summary.returns[i];
+		FunctionInfo &Info = Functions[R.function];
+		if (Info.returns && Info.returnWidth != R.width)
+			Info.returnWidth = 0;
+		else
+			Info.returnWidth = R.width;
+		Info.returns = true;
+	}
+
+	// Open functions may be called with anything. The others start with no
+	// call at all, and gather the ranges of their call sites.
+	for (FunctionMap::iterator it = Functions.begin(), e = Functions.end();
+			it != e; ++it) {
+		FunctionInfo &Info = it->second;
+		Info.open |= !Info.called;
+		Info.arguments.assign(Info.widths.size(),
+				Info.open ? SummaryRange::full() : SummaryRange());
+		Info.argumentUpdates.assign(Info.widths.size(), 0);
+	}
+
+	bool Changed = true;
+	while (Changed) {
+		Changed = false;
+
+		for (size_t i = 0; i < Summary.calls.size(); ++i) {
+			const SummaryCall &C = Summary.calls[i];
+			FunctionInfo &Callee = Functions[C.callee];
+			if (!Callee.defined || Callee.open
+					|| C.argument >= Callee.arguments.size())
+				continue;
+
+			Changed |= update(Callee.arguments[C.argument],
+					Callee.argumentUpdates[C.argument],
+					evaluateCall(C, Functions), Widen);
+		}
+
+		for (size_t i = 0; i < Summary.returns.size(); ++i) {
+			const SummaryReturn &R = Summary.returns[i];
+			FunctionInfo &Info = Functions[R.function];
+			Changed |= update(Info.returned, Info.returnUpdates,
+					evaluateReturn(R, Functions), Widen);
+		}
+	}
+
+	// The ranges are stable, so evaluating the summaries again gives ranges
+	// that still hold, and that undo some of the widening
+	for (unsigned Round = 0; Round < Widen; ++Round) {
+		FunctionMap Narrowed = Functions;
+		for (FunctionMap::iterator it = Narrowed.begin(), e = Narrowed.end();
+				it != e; ++it) {
+			FunctionInfo &Info = it->second;
+			if (Info.defined && !Info.open)
+				Info.arguments.assign(Info.widths.size(), SummaryRange());
+			Info.returned = SummaryRange();
+		}
+
+		for (size_t i = 0; i < Summary.calls.size(); ++i) {
+			const SummaryCall &C = Summary.calls[i];
+			FunctionInfo &Callee = Narrowed[C.callee];
+			if (Callee.defined && !Callee.open
+					&& C.argument < Callee.arguments.size())
+				Callee.arguments[C.argument].join(evaluateCall(C, Functions));
+		}
+
+		for (size_t i = 0; i < Summary.returns.size(); ++i) {
+			const SummaryReturn &R = Summary.returns[i];
+			Narrowed[R.function].returned.join(evaluateReturn(R, Functions));
+		}
+
+		Changed = false;
+		for (FunctionMap::iterator it = Functions.begin(), e = Functions.end();
+				it != e; ++it) {
+			const FunctionInfo &Info = Narrowed[it->first];
+			Changed |= Info.arguments != it->second.arguments
+					|| Info.returned != it->second.returned;
+		}
+		Functions.swap(Narrowed);
+		if (!Changed)
+			break;
+	}
+
+	// Only the ranges that bound something are written
+	RangeIndex Index;
+	for (FunctionMap::iterator it = Functions.begin(), e = Functions.end();
+			it != e; ++it) {
+		const FunctionInfo &Info = it->second;
+		if (!Info.defined)
+			continue;
+
+		for (unsigned i = 0; i < Info.arguments.size(); ++i) {
+			SummaryRange R = clampToWidth(Info.arguments[i], Info.widths[i]);
+			if (Info.widths[i] && !R.empty && !R.isFull())
+				Index.arguments[std::make_pair(it->first, i)] = R;
+		}
+
+		SummaryRange R = clampToWidth(Info.returned, Info.returnWidth);
+		if (Info.returns && Info.returnWidth && !R.empty && !R.isFull())
+			Index.returns[it->first] = R;
+	}
+
+	if (!Index.write(Output)) {
+		fprintf(stderr, "Error opening file %s for writing!\n", Output.c_str());
+		return 1;
+	}
+
+	return 0;
+}
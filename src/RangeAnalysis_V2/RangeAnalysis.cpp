@@ -477,42 +477,58 @@ void llvm::RangeAnalysis::addConstraints(
 		// For each value, we iterate through its uses, looking for sigmas. We
 		// can only learn with conditionals when we insert sigmas, because they split the
 		// live ranges of the variables according to the branch results.
+		// If the graph was built from a virtual e-SSA form, its sigmas are
+		// not in the use list, so we take them from the overlay.
+		const ESSAOverlay* overlay = depGraph->getOverlay();
+
+		SmallVector<const PHINode*, 8> Sigmas;
+		if (overlay) {
+			ArrayRef<PHINode*> VirtualSigmas = overlay->getSigmasOf(CurrentValue);
+			Sigmas.append(VirtualSigmas.begin(), VirtualSigmas.end());
+		} else {
+			Value::const_use_iterator Uit, Uend;
+			for(Uit = CurrentValue->use_begin(), Uend = CurrentValue->use_end(); Uit != Uend; Uit++){
+				if (const PHINode* CurrentUse = dyn_cast_or_null<const PHINode>(*Uit))
+					Sigmas.push_back(CurrentUse);
+			}
+		}
 
-		Value::const_use_iterator Uit, Uend;
-		for(Uit = CurrentValue->use_begin(), Uend = CurrentValue->use_end(); Uit != Uend; Uit++){
+		for (unsigned i = 0, e = Sigmas.size(); i != e; ++i) {
 
-			const User* U = *Uit;
-			if (!U) continue;
+			const PHINode* CurrentUse = Sigmas[i];
 
-			if (const PHINode* CurrentUse = dyn_cast<const PHINode>(U)){
+			if(SigmaOpNode* CurrentSigmaOpNode = dyn_cast_or_null<SigmaOpNode>(depGraph->findOpNode(CurrentUse))){
 
-				if(SigmaOpNode* CurrentSigmaOpNode = dyn_cast<SigmaOpNode>(depGraph->findOpNode(CurrentUse))){
+				const BasicBlock* ParentBB = overlay ? overlay->getParent(CurrentUse) : CurrentUse->getParent();
 
-					const BasicBlock* ParentBB = CurrentUse->getParent();
+				// We will look for the symbolic range of the basic block of this sigma node.
+				std::list<ValueSwitchMap*>::iterator VSMit, VSMend;
+				for(VSMit = Cit->second.begin(), VSMend = Cit->second.end(); VSMit != VSMend; VSMit++){
 
-					// We will look for the symbolic range of the basic block of this sigma node.
-					std::list<ValueSwitchMap*>::iterator VSMit, VSMend;
-					for(VSMit = Cit->second.begin(), VSMend = Cit->second.end(); VSMit != VSMend; VSMit++){
+					ValueSwitchMap* CurrentVSM = *VSMit;
+					int Idx = CurrentVSM->getBBid(ParentBB);
+					if(Idx >= 0){
+						//Save the symbolic interval of the opNode. We will use it in the narrowing
+						// phase of the range analysis
 
-						ValueSwitchMap* CurrentVSM = *VSMit;
-						int Idx = CurrentVSM->getBBid(ParentBB);
-						if(Idx >= 0){
-							//Save the symbolic interval of the opNode. We will use it in the narrowing
-							// phase of the range analysis
+						BasicInterval* BI = CurrentVSM->getItv(Idx);
+						branchConstraints[CurrentSigmaOpNode] = BI;
 
-							BasicInterval* BI = CurrentVSM->getItv(Idx);
-							branchConstraints[CurrentSigmaOpNode] = BI;
+						//If it is a symbolic interval, then we have a future value and we must
+						//insert a control dependence edge in the graph.
+						if(SymbInterval* SI = dyn_cast<SymbInterval>(BI)){
 
-							//If it is a symbolic interval, then we have a future value and we must
-							//insert a control dependence edge in the graph.
-							if(SymbInterval* SI = dyn_cast<SymbInterval>(BI)){
+							// Without sigmas in the IR, the bound is whatever
+							// definition of it reaches the branch
+							Value* Bound = SI->getBound();
+							if (overlay)
+								Bound = overlay->getDefAtEnd(ParentBB->getSinglePredecessor(), Bound);
 
-								if (GraphNode* FutureValue = depGraph->findNode(SI->getBound())) {
-									depGraph->addEdge(FutureValue, CurrentSigmaOpNode, etControl);
-								}
+							if (GraphNode* FutureValue = depGraph->findNode(Bound)) {
+								depGraph->addEdge(FutureValue, CurrentSigmaOpNode, etControl);
 							}
-							break;
 						}
+						break;
 					}
 				}
 			}
@@ -0,0 +1,135 @@
+#ifndef __PRIMITIVE_LAYOUTS_H__
+#define __PRIMITIVE_LAYOUTS_H__
+
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+/*
+* Primitive layouts of types, shared by the tables of RangedAliasTables
+* (here and in DistributedRA) and SegmentationTables.
+*/
+
+namespace llvm
+{
+
+	//Holds the flattened Primitive Layout of a determined Type.
+	//Layouts are built once per Type and shared by every GEP of the module,
+	//so translating an index into a primitive offset is a table lookup.
+	struct PrimitiveLayout
+	{
+		Type * type;
+		//Number of primitive elements inside type
+		int num_primitives;
+		//Number of elements one level inside type
+		int num_elements;
+		//Primitives of each element, when they are all alike (arrays and
+		//vectors). Structs use the prefix table instead.
+		int stride;
+		//prefix[i] is the number of primitives behind the ith element
+		std::vector<int> prefix;
+		PrimitiveLayout(Type* ty, int np, int ne, int st)
+		{
+			type = ty;
+			num_primitives = np;
+			num_elements = ne;
+			stride = st;
+		}
+	};
+
+	//The primitive layouts of the types of a module, flattened at the first
+	//request
+	class PrimitiveLayoutTable
+	{
+		private:
+			llvm::DenseMap<Type*, PrimitiveLayout*> Layouts;
+
+		public:
+			~PrimitiveLayoutTable()
+			{
+				for(llvm::DenseMap<Type*, PrimitiveLayout*>::iterator i = Layouts.begin(),
+				e = Layouts.end(); i != e; i++)
+					delete i->second;
+			}
+
+			//Returns the number of primitives behind the ith element of layout
+			static int getSumBehind(PrimitiveLayout* layout, int i)
+			{
+				if(i <= 0)
+					return 0;
+				if(i > layout->num_elements)
+					i = layout->num_elements;
+				if(layout->prefix.empty())
+					return i * layout->stride;
+				return layout->prefix[i];
+			}
+
+			//Returns the number of primitive elements of type
+			int getNumPrimitives(Type* type)
+			{
+				return getPrimitiveLayout(type)->num_primitives;
+			}
+
+			//Returns the primitive layout of type
+			PrimitiveLayout* getPrimitiveLayout(Type* type)
+			{
+				//Verifies if this layout was calculated already
+				llvm::DenseMap<Type*, PrimitiveLayout*>::iterator it = Layouts.find(type);
+				if(it != Layouts.end())
+					return it->second;
+
+				//if not
+				PrimitiveLayout* pl;
+
+				if(type->isArrayTy())
+				{
+					int num = type->getArrayNumElements();
+					int arrtypenum = getNumPrimitives(type->getArrayElementType());
+					pl = new PrimitiveLayout(type, num * arrtypenum, num, arrtypenum);
+				}
+				else if(type->isStructTy())
+				{
+					int num = type->getStructNumElements();
+					pl = new PrimitiveLayout(type, 0, num, 0);
+					pl->prefix.resize(num + 1);
+					pl->prefix[0] = 0;
+					for(int i = 0; i < num; i++)
+						pl->prefix[i+1] = pl->prefix[i] + getNumPrimitives(type->getStructElementType(i));
+					pl->num_primitives = pl->prefix[num];
+				}
+				else if(type->isVectorTy())
+				{
+					int num = type->getVectorNumElements();
+					int arrtypenum = getNumPrimitives(type->getVectorElementType());
+					pl = new PrimitiveLayout(type, num * arrtypenum, num, arrtypenum);
+				}
+				else
+				{
+					pl = new PrimitiveLayout(type, 1, 1, 1);
+				}
+
+				Layouts[type] = pl;
+				return pl;
+			}
+
+			void print()
+			{
+				errs() << "\n-------------------------\nPrimitive Layouts:" << "\n";
+				for(llvm::DenseMap<Type*, PrimitiveLayout*>::iterator i = Layouts.begin(),
+				e = Layouts.end(); i != e; i++)
+				{
+					PrimitiveLayout* pl = i->second;
+					errs() << *(pl->type) << ":\n";
+					for(int j = 0; j < pl->num_elements; j++)
+						errs() << getSumBehind(pl, j+1) - getSumBehind(pl, j) << "  ";
+					errs() << "\n";
+				}
+
+				errs() << "-------------------------\n\n";
+			}
+	};
+
+}
+
+#endif
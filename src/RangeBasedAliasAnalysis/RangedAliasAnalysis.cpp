@@ -1,7 +1,7 @@
 #define DEBUG_TYPE "ranged-aa"
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/AliasAnalysis.h"
-#include "RangedAliasTables.h"
+#include "RangedAliasCache.h"
 #include "llvm/Pass.h"
 #include "llvm/ADT/DenseMap.h"
 
@@ -65,14 +65,14 @@ static RegisterAnalysisGroup<AliasAnalysis> E(X);
 void
 RangedAliasAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
   AliasAnalysis::getAnalysisUsage(AU);
-  AU.addRequired<RangedAliasTables>();
+  AU.addRequired<RangedAliasCache>();
   AU.setPreservesAll();
 }
 
 bool
 RangedAliasAnalysis::runOnFunction(Function &F) {
   InitializeAliasAnalysis(this);
-  RAT = &getAnalysis<RangedAliasTables>();
+  RAT = getAnalysis<RangedAliasCache>().getTables(*F.getParent());
   RangedAliasTableMap = RAT->getRangedAliasTableMap();
   RangedPointerMap = RAT->getRangedPointerMap();
   return false;
@@ -0,0 +1,46 @@
+#define DEBUG_TYPE "ranged-aa-cache"
+#include "RangedAliasCache.h"
+#include "llvm/ADT/Statistic.h"
+
+using namespace llvm;
+
+STATISTIC(NTablesHits, "Number of ranged alias tables reused");
+STATISTIC(NTablesMisses, "Number of ranged alias tables built");
+
+char RangedAliasCache::ID = 0;
+static RegisterPass<RangedAliasCache> X("ranged-aa-cache",
+"RangedAliasTables kept across passes", false, true);
+
+void
+RangedAliasCache::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+	AU.setPreservesAll();
+}
+
+RangedAliasCache::~RangedAliasCache() {
+	delete Tables;
+}
+
+RangedAliasTables*
+RangedAliasCache::getTables(Module &M) {
+	hash_code H = codeFingerprint(M);
+
+	if (Valid && Fingerprint == H) {
+		NTablesHits++;
+		return Tables;
+	}
+
+	NTablesMisses++;
+	delete Tables;
+	Tables = new RangedAliasTables();
+	Tables->build(M, getAnalysis<RangeAnalysisCache>().getModuleRA(M));
+	Fingerprint = H;
+	Valid = true;
+	return Tables;
+}
+
+void
+RangedAliasCache::forget(const Function &F) {
+	//The tables hold values of F. They are built again by the next call
+	Valid = false;
+}
@@ -0,0 +1,36 @@
+#ifndef __RANGED_ALIAS_CACHE_H__
+#define __RANGED_ALIAS_CACHE_H__
+
+#include "RangedAliasTables.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+
+namespace llvm
+{
+	/// RangedAliasCache - Keeps the tables of RangedAliasTables for the whole
+	/// run of the pass manager, so the alias analysis and the metadata they
+	/// back do not build them again after a transform that did not change the
+	/// code. The tables are built from the inter-procedural ranges of the
+	/// module, so they are built again, for the whole module, after any
+	/// function changed (see CodeFingerprint.h).
+	class RangedAliasCache : public ImmutablePass
+	{
+		private:
+			RangedAliasTables* Tables;
+			hash_code Fingerprint;
+			bool Valid;
+
+		public:
+			static char ID;
+			RangedAliasCache() : ImmutablePass(ID), Tables(NULL), Valid(false) {}
+			~RangedAliasCache();
+			void getAnalysisUsage(AnalysisUsage &AU) const;
+
+			//The tables of M. Owned by the cache, and only valid until the next call
+			RangedAliasTables* getTables(Module &M);
+			//Marks the tables out of date. Must be called before a function is
+			//deleted, since another one may be created at its address
+			void forget(const Function &F);
+	};
+}
+
+#endif
@@ -0,0 +1,305 @@
+#define DEBUG_TYPE "ranged-aa-metadata"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "RangedAliasCache.h"
+#include "llvm/Pass.h"
+#include "llvm/ADT/DenseMap.h"
+
+using namespace llvm;
+
+STATISTIC(NDomains, "Number of alias scope domains created");
+STATISTIC(NScopes, "Number of alias scopes created");
+STATISTIC(NAnnotated, "Number of loads and stores annotated");
+
+namespace llvm {
+	/// RangedAliasMetadata - Persists the disjointness proven by
+	/// RangedAliasTables as !alias.scope and !noalias metadata.
+	///
+	/// A load or store through a pointer of a table covers the rows from the
+	/// lowest offset of its pointer to the last primitive its bytes may reach
+	/// from the highest one. Each row covered by some access becomes a scope
+	/// of the table's domain. An access is in the scopes of the rows it covers,
+	/// and is marked noalias with the other scopes of the domain, so two
+	/// accesses are only noalias when they cover disjoint rows.
+	///
+	/// Scopes are created per function, so that globals and parameters shared
+	/// by several functions do not relate accesses of different functions.
+	class RangedAliasMetadata : public ModulePass {
+
+		typedef std::pair<RangedAliasTable*, Function*> DomainKey;
+		typedef std::pair<RangedAliasTableRow*, Function*> ScopeKey;
+
+		llvm::DenseMap<Value*, RangedAliasTable*> RangedAliasTableMap;
+		llvm::DenseMap<Value*, RangedPointer*> RangedPointerMap;
+		llvm::DenseMap<DomainKey, MDNode*> Domains;
+		llvm::DenseMap<ScopeKey, MDNode*> Scopes;
+		unsigned AliasScopeKind, NoAliasKind;
+		const DataLayout* DL;
+
+		//A load or store, and the rows of its table it may touch
+		struct Access
+		{
+			Instruction* inst;
+			RangedAliasTable* table;
+			std::set<RangedAliasTableRow*> rows;
+		};
+
+	  public:
+    static char ID; // Class identification, replacement for typeinfo
+    RangedAliasMetadata() : ModulePass(ID) {}
+
+    private:
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+    virtual bool runOnModule(Module &M);
+    MDNode* getDomain(RangedAliasTable* table, Function* F);
+    MDNode* getScope(RangedAliasTable* table, RangedAliasTableRow* row, Function* F);
+    MDNode* createDistinctNode(LLVMContext &Ctx, ArrayRef<Value*> Ops);
+    uint64_t getMinPrimitiveSize(Type* type);
+    bool getCoveredRows(Value* p, Access &A);
+    void annotate(Access &A, std::set<ScopeKey> &Used, Function* F);
+    void appendMetadata(Instruction* I, unsigned Kind, SmallVectorImpl<Value*> &List);
+  };
+}
+
+// Register this pass...
+char RangedAliasMetadata::ID = 0;
+static RegisterPass<RangedAliasMetadata> X("ranged-aa-metadata",
+"Emit alias.scope/noalias metadata from RangedAliasTables", false, false);
+
+void
+RangedAliasMetadata::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<RangedAliasCache>();
+}
+
+//Returns a node whose first operand is itself, followed by Ops. Such nodes
+//are never uniqued with another one, whatever their other operands are.
+MDNode*
+RangedAliasMetadata::createDistinctNode
+(LLVMContext &Ctx, ArrayRef<Value*> Ops)
+{
+	MDNode* dummy = MDNode::getTemporary(Ctx, ArrayRef<Value*>());
+	SmallVector<Value*, 3> ops;
+	ops.push_back(dummy);
+	ops.append(Ops.begin(), Ops.end());
+	MDNode* node = MDNode::get(Ctx, ops);
+	node->replaceOperandWith(0, node);
+	MDNode::deleteTemporary(dummy);
+	return node;
+}
+
+//Returns the scope domain of table inside function F
+MDNode*
+RangedAliasMetadata::getDomain
+(RangedAliasTable* table, Function* F)
+{
+	MDNode* &domain = Domains[std::make_pair(table, F)];
+	if(domain == NULL)
+	{
+		LLVMContext &Ctx = F->getContext();
+		std::string name = "ranged-aa domain " + F->getName().str();
+		Value* ops[] = { MDString::get(Ctx, name) };
+		domain = createDistinctNode(Ctx, ops);
+		NDomains++;
+	}
+	return domain;
+}
+
+//Returns the scope of row inside function F
+MDNode*
+RangedAliasMetadata::getScope
+(RangedAliasTable* table, RangedAliasTableRow* row, Function* F)
+{
+	MDNode* &scope = Scopes[std::make_pair(row, F)];
+	if(scope == NULL)
+	{
+		LLVMContext &Ctx = F->getContext();
+		std::string name = "ranged-aa scope " + F->getName().str();
+		Value* ops[] = { getDomain(table, F), MDString::get(Ctx, name) };
+		scope = createDistinctNode(Ctx, ops);
+		NScopes++;
+	}
+	return scope;
+}
+
+//Adds the scopes in List to the Kind metadata list already present in I
+void
+RangedAliasMetadata::appendMetadata
+(Instruction* I, unsigned Kind, SmallVectorImpl<Value*> &List)
+{
+	if(List.empty())
+		return;
+	if(MDNode* old = I->getMetadata(Kind))
+		for(unsigned i = 0, e = old->getNumOperands(); i != e; i++)
+			List.push_back(old->getOperand(i));
+	I->setMetadata(Kind, MDNode::get(I->getContext(), List));
+}
+
+//Returns the size in bytes of the smallest primitive of type, or 1 if it is
+//not known. Each primitive takes at least that many bytes of memory.
+uint64_t
+RangedAliasMetadata::getMinPrimitiveSize
+(Type* type)
+{
+	if(type->isArrayTy())
+		return getMinPrimitiveSize(type->getArrayElementType());
+	if(type->isVectorTy())
+		return getMinPrimitiveSize(type->getVectorElementType());
+	if(StructType* st = dyn_cast<StructType>(type))
+	{
+		uint64_t min = 0;
+		for(unsigned i = 0, e = st->getNumElements(); i != e; i++)
+		{
+			//Empty aggregates hold no primitive
+			Type* elem = st->getElementType(i);
+			if(elem->isAggregateType() && elem->isSized()
+					&& DL->getTypeAllocSize(elem) == 0)
+				continue;
+			uint64_t size = getMinPrimitiveSize(elem);
+			if(min == 0 || size < min)
+				min = size;
+		}
+		return min ? min : 1;
+	}
+	if(!type->isSized())
+		return 1;
+	uint64_t size = DL->getTypeStoreSize(type);
+	return size ? size : 1;
+}
+
+//Finds the table of p and the rows that an access of A->inst through p may
+//touch. Offsets are counted in primitives of the type of the table's base,
+//so the bytes of the access reach at most as many primitives as the
+//smallest of them fits in those bytes. Returns false if p has no table, or
+//if the access may touch anything in it.
+bool
+RangedAliasMetadata::getCoveredRows
+(Value* p, Access &A)
+{
+	DenseMap<Value*, RangedPointer*>::iterator pit = RangedPointerMap.find(p);
+	if(pit == RangedPointerMap.end())
+		return false;
+	RangedPointer* rp = pit->second;
+	DenseMap<Value*, RangedAliasTable*>::iterator tit =
+		RangedAliasTableMap.find(rp->father);
+	if(tit == RangedAliasTableMap.end())
+		return false;
+	A.table = tit->second;
+
+	//A table with a single row cannot separate anything
+	if(A.table->row_num < 2)
+		return false;
+
+	//The access may start anywhere in the range of p
+	Type* accessed = p->getType()->getPointerElementType();
+	uint64_t bytes = DL->getTypeStoreSize(accessed);
+	Type* base = rp->father->getType();
+	if(base->isPointerTy())
+		base = base->getPointerElementType();
+	uint64_t unit = getMinPrimitiveSize(base);
+	uint64_t extra = bytes > unit ? (bytes + unit - 1) / unit - 1 : 0;
+
+	APInt lower = rp->offset.getLower();
+	APInt upper = rp->offset.getUpper();
+	unsigned width = upper.getBitWidth();
+	APInt limit = APInt::getSignedMaxValue(width);
+	if(width <= 64 && extra > limit.getZExtValue())
+		upper = limit;
+	else if(upper.sgt(limit - APInt(width, extra)))
+		upper = limit;
+	else
+		upper += APInt(width, extra);
+
+	for(set<RangedAliasTableRow*>::iterator i = A.table->rows.begin(),
+	e = A.table->rows.end(); i != e; i++)
+		if((*i)->offset.getLower().sle(upper) and (*i)->offset.getUpper().sge(lower))
+			A.rows.insert(*i);
+
+	return A.rows.size() < A.table->rows.size();
+}
+
+//Marks the access A with the scopes of the rows it covers, and as noalias
+//with the other rows of Used, the rows covered by the accesses of its table
+void
+RangedAliasMetadata::annotate
+(Access &A, std::set<ScopeKey> &Used, Function* F)
+{
+	SmallVector<Value*, 8> AliasScopes;
+	SmallVector<Value*, 8> NoAliasScopes;
+	for(set<RangedAliasTableRow*>::iterator i = A.table->rows.begin(),
+	e = A.table->rows.end(); i != e; i++)
+	{
+		if(!Used.count(std::make_pair(*i, F)))
+			continue;
+		if(A.rows.count(*i))
+			AliasScopes.push_back(getScope(A.table, *i, F));
+		else
+			NoAliasScopes.push_back(getScope(A.table, *i, F));
+	}
+
+	appendMetadata(A.inst, AliasScopeKind, AliasScopes);
+	appendMetadata(A.inst, NoAliasKind, NoAliasScopes);
+}
+
+bool
+RangedAliasMetadata::runOnModule(Module &M) {
+  RangedAliasTables* RAT = getAnalysis<RangedAliasCache>().getTables(M);
+  RangedAliasTableMap = RAT->getRangedAliasTableMap();
+  RangedPointerMap = RAT->getRangedPointerMap();
+  AliasScopeKind = M.getContext().getMDKindID("alias.scope");
+  NoAliasKind = M.getContext().getMDKindID("noalias");
+
+  //Without the sizes of the accesses, no row is known to be out of reach
+  DataLayoutPass *DLP = getAnalysisIfAvailable<DataLayoutPass>();
+  DL = DLP ? &DLP->getDataLayout() : NULL;
+  if(DL == NULL)
+  	return false;
+
+  unsigned annotated = 0;
+  for (Module::iterator F = M.begin(), Fe = M.end(); F != Fe; F++)
+  {
+  	//The rows of each access first: an access is only noalias with the
+  	//rows that other accesses of the function cover
+  	std::vector<Access> Accesses;
+  	std::set<ScopeKey> Used;
+  	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+  	{
+  		Instruction* i = &(*I);
+  		Value* p = NULL;
+  		if(LoadInst* li = dyn_cast<LoadInst>(i))
+  			p = li->getPointerOperand();
+  		else if(StoreInst* si = dyn_cast<StoreInst>(i))
+  			p = si->getPointerOperand();
+  		else
+  			continue;
+
+  		//Accesses of unknown size may reach any row
+  		if(!p->getType()->getPointerElementType()->isSized())
+  			continue;
+
+  		Access A;
+  		A.inst = i;
+  		if(!getCoveredRows(p, A))
+  			continue;
+
+  		for(set<RangedAliasTableRow*>::iterator r = A.rows.begin(),
+  		re = A.rows.end(); r != re; r++)
+  			Used.insert(std::make_pair(*r, F));
+  		Accesses.push_back(A);
+  	}
+
+  	for(unsigned a = 0, ae = Accesses.size(); a != ae; a++)
+  	{
+  		annotate(Accesses[a], Used, F);
+  		NAnnotated++;
+  		annotated++;
+  	}
+  }
+
+  DEBUG(errs() << "ranged-aa-metadata: " << annotated << " accesses, "
+  	<< Scopes.size() << " scopes, " << Domains.size() << " domains\n");
+  return annotated > 0;
+}
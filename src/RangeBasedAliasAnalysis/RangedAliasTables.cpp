@@ -193,19 +193,6 @@ RangedPointer::FindByValue //Name
 * Calculate Primitive Layouts and Number of elements.
 */
 
-//Returns the sum of previous elements of vector
-int 
-RangedAliasTables::getSumBehind
-(std::vector<int> v, int i)
-{
-	int s = 0;
-	if(i > v.size())
-		i = v.size();
-	for(int j = i-1; j >= 0; j--)
-		s += v[j];
-	return s;
-}
-
 //Returns the type of the ith element inside type
 Type* 
 RangedAliasTables::getTypeInside
@@ -223,102 +210,6 @@ RangedAliasTables::getTypeInside
 		return NULL;	
 }
 	
-//Returns the number of primitive elements of type
-int //returns
-RangedAliasTables::getNumPrimitives //Name
-(Type* type) //Parameter
-{
-	//Verifies if this number of primitives was calculated already
-	for(int i = 0; i < NumPrimitives.size(); i++)
-		if(NumPrimitives[i]->type == type)
-			return NumPrimitives[i]->num;
-	
-	//if not
-	int np = 1;
-	if(type->isArrayTy())
-	{
-		int num = type->getArrayNumElements();
-		Type* arrtype = type->getArrayElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		np = num * arrtypenum;
-	}
-	else if(type->isStructTy())
-	{
-		int num = type->getStructNumElements();
-		np = 0;
-		for(int i = 0; i < num; i++)
-		{
-			Type* structelemtype = type->getStructElementType(i);
-			np += getNumPrimitives(structelemtype);
-		}
-	}
-	else if(type->isVectorTy())
-	{
-		int num = type->getVectorNumElements();
-		Type* arrtype = type->getVectorElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		np = num * arrtypenum;
-	}
-	
-	NumPrimitives.insert(NumPrimitives.end(), new NumPrimitive(type, np));
-	return np;
-}
-
-//Returns a vector with the primitive layout of type
-std::vector<int> //returns
-RangedAliasTables::getPrimitiveLayout //Name
-(Type* type) //Parameter
-{
-	//Verifies if this layout was calculated already
-	for(int i = 0; i < PrimitiveLayouts.size(); i++)
-		if(PrimitiveLayouts[i]->type == type)
-			return PrimitiveLayouts[i]->layout;
-	
-	//if not
-		
-	if(type->isArrayTy())
-	{
-		int num = type->getArrayNumElements();
-		std::vector<int> pm (num);
-		Type* arrtype = type->getArrayElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		for(int i = 0; i < num; i++)
-			pm[i] = arrtypenum;
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}
-	else if(type->isStructTy())
-	{
-		int num = type->getStructNumElements();
-		std::vector<int> pm (num);
-		for(int i = 0; i < num; i++)
-		{
-			Type* structelemtype = type->getStructElementType(i);
-			pm[i] = getNumPrimitives(structelemtype);
-		}
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}
-	else if(type->isVectorTy())
-	{
-		int num = type->getVectorNumElements();
-		std::vector<int> pm (num);
-		Type* arrtype = type->getVectorElementType();
-		int arrtypenum = getNumPrimitives(arrtype); 
-		for(int i = 0; i < num; i++)
-			pm[i] = arrtypenum;
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}
-	else
-	{
-		std::vector<int> pm (1);
-		pm[0] = 1;
-		PrimitiveLayouts.insert(PrimitiveLayouts.end(), new PrimitiveLayout(type, pm));
-		return pm;
-	}	
-}
-
 /*
 * Debug Functions
 */
@@ -382,22 +273,6 @@ RangedAliasTables::printNotUsedPointers
 	errs() << "-------------------------\n\n";
 }
 
-void //Returns Nothing 
-RangedAliasTables::printPrimitiveLayouts //Name
-(std::vector<PrimitiveLayout*> PrimitiveLayouts) //Parameters
-{
-	errs() << "\n-------------------------\nPrimitive Layouts:" << "\n";
-	for(int i = 0; i < PrimitiveLayouts.size(); i++)
-	{
-		errs() << *(PrimitiveLayouts[i]->type) << ":\n";
-		for(int j = 0; j < PrimitiveLayouts[i]->layout.size(); j++)
-			errs() << PrimitiveLayouts[i]->layout[j] << "  ";
-		errs() << "\n";
-	}
-	
-	errs() << "-------------------------\n\n";
-}
-
 void 
 RangedAliasTables::printRangedAliasTableMap
 ()
@@ -490,12 +365,49 @@ static RegisterPass<RangedAliasTables> X("ranged-alias-tables",
 bool //Returns 
 RangedAliasTables::runOnModule //Name
 (Module &M) //Parameters
+{
+	build(M, getAnalysis<InterProceduralRA<Cousot> >());
+	return false;
+}
+
+RangedAliasTables::~RangedAliasTables
+()
+{
+	//A pointer may be in more than one map, so each one is freed once
+	std::set<RangedPointer*> pointers;
+	for (llvm::DenseMap<Value*, RangedPointer*>::iterator i = RangedPointerMap.begin(),
+	e = RangedPointerMap.end(); i != e; ++i)
+		pointers.insert(i->second);
+	for (llvm::DenseMap<Value*, std::set<RangedPointer*> >::iterator i = RangedPointerSets.begin(),
+	e = RangedPointerSets.end(); i != e; ++i)
+		pointers.insert(i->second.begin(), i->second.end());
+	for (std::set<RangedPointer*>::iterator i = pointers.begin(), e = pointers.end(); i != e; ++i)
+		delete *i;
+
+	for (llvm::DenseMap<Value*, RangedAliasTable*>::iterator i = RangedAliasTableMap.begin(),
+	e = RangedAliasTableMap.end(); i != e; ++i)
+	{
+		for (set<RangedAliasTableRow*>::iterator ii = i->second->rows.begin(),
+		ee = i->second->rows.end(); ii != ee; ++ii)
+			delete *ii;
+		delete i->second;
+	}
+}
+
+/*
+*
+* Builds the tables of M from the ranges of ra. Also used by RangedAliasCache
+*
+*/
+
+void //Returns nothing
+RangedAliasTables::build //Name
+(Module &M, InterProceduralRA<Cousot> &ra) //Parameters
 {
 	/*
-	* Gets RangeAnalysis Pass Data, declares some auxiliary sets and initiates statistics.
+	* Declares some auxiliary sets and initiates statistics.
 	*/
 	
-	InterProceduralRA<Cousot> &ra = getAnalysis<InterProceduralRA<Cousot> >();
 	unsigned MaxBitWidth = getMaxBitWidth(M);
 	DEBUG(printRangeAnalysis(&ra, &M));
 	
@@ -627,7 +539,7 @@ RangedAliasTables::runOnModule //Name
        	
        	//Number of primitive elements
        	Type* base_ptr_type = base_ptr->getType();
-       	int base_ptr_num_primitive = getNumPrimitives(base_ptr_type->getPointerElementType());
+       	int base_ptr_num_primitive = PrimitiveLayouts.getNumPrimitives(base_ptr_type->getPointerElementType());
        	
        	//parse first index
        	User::op_iterator idx = ((GetElementPtrInst*)i)->idx_begin();
@@ -688,7 +600,7 @@ RangedAliasTables::runOnModule //Name
        	{
        		//Calculating Primitive Layout
        		base_ptr_type = getTypeInside(base_ptr_type, index.getSExtValue());
-     			std::vector<int> base_ptr_primitive_layout = getPrimitiveLayout(base_ptr_type);
+     			PrimitiveLayout* base_ptr_primitive_layout = PrimitiveLayouts.getPrimitiveLayout(base_ptr_type);
      			
      			Value* indx = idx->get();
         	if(isa<ConstantInt>(*indx))
@@ -707,8 +619,8 @@ RangedAliasTables::runOnModule //Name
 		      	higher_range = higher_range.sextOrTrunc(higher_bitwidth);
 		      	constant = constant.sextOrTrunc(higher_bitwidth);
 		      	
-						lower_range = safe_addition( lower_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
-						higher_range = safe_addition( higher_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
+						lower_range = safe_addition( lower_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
+						higher_range = safe_addition( higher_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, constant.getSExtValue()) ) );
 
 		      	index = constant;
         	}
@@ -734,8 +646,8 @@ RangedAliasTables::runOnModule //Name
 		      		rl = rl.sextOrTrunc(higher_bitwidth);
 		      		ru = ru.sextOrTrunc(higher_bitwidth);
 		        
-		        	lower_range = safe_addition( lower_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, rl.getSExtValue()) ) );
-							higher_range = safe_addition( higher_range, APInt(higher_bitwidth, getSumBehind(base_ptr_primitive_layout, ru.getSExtValue()) ) );
+		        	lower_range = safe_addition( lower_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, rl.getSExtValue()) ) );
+							higher_range = safe_addition( higher_range, APInt(higher_bitwidth, PrimitiveLayouts.getSumBehind(base_ptr_primitive_layout, ru.getSExtValue()) ) );
 		        
 		        	index = Zero;
 		    	  }
@@ -757,7 +669,7 @@ RangedAliasTables::runOnModule //Name
 	
 	DEBUG(printRangedPointerMap());
 	DEBUG(printNotUsedPointers());
-	DEBUG(printPrimitiveLayouts(PrimitiveLayouts));
+	DEBUG(PrimitiveLayouts.print());
 	
 	/*
 	* Separating pointers for table construction
@@ -15,6 +15,7 @@
 #include <vector>
 #include <algorithm>
 #include "../RangeAnalysis/RangeAnalysis.h"
+#include "PrimitiveLayouts.h"
 
 using namespace std;
 
@@ -84,33 +85,8 @@ namespace llvm
 	class RangedAliasTables: public ModulePass
 	{
 		private:
-			//Holds a Primitive Layout for a determined Type
-			struct PrimitiveLayout
-			{
-				Type * type;
-				std::vector<int> layout;
-				PrimitiveLayout(Type* ty, std::vector<int> lay)
-				{
-					type = ty;
-					layout = lay;
-				}
-			};
-			struct NumPrimitive
-			{
-				Type * type;
-				int num;
-				NumPrimitive(Type* ty, int n)
-				{
-					type = ty;
-					num = n;
-				}
-			};
-			std::vector<PrimitiveLayout*> PrimitiveLayouts;
-			std::vector<NumPrimitive*> NumPrimitives;
-			std::vector<int> getPrimitiveLayout(Type* type);
-			int getNumPrimitives(Type* type);
+			PrimitiveLayoutTable PrimitiveLayouts;
 			llvm::Type* getTypeInside(Type* type, int i);
-			int getSumBehind(std::vector<int> v, int i);
 		
 			//Persistent maps
 			llvm::DenseMap<Value*, RangedPointer*> RangedPointerMap;
@@ -122,15 +98,17 @@ namespace llvm
 			void printRangeAnalysis(InterProceduralRA<Cousot> *ra, Module *M);
 			void printRangedPointerMap();
 			void printNotUsedPointers();
-			void printPrimitiveLayouts(std::vector<PrimitiveLayout*> PrimitiveLayouts);
 			void printRangedAliasTableMap();
 			
 		public:
 			//LLVM framework methods and atributes
 			static char ID;
 			RangedAliasTables() : ModulePass(ID){}
+			~RangedAliasTables();
 			bool runOnModule(Module &M);
 			void getAnalysisUsage(AnalysisUsage &AU) const;
+			//Builds the tables from the given ranges, out of a pass manager
+			void build(Module &M, InterProceduralRA<Cousot> &ra);
 			
 			//methods that return the persistent maps
 			llvm::DenseMap<Value*, RangedPointer*> getRangedPointerMap();
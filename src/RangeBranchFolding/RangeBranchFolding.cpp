@@ -0,0 +1,295 @@
+//===- RangeBranchFolding.cpp - Fold branches decided by range analysis --===//
+//
+// This pass uses the ranges computed by the interprocedural range analysis to
+// fold integer comparisons whose result does not depend on the values of
+// their operands, to remove the cases of switches that the condition can
+// never take, and to delete the blocks that become unreachable.
+//
+// Removing code can only shrink the ranges of the values that remain, so
+// running the range analysis again may decide more comparisons. The pass
+// repeats folding and analysis until nothing changes, or until it has done
+// -rbf-max-rounds rounds.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-branch-folding"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+#include "RangeBranchFolding.h"
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+MaxRounds("rbf-max-rounds", cl::desc("Maximum number of rounds of folding and range analysis (0 means until nothing changes)."), cl::init(0));
+
+static cl::opt<bool, false>
+PrintReport("rbf-report", cl::desc("Print the branches eliminated in each function."), cl::NotHidden);
+
+STATISTIC(NumCmpsFolded, "Number of comparisons folded");
+STATISTIC(NumBranchesFolded, "Number of branches and switches folded");
+STATISTIC(NumCasesRemoved, "Number of switch cases removed");
+STATISTIC(NumBlocksDeleted, "Number of unreachable blocks deleted");
+STATISTIC(NumReanalyses, "Number of times the range analysis was run again");
+
+namespace {
+	// Code eliminated in one function
+	struct FoldCounts {
+		unsigned Cmps, Branches, Cases, Blocks;
+		FoldCounts() : Cmps(0), Branches(0), Cases(0), Blocks(0) { }
+	};
+
+	// Result of a comparison over the ranges of its operands
+	enum CmpResult { crUnknown, crTrue, crFalse };
+
+	class RangeBranchFolding : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		DenseMap<const Function*, FoldCounts> Counts;
+
+	public:
+		static char ID;
+		RangeBranchFolding() : ModulePass(ID), RA(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool runOnFunction(Function &F);
+		CmpResult evaluate(ICmpInst *Cmp);
+		bool simplifySwitch(SwitchInst *SI, FoldCounts &FC);
+		void printReport(Module &M);
+	};
+}
+
+char RangeBranchFolding::ID = 0;
+static RegisterPass<RangeBranchFolding> X("range-branch-folding",
+"Fold branches and delete code using range analysis", false, false);
+
+void RangeBranchFolding::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool RangeBranchFolding::runOnModule(Module &M) {
+	// The cache only runs the analysis again if the last round changed M
+	RangeAnalysisCache &Cache = getAnalysis<RangeAnalysisCache>();
+	Counts.clear();
+	bool Modified = false;
+
+	for (unsigned Round = 1; ; ++Round) {
+		if (Round > 1)
+			++NumReanalyses;
+		RA = &Cache.getModuleRA(M);
+
+		bool Changed = false;
+		for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+			// There is nothing to fold in declarations
+			if (Fit->isDeclaration())
+				continue;
+
+			Changed |= runOnFunction(*Fit);
+		}
+
+		Modified |= Changed;
+		if (!Changed || Round == MaxRounds)
+			break;
+	}
+
+	RA = NULL;
+
+	if (PrintReport)
+		printReport(M);
+
+	return Modified;
+}
+
+CmpResult RangeBranchFolding::evaluate(ICmpInst *Cmp) {
+	if (!Cmp->getOperand(0)->getType()->isIntegerTy())
+		return crUnknown;
+
+	APInt LA, UA, LB, UB;
+	if (!getRegularBounds(RA, Cmp->getOperand(0), LA, UA)
+			|| !getRegularBounds(RA, Cmp->getOperand(1), LB, UB))
+		return crUnknown;
+
+	ICmpInst::Predicate P = Cmp->getPredicate();
+
+	// Unsigned comparisons order the operands as the signed ones when both
+	// have the same sign. Otherwise the negative one is the greatest.
+	if (Cmp->isUnsigned()) {
+		bool NegA = UA.isNegative(), NegB = UB.isNegative();
+		if ((!NegA && LA.isNegative()) || (!NegB && LB.isNegative()))
+			return crUnknown;
+
+		if (NegA != NegB) {
+			bool Greater = (P == ICmpInst::ICMP_UGT || P == ICmpInst::ICMP_UGE);
+			return Greater == NegA ? crTrue : crFalse;
+		}
+
+		P = Cmp->getSignedPredicate();
+	}
+
+	// We only have to decide <, <= and ==
+	if (P == ICmpInst::ICMP_SGT || P == ICmpInst::ICMP_SGE) {
+		std::swap(LA, LB);
+		std::swap(UA, UB);
+		P = ICmpInst::getSwappedPredicate(P);
+	}
+
+	switch (P) {
+	case ICmpInst::ICMP_SLT:
+		if (UA.slt(LB)) return crTrue;
+		if (LA.sge(UB)) return crFalse;
+		return crUnknown;
+	case ICmpInst::ICMP_SLE:
+		if (UA.sle(LB)) return crTrue;
+		if (LA.sgt(UB)) return crFalse;
+		return crUnknown;
+	case ICmpInst::ICMP_EQ:
+	case ICmpInst::ICMP_NE: {
+		CmpResult Equal = crUnknown;
+		if (UA.slt(LB) || UB.slt(LA))
+			Equal = crFalse;
+		else if (LA.eq(UA) && LB.eq(UB) && LA.eq(LB))
+			Equal = crTrue;
+
+		if (P == ICmpInst::ICMP_EQ || Equal == crUnknown)
+			return Equal;
+
+		return Equal == crTrue ? crFalse : crTrue;
+	}
+	default:
+		return crUnknown;
+	}
+}
+
+unsigned llvm::pruneSwitchCases(SwitchInst *SI, const APInt &Lower, const APInt &Upper) {
+	BasicBlock *BB = SI->getParent();
+	unsigned Width = Lower.getBitWidth();
+	unsigned Removed = 0;
+
+	for (unsigned i = SI->getNumCases(); i-- > 0; ) {
+		SwitchInst::CaseIt Case(SI, i);
+		APInt CaseValue = Case.getCaseValue()->getValue().sext(Width);
+
+		if (CaseValue.sge(Lower) && CaseValue.sle(Upper))
+			continue;
+
+		Case.getCaseSuccessor()->removePredecessor(BB);
+		SI->removeCase(Case);
+		++Removed;
+	}
+
+	// Cases are distinct, so they cover [Lower, Upper] if there are as many
+	unsigned NumCases = SI->getNumCases();
+	if (NumCases > 0 && (Upper - Lower).ult(APInt(Width, NumCases))) {
+		SwitchInst::CaseIt Last(SI, NumCases - 1);
+		BasicBlock *Default = SI->getDefaultDest();
+
+		SI->setDefaultDest(Last.getCaseSuccessor());
+		SI->removeCase(Last);
+		Default->removePredecessor(BB);
+		++Removed;
+	}
+
+	return Removed;
+}
+
+// Removes the cases the condition of SI can never take, or replaces the
+// condition by a constant if it can only take one value
+bool RangeBranchFolding::simplifySwitch(SwitchInst *SI, FoldCounts &FC) {
+	APInt Lower, Upper;
+	if (!getRegularBounds(RA, SI->getCondition(), Lower, Upper))
+		return false;
+
+	// A condition with a single value is a constant
+	if (Lower.eq(Upper) && !isa<Constant>(SI->getCondition())) {
+		IntegerType *Ty = cast<IntegerType>(SI->getCondition()->getType());
+		SI->setCondition(ConstantInt::get(Ty, Lower.trunc(Ty->getBitWidth())));
+		return true;
+	}
+
+	unsigned Removed = pruneSwitchCases(SI, Lower, Upper);
+	FC.Cases += Removed;
+	NumCasesRemoved += Removed;
+
+	return Removed > 0;
+}
+
+bool RangeBranchFolding::runOnFunction(Function &F) {
+	FoldCounts &FC = Counts[&F];
+	bool Changed = false;
+
+	// First decide everything, then change the code
+	SmallVector<std::pair<ICmpInst*, bool>, 16> Decided;
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+		if (ICmpInst *Cmp = dyn_cast<ICmpInst>(&*I)) {
+			CmpResult R = evaluate(Cmp);
+			if (R != crUnknown)
+				Decided.push_back(std::make_pair(Cmp, R == crTrue));
+		}
+	}
+
+	for (unsigned i = 0, e = Decided.size(); i < e; ++i) {
+		ICmpInst *Cmp = Decided[i].first;
+		Cmp->replaceAllUsesWith(ConstantInt::get(Cmp->getType(), Decided[i].second));
+		Cmp->eraseFromParent();
+		++FC.Cmps;
+		++NumCmpsFolded;
+		Changed = true;
+	}
+
+	for (Function::iterator BBit = F.begin(), BBend = F.end(); BBit != BBend; ++BBit) {
+		if (SwitchInst *SI = dyn_cast<SwitchInst>(BBit->getTerminator()))
+			Changed |= simplifySwitch(SI, FC);
+
+		TerminatorInst *TI = BBit->getTerminator();
+		Value *Cond = NULL;
+		if (BranchInst *BI = dyn_cast<BranchInst>(TI)) {
+			if (BI->isConditional())
+				Cond = BI->getCondition();
+		} else if (SwitchInst *SI = dyn_cast<SwitchInst>(TI)) {
+			Cond = SI->getCondition();
+		}
+
+		if (Cond && isa<Constant>(Cond) && ConstantFoldTerminator(BBit)) {
+			++FC.Branches;
+			++NumBranchesFolded;
+			Changed = true;
+		}
+	}
+
+	unsigned Before = F.size();
+	if (removeUnreachableBlocks(F)) {
+		FC.Blocks += Before - F.size();
+		NumBlocksDeleted += Before - F.size();
+		Changed = true;
+	}
+
+	return Changed;
+}
+
+void RangeBranchFolding::printReport(Module &M) {
+	errs() << "Function\tBranches\tCases\tComparisons\tBlocks\n";
+
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		DenseMap<const Function*, FoldCounts>::iterator it = Counts.find(&*Fit);
+		if (it == Counts.end())
+			continue;
+
+		const FoldCounts &FC = it->second;
+		if (!FC.Cmps && !FC.Branches && !FC.Cases && !FC.Blocks)
+			continue;
+
+		errs() << Fit->getName() << "\t" << FC.Branches << "\t" << FC.Cases
+				<< "\t" << FC.Cmps << "\t" << FC.Blocks << "\n";
+	}
+}
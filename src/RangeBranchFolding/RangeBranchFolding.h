@@ -0,0 +1,23 @@
+//===- RangeBranchFolding.h - Control flow simplified with ranges -*- C++ -*-===//
+//
+// Helpers shared by the passes that simplify control flow with the ranges of
+// the interprocedural range analysis.
+//
+//===----------------------------------------------------------------------===//
+#ifndef RANGEBRANCHFOLDING_H_
+#define RANGEBRANCHFOLDING_H_
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/IR/Instructions.h"
+
+namespace llvm {
+
+/// Removes the cases of SI outside [Lower, Upper], the signed range of its
+/// condition, which may be wider than the condition. If the cases left cover
+/// the whole range, the default destination is dead too, and is replaced by
+/// the destination of the last case. Returns the number of cases removed.
+unsigned pruneSwitchCases(SwitchInst *SI, const APInt &Lower, const APInt &Upper);
+
+}
+
+#endif /* RANGEBRANCHFOLDING_H_ */
@@ -0,0 +1,282 @@
+//===- RangeSwitchLowering.cpp - Lower switches using their ranges -------===//
+//
+// This pass uses the range of the condition of each switch, as computed by
+// the interprocedural range analysis, to make the switch cheaper to lower:
+//
+// - Cases outside the range are removed, and the default destination is
+//   removed when the cases cover the whole range, so the code generator
+//   emits no guard for it.
+// - If every destination only selects values for the phis of a common
+//   successor, the switch becomes a load from one table per phi, indexed by
+//   the condition minus the lower bound of its range. The range bounds the
+//   index, so the load needs no guard either.
+// - Otherwise, the switch is rebased to the index, so that its cases
+//   start at zero.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-switch-lowering"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "RangeBranchFolding.h"
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+MaxTableSize("rsl-max-table-size", cl::desc("Largest range of a switch condition turned into a lookup table."), cl::init(1024));
+
+STATISTIC(NumSwitches, "Number of switches with a bounded condition");
+STATISTIC(NumCasesRemoved, "Number of switch cases removed");
+STATISTIC(NumDefaultsRemoved, "Number of default destinations removed");
+STATISTIC(NumLookupTables, "Number of switches turned into lookup tables");
+STATISTIC(NumRebased, "Number of switches rebased to a zero based index");
+
+namespace {
+	class RangeSwitchLowering : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		const TargetTransformInfo *TTI;
+
+	public:
+		static char ID;
+		RangeSwitchLowering() : ModulePass(ID), RA(NULL), TTI(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool runOnFunction(Function &F);
+		bool lowerSwitch(SwitchInst *SI);
+		BasicBlock *getSelectedBlock(BasicBlock *Dest, BasicBlock *BB, BasicBlock *&From) const;
+		bool buildLookupTables(SwitchInst *SI, const APInt &Lower, uint64_t TableSize);
+		Value *buildIndex(SwitchInst *SI, const APInt &Lower);
+	};
+}
+
+char RangeSwitchLowering::ID = 0;
+static RegisterPass<RangeSwitchLowering> X("range-switch-lowering",
+"Lower switches using the ranges of their conditions", false, false);
+
+void RangeSwitchLowering::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+	AU.addRequired<TargetTransformInfo>();
+}
+
+bool RangeSwitchLowering::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+	TTI = &getAnalysis<TargetTransformInfo>();
+
+	bool Changed = false;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		// There is nothing to lower in declarations
+		if (Fit->isDeclaration())
+			continue;
+
+		Changed |= runOnFunction(*Fit);
+	}
+
+	return Changed;
+}
+
+bool RangeSwitchLowering::runOnFunction(Function &F) {
+	SmallVector<SwitchInst*, 8> Switches;
+	for (Function::iterator BBit = F.begin(), BBend = F.end(); BBit != BBend; ++BBit)
+		if (SwitchInst *SI = dyn_cast<SwitchInst>(BBit->getTerminator()))
+			Switches.push_back(SI);
+
+	bool Changed = false;
+	for (unsigned i = 0, e = Switches.size(); i < e; ++i)
+		Changed |= lowerSwitch(Switches[i]);
+
+	// Destinations only reached by switches that became lookups
+	if (Changed)
+		removeUnreachableBlocks(F);
+
+	return Changed;
+}
+
+bool RangeSwitchLowering::lowerSwitch(SwitchInst *SI) {
+	Value *Cond = SI->getCondition();
+	if (isa<Constant>(Cond))
+		return false;
+
+	Range R = RA->getRange(Cond);
+	if (!R.isRegular() || R.getLower().eq(RA->getMin()) || R.getUpper().eq(RA->getMax()))
+		return false;
+
+	// The analysis works on the widest integer of the module, so the bounds
+	// must also fit the condition
+	APInt Lower = R.getLower(), Upper = R.getUpper();
+	unsigned Width = Lower.getBitWidth();
+	unsigned CondWidth = Cond->getType()->getIntegerBitWidth();
+	if (Lower.slt(APInt::getSignedMinValue(CondWidth).sext(Width))
+			|| Upper.sgt(APInt::getSignedMaxValue(CondWidth).sext(Width)))
+		return false;
+
+	++NumSwitches;
+
+	// The default destination is dead if the cases in range cover it all
+	unsigned InRange = 0;
+	for (SwitchInst::CaseIt Case = SI->case_begin(), E = SI->case_end(); Case != E; ++Case) {
+		APInt CaseValue = Case.getCaseValue()->getValue().sext(Width);
+		if (CaseValue.sge(Lower) && CaseValue.sle(Upper))
+			++InRange;
+	}
+	if (InRange > 0 && (Upper - Lower).ult(APInt(Width, InRange)))
+		++NumDefaultsRemoved;
+
+	unsigned Removed = pruneSwitchCases(SI, Lower, Upper);
+	NumCasesRemoved += Removed;
+
+	// Nothing left to lower, the branch folding will turn it into a branch
+	if (SI->getNumCases() == 0)
+		return Removed > 0;
+
+	APInt Size = Upper - Lower + 1;
+	if (Size.ule(APInt(Width, MaxTableSize)) && TTI->shouldBuildLookupTables()
+			&& buildLookupTables(SI, Lower, Size.getZExtValue())) {
+		++NumLookupTables;
+		return true;
+	}
+
+	if (!Lower)
+		return Removed > 0;
+
+	// Rebase the cases to start at zero
+	IntegerType *Ty = cast<IntegerType>(Cond->getType());
+	SI->setCondition(buildIndex(SI, Lower));
+	for (SwitchInst::CaseIt Case = SI->case_begin(), E = SI->case_end(); Case != E; ++Case) {
+		APInt Index = Case.getCaseValue()->getValue().sext(Width) - Lower;
+		Case.setValue(ConstantInt::get(Ty, Index.trunc(CondWidth)));
+	}
+	++NumRebased;
+
+	return true;
+}
+
+// Condition of SI minus Lower, inserted before SI. It is between 0 and the
+// size of the range, as an unsigned number.
+Value *RangeSwitchLowering::buildIndex(SwitchInst *SI, const APInt &Lower) {
+	Value *Cond = SI->getCondition();
+	IntegerType *Ty = cast<IntegerType>(Cond->getType());
+
+	if (!Lower)
+		return Cond;
+
+	Constant *Offset = ConstantInt::get(Ty, Lower.trunc(Ty->getBitWidth()));
+	return BinaryOperator::CreateSub(Cond, Offset, Cond->getName() + ".idx", SI);
+}
+
+// The block whose phis Dest selects values for, when SI in BB jumps to Dest.
+// Dest selects for its successor if it only branches there, and it is only
+// reached from BB. Otherwise, Dest selects for itself. From is the block that
+// reaches the selected one.
+BasicBlock *RangeSwitchLowering::getSelectedBlock(BasicBlock *Dest, BasicBlock *BB,
+		BasicBlock *&From) const {
+	From = BB;
+
+	BranchInst *Br = dyn_cast<BranchInst>(&Dest->front());
+	if (!Br || Br->isConditional())
+		return Dest;
+
+	for (pred_iterator PI = pred_begin(Dest), E = pred_end(Dest); PI != E; ++PI)
+		if (*PI != BB)
+			return Dest;
+
+	From = Dest;
+	return Br->getSuccessor(0);
+}
+
+// Replaces SI by loads from tables, one for each phi of the block where all
+// destinations of SI lead to. Fails if there is no such block, or if some
+// value selected is not a constant.
+bool RangeSwitchLowering::buildLookupTables(SwitchInst *SI, const APInt &Lower,
+		uint64_t TableSize) {
+	BasicBlock *BB = SI->getParent();
+	unsigned Width = Lower.getBitWidth();
+
+	// Same density as the lookup tables of SimplifyCFG, which only has the
+	// case values to go by
+	unsigned NumCases = SI->getNumCases() + 1;
+	if (NumCases < 4 || NumCases * 10 < TableSize * 4)
+		return false;
+
+	// Where each entry of the table comes from. Entries no case covers come
+	// from the default destination.
+	BasicBlock *DefaultFrom;
+	BasicBlock *Target = getSelectedBlock(SI->getDefaultDest(), BB, DefaultFrom);
+	SmallVector<BasicBlock*, 64> From(TableSize, DefaultFrom);
+
+	for (SwitchInst::CaseIt Case = SI->case_begin(), E = SI->case_end(); Case != E; ++Case) {
+		BasicBlock *CaseFrom;
+		if (getSelectedBlock(Case.getCaseSuccessor(), BB, CaseFrom) != Target)
+			return false;
+
+		APInt Index = Case.getCaseValue()->getValue().sext(Width) - Lower;
+		From[Index.getZExtValue()] = CaseFrom;
+	}
+
+	if (Target == BB)
+		return false;
+
+	SmallVector<PHINode*, 4> Phis;
+	for (BasicBlock::iterator I = Target->begin(); PHINode *PN = dyn_cast<PHINode>(I); ++I) {
+		for (uint64_t i = 0; i < TableSize; ++i)
+			if (!isa<Constant>(PN->getIncomingValueForBlock(From[i])))
+				return false;
+
+		Phis.push_back(PN);
+	}
+
+	Module *M = BB->getParent()->getParent();
+	Value *Index = NULL;
+	if (!Phis.empty()) {
+		// Zero extended, because the index may not fit as a signed number
+		Index = buildIndex(SI, Lower);
+		if (Index->getType()->getIntegerBitWidth() < 64)
+			Index = new ZExtInst(Index, Type::getInt64Ty(M->getContext()),
+					Index->getName() + ".ext", SI);
+	}
+
+	for (unsigned p = 0, e = Phis.size(); p < e; ++p) {
+		PHINode *PN = Phis[p];
+
+		SmallVector<Constant*, 64> Values;
+		for (uint64_t i = 0; i < TableSize; ++i)
+			Values.push_back(cast<Constant>(PN->getIncomingValueForBlock(From[i])));
+
+		ArrayType *TableTy = ArrayType::get(PN->getType(), TableSize);
+		GlobalVariable *Table = new GlobalVariable(*M, TableTy, true,
+				GlobalValue::PrivateLinkage, ConstantArray::get(TableTy, Values),
+				"switch.table");
+		Table->setUnnamedAddr(true);
+
+		Value *Idxs[] = { ConstantInt::get(Index->getType(), 0), Index };
+		Value *Ptr = GetElementPtrInst::CreateInBounds(Table, Idxs,
+				PN->getName() + ".ptr", SI);
+		Value *Load = new LoadInst(Ptr, PN->getName() + ".load", SI);
+
+		// The switch reached the phi through one edge per case that went
+		// there directly. The branch that replaces it is a single edge.
+		while (PN->getBasicBlockIndex(BB) >= 0)
+			PN->removeIncomingValue(BB, false);
+		PN->addIncoming(Load, BB);
+	}
+
+	// The other destinations are only reached from BB, so they are unreachable
+	// now, and their entries in the phis go away with them
+	BranchInst::Create(Target, SI);
+	SI->eraseFromParent();
+
+	return true;
+}
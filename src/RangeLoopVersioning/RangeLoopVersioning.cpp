@@ -0,0 +1,670 @@
+//===- RangeLoopVersioning.cpp - Version loops on range predicates --------===//
+//
+// This pass versions loops on a predicate, checked once before the loop,
+// under which the range analysis proves that the bounds checks and the
+// overflow checks inside the loop always pass. The fast version runs
+// without those checks; the original loop runs when the predicate fails.
+//
+// The predicate is built from the symbolic intervals of the sigmas that
+// copy the indices. If idx is a copy of a sigma whose value is below the
+// bound n, as in the body of a loop guarded by i < n, and n and len are not
+// changed in the loop, then:
+//
+// - the check idx < len holds if n <= len;
+// - the check that idx + c does not overflow holds if n <= MAX - c + 1.
+//
+// A check of the form idx >= 0 holds if idx only grows from the value start
+// it has when the loop is entered, and start >= 0.
+//
+// The predicate is the conjunction of such comparisons, without those the
+// ranges already prove. Loops only get a version if it removes at least
+// one check that the other range passes cannot remove, e.g. -ra-bce.
+//
+// The analysis must run on e-SSA form, either with sigmas in the IR or with
+// -ra-essa-overlay, since without sigmas there are no symbolic intervals.
+// Only outermost loops in LCSSA form with a preheader are versioned; the
+// checks in the inner loops are removed too if their predicates can be
+// checked before the outermost loop.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-loop-versioning"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+MaxGuards("rlv-max-guards", cl::desc("Largest number of comparisons in the predicate of a loop."), cl::init(4));
+
+static cl::opt<unsigned>
+MaxSize("rlv-max-size", cl::desc("Largest number of instructions in a loop to version."), cl::init(500));
+
+static cl::opt<bool, false>
+PrintReport("rlv-report", cl::desc("Print the loops versioned, their predicates and the checks removed."), cl::NotHidden);
+
+STATISTIC(NumLoops, "Number of outermost loops found");
+STATISTIC(NumLoopsVersioned, "Number of loops versioned");
+STATISTIC(NumGuards, "Number of comparisons in the predicates");
+STATISTIC(NumBoundsChecks, "Number of bounds checks removed from the fast versions");
+STATISTIC(NumOverflowChecks, "Number of overflow checks removed from the fast versions");
+STATISTIC(NumInstsCloned, "Number of instructions in the fast versions");
+
+namespace {
+	// LHS Pred RHS, with LHS and RHS defined before the loop
+	struct Guard {
+		CmpInst::Predicate Pred;
+		const Value *LHS, *RHS;
+	};
+
+	// X + Inc, with Inc > 0, computed by a signed add or sub with overflow
+	struct OverflowCheck {
+		IntrinsicInst *II;
+		unsigned XIdx;
+		APInt Inc;
+	};
+
+	struct Version {
+		Loop *L;
+		BasicBlock *Preheader;
+		SmallVector<Guard, 4> Guards;
+		SmallVector<BoundsCheck, 8> BoundsChecks;
+		SmallVector<OverflowCheck, 8> OverflowChecks;
+	};
+
+	class RangeLoopVersioning : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		ConstraintGraph *CG;
+
+	public:
+		static char ID;
+		RangeLoopVersioning() : ModulePass(ID), RA(NULL), CG(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool plan(Loop *L, Version &V);
+		bool isClosed(const Loop *L) const;
+		bool isAvailable(const Value *V, const Loop *L) const;
+		bool matchOverflow(Instruction *I, OverflowCheck &Check) const;
+		bool proveCheck(const BoundsCheck &Check, const Loop *L,
+				SmallVectorImpl<Guard> &Guards);
+		bool proveOverflow(const OverflowCheck &Check, const Loop *L,
+				SmallVectorImpl<Guard> &Guards);
+		bool proveNonNegative(const Value *Idx, const Loop *L,
+				SmallVectorImpl<Guard> &Guards);
+		bool require(CmpInst::Predicate Pred, const Value *LHS, const Value *RHS,
+				SmallVectorImpl<Guard> &Guards);
+		bool addGuards(Version &V, const SmallVectorImpl<Guard> &New) const;
+
+		const Value *stripIncrements(const Value *V) const;
+		bool findUpperBound(const Value *Idx, const Loop *L, const Value *&Bound,
+				bool &Strict) const;
+		const Value *findStart(const Value *Idx, const Loop *L) const;
+
+		void version(Version &V);
+		void report(const Version &V) const;
+	};
+}
+
+char RangeLoopVersioning::ID = 0;
+static RegisterPass<RangeLoopVersioning> X("range-loop-versioning",
+"Version loops on predicates that remove their checks", false, false);
+
+void RangeLoopVersioning::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+	AU.addRequired<LoopInfo>();
+}
+
+bool RangeLoopVersioning::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+	CG = RA->getConstraintGraph();
+
+	bool Changed = false;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		if (Fit->isDeclaration())
+			continue;
+
+		LoopInfo &LI = getAnalysis<LoopInfo>(*Fit);
+
+		// Outermost loops do not share blocks, so versioning one of them
+		// does not change the others
+		SmallVector<Version, 4> Versions;
+		for (LoopInfo::iterator Lit = LI.begin(), Lend = LI.end(); Lit != Lend; ++Lit) {
+			++NumLoops;
+			Version V;
+			if (plan(*Lit, V))
+				Versions.push_back(V);
+		}
+
+		for (unsigned i = 0, e = Versions.size(); i < e; ++i) {
+			if (PrintReport)
+				report(Versions[i]);
+			version(Versions[i]);
+		}
+
+		if (!Versions.empty()) {
+			removeUnreachableBlocks(*Fit);
+			Changed = true;
+		}
+	}
+
+	return Changed;
+}
+
+// Finds the checks of L, and the predicate under which they pass. Fails if
+// no check needs a predicate.
+bool RangeLoopVersioning::plan(Loop *L, Version &V) {
+	BasicBlock *Preheader = L->getLoopPreheader();
+	if (!Preheader || !isClosed(L))
+		return false;
+
+	BranchInst *Entry = dyn_cast<BranchInst>(Preheader->getTerminator());
+	if (!Entry || Entry->isConditional())
+		return false;
+
+	unsigned Size = 0;
+	for (Loop::block_iterator BI = L->block_begin(), BE = L->block_end(); BI != BE; ++BI)
+		Size += (*BI)->size();
+	if (Size > MaxSize)
+		return false;
+
+	V.L = L;
+	V.Preheader = Preheader;
+	for (Loop::block_iterator BI = L->block_begin(), BE = L->block_end(); BI != BE; ++BI) {
+		for (BasicBlock::iterator I = (*BI)->begin(), E = (*BI)->end(); I != E; ++I) {
+			SmallVector<Guard, 4> New;
+
+			BoundsCheck Check;
+			BranchInst *Br = dyn_cast<BranchInst>(I);
+			if (Br && matchBoundsCheck(CG, Br, Check) && proveCheck(Check, L, New)
+					&& addGuards(V, New)) {
+				V.BoundsChecks.push_back(Check);
+				continue;
+			}
+
+			OverflowCheck OC;
+			if (matchOverflow(I, OC) && proveOverflow(OC, L, New) && addGuards(V, New))
+				V.OverflowChecks.push_back(OC);
+		}
+	}
+
+	// Checks that pass without a predicate are left to the other passes
+	return !V.Guards.empty();
+}
+
+// True if the values defined in L are only used outside of L by the phis of
+// its exit blocks
+bool RangeLoopVersioning::isClosed(const Loop *L) const {
+	for (Loop::block_iterator BI = L->block_begin(), BE = L->block_end(); BI != BE; ++BI) {
+		for (BasicBlock::iterator I = (*BI)->begin(), E = (*BI)->end(); I != E; ++I) {
+			for (Value::use_iterator UI = I->use_begin(), UE = I->use_end(); UI != UE; ++UI) {
+				Instruction *User = cast<Instruction>(*UI);
+				if (L->contains(User->getParent()))
+					continue;
+
+				PHINode *PN = dyn_cast<PHINode>(User);
+				if (!PN || !L->contains(PN->getIncomingBlock(UI)))
+					return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// True if V can be used in the preheader of L. An instruction defined out
+// of L and used in L dominates the header of L, and so its preheader.
+bool RangeLoopVersioning::isAvailable(const Value *V, const Loop *L) const {
+	if (isa<Constant>(V) || isa<Argument>(V))
+		return true;
+
+	const Instruction *I = dyn_cast<Instruction>(V);
+	if (!I || L->contains(I->getParent()))
+		return false;
+
+	for (Value::const_use_iterator UI = I->use_begin(), E = I->use_end(); UI != E; ++UI) {
+		const Instruction *User = cast<Instruction>(*UI);
+		if (!isa<PHINode>(User) && L->contains(User->getParent()))
+			return true;
+	}
+
+	return false;
+}
+
+// Matches X + C and X - C with overflow, with C a constant, whose overflow
+// bit is only extracted and tested by branches
+bool RangeLoopVersioning::matchOverflow(Instruction *I, OverflowCheck &Check) const {
+	IntrinsicInst *II = dyn_cast<IntrinsicInst>(I);
+	if (!II)
+		return false;
+
+	Intrinsic::ID ID = II->getIntrinsicID();
+	if (ID != Intrinsic::sadd_with_overflow && ID != Intrinsic::ssub_with_overflow)
+		return false;
+
+	unsigned XIdx = 0;
+	ConstantInt *C = dyn_cast<ConstantInt>(II->getArgOperand(1));
+	if (!C && ID == Intrinsic::sadd_with_overflow) {
+		C = dyn_cast<ConstantInt>(II->getArgOperand(0));
+		XIdx = 1;
+	}
+
+	if (!C || isa<Constant>(II->getArgOperand(XIdx)))
+		return false;
+
+	APInt Inc = C->getValue();
+	if (ID == Intrinsic::ssub_with_overflow) {
+		if (Inc.isMinSignedValue())
+			return false;
+		Inc = -Inc;
+	}
+
+	// Decrements may only overflow below the lower bound, which does not
+	// come from a symbolic interval
+	if (!Inc.isStrictlyPositive())
+		return false;
+
+	bool Tested = false;
+	for (Value::use_iterator UI = II->use_begin(), E = II->use_end(); UI != E; ++UI) {
+		ExtractValueInst *EV = dyn_cast<ExtractValueInst>(*UI);
+		if (!EV || EV->getNumIndices() != 1)
+			return false;
+
+		if (EV->getIndices()[0] != 1)
+			continue;
+
+		for (Value::use_iterator BI = EV->use_begin(), BE = EV->use_end(); BI != BE; ++BI)
+			if (isa<BranchInst>(*BI))
+				Tested = true;
+	}
+
+	if (!Tested)
+		return false;
+
+	Check.II = II;
+	Check.XIdx = XIdx;
+	Check.Inc = Inc;
+	return true;
+}
+
+bool RangeLoopVersioning::proveCheck(const BoundsCheck &Check, const Loop *L,
+		SmallVectorImpl<Guard> &Guards) {
+	if (!Check.Len)
+		return proveNonNegative(Check.Idx, L, Guards);
+
+	if (Check.Pred != ICmpInst::ICMP_SLT && Check.Pred != ICmpInst::ICMP_ULT)
+		return false;
+
+	// 0 <= idx < len implies idx <u len
+	if (Check.Pred == ICmpInst::ICMP_ULT && !proveNonNegative(Check.Idx, L, Guards))
+		return false;
+
+	APInt LI, UI, LL, UL;
+	if (getBounds(RA, Check.Idx, LI, UI) && getBounds(RA, Check.Len, LL, UL) && UI.slt(LL))
+		return true;
+
+	const Value *Len = stripCopies(CG, Check.Len);
+	const Value *Bound;
+	bool Strict;
+	if (!isAvailable(Len, L) || !findUpperBound(Check.Idx, L, Bound, Strict))
+		return false;
+
+	// idx < n <= len, or idx <= n < len
+	if (Bound == Len && Strict)
+		return true;
+
+	return require(Strict ? ICmpInst::ICMP_SLE : ICmpInst::ICMP_SLT, Bound, Len, Guards);
+}
+
+// X + Inc does not overflow if X <= n, or X < n, and n <= MAX - Inc, or
+// n <= MAX - Inc + 1
+bool RangeLoopVersioning::proveOverflow(const OverflowCheck &Check, const Loop *L,
+		SmallVectorImpl<Guard> &Guards) {
+	const Value *X = CG->getUsedValue(Check.II->getArgOperandUse(Check.XIdx));
+	IntegerType *Ty = cast<IntegerType>(X->getType());
+	APInt TypeMax = APInt::getSignedMaxValue(Ty->getBitWidth());
+	unsigned RangeWidth = RA->getMin().getBitWidth();
+
+	APInt Lower, Upper;
+	if (getBounds(RA, X, Lower, Upper) && Ty->getBitWidth() <= RangeWidth
+			&& Upper.sle((TypeMax - Check.Inc).sext(RangeWidth)))
+		return true;
+
+	const Value *Bound;
+	bool Strict;
+	if (!findUpperBound(X, L, Bound, Strict))
+		return false;
+
+	APInt Limit = TypeMax - Check.Inc;
+	if (Strict) {
+		if (Check.Inc == 1)
+			return true;
+		++Limit;
+	}
+
+	return require(ICmpInst::ICMP_SLE, Bound, ConstantInt::get(Ty, Limit), Guards);
+}
+
+bool RangeLoopVersioning::proveNonNegative(const Value *Idx, const Loop *L,
+		SmallVectorImpl<Guard> &Guards) {
+	APInt Lower, Upper;
+	if (getBounds(RA, Idx, Lower, Upper) && !Lower.isNegative())
+		return true;
+
+	const Value *Start = findStart(Idx, L);
+	if (!Start)
+		return false;
+
+	return require(ICmpInst::ICMP_SGE, Start,
+			ConstantInt::get(Start->getType(), 0), Guards);
+}
+
+// Adds LHS Pred RHS to Guards, unless the ranges prove it
+bool RangeLoopVersioning::require(CmpInst::Predicate Pred, const Value *LHS,
+		const Value *RHS, SmallVectorImpl<Guard> &Guards) {
+	if (LHS->getType() != RHS->getType())
+		return false;
+
+	APInt LL, UL, LR, UR;
+	if (getBounds(RA, LHS, LL, UL) && getBounds(RA, RHS, LR, UR)) {
+		if ((Pred == ICmpInst::ICMP_SLT && UL.slt(LR))
+				|| (Pred == ICmpInst::ICMP_SLE && UL.sle(LR))
+				|| (Pred == ICmpInst::ICMP_SGE && LL.sge(UR)))
+			return true;
+	}
+
+	Guard G = { Pred, LHS, RHS };
+	Guards.push_back(G);
+	return true;
+}
+
+// Adds the guards of a check to the predicate of V, unless they make it
+// too long
+bool RangeLoopVersioning::addGuards(Version &V, const SmallVectorImpl<Guard> &New) const {
+	SmallVector<Guard, 4> Guards(V.Guards.begin(), V.Guards.end());
+
+	for (unsigned i = 0, e = New.size(); i < e; ++i) {
+		bool Found = false;
+		for (unsigned j = 0, f = Guards.size(); j < f && !Found; ++j)
+			Found = Guards[j].Pred == New[i].Pred && Guards[j].LHS == New[i].LHS
+				&& Guards[j].RHS == New[i].RHS;
+
+		if (!Found)
+			Guards.push_back(New[i]);
+	}
+
+	if (Guards.size() > MaxGuards)
+		return false;
+
+	V.Guards.swap(Guards);
+	return true;
+}
+
+// Walks back from V through copies and increments that cannot wrap, so the
+// value returned is at most V
+const Value *RangeLoopVersioning::stripIncrements(const Value *V) const {
+	for (unsigned Steps = 0; Steps < 64; ++Steps) {
+		V = stripCopies(CG, V);
+
+		// V = X + C or V = X - (-C), with C >= 0, so V >= X
+		const BinaryOperator *BO = dyn_cast<BinaryOperator>(V);
+		if (!BO || !BO->hasNoSignedWrap())
+			break;
+
+		const ConstantInt *C = dyn_cast<ConstantInt>(CG->getUsedValue(BO->getOperandUse(1)));
+		if (!C)
+			break;
+
+		if ((BO->getOpcode() == Instruction::Add && !C->getValue().isNegative())
+				|| (BO->getOpcode() == Instruction::Sub && !C->getValue().isStrictlyPositive())) {
+			V = CG->getUsedValue(BO->getOperandUse(0));
+			continue;
+		}
+
+		break;
+	}
+
+	return V;
+}
+
+// Walks back from Idx through sigmas and decrements that cannot wrap,
+// looking for a sigma whose symbolic interval is bounded by a value that is
+// available before L. On success, Idx < Bound if Strict, Idx <= Bound
+// otherwise.
+bool RangeLoopVersioning::findUpperBound(const Value *Idx, const Loop *L,
+		const Value *&Bound, bool &Strict) const {
+	DefMap *Defs = CG->getDefMap();
+	bool Decremented = false;
+
+	const Value *V = Idx;
+	for (unsigned Steps = 0; V && Steps < 64; ++Steps) {
+		DefMap::iterator it = Defs->find(V);
+		BasicOp *Op = it == Defs->end() ? NULL : it->second;
+
+		if (SigmaOp *Sigma = dyn_cast_or_null<SigmaOp>(Op)) {
+			SymbInterval *SI = dyn_cast<SymbInterval>(Sigma->getIntersect());
+
+			if (SI) {
+				const Value *B = stripCopies(CG, SI->getBound());
+				CmpInst::Predicate P = getSigmaPredicate(CG, Sigma);
+				if ((P == ICmpInst::ICMP_SLT || P == ICmpInst::ICMP_SLE)
+						&& B->getType() == Idx->getType() && isAvailable(B, L)) {
+					Bound = B;
+					Strict = P == ICmpInst::ICMP_SLT || Decremented;
+					return true;
+				}
+			}
+
+			V = Sigma->getSource()->getValue();
+			continue;
+		}
+
+		// V = X - C or V = X + (-C), with C > 0, so V < X
+		const BinaryOperator *BO = dyn_cast<BinaryOperator>(V);
+		if (!BO || !BO->hasNoSignedWrap())
+			break;
+
+		const ConstantInt *C = dyn_cast<ConstantInt>(CG->getUsedValue(BO->getOperandUse(1)));
+		if (!C)
+			break;
+
+		if ((BO->getOpcode() == Instruction::Add && C->getValue().isNegative())
+				|| (BO->getOpcode() == Instruction::Sub && C->getValue().isStrictlyPositive())) {
+			V = CG->getUsedValue(BO->getOperandUse(0));
+			Decremented = true;
+			continue;
+		}
+
+		break;
+	}
+
+	return false;
+}
+
+// The value an induction variable of L that only grows takes when L is
+// entered, if Idx is at least that variable, and it can be used before L,
+// or NULL
+const Value *RangeLoopVersioning::findStart(const Value *Idx, const Loop *L) const {
+	const PHINode *PN = dyn_cast<PHINode>(stripIncrements(Idx));
+	if (!PN || PN->getParent() != L->getHeader())
+		return NULL;
+
+	const Value *Start = NULL;
+	for (unsigned i = 0, e = PN->getNumIncomingValues(); i < e; ++i) {
+		const Value *In = CG->getUsedValue(PN->getOperandUse(i));
+
+		if (!L->contains(PN->getIncomingBlock(i))) {
+			// The sigmas of the overlay are not in the function
+			In = stripCopies(CG, In);
+			if (Start && Start != In)
+				return NULL;
+			Start = In;
+		} else if (stripIncrements(In) != PN) {
+			return NULL;
+		}
+	}
+
+	if (!Start || !isAvailable(Start, L))
+		return NULL;
+
+	return Start;
+}
+
+// Clones the loop of V and enters the clone, without the checks, if the
+// predicate holds
+void RangeLoopVersioning::version(Version &V) {
+	Loop *L = V.L;
+	BasicBlock *Preheader = V.Preheader;
+	BasicBlock *Header = L->getHeader();
+	Function *F = Header->getParent();
+	LLVMContext &Ctx = F->getContext();
+
+	ValueToValueMapTy VMap;
+	SmallVector<BasicBlock*, 16> Blocks(L->block_begin(), L->block_end());
+	SmallVector<BasicBlock*, 16> NewBlocks;
+	for (unsigned i = 0, e = Blocks.size(); i < e; ++i) {
+		BasicBlock *NewBB = CloneBasicBlock(Blocks[i], VMap, ".fast", F);
+		VMap[Blocks[i]] = NewBB;
+		NewBlocks.push_back(NewBB);
+		NumInstsCloned += NewBB->size();
+	}
+
+	for (unsigned i = 0, e = NewBlocks.size(); i < e; ++i)
+		for (BasicBlock::iterator I = NewBlocks[i]->begin(), E = NewBlocks[i]->end(); I != E; ++I)
+			RemapInstruction(I, VMap, RF_NoModuleLevelChanges | RF_IgnoreMissingEntries);
+
+	// The exit blocks are also reached from the clone, with the cloned values
+	for (unsigned i = 0, e = Blocks.size(); i < e; ++i) {
+		SmallPtrSet<BasicBlock*, 4> Exits;
+		TerminatorInst *TI = Blocks[i]->getTerminator();
+
+		for (unsigned s = 0, se = TI->getNumSuccessors(); s < se; ++s) {
+			BasicBlock *Exit = TI->getSuccessor(s);
+			if (L->contains(Exit) || !Exits.insert(Exit))
+				continue;
+
+			for (BasicBlock::iterator I = Exit->begin(); PHINode *PN = dyn_cast<PHINode>(I); ++I) {
+				for (unsigned p = 0, pe = PN->getNumIncomingValues(); p < pe; ++p) {
+					if (PN->getIncomingBlock(p) != Blocks[i])
+						continue;
+
+					Value *In = PN->getIncomingValue(p);
+					Value *NewIn = VMap.lookup(In);
+					PN->addIncoming(NewIn ? NewIn : In, NewBlocks[i]);
+				}
+			}
+		}
+	}
+
+	// Each version gets its own preheader
+	BasicBlock *NewHeader = cast<BasicBlock>(VMap[Header]);
+	BasicBlock *FastPreheader = BasicBlock::Create(Ctx, Preheader->getName() + ".fast", F, NewHeader);
+	BasicBlock *SlowPreheader = BasicBlock::Create(Ctx, Preheader->getName() + ".slow", F, Header);
+	BranchInst::Create(NewHeader, FastPreheader);
+	BranchInst::Create(Header, SlowPreheader);
+
+	for (BasicBlock::iterator I = Header->begin(); PHINode *PN = dyn_cast<PHINode>(I); ++I) {
+		int Idx = PN->getBasicBlockIndex(Preheader);
+		PN->setIncomingBlock(Idx, SlowPreheader);
+		cast<PHINode>(VMap[PN])->setIncomingBlock(Idx, FastPreheader);
+	}
+
+	IRBuilder<> Builder(Preheader->getTerminator());
+	Value *Cond = NULL;
+	for (unsigned i = 0, e = V.Guards.size(); i < e; ++i) {
+		Value *Cmp = Builder.CreateICmp(V.Guards[i].Pred, const_cast<Value*>(V.Guards[i].LHS),
+				const_cast<Value*>(V.Guards[i].RHS), "version.guard");
+		Cond = Cond ? Builder.CreateAnd(Cond, Cmp, "version.cond") : Cmp;
+	}
+
+	Preheader->getTerminator()->eraseFromParent();
+	BranchInst::Create(FastPreheader, SlowPreheader, Cond, Preheader);
+
+	// The checks of the clone always pass
+	for (unsigned i = 0, e = V.BoundsChecks.size(); i < e; ++i) {
+		BranchInst *Br = cast<BranchInst>(VMap[V.BoundsChecks[i].Br]);
+		unsigned PassIdx = V.BoundsChecks[i].PassIdx;
+		Value *Cmp = Br->getCondition();
+
+		Br->getSuccessor(1 - PassIdx)->removePredecessor(Br->getParent());
+		BranchInst::Create(Br->getSuccessor(PassIdx), Br);
+		Br->eraseFromParent();
+		RecursivelyDeleteTriviallyDeadInstructions(Cmp);
+	}
+
+	for (unsigned i = 0, e = V.OverflowChecks.size(); i < e; ++i) {
+		const OverflowCheck &Check = V.OverflowChecks[i];
+		IntrinsicInst *II = cast<IntrinsicInst>(VMap[Check.II]);
+		Instruction *Sum = BinaryOperator::CreateNSWAdd(II->getArgOperand(Check.XIdx),
+				ConstantInt::get(Ctx, Check.Inc), II->getName() + ".fast", II);
+
+		SmallVector<ExtractValueInst*, 4> Extracts;
+		for (Value::use_iterator UI = II->use_begin(), E = II->use_end(); UI != E; ++UI)
+			Extracts.push_back(cast<ExtractValueInst>(*UI));
+
+		for (unsigned j = 0, f = Extracts.size(); j < f; ++j) {
+			if (Extracts[j]->getIndices()[0] == 0)
+				Extracts[j]->replaceAllUsesWith(Sum);
+			else
+				Extracts[j]->replaceAllUsesWith(ConstantInt::getFalse(Ctx));
+			Extracts[j]->eraseFromParent();
+		}
+
+		II->eraseFromParent();
+	}
+
+	// Branches on overflow bits are now constant
+	for (unsigned i = 0, e = NewBlocks.size(); i < e; ++i)
+		ConstantFoldTerminator(NewBlocks[i]);
+
+	++NumLoopsVersioned;
+	NumGuards += V.Guards.size();
+	NumBoundsChecks += V.BoundsChecks.size();
+	NumOverflowChecks += V.OverflowChecks.size();
+}
+
+// Constants are printed by value, other operands by name
+static void printOperand(const Value *V) {
+	if (const ConstantInt *CI = dyn_cast<ConstantInt>(V))
+		errs() << CI->getValue();
+	else
+		errs() << V->getName();
+}
+
+void RangeLoopVersioning::report(const Version &V) const {
+	BasicBlock *Header = V.L->getHeader();
+	errs() << Header->getParent()->getName() << "\t" << Header->getName()
+		<< "\t" << V.BoundsChecks.size() << " bounds checks, "
+		<< V.OverflowChecks.size() << " overflow checks removed if";
+
+	for (unsigned i = 0, e = V.Guards.size(); i < e; ++i) {
+		const Guard &G = V.Guards[i];
+		errs() << (i ? " and " : " ");
+		printOperand(G.LHS);
+		switch (G.Pred) {
+		case ICmpInst::ICMP_SLT: errs() << " < "; break;
+		case ICmpInst::ICMP_SLE: errs() << " <= "; break;
+		default:                 errs() << " >= "; break;
+		}
+		printOperand(G.RHS);
+	}
+
+	errs() << "\n";
+}
@@ -0,0 +1,266 @@
+//===- RangeMetadata.cpp - Keep the results of range analysis in the IR ---===//
+//
+// This pass writes what the interprocedural range analysis knows about the
+// integers of a module into the IR, so that the passes that run after it do
+// not need the analysis to use it:
+//
+// - Loads whose results have bounded ranges get !range metadata. Calls
+//   could carry it too, but the verifier only accepts it on them from LLVM
+//   3.6 on.
+// - Additions, subtractions, multiplications and left shifts get the nsw and
+//   nuw flags when the ranges of their operands show that they never wrap.
+// - Divisions and right shifts get the exact flag when the ranges of their
+//   operands show that they never discard a remainder.
+//
+// The pass only adds facts to the IR. It never removes a flag, and it leaves
+// alone the !range metadata that the front end has already attached.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "range-metadata"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+
+using namespace llvm;
+
+STATISTIC(NumRangeMD, "Number of loads annotated with !range");
+STATISTIC(NumNSW, "Number of instructions marked nsw");
+STATISTIC(NumNUW, "Number of instructions marked nuw");
+STATISTIC(NumExact, "Number of instructions marked exact");
+
+namespace {
+	class RangeMetadata : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+
+	public:
+		static char ID;
+		RangeMetadata() : ModulePass(ID), RA(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool getWideBounds(const Value *V, unsigned Width, APInt &Lower, APInt &Upper);
+		bool annotateRange(LoadInst *LI);
+		bool annotateWrap(BinaryOperator *BO);
+		bool annotateExact(BinaryOperator *BO);
+	};
+}
+
+char RangeMetadata::ID = 0;
+static RegisterPass<RangeMetadata> X("range-metadata",
+"Write the results of range analysis as metadata and flags", false, false);
+
+void RangeMetadata::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+	AU.setPreservesAll();
+}
+
+bool RangeMetadata::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+
+	bool Changed = false;
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			if (!I->getType()->isIntegerTy())
+				continue;
+
+			if (LoadInst *LI = dyn_cast<LoadInst>(&*I)) {
+				Changed |= annotateRange(LI);
+				continue;
+			}
+
+			BinaryOperator *BO = dyn_cast<BinaryOperator>(&*I);
+			if (!BO)
+				continue;
+
+			switch (BO->getOpcode()) {
+			case Instruction::Add:
+			case Instruction::Sub:
+			case Instruction::Mul:
+			case Instruction::Shl:
+				Changed |= annotateWrap(BO);
+				break;
+			case Instruction::UDiv:
+			case Instruction::SDiv:
+			case Instruction::LShr:
+			case Instruction::AShr:
+				Changed |= annotateExact(BO);
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	return Changed;
+}
+
+// Signed bounds of V, extended to twice the width of its type plus two bits,
+// where the products and sums of two such bounds cannot overflow. Fails if a
+// bound is unknown, or if it does not fit the type of V.
+bool RangeMetadata::getWideBounds(const Value *V, unsigned Width, APInt &Lower, APInt &Upper) {
+	if (!getBounds(RA, V, Width, Lower, Upper))
+		return false;
+
+	unsigned Wide = 2 * Width + 2;
+	Lower = Lower.sextOrTrunc(Wide);
+	Upper = Upper.sextOrTrunc(Wide);
+	return true;
+}
+
+// !range holds the lower bound and the upper bound plus one, in the width of
+// the type. The interval may wrap, so signed ranges need no translation.
+bool RangeMetadata::annotateRange(LoadInst *LI) {
+	if (LI->getMetadata(LLVMContext::MD_range))
+		return false;
+
+	IntegerType *Ty = cast<IntegerType>(LI->getType());
+	unsigned Width = Ty->getBitWidth();
+
+	APInt Lower, Upper;
+	if (!getWideBounds(LI, Width, Lower, Upper))
+		return false;
+
+	// A full range tells nothing, and the verifier rejects it
+	APInt Size = Upper - Lower + 1;
+	if (Size.uge(APInt::getOneBitSet(Size.getBitWidth(), Width)))
+		return false;
+
+	Value *Bounds[] = {
+		ConstantInt::get(Ty, Lower.trunc(Width)),
+		ConstantInt::get(Ty, (Upper + 1).trunc(Width))
+	};
+	LI->setMetadata(LLVMContext::MD_range, MDNode::get(LI->getContext(), Bounds));
+	++NumRangeMD;
+
+	return true;
+}
+
+// The result of BO, in infinite precision, lies in [Lower, Upper] whenever
+// its operands lie in their ranges. It does not wrap if it fits the type.
+bool RangeMetadata::annotateWrap(BinaryOperator *BO) {
+	unsigned Width = BO->getType()->getIntegerBitWidth();
+
+	APInt LA, UA, LB, UB;
+	if (!getWideBounds(BO->getOperand(0), Width, LA, UA)
+			|| !getWideBounds(BO->getOperand(1), Width, LB, UB))
+		return false;
+
+	unsigned Wide = LA.getBitWidth();
+	APInt Lower, Upper;
+
+	// Unsigned wrapping is only checked for operands that are not negative,
+	// which have the same value as unsigned numbers. The greatest result
+	// comes from the greatest operands, except for the subtraction.
+	bool NonNegative = !LA.isNegative() && !LB.isNegative();
+	APInt UMax;
+
+	switch (BO->getOpcode()) {
+	case Instruction::Add:
+		Lower = LA + LB;
+		Upper = UA + UB;
+		UMax = Upper;
+		break;
+	case Instruction::Sub:
+		Lower = LA - UB;
+		Upper = UA - LB;
+		NonNegative = NonNegative && !Lower.isNegative();
+		UMax = Upper;
+		break;
+	case Instruction::Shl:
+		// Shifting by the width of the type or more gives undef
+		if (LB.isNegative() || UB.sge(APInt(Wide, Width)))
+			return false;
+
+		LB = APInt::getOneBitSet(Wide, LB.getZExtValue());
+		UB = APInt::getOneBitSet(Wide, UB.getZExtValue());
+		NonNegative = !LA.isNegative();
+		// Fall through, a left shift multiplies by a power of two
+	case Instruction::Mul: {
+		APInt Products[] = { LA * LB, LA * UB, UA * LB, UA * UB };
+		Lower = Upper = Products[0];
+		for (unsigned i = 1; i < 4; ++i) {
+			if (Products[i].slt(Lower))
+				Lower = Products[i];
+			if (Products[i].sgt(Upper))
+				Upper = Products[i];
+		}
+		UMax = UA * UB;
+		break;
+	}
+	default:
+		return false;
+	}
+
+	bool Changed = false;
+
+	if (!BO->hasNoSignedWrap()
+			&& Lower.sge(APInt::getSignedMinValue(Width).sext(Wide))
+			&& Upper.sle(APInt::getSignedMaxValue(Width).sext(Wide))) {
+		BO->setHasNoSignedWrap(true);
+		++NumNSW;
+		Changed = true;
+	}
+
+	if (!BO->hasNoUnsignedWrap() && NonNegative
+			&& UMax.ule(APInt::getMaxValue(Width).zext(Wide))) {
+		BO->setHasNoUnsignedWrap(true);
+		++NumNUW;
+		Changed = true;
+	}
+
+	return Changed;
+}
+
+// Intervals say nothing about divisibility, unless they hold a single value.
+// This happens to the operands of divisions that the analysis has
+// specialized, e.g. after inlining, before constant propagation folds them.
+bool RangeMetadata::annotateExact(BinaryOperator *BO) {
+	if (BO->isExact())
+		return false;
+
+	unsigned Width = BO->getType()->getIntegerBitWidth();
+
+	APInt LA, UA, LB, UB;
+	if (!getWideBounds(BO->getOperand(0), Width, LA, UA)
+			|| !getWideBounds(BO->getOperand(1), Width, LB, UB))
+		return false;
+
+	if (LA.ne(UA) || LB.ne(UB))
+		return false;
+
+	APInt Dividend = LA.trunc(Width), Divisor = LB.trunc(Width);
+	bool Exact = false;
+
+	switch (BO->getOpcode()) {
+	case Instruction::UDiv:
+		Exact = !!Divisor && !Dividend.urem(Divisor);
+		break;
+	case Instruction::SDiv:
+		// The minimum divided by minus one overflows
+		Exact = !!Divisor && !(Dividend.isMinSignedValue() && Divisor.isAllOnesValue())
+			&& !Dividend.srem(Divisor);
+		break;
+	case Instruction::LShr:
+	case Instruction::AShr:
+		Exact = Divisor.ult(Width) && Dividend.countTrailingZeros() >= Divisor.getZExtValue();
+		break;
+	default:
+		break;
+	}
+
+	if (!Exact)
+		return false;
+
+	BO->setIsExact(true);
+	++NumExact;
+	return true;
+}
@@ -0,0 +1,761 @@
+//===- StructFieldShrinking.cpp - Shrink struct fields using ranges -------===//
+//
+// This pass shrinks the integer fields of struct types whose stored values,
+// according to the interprocedural range analysis, fit in 8, 16 or 32 bits.
+// Every store to such a field truncates the value, and every load extends it
+// back, so the code computes the same values on smaller objects. The fields
+// of the shrunk type are ordered by alignment, so that the bits saved are not
+// lost to padding.
+//
+// Types can only be shrunk if the pass sees every access to their objects,
+// so the module must be the whole program, and a type is left alone if its
+// layout may be observed by code that does not name its fields:
+//
+// - it is nested in another aggregate, or in the type of a global;
+// - a function declaration takes or returns it;
+// - a pointer to it is cast to or from anything other than the result of
+//   malloc or calloc, or the argument of free, or that result has users
+//   other than its casts to the type and free;
+// - a type that holds pointers to it, such as a pointer to such a pointer,
+//   is cast to or from another type;
+// - it is loaded, stored or passed around as a whole;
+// - the address of one of its fields is used by anything but simple loads
+//   and stores, since the fields move to new offsets.
+//
+// A field is only shrunk if every value stored to it is bounded. The allocations whose size is a
+// multiple of the old size of the type are resized.
+//
+// Types cannot change in place, so the functions that use a shrunk type are
+// cloned with the new one, and the originals are deleted.
+//
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "struct-field-shrinking"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/TypeFinder.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "llvm/Pass.h"
+#include "../RangeAnalysis/RangeAnalysisCache.h"
+#include "../RangeAnalysis/RangeClients.h"
+#include <algorithm>
+
+using namespace llvm;
+
+static cl::opt<bool, false>
+PrintReport("sfs-report", cl::desc("Print the footprint of each shrunk struct type."), cl::NotHidden);
+
+STATISTIC(NumTypesShrunk, "Number of struct types shrunk");
+STATISTIC(NumFieldsShrunk, "Number of struct fields shrunk");
+STATISTIC(NumBytesSaved, "Number of bytes saved in each object of the shrunk types");
+STATISTIC(NumAccessesRewritten, "Number of loads and stores of shrunk fields rewritten");
+STATISTIC(NumAllocationsResized, "Number of allocations resized");
+STATISTIC(NumFunctionsCloned, "Number of functions cloned with the shrunk types");
+
+namespace {
+	// New layout of a struct type
+	struct ShrunkType {
+		StructType *Old, *New;
+		std::string Name;
+		// Position of each field of Old in New
+		SmallVector<unsigned, 8> NewIndex;
+		// Width each integer field is stored in, or 0 if it keeps its type
+		SmallVector<unsigned, 8> NarrowWidth;
+		uint64_t OldSize, NewSize;
+		unsigned Allocations;
+	};
+
+	// Replaces the shrunk types, and the types built from them, by their new
+	// versions
+	class ShrinkRemapper : public ValueMapTypeRemapper {
+		DenseMap<Type*, Type*> Mapped;
+
+	public:
+		void add(Type *Old, Type *New) { Mapped[Old] = New; }
+		virtual Type *remapType(Type *Ty);
+	};
+
+	class StructFieldShrinking : public ModulePass {
+		InterProceduralRA<Cousot> *RA;
+		const DataLayout *DL;
+		ShrinkRemapper Remapper;
+		SmallVector<ShrunkType*, 4> Shrunk;
+		// Shrunk types, by their new versions
+		DenseMap<Type*, ShrunkType*> ShrunkOf;
+
+	public:
+		static char ID;
+		StructFieldShrinking() : ModulePass(ID), RA(NULL), DL(NULL) { }
+
+		virtual bool runOnModule(Module &M);
+		virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+
+	private:
+		bool escapes(Module &M, StructType *S, TypeFinder &Types);
+		bool escapesThrough(Value *V);
+		bool isCreatedSafely(Instruction *I, StructType *S);
+		ShrunkType *analyzeFields(Module &M, StructType *S);
+
+		void createTypes(Module &M, TypeFinder &Types);
+		void cloneFunctions(Module &M);
+		void rewriteAccesses(Function &F);
+		void resizeAllocations(Function &F);
+		void printReport();
+	};
+}
+
+char StructFieldShrinking::ID = 0;
+static RegisterPass<StructFieldShrinking> X("struct-field-shrinking",
+"Shrink struct fields using range analysis", false, false);
+
+// Whether S is part of the objects of type Ty
+static bool containsByValue(Type *Ty, StructType *S) {
+	if (Ty == S)
+		return true;
+
+	if (SequentialType *SeqTy = dyn_cast<SequentialType>(Ty))
+		return !Ty->isPointerTy() && containsByValue(SeqTy->getElementType(), S);
+
+	if (StructType *ST = dyn_cast<StructType>(Ty))
+		for (unsigned i = 0, e = ST->getNumElements(); i < e; ++i)
+			if (containsByValue(ST->getElementType(i), S))
+				return true;
+
+	return false;
+}
+
+// Whether S appears anywhere in Ty, even behind pointers
+static bool mentions(Type *Ty, StructType *S, SmallPtrSet<Type*, 16> &Visited) {
+	if (Ty == S)
+		return true;
+
+	if (!Visited.insert(Ty))
+		return false;
+
+	for (Type::subtype_iterator it = Ty->subtype_begin(), e = Ty->subtype_end(); it != e; ++it)
+		if (mentions(*it, S, Visited))
+			return true;
+
+	return false;
+}
+
+static bool mentions(Type *Ty, StructType *S) {
+	SmallPtrSet<Type*, 16> Visited;
+	return mentions(Ty, S, Visited);
+}
+
+// Whether the constant C depends on the layout of S. Null pointers do not,
+// and globals are checked on their own.
+static bool mentions(Constant *C, StructType *S) {
+	if (isa<GlobalValue>(C) || isa<ConstantPointerNull>(C)
+			|| (isa<UndefValue>(C) && C->getType()->isPointerTy()))
+		return false;
+
+	if (mentions(C->getType(), S))
+		return true;
+
+	for (unsigned i = 0, e = C->getNumOperands(); i < e; ++i)
+		if (mentions(cast<Constant>(C->getOperand(i)), S))
+			return true;
+
+	return false;
+}
+
+static bool isCallTo(Value *V, StringRef Name) {
+	CallInst *CI = dyn_cast<CallInst>(V);
+	return CI && CI->getCalledFunction() && CI->getCalledFunction()->getName() == Name;
+}
+
+Type *ShrinkRemapper::remapType(Type *Ty) {
+	DenseMap<Type*, Type*>::iterator it = Mapped.find(Ty);
+	if (it != Mapped.end())
+		return it->second;
+
+	// Identified structs that mention a shrunk type were mapped up front
+	Type *New = Ty;
+	if (PointerType *PT = dyn_cast<PointerType>(Ty)) {
+		New = PointerType::get(remapType(PT->getElementType()), PT->getAddressSpace());
+	} else if (ArrayType *AT = dyn_cast<ArrayType>(Ty)) {
+		New = ArrayType::get(remapType(AT->getElementType()), AT->getNumElements());
+	} else if (VectorType *VT = dyn_cast<VectorType>(Ty)) {
+		New = VectorType::get(remapType(VT->getElementType()), VT->getNumElements());
+	} else if (FunctionType *FT = dyn_cast<FunctionType>(Ty)) {
+		SmallVector<Type*, 8> Params;
+		for (unsigned i = 0, e = FT->getNumParams(); i < e; ++i)
+			Params.push_back(remapType(FT->getParamType(i)));
+		New = FunctionType::get(remapType(FT->getReturnType()), Params, FT->isVarArg());
+	} else if (StructType *ST = dyn_cast<StructType>(Ty)) {
+		if (ST->isLiteral()) {
+			SmallVector<Type*, 8> Elements;
+			for (unsigned i = 0, e = ST->getNumElements(); i < e; ++i)
+				Elements.push_back(remapType(ST->getElementType(i)));
+			New = StructType::get(Ty->getContext(), Elements, ST->isPacked());
+		}
+	}
+
+	Mapped[Ty] = New;
+	return New;
+}
+
+void StructFieldShrinking::getAnalysisUsage(AnalysisUsage &AU) const {
+	AU.addRequired<RangeAnalysisCache>();
+}
+
+bool StructFieldShrinking::runOnModule(Module &M) {
+	RA = &getAnalysis<RangeAnalysisCache>().getModuleRA(M);
+
+	// Without the sizes of the types there is no footprint to reduce
+	DataLayoutPass *DLP = getAnalysisIfAvailable<DataLayoutPass>();
+	DL = DLP ? &DLP->getDataLayout() : NULL;
+	if (!DL)
+		return false;
+
+	TypeFinder Types;
+	Types.run(M, true);
+
+	// Decide with the ranges of the original code, then change it
+	for (TypeFinder::iterator it = Types.begin(), e = Types.end(); it != e; ++it) {
+		StructType *S = *it;
+		if (S->isOpaque() || S->isPacked() || escapes(M, S, Types))
+			continue;
+
+		if (ShrunkType *ST = analyzeFields(M, S))
+			Shrunk.push_back(ST);
+	}
+
+	if (Shrunk.empty())
+		return false;
+
+	createTypes(M, Types);
+	cloneFunctions(M);
+
+	if (PrintReport)
+		printReport();
+
+	for (unsigned i = 0, e = Shrunk.size(); i < e; ++i)
+		delete Shrunk[i];
+	Shrunk.clear();
+	ShrunkOf.clear();
+
+	return true;
+}
+
+// Whether the layout of S may be observed by code that does not name its
+// fields
+bool StructFieldShrinking::escapes(Module &M, StructType *S, TypeFinder &Types) {
+	for (TypeFinder::iterator it = Types.begin(), e = Types.end(); it != e; ++it)
+		if (*it != S && containsByValue(*it, S))
+			return true;
+
+	// The types of globals cannot change
+	for (Module::global_iterator G = M.global_begin(), E = M.global_end(); G != E; ++G)
+		if (mentions(G->getType(), S))
+			return true;
+
+	PointerType *SPtr = PointerType::getUnqual(S);
+
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		bool Mentioned = mentions(Fit->getFunctionType(), S);
+
+		// Code we do not see may take S apart
+		if (Fit->isDeclaration()) {
+			if (Mentioned)
+				return true;
+			continue;
+		}
+
+		// The clone with the new type must replace every use
+		if (Mentioned)
+			for (Value::use_iterator UI = Fit->use_begin(), E = Fit->use_end(); UI != E; ++UI) {
+				CallSite CS(*UI);
+				if (!CS.getInstruction() || CS.getCalledValue() != &*Fit)
+					return true;
+			}
+
+		for (Function::arg_iterator A = Fit->arg_begin(), E = Fit->arg_end(); A != E; ++A)
+			if (A->getType() == SPtr && escapesThrough(&*A))
+				return true;
+
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			// Whole objects, or arrays of them
+			Type *Ty = I->getType();
+			if (containsByValue(Ty, S))
+				return true;
+			if (Ty->isPointerTy() && Ty != SPtr && containsByValue(Ty->getPointerElementType(), S))
+				return true;
+
+			for (unsigned o = 0, e = I->getNumOperands(); o < e; ++o)
+				if (Constant *C = dyn_cast<Constant>(I->getOperand(o)))
+					if (mentions(C, S))
+						return true;
+
+			if (Ty == SPtr && (!isCreatedSafely(&*I, S) || escapesThrough(&*I)))
+				return true;
+
+			// Pointers to S stored as something else, and loaded back
+			if (BitCastInst *BC = dyn_cast<BitCastInst>(&*I)) {
+				Type *SrcTy = BC->getSrcTy();
+				if ((Ty != SPtr && mentions(Ty, S)) || (SrcTy != SPtr && mentions(SrcTy, S)))
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+// Whether I, a pointer to S, points to an object of type S, or to memory
+// that was allocated for it
+bool StructFieldShrinking::isCreatedSafely(Instruction *I, StructType *S) {
+	if (AllocaInst *AI = dyn_cast<AllocaInst>(I))
+		return AI->getAllocatedType() == S;
+
+	if (BitCastInst *BC = dyn_cast<BitCastInst>(I)) {
+		Value *Alloc = BC->getOperand(0);
+		if (!isCallTo(Alloc, "malloc") && !isCallTo(Alloc, "calloc"))
+			return false;
+
+		// The allocation shrinks with S, so nothing else may write to it
+		PointerType *SPtr = PointerType::getUnqual(S);
+		for (Value::use_iterator UI = Alloc->use_begin(), E = Alloc->use_end(); UI != E; ++UI)
+			if (!isCallTo(*UI, "free") && !(isa<BitCastInst>(*UI) && UI->getType() == SPtr))
+				return false;
+
+		return true;
+	}
+
+	return isa<LoadInst>(I) || isa<PHINode>(I) || isa<SelectInst>(I)
+		|| isa<GetElementPtrInst>(I) || isa<CallInst>(I) || isa<InvokeInst>(I);
+}
+
+// Whether the address of a field, given by GEP, is used for anything but
+// loading and storing the field. Code that computes with the address, or
+// copies bytes through it, would keep using the old offsets.
+static bool isOnlyAccessed(GetElementPtrInst *GEP) {
+	for (Value::use_iterator UI = GEP->use_begin(), E = GEP->use_end(); UI != E; ++UI) {
+		if (LoadInst *LI = dyn_cast<LoadInst>(*UI)) {
+			if (!LI->isSimple())
+				return false;
+		} else if (StoreInst *SI = dyn_cast<StoreInst>(*UI)) {
+			if (!SI->isSimple() || SI->getValueOperand() == GEP)
+				return false;
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Whether the users of V, a pointer to S, may observe the layout of S
+bool StructFieldShrinking::escapesThrough(Value *V) {
+	for (Value::use_iterator UI = V->use_begin(), E = V->use_end(); UI != E; ++UI) {
+		Instruction *U = cast<Instruction>(*UI);
+
+		if (GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(U)) {
+			if (GEP->getPointerOperand() != V)
+				return true;
+
+			// One index moves to another object of type S
+			if (GEP->getNumIndices() == 1) {
+				if (escapesThrough(GEP))
+					return true;
+			} else if (!isOnlyAccessed(GEP)) {
+				return true;
+			}
+		} else if (StoreInst *SI = dyn_cast<StoreInst>(U)) {
+			if (SI->getPointerOperand() == V)
+				return true;
+		} else if (BitCastInst *BC = dyn_cast<BitCastInst>(U)) {
+			for (Value::use_iterator BI = BC->use_begin(), BE = BC->use_end(); BI != BE; ++BI)
+				if (!isCallTo(*BI, "free"))
+					return true;
+		} else if (isa<CallInst>(U) || isa<InvokeInst>(U)) {
+			CallSite CS(U);
+			Function *Callee = CS.getCalledFunction();
+			if (!Callee || Callee->isDeclaration() || CS.getCalledValue() == V)
+				return true;
+		} else if (!isa<LoadInst>(U) && !isa<ICmpInst>(U) && !isa<PHINode>(U)
+				&& !isa<SelectInst>(U) && !isa<ReturnInst>(U)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+namespace {
+	// Orders fields by decreasing alignment, keeping the original order
+	// among fields with the same alignment
+	struct AlignmentOrder {
+		const SmallVectorImpl<unsigned> &Align;
+		AlignmentOrder(const SmallVectorImpl<unsigned> &A) : Align(A) { }
+		bool operator()(unsigned A, unsigned B) const {
+			return Align[A] > Align[B];
+		}
+	};
+}
+
+// The new layout of S, or NULL if no field can be shrunk, or if shrinking
+// does not make the objects smaller
+ShrunkType *StructFieldShrinking::analyzeFields(Module &M, StructType *S) {
+	unsigned NumFields = S->getNumElements();
+	unsigned RangeWidth = RA->getMin().getBitWidth();
+	PointerType *SPtr = PointerType::getUnqual(S);
+
+	SmallVector<bool, 8> Shrinkable(NumFields, false);
+	SmallVector<APInt, 8> Lower(NumFields, APInt::getSignedMaxValue(RangeWidth));
+	SmallVector<APInt, 8> Upper(NumFields, APInt::getSignedMinValue(RangeWidth));
+	for (unsigned f = 0; f < NumFields; ++f) {
+		IntegerType *Ty = dyn_cast<IntegerType>(S->getElementType(f));
+		Shrinkable[f] = Ty && Ty->getBitWidth() > 8 && Ty->getBitWidth() <= RangeWidth;
+	}
+
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E; ++I) {
+			GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(&*I);
+			if (!GEP || GEP->getPointerOperand()->getType() != SPtr || GEP->getNumIndices() < 2)
+				continue;
+
+			unsigned f = cast<ConstantInt>(GEP->getOperand(2))->getZExtValue();
+			if (!Shrinkable[f])
+				continue;
+
+			// Only simple loads and stores use the address, as escapes checked
+			for (Value::use_iterator UI = GEP->use_begin(), UE = GEP->use_end(); UI != UE; ++UI) {
+				StoreInst *SI = dyn_cast<StoreInst>(*UI);
+				if (!SI)
+					continue;
+
+				APInt L, U;
+				if (!getBounds(RA, SI->getValueOperand(), L, U)) {
+					Shrinkable[f] = false;
+					break;
+				}
+
+				if (L.slt(Lower[f]))
+					Lower[f] = L;
+				if (U.sgt(Upper[f]))
+					Upper[f] = U;
+			}
+		}
+	}
+
+	ShrunkType *ST = new ShrunkType();
+	ST->Old = S;
+	ST->New = NULL;
+	ST->Allocations = 0;
+
+	SmallVector<Type*, 8> Elements;
+	SmallVector<unsigned, 8> Align;
+	unsigned NumShrunk = 0;
+	for (unsigned f = 0; f < NumFields; ++f) {
+		Type *Ty = S->getElementType(f);
+		unsigned Width = 0;
+
+		// Fields that are never stored only hold zeros from calloc, or garbage
+		if (Shrinkable[f] && Lower[f].sgt(Upper[f]))
+			Lower[f] = Upper[f] = APInt(RangeWidth, 0);
+
+		for (unsigned w = 8; Shrinkable[f] && w < Ty->getIntegerBitWidth(); w *= 2) {
+			if (Lower[f].sge(APInt::getSignedMinValue(w).sext(RangeWidth))
+					&& Upper[f].sle(APInt::getSignedMaxValue(w).sext(RangeWidth))) {
+				Width = w;
+				Ty = IntegerType::get(S->getContext(), w);
+				++NumShrunk;
+				break;
+			}
+		}
+
+		ST->NarrowWidth.push_back(Width);
+		Elements.push_back(Ty);
+		Align.push_back(DL->getABITypeAlignment(Ty));
+	}
+
+	SmallVector<unsigned, 8> Order;
+	for (unsigned f = 0; f < NumFields; ++f)
+		Order.push_back(f);
+	std::stable_sort(Order.begin(), Order.end(), AlignmentOrder(Align));
+
+	ST->NewIndex.resize(NumFields);
+	SmallVector<Type*, 8> Ordered;
+	for (unsigned i = 0; i < NumFields; ++i) {
+		ST->NewIndex[Order[i]] = i;
+		Ordered.push_back(Elements[Order[i]]);
+	}
+
+	// Pointers to the types that change keep their sizes
+	ST->OldSize = DL->getTypeAllocSize(S);
+	ST->NewSize = DL->getTypeAllocSize(StructType::get(S->getContext(), Ordered));
+	if (!NumShrunk || ST->NewSize >= ST->OldSize) {
+		delete ST;
+		return NULL;
+	}
+
+	NumFieldsShrunk += NumShrunk;
+	return ST;
+}
+
+// Creates the new versions of the shrunk types, and of the identified types
+// that mention them
+void StructFieldShrinking::createTypes(Module &M, TypeFinder &Types) {
+	LLVMContext &Ctx = M.getContext();
+
+	// The old types give their names to the new ones
+	for (unsigned i = 0, e = Shrunk.size(); i < e; ++i) {
+		ShrunkType *ST = Shrunk[i];
+		ST->Name = ST->Old->getName();
+		ST->Old->setName("");
+		ST->New = StructType::create(Ctx, ST->Name);
+		Remapper.add(ST->Old, ST->New);
+		ShrunkOf[ST->New] = ST;
+	}
+
+	SmallPtrSet<Type*, 8> Olds;
+	for (unsigned i = 0, e = Shrunk.size(); i < e; ++i)
+		Olds.insert(Shrunk[i]->Old);
+
+	SmallVector<std::pair<StructType*, StructType*>, 8> Remapped;
+	for (TypeFinder::iterator it = Types.begin(), e = Types.end(); it != e; ++it) {
+		StructType *T = *it;
+		if (Olds.count(T) || T->isOpaque())
+			continue;
+
+		for (unsigned i = 0, e = Shrunk.size(); i < e; ++i) {
+			if (!mentions(T, Shrunk[i]->Old))
+				continue;
+
+			std::string Name = T->getName();
+			T->setName("");
+			StructType *NewT = StructType::create(Ctx, Name);
+			Remapper.add(T, NewT);
+			Remapped.push_back(std::make_pair(T, NewT));
+			break;
+		}
+	}
+
+	// Bodies last, since they may mention each other
+	for (unsigned i = 0, e = Shrunk.size(); i < e; ++i) {
+		ShrunkType *ST = Shrunk[i];
+		unsigned NumFields = ST->Old->getNumElements();
+		SmallVector<Type*, 8> Elements(NumFields);
+		for (unsigned f = 0; f < NumFields; ++f) {
+			Type *Ty = ST->NarrowWidth[f] ? IntegerType::get(Ctx, ST->NarrowWidth[f])
+				: Remapper.remapType(ST->Old->getElementType(f));
+			Elements[ST->NewIndex[f]] = Ty;
+		}
+		ST->New->setBody(Elements);
+		ST->NewSize = DL->getTypeAllocSize(ST->New);
+
+		++NumTypesShrunk;
+		NumBytesSaved += ST->OldSize - ST->NewSize;
+	}
+
+	for (unsigned i = 0, e = Remapped.size(); i < e; ++i) {
+		StructType *T = Remapped[i].first;
+		SmallVector<Type*, 8> Elements;
+		for (unsigned f = 0, e = T->getNumElements(); f < e; ++f)
+			Elements.push_back(Remapper.remapType(T->getElementType(f)));
+		Remapped[i].second->setBody(Elements, T->isPacked());
+	}
+}
+
+// Replaces every function that uses a shrunk type by a clone that uses the
+// new one
+void StructFieldShrinking::cloneFunctions(Module &M) {
+	SmallVector<std::pair<Function*, Function*>, 16> Clones;
+	ValueToValueMapTy VMap;
+
+	for (Module::iterator Fit = M.begin(), Fend = M.end(); Fit != Fend; ++Fit) {
+		if (Fit->isDeclaration())
+			continue;
+
+		bool Uses = Remapper.remapType(Fit->getType()) != Fit->getType();
+		for (inst_iterator I = inst_begin(*Fit), E = inst_end(*Fit); I != E && !Uses; ++I) {
+			Uses = Remapper.remapType(I->getType()) != I->getType();
+			for (unsigned o = 0, e = I->getNumOperands(); o < e && !Uses; ++o)
+				Uses = Remapper.remapType(I->getOperand(o)->getType()) != I->getOperand(o)->getType();
+		}
+
+		if (!Uses)
+			continue;
+
+		FunctionType *FTy = cast<FunctionType>(Remapper.remapType(Fit->getFunctionType()));
+		Function *NewF = Function::Create(FTy, Fit->getLinkage(), "", &M);
+		NewF->copyAttributesFrom(&*Fit);
+		VMap[&*Fit] = NewF;
+
+		Function::arg_iterator NewA = NewF->arg_begin();
+		for (Function::arg_iterator A = Fit->arg_begin(), E = Fit->arg_end(); A != E; ++A, ++NewA) {
+			NewA->setName(A->getName());
+			VMap[&*A] = &*NewA;
+		}
+
+		Clones.push_back(std::make_pair(&*Fit, NewF));
+	}
+
+	for (unsigned i = 0, e = Clones.size(); i < e; ++i) {
+		SmallVector<ReturnInst*, 8> Returns;
+		CloneFunctionInto(Clones[i].second, Clones[i].first, VMap, true, Returns,
+				"", NULL, &Remapper);
+		rewriteAccesses(*Clones[i].second);
+		resizeAllocations(*Clones[i].second);
+	}
+
+	// Functions whose types did not change may be used outside of calls
+	for (unsigned i = 0, e = Clones.size(); i < e; ++i) {
+		Function *F = Clones[i].first;
+		if (F->getType() == Clones[i].second->getType())
+			F->replaceAllUsesWith(Clones[i].second);
+		F->dropAllReferences();
+	}
+
+	RangeAnalysisCache &Cache = getAnalysis<RangeAnalysisCache>();
+	for (unsigned i = 0, e = Clones.size(); i < e; ++i) {
+		Clones[i].second->takeName(Clones[i].first);
+		Cache.forget(*Clones[i].first);
+		Clones[i].first->eraseFromParent();
+	}
+
+	NumFunctionsCloned += Clones.size();
+}
+
+// The clone still accesses the fields at their old positions, with their
+// old types. Each access is rebuilt for the new layout.
+void StructFieldShrinking::rewriteAccesses(Function &F) {
+	SmallVector<GetElementPtrInst*, 16> GEPs;
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+		if (GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(&*I))
+			if (GEP->getNumIndices() >= 2 && GEP->getPointerOperand()->getType()->isPointerTy()
+					&& ShrunkOf.count(GEP->getPointerOperand()->getType()->getPointerElementType()))
+				GEPs.push_back(GEP);
+
+	for (unsigned i = 0, e = GEPs.size(); i < e; ++i) {
+		GetElementPtrInst *GEP = GEPs[i];
+		ShrunkType *ST = ShrunkOf.lookup(GEP->getPointerOperand()->getType()->getPointerElementType());
+
+		ConstantInt *FieldIdx = cast<ConstantInt>(GEP->getOperand(2));
+		unsigned Field = FieldIdx->getZExtValue();
+
+		SmallVector<Value*, 4> Idxs(GEP->idx_begin(), GEP->idx_end());
+		Idxs[1] = ConstantInt::get(FieldIdx->getType(), ST->NewIndex[Field]);
+		GetElementPtrInst *New = GetElementPtrInst::Create(GEP->getPointerOperand(),
+				Idxs, "", GEP);
+		New->setIsInBounds(GEP->isInBounds());
+		New->takeName(GEP);
+
+		// The field may have moved to an offset that is less aligned
+		if (!ST->NarrowWidth[Field]) {
+			for (Value::use_iterator UI = GEP->use_begin(), E = GEP->use_end(); UI != E; ++UI) {
+				if (LoadInst *LI = dyn_cast<LoadInst>(*UI))
+					LI->setAlignment(0);
+				else if (StoreInst *SI = dyn_cast<StoreInst>(*UI))
+					if (SI->getPointerOperand() == GEP)
+						SI->setAlignment(0);
+			}
+
+			GEP->replaceAllUsesWith(New);
+			GEP->eraseFromParent();
+			continue;
+		}
+
+		// Loads and stores, as the analysis checked
+		IntegerType *NarrowTy = IntegerType::get(F.getContext(), ST->NarrowWidth[Field]);
+		SmallVector<Instruction*, 8> Users;
+		for (Value::use_iterator UI = GEP->use_begin(), E = GEP->use_end(); UI != E; ++UI)
+			Users.push_back(cast<Instruction>(*UI));
+
+		for (unsigned u = 0, ue = Users.size(); u < ue; ++u) {
+			if (LoadInst *LI = dyn_cast<LoadInst>(Users[u])) {
+				LoadInst *NewLI = new LoadInst(New, LI->getName() + ".nrw", LI);
+				Instruction *Ext = new SExtInst(NewLI, LI->getType(), "", LI);
+				Ext->takeName(LI);
+				LI->replaceAllUsesWith(Ext);
+				LI->eraseFromParent();
+			} else {
+				StoreInst *SI = cast<StoreInst>(Users[u]);
+				Value *Trunc = new TruncInst(SI->getValueOperand(), NarrowTy, "", SI);
+				new StoreInst(Trunc, New, SI);
+				SI->eraseFromParent();
+			}
+			++NumAccessesRewritten;
+		}
+
+		GEP->eraseFromParent();
+	}
+}
+
+// Allocations of a number of objects of a shrunk type ask for fewer bytes.
+// Memory used as bytes elsewhere keeps its size.
+void StructFieldShrinking::resizeAllocations(Function &F) {
+	for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+		BitCastInst *BC = dyn_cast<BitCastInst>(&*I);
+		if (!BC || !BC->getType()->isPointerTy())
+			continue;
+
+		ShrunkType *ST = ShrunkOf.lookup(BC->getType()->getPointerElementType());
+		CallInst *Call = dyn_cast<CallInst>(BC->getOperand(0));
+		if (!ST || !Call || !Call->hasOneUse())
+			continue;
+
+		bool Calloc = isCallTo(Call, "calloc");
+		if (!Calloc && !isCallTo(Call, "malloc"))
+			continue;
+
+		// The size of calloc is the size of one object, malloc asks for
+		// all of them at once
+		unsigned SizeArg = Calloc ? 1 : 0;
+		Value *Size = Call->getArgOperand(SizeArg);
+		Value *NewSize = NULL;
+
+		if (ConstantInt *CI = dyn_cast<ConstantInt>(Size)) {
+			uint64_t Bytes = CI->getZExtValue();
+			if (Bytes % ST->OldSize == 0)
+				NewSize = ConstantInt::get(CI->getType(), Bytes / ST->OldSize * ST->NewSize);
+		} else if (BinaryOperator *Mul = dyn_cast<BinaryOperator>(Size)) {
+			ConstantInt *CI = dyn_cast<ConstantInt>(Mul->getOperand(1));
+			Value *Count = Mul->getOperand(0);
+			if (!CI) {
+				CI = dyn_cast<ConstantInt>(Mul->getOperand(0));
+				Count = Mul->getOperand(1);
+			}
+
+			if (Mul->getOpcode() == Instruction::Mul && CI && CI->getZExtValue() % ST->OldSize == 0)
+				NewSize = BinaryOperator::CreateMul(Count, ConstantInt::get(CI->getType(),
+						CI->getZExtValue() / ST->OldSize * ST->NewSize), Mul->getName(), Call);
+		}
+
+		if (!NewSize)
+			continue;
+
+		Call->setArgOperand(SizeArg, NewSize);
+		++ST->Allocations;
+		++NumAllocationsResized;
+	}
+}
+
+void StructFieldShrinking::printReport() {
+	errs() << "Type\tOld size\tNew size\tFields shrunk\tAllocations resized\n";
+
+	for (unsigned i = 0, e = Shrunk.size(); i < e; ++i) {
+		ShrunkType *ST = Shrunk[i];
+		unsigned Fields = 0;
+		for (unsigned f = 0, fe = ST->NarrowWidth.size(); f < fe; ++f)
+			if (ST->NarrowWidth[f])
+				++Fields;
+
+		errs() << ST->Name << "\t" << ST->OldSize << "\t" << ST->NewSize << "\t"
+				<< Fields << "\t" << ST->Allocations << "\n";
+	}
+}
@@ -36,6 +36,11 @@ bool uSSA::runOnFunction(Function &F) {
 		createNewDefs(Fit);
 	}
 	
+	// Rename the uses of all variables that got new definitions at once
+	renameNewDefs();
+	
+	newdefs_.clear();
+	
 	return false;
 }
 
@@ -63,7 +68,7 @@ void uSSA::createNewDefs(BasicBlock *BB)
 					BinaryOperator *newdef = BinaryOperator::Create(Instruction::Add, op, ConstantInt::get(op->getType(), 0), Twine(newname), next);					
 					newdef->setMetadata("new-inst", MDNode::get(BB->getParent()->getContext(), llvm::ArrayRef<Value*>()));
 					
-					renameNewDefs(newdef);
+					newdefs_.insert(newdef);
 					
 					// Skip the instruction that has just been created
 					++BBit;
@@ -84,7 +89,7 @@ void uSSA::createNewDefs(BasicBlock *BB)
 						BinaryOperator *newdef = BinaryOperator::Create(Instruction::Add, op, ConstantInt::get(op->getType(), 0), Twine(newname), next);
 						newdef->setMetadata("new-inst", MDNode::get(BB->getParent()->getContext(), llvm::ArrayRef<Value*>()));
 						
-						renameNewDefs(newdef);
+						newdefs_.insert(newdef);
 
 						// Skip the instruction that has just been created
 						++BBit;
@@ -95,50 +100,89 @@ void uSSA::createNewDefs(BasicBlock *BB)
 	}
 }
 
-void uSSA::renameNewDefs(Instruction *newdef)
+/*
+ *  Renames the uses of every variable that got new definitions, in a single
+ *  walk over the dominator tree. Each variable has a stack with the
+ *  definitions that dominate the current point: uses take the top of the
+ *  stack, and a new definition takes the top as its operand before being
+ *  pushed. A use is thus renamed to the closest new definition that
+ *  dominates it, as if the definitions were renamed one at a time.
+ */
+void uSSA::renameNewDefs()
 {
-	// This vector of Instruction* points to the uses of V.
-	// This auxiliary vector of pointers is used because the use_iterators are invalidated when we do the renaming
-	Value *V = newdef->getOperand(0);
-	SmallVector<Instruction*, 25> usepointers;
-	unsigned i = 0, n = V->getNumUses();
-	usepointers.resize(n);
-	BasicBlock *BB = newdef->getParent();
+	if (newdefs_.empty())
+		return;
 	
-	for (Value::use_iterator uit = V->use_begin(), uend = V->use_end(); uit != uend; ++uit, ++i)
-		usepointers[i] = dyn_cast<Instruction>(*uit);
+	// Current definition of each renamed variable
+	DenseMap<Value*, SmallVector<Instruction*, 8> > stacks;
 	
-	for (i = 0; i < n; ++i) {
-		if (usepointers[i] ==  NULL) {
-			continue;
+	for (SmallPtrSet<Instruction*, 32>::iterator it = newdefs_.begin(), end = newdefs_.end(); it != end; ++it) {
+		stacks[(*it)->getOperand(0)];
+	}
+	
+	// Nodes of the dominator tree still to be visited, with the index of their next child,
+	// and the variables whose definitions were pushed in each of them
+	SmallVector<std::pair<DomTreeNode*, unsigned>, 32> worklist;
+	SmallVector<SmallVector<Value*, 4>, 32> pushed;
+	
+	worklist.push_back(std::make_pair(DT_->getRootNode(), 0));
+	pushed.push_back(SmallVector<Value*, 4>());
+	renameUsesInBlock(DT_->getRootNode()->getBlock(), stacks, pushed.back());
+	
+	while (!worklist.empty()) {
+		DomTreeNode *node = worklist.back().first;
+		unsigned child = worklist.back().second;
+		
+		if (child < node->getNumChildren()) {
+			++worklist.back().second;
+			
+			DomTreeNode *next = node->getChildren()[child];
+			
+			worklist.push_back(std::make_pair(next, 0));
+			pushed.push_back(SmallVector<Value*, 4>());
+			renameUsesInBlock(next->getBlock(), stacks, pushed.back());
 		}
-		if (usepointers[i] == newdef) {
-			continue;
+		else {
+			// Leaving the subtree, its definitions no longer dominate anything
+			for (SmallVectorImpl<Value*>::iterator it = pushed.back().begin(), end = pushed.back().end(); it != end; ++it) {
+				stacks[*it].pop_back();
+			}
+			
+			worklist.pop_back();
+			pushed.pop_back();
 		}
-		if (isa<GetElementPtrInst>(usepointers[i])) {
+	}
+}
+
+/*
+ *  Renames the uses in BB of variables with new definitions to the definitions
+ *  on top of their stacks, pushing the new definitions found in BB
+ */
+void uSSA::renameUsesInBlock(BasicBlock *BB, DenseMap<Value*, SmallVector<Instruction*, 8> > &stacks, SmallVectorImpl<Value*> &pushed)
+{
+	for (BasicBlock::iterator BBit = BB->begin(), BBend = BB->end(); BBit != BBend; ++BBit) {
+		Instruction *I = BBit;
+		
+		// ATTENTION: GEP uses are not taken into account
+		if (isa<GetElementPtrInst>(I)) {
 			continue;
 		}
 		
-		BasicBlock *BB_user = usepointers[i]->getParent();
-		BasicBlock::iterator newdefit(newdef);
-		BasicBlock::iterator useit(usepointers[i]);
+		// New definitions were created with the original variable as operand
+		Value *V = newdefs_.count(I) ? I->getOperand(0) : NULL;
 		
-		// Check if the use is in the dominator tree of newdef(V)
-		if (DT_->dominates(BB, BB_user)) {
-			// If in the same basicblock, only rename if the use is posterior to the newdef
-			if (BB_user == BB) {
-				int dist1 = std::distance(BB->begin(), useit);
-				int dist2 = std::distance(BB->begin(), newdefit);
-				int offset = dist1 - dist2;
-				
-				if (offset > 0) {
-					usepointers[i]->replaceUsesOfWith(V, newdef);
-				}
-			}
-			else {
-				usepointers[i]->replaceUsesOfWith(V, newdef);
+		for (unsigned i = 0, e = I->getNumOperands(); i < e; ++i) {
+			DenseMap<Value*, SmallVector<Instruction*, 8> >::iterator sit = stacks.find(I->getOperand(i));
+			
+			if (sit != stacks.end() && !sit->second.empty()) {
+				I->setOperand(i, sit->second.back());
 			}
 		}
+		
+		if (V) {
+			stacks[V].push_back(I);
+			pushed.push_back(V);
+		}
 	}
 }
 
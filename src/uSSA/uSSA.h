@@ -14,6 +14,8 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/CFG.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Analysis/DominanceFrontier.h"
@@ -31,12 +33,15 @@ public:
 	bool runOnFunction(Function&);
 	
 	void createNewDefs(BasicBlock *BB);
-	void renameNewDefs(Instruction *newdef);
+	void renameNewDefs();
 
 private:
 	// Variables always live
 	DominatorTree *DT_;
 	DominanceFrontier *DF_;
+	// New definitions created in the current function, renamed all at once
+	SmallPtrSet<Instruction*, 32> newdefs_;
+	void renameUsesInBlock(BasicBlock *BB, DenseMap<Value*, SmallVector<Instruction*, 8> > &stacks, SmallVectorImpl<Value*> &pushed);
 };
 
 }
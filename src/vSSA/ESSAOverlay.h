@@ -0,0 +1,518 @@
+/*
+ *	ESSAOverlay.h
+ *
+ *	Describes the e-SSA form of a function without changing its IR. The
+ *	sigmas and phis that vSSA would insert are recorded in side tables keyed
+ *	by (basic block, value). Each one has a detached placeholder PHINode
+ *	that stands for it in the graphs of the analyses. Every operand is
+ *	mapped to the definition, real or virtual, that reaches it, so clients
+ *	read operands through getOperand() instead of from the instructions.
+ *
+ *	Placement follows the rules of the vSSA pass: a sigma for each variable
+ *	compared by a branch or switch (and for the source of a cast operand) in
+ *	the successors that have a single predecessor and reach a use of the
+ *	variable, and phis in the dominance frontiers of those blocks where the
+ *	variable is still used.
+ *
+ *	It is defined in this header only, so that the range analysis and the
+ *	dependence graph libraries can both use it without linking to each other.
+ */
+
+#ifndef ESSAOVERLAY_H_
+#define ESSAOVERLAY_H_
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include <vector>
+
+namespace llvm {
+
+class ESSAOverlay {
+public:
+	// A sigma or phi placed by the overlay at the beginning of a block
+	struct VirtualDef {
+		// Detached instruction that stands for the definition
+		PHINode *Placeholder;
+		BasicBlock *BB;
+		// The variable it redefines
+		Value *Original;
+		bool IsSigma;
+		// One entry per edge into BB, with the definition of Original that
+		// reaches the end of the predecessor
+		SmallVector<std::pair<BasicBlock*, Value*>, 2> Incoming;
+	};
+
+private:
+	typedef std::pair<const BasicBlock*, const Value*> BlockValue;
+
+	// Virtual definitions of each function, in the order they were placed
+	DenseMap<const Function*, std::vector<VirtualDef*> > defsOf;
+	DenseMap<BlockValue, VirtualDef*> defAt;
+	DenseMap<const BasicBlock*, SmallVector<VirtualDef*, 4> > defsIn;
+	DenseMap<const Value*, VirtualDef*> byPlaceholder;
+	DenseMap<const Value*, SmallVector<PHINode*, 4> > sigmasOf;
+	// Operands reached by a virtual definition
+	DenseMap<const Use*, Value*> renamed;
+	// Definitions reaching the end of branching blocks, for the operands of
+	// their conditions
+	DenseMap<BlockValue, Value*> defAtEnd;
+
+	// Only valid while a function is built
+	DominatorTree DT;
+	DenseMap<const BasicBlock*, std::pair<unsigned, unsigned> > intervals;
+	DenseMap<const BasicBlock*, SmallPtrSet<BasicBlock*, 4> > frontiers;
+
+	typedef DenseMap<Value*, SmallVector<Value*, 8> > RenameStacks;
+
+	ESSAOverlay(const ESSAOverlay&);
+	void operator=(const ESSAOverlay&);
+
+	bool dominates(const BasicBlock *A, const BasicBlock *B) const {
+		DenseMap<const BasicBlock*, std::pair<unsigned, unsigned> >::const_iterator ait = intervals.find(A);
+		DenseMap<const BasicBlock*, std::pair<unsigned, unsigned> >::const_iterator bit = intervals.find(B);
+
+		if (ait == intervals.end() || bit == intervals.end())
+			return false;
+
+		return ait->second.first <= bit->second.first && bit->second.second <= ait->second.second;
+	}
+
+	bool inFrontier(const BasicBlock *BB, BasicBlock *F) const {
+		DenseMap<const BasicBlock*, SmallPtrSet<BasicBlock*, 4> >::const_iterator it = frontiers.find(BB);
+		return it != frontiers.end() && it->second.count(F);
+	}
+
+	// DFS numbers of the dominator tree and dominance frontiers, as in
+	// Cooper, Harvey and Kennedy
+	void buildDominanceTables(Function &F) {
+		DT.recalculate(F);
+		DT.updateDFSNumbers();
+
+		for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+			if (DomTreeNode *node = DT.getNode(BB))
+				intervals[BB] = std::make_pair(node->getDFSNumIn(), node->getDFSNumOut());
+		}
+
+		for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+			DomTreeNode *node = DT.getNode(BB);
+
+			if (!node)
+				continue;
+
+			unsigned numPreds = 0;
+			for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB); PI != PE; ++PI)
+				++numPreds;
+
+			if (numPreds < 2)
+				continue;
+
+			for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB); PI != PE; ++PI) {
+				for (DomTreeNode *runner = DT.getNode(*PI); runner && runner != node->getIDom(); runner = runner->getIDom())
+					frontiers[runner->getBlock()].insert(BB);
+			}
+		}
+	}
+
+	// Variables constrained by the terminator of BB, as in vSSA
+	static void getConstrainedVars(const TerminatorInst *TI, SmallVectorImpl<Value*> &vars) {
+		SmallVector<Value*, 2> operands;
+
+		if (const BranchInst *bi = dyn_cast<BranchInst>(TI)) {
+			if (!bi->isConditional())
+				return;
+
+			if (ICmpInst *cmp = dyn_cast<ICmpInst>(bi->getCondition())) {
+				operands.push_back(cmp->getOperand(0));
+				operands.push_back(cmp->getOperand(1));
+			}
+		}
+		else if (const SwitchInst *si = dyn_cast<SwitchInst>(TI)) {
+			operands.push_back(si->getCondition());
+		}
+
+		for (unsigned i = 0, e = operands.size(); i < e; ++i) {
+			Value *operand = operands[i];
+
+			if (!isa<Instruction>(operand) && !isa<Argument>(operand))
+				continue;
+
+			vars.push_back(operand);
+
+			// Sigmas are created for the operand of a cast too
+			if (CastInst *cinst = dyn_cast<CastInst>(operand)) {
+				if (isa<Instruction>(cinst->getOperand(0)) || isa<Argument>(cinst->getOperand(0)))
+					vars.push_back(cinst->getOperand(0));
+			}
+		}
+	}
+
+	// BB_next dominates a use of V, or has one in its frontier
+	bool needsSigma(BasicBlock *BB, BasicBlock *BB_next, Value *V) const {
+		for (Value::user_iterator uit = V->user_begin(), uend = V->user_end(); uit != uend; ++uit) {
+			Instruction *I = dyn_cast<Instruction>(*uit);
+
+			if (I == NULL || isa<GetElementPtrInst>(I))
+				continue;
+
+			BasicBlock *BB_father = I->getParent();
+			if (BB_next == BB_father && isa<PHINode>(I))
+				continue;
+
+			if (dominates(BB_next, BB_father))
+				return true;
+
+			if (BB_father != BB && inFrontier(BB_next, BB_father))
+				return true;
+		}
+		return false;
+	}
+
+	// V reaches BB and is used in a block dominated by it
+	bool needsPhi(BasicBlock *BB, Value *V) const {
+		if (Instruction *I = dyn_cast<Instruction>(V)) {
+			if (BB == I->getParent() || !dominates(I->getParent(), BB))
+				return false;
+		}
+		else if (Argument *A = dyn_cast<Argument>(V)) {
+			if (BB == &A->getParent()->getEntryBlock())
+				return false;
+		}
+		else {
+			return false;
+		}
+
+		for (Value::user_iterator uit = V->user_begin(), uend = V->user_end(); uit != uend; ++uit) {
+			Instruction *I = dyn_cast<Instruction>(*uit);
+
+			if (I == NULL)
+				continue;
+
+			if (BB == I->getParent() && isa<PHINode>(I))
+				continue;
+
+			if (dominates(BB, I->getParent()))
+				return true;
+		}
+		return false;
+	}
+
+	VirtualDef *addDef(BasicBlock *BB, Value *V, bool IsSigma, std::vector<VirtualDef*> &defs) {
+		VirtualDef *D = new VirtualDef();
+		D->Placeholder = PHINode::Create(V->getType(), 0, IsSigma ? "vSSA_sigma" : "vSSA_phi");
+		D->BB = BB;
+		D->Original = V;
+		D->IsSigma = IsSigma;
+
+		defs.push_back(D);
+		defAt[std::make_pair(BB, V)] = D;
+		defsIn[BB].push_back(D);
+		byPlaceholder[D->Placeholder] = D;
+
+		if (IsSigma)
+			sigmasOf[V].push_back(D->Placeholder);
+
+		return D;
+	}
+
+	void placeSigmas(Function &F, std::vector<VirtualDef*> &defs) {
+		for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+			if (!intervals.count(BB))
+				continue;
+
+			TerminatorInst *TI = BB->getTerminator();
+			SmallVector<Value*, 4> vars;
+			getConstrainedVars(TI, vars);
+
+			for (unsigned v = 0, ve = vars.size(); v < ve; ++v) {
+				for (unsigned i = 0, e = TI->getNumSuccessors(); i < e; ++i) {
+					BasicBlock *BB_next = TI->getSuccessor(i);
+
+					if (BB_next == BB || BB_next->getSinglePredecessor() == NULL)
+						continue;
+
+					if (defAt.count(std::make_pair(BB_next, vars[v])) || !needsSigma(BB, BB_next, vars[v]))
+						continue;
+
+					addDef(BB_next, vars[v], true, defs);
+				}
+			}
+		}
+	}
+
+	// Phis go in the iterated dominance frontier of the sigmas of each variable
+	void placePhis(std::vector<VirtualDef*> &defs) {
+		SmallVector<Value*, 16> vars;
+		SmallPtrSet<Value*, 16> seen;
+
+		for (unsigned i = 0, e = defs.size(); i < e; ++i) {
+			if (!seen.count(defs[i]->Original)) {
+				seen.insert(defs[i]->Original);
+				vars.push_back(defs[i]->Original);
+			}
+		}
+
+		for (unsigned v = 0, ve = vars.size(); v < ve; ++v) {
+			Value *V = vars[v];
+			SmallVector<BasicBlock*, 16> worklist;
+
+			for (unsigned i = 0, e = defs.size(); i < e; ++i) {
+				if (defs[i]->Original == V)
+					worklist.push_back(defs[i]->BB);
+			}
+
+			while (!worklist.empty()) {
+				BasicBlock *X = worklist.pop_back_val();
+
+				DenseMap<const BasicBlock*, SmallPtrSet<BasicBlock*, 4> >::iterator fit = frontiers.find(X);
+				if (fit == frontiers.end())
+					continue;
+
+				for (SmallPtrSet<BasicBlock*, 4>::iterator it = fit->second.begin(), end = fit->second.end(); it != end; ++it) {
+					BasicBlock *F = *it;
+
+					if (defAt.count(std::make_pair(F, V)) || !needsPhi(F, V))
+						continue;
+
+					addDef(F, V, false, defs);
+					worklist.push_back(F);
+				}
+			}
+		}
+	}
+
+	Value *top(RenameStacks &stacks, Value *V) const {
+		RenameStacks::iterator sit = stacks.find(V);
+
+		if (sit == stacks.end() || sit->second.empty())
+			return NULL;
+
+		return sit->second.back();
+	}
+
+	void recordDefAtEnd(BasicBlock *BB, Value *V, RenameStacks &stacks) {
+		if (Value *def = top(stacks, V))
+			defAtEnd[std::make_pair(BB, V)] = def;
+	}
+
+	// Renames the operands of BB, pushing the virtual definitions placed in it
+	void renameBlock(BasicBlock *BB, RenameStacks &stacks, SmallVectorImpl<Value*> &pushed) {
+		DenseMap<const BasicBlock*, SmallVector<VirtualDef*, 4> >::iterator dit = defsIn.find(BB);
+
+		if (dit != defsIn.end()) {
+			for (unsigned i = 0, e = dit->second.size(); i < e; ++i) {
+				stacks[dit->second[i]->Original].push_back(dit->second[i]->Placeholder);
+				pushed.push_back(dit->second[i]->Original);
+			}
+		}
+
+		for (BasicBlock::iterator it = BB->begin(), end = BB->end(); it != end; ++it) {
+			// Phi operands are renamed at the end of the incoming blocks, and
+			// vSSA leaves the uses in GEPs alone
+			if (isa<PHINode>(it) || isa<GetElementPtrInst>(it))
+				continue;
+
+			for (unsigned i = 0, e = it->getNumOperands(); i < e; ++i) {
+				if (Value *def = top(stacks, it->getOperand(i)))
+					renamed[&it->getOperandUse(i)] = def;
+			}
+		}
+
+		TerminatorInst *TI = BB->getTerminator();
+		SmallVector<Value*, 4> vars;
+		getConstrainedVars(TI, vars);
+
+		for (unsigned i = 0, e = vars.size(); i < e; ++i)
+			recordDefAtEnd(BB, vars[i], stacks);
+
+		SmallPtrSet<BasicBlock*, 4> visited;
+
+		for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI) {
+			BasicBlock *succ = *SI;
+
+			// One incoming value per edge in the virtual phis
+			DenseMap<const BasicBlock*, SmallVector<VirtualDef*, 4> >::iterator sdit = defsIn.find(succ);
+
+			if (sdit != defsIn.end()) {
+				for (unsigned i = 0, e = sdit->second.size(); i < e; ++i) {
+					VirtualDef *D = sdit->second[i];
+					Value *def = top(stacks, D->Original);
+					D->Incoming.push_back(std::make_pair(BB, def ? def : D->Original));
+				}
+			}
+
+			if (visited.count(succ))
+				continue;
+			visited.insert(succ);
+
+			for (BasicBlock::iterator it = succ->begin(); PHINode *phi = dyn_cast<PHINode>(it); ++it) {
+				for (unsigned i = 0, e = phi->getNumIncomingValues(); i < e; ++i) {
+					if (phi->getIncomingBlock(i) != BB)
+						continue;
+
+					if (Value *def = top(stacks, phi->getIncomingValue(i)))
+						renamed[&phi->getOperandUse(i)] = def;
+				}
+			}
+		}
+	}
+
+	// Standard SSA renaming, in a walk over the dominator tree with a stack
+	// of reaching definitions per variable
+	void rename(std::vector<VirtualDef*> &defs) {
+		RenameStacks stacks;
+
+		for (unsigned i = 0, e = defs.size(); i < e; ++i)
+			stacks[defs[i]->Original];
+
+		SmallVector<std::pair<DomTreeNode*, unsigned>, 32> worklist;
+		SmallVector<SmallVector<Value*, 4>, 32> pushed;
+
+		worklist.push_back(std::make_pair(DT.getRootNode(), 0));
+		pushed.push_back(SmallVector<Value*, 4>());
+		renameBlock(DT.getRootNode()->getBlock(), stacks, pushed.back());
+
+		while (!worklist.empty()) {
+			DomTreeNode *node = worklist.back().first;
+			unsigned child = worklist.back().second;
+
+			if (child < node->getNumChildren()) {
+				++worklist.back().second;
+
+				DomTreeNode *next = node->getChildren()[child];
+
+				worklist.push_back(std::make_pair(next, 0));
+				pushed.push_back(SmallVector<Value*, 4>());
+				renameBlock(next->getBlock(), stacks, pushed.back());
+			}
+			else {
+				for (unsigned i = 0, e = pushed.back().size(); i < e; ++i)
+					stacks[pushed.back()[i]].pop_back();
+
+				worklist.pop_back();
+				pushed.pop_back();
+			}
+		}
+	}
+
+public:
+	ESSAOverlay() {}
+	~ESSAOverlay() { clear(); }
+
+	// Places the sigmas and phis of F and finds the definitions reaching its
+	// operands. Functions that vSSA already converted are left as they are.
+	void build(Function &F) {
+		if (F.isDeclaration() || defsOf.count(&F))
+			return;
+
+		std::vector<VirtualDef*> &defs = defsOf[&F];
+
+		for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+			for (BasicBlock::iterator it = BB->begin(); PHINode *phi = dyn_cast<PHINode>(it); ++it) {
+				if (phi->getName().startswith("vSSA_sigma"))
+					return;
+			}
+		}
+
+		buildDominanceTables(F);
+		placeSigmas(F, defs);
+		placePhis(defs);
+		if (!defs.empty())
+			rename(defs);
+
+		intervals.clear();
+		frontiers.clear();
+	}
+
+	void clear() {
+		for (DenseMap<const Function*, std::vector<VirtualDef*> >::iterator it = defsOf.begin(), end = defsOf.end(); it != end; ++it) {
+			for (unsigned i = 0, e = it->second.size(); i < e; ++i) {
+				delete it->second[i]->Placeholder;
+				delete it->second[i];
+			}
+		}
+
+		defsOf.clear();
+		defAt.clear();
+		defsIn.clear();
+		byPlaceholder.clear();
+		sigmasOf.clear();
+		renamed.clear();
+		defAtEnd.clear();
+	}
+
+	// Virtual definitions of F, in the order they were placed
+	ArrayRef<VirtualDef*> getVirtualDefs(const Function *F) const {
+		DenseMap<const Function*, std::vector<VirtualDef*> >::const_iterator it = defsOf.find(F);
+
+		if (it == defsOf.end())
+			return ArrayRef<VirtualDef*>();
+
+		return it->second;
+	}
+
+	// The virtual definition V stands for, or NULL
+	const VirtualDef *getVirtualDef(const Value *V) const {
+		DenseMap<const Value*, VirtualDef*>::const_iterator it = byPlaceholder.find(V);
+		return it == byPlaceholder.end() ? NULL : it->second;
+	}
+
+	// Virtual definition of V placed at the beginning of BB, or NULL
+	const VirtualDef *getVirtualDef(const BasicBlock *BB, const Value *V) const {
+		DenseMap<BlockValue, VirtualDef*>::const_iterator it = defAt.find(std::make_pair(BB, V));
+		return it == defAt.end() ? NULL : it->second;
+	}
+
+	// Placeholders of the sigmas that redefine V
+	ArrayRef<PHINode*> getSigmasOf(const Value *V) const {
+		DenseMap<const Value*, SmallVector<PHINode*, 4> >::const_iterator it = sigmasOf.find(V);
+
+		if (it == sigmasOf.end())
+			return ArrayRef<PHINode*>();
+
+		return it->second;
+	}
+
+	// The following also accept placeholders
+
+	const BasicBlock *getParent(const Instruction *I) const {
+		if (const VirtualDef *D = getVirtualDef(I))
+			return D->BB;
+		return I->getParent();
+	}
+
+	unsigned getNumOperands(const Instruction *I) const {
+		if (const VirtualDef *D = getVirtualDef(I))
+			return D->Incoming.size();
+		return I->getNumOperands();
+	}
+
+	// Definition that reaches operand i of I
+	Value *getOperand(const Instruction *I, unsigned i) const {
+		if (const VirtualDef *D = getVirtualDef(I))
+			return D->Incoming[i].second;
+		return getUsedValue(I->getOperandUse(i));
+	}
+
+	// Definition that reaches the use U
+	Value *getUsedValue(const Use &U) const {
+		DenseMap<const Use*, Value*>::const_iterator it = renamed.find(&U);
+		return it == renamed.end() ? U.get() : it->second;
+	}
+
+	// Definition of V that reaches the end of BB, if BB ends with a branch
+	// or switch whose condition uses V
+	Value *getDefAtEnd(const BasicBlock *BB, Value *V) const {
+		DenseMap<BlockValue, Value*>::const_iterator it = defAtEnd.find(std::make_pair(BB, V));
+		return it == defAtEnd.end() ? V : it->second;
+	}
+};
+
+}
+
+#endif /* ESSAOVERLAY_H_ */
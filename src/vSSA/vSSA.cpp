@@ -12,6 +12,7 @@
 #define DEBUG_TYPE "vssa"
 
 #include "vSSA.h"
+#include "llvm/Support/CommandLine.h"
 
 using namespace llvm;
 
@@ -20,6 +21,11 @@ static const std::string vSSA_SIG = "vSSA_sigma";
 
 STATISTIC(numsigmas, "Number of sigmas");
 STATISTIC(numphis, "Number of phis");
+STATISTIC(numdeadsigmas, "Number of sigmas pruned for having no use below the branch");
+STATISTIC(numredundantsigmas, "Number of sigmas pruned for constraining an already constrained copy");
+
+static cl::opt<bool>
+PrunedSigmas("vssa-pruned", cl::desc("Only insert sigmas for variables used in the blocks dominated by the branch target"), cl::init(false));
 
 void vSSA::getAnalysisUsage(AnalysisUsage &AU) const {
 	AU.addRequired<DominanceFrontier>();
@@ -38,13 +44,66 @@ bool vSSA::runOnFunction(Function &F) {
 	DT_ = &DTw_->getDomTree();
 	DF_ = &getAnalysis<DominanceFrontier>();
 	
+	// Sigma and phi placement query dominance and frontiers once per use of
+	// each variable, so both are turned into constant time lookups first.
+	// Only phis are inserted below, so the tables stay valid.
+	buildDominanceTables(F);
+	
 	// Iterate over all Basic Blocks of the Function, calling the function that creates sigma functions, if needed
 	for (Function::iterator Fit = F.begin(), Fend = F.end(); Fit != Fend; ++Fit) {
 		createSigmasIfNeeded(Fit);
 	}
+	
+	DFSIntervals_.clear();
+	FrontierPairs_.clear();
 	return true;
 }
 
+/*
+ *  Numbers the dominator tree in DFS order and flattens the dominance frontiers
+ */
+void vSSA::buildDominanceTables(Function &F)
+{
+	DFSIntervals_.clear();
+	FrontierPairs_.clear();
+	
+	DT_->updateDFSNumbers();
+	
+	for (Function::iterator Fit = F.begin(), Fend = F.end(); Fit != Fend; ++Fit) {
+		if (DomTreeNode *node = DT_->getNode(Fit)) {
+			DFSIntervals_[Fit] = std::make_pair(node->getDFSNumIn(), node->getDFSNumOut());
+		}
+	}
+	
+	for (DominanceFrontier::iterator DFit = DF_->begin(), DFend = DF_->end(); DFit != DFend; ++DFit) {
+		for (std::set<BasicBlock*>::iterator sit = DFit->second.begin(), send = DFit->second.end(); sit != send; ++sit) {
+			FrontierPairs_.insert(std::make_pair(DFit->first, *sit));
+		}
+	}
+}
+
+/*
+ *  Dominance between blocks of the current function, in constant time
+ */
+bool vSSA::dominates(BasicBlock *A, BasicBlock *B) const
+{
+	DenseMap<BasicBlock*, std::pair<unsigned, unsigned> >::const_iterator ait = DFSIntervals_.find(A);
+	DenseMap<BasicBlock*, std::pair<unsigned, unsigned> >::const_iterator bit = DFSIntervals_.find(B);
+	
+	if (ait == DFSIntervals_.end() || bit == DFSIntervals_.end())
+		return false;
+	
+	return ait->second.first <= bit->second.first && bit->second.second <= ait->second.second;
+}
+
+/*
+ *  Tests whether F is in the dominance frontier of BB
+ */
+bool vSSA::inFrontier(BasicBlock *BB, BasicBlock *F) const
+{
+	return FrontierPairs_.count(std::make_pair(BB, F));
+}
+
 void vSSA::createSigmasIfNeeded(BasicBlock *BB)
 {
 	TerminatorInst *ti = BB->getTerminator();
@@ -130,6 +189,12 @@ void vSSA::insertSigmas(TerminatorInst *TI, Value *V)
 	
 	bool firstSigma = true;
 	
+	// Sigmas created for V, one per successor of BB that needs it
+	SmallVector<PHINode*, 8> sigmas;
+	
+	// In pruned mode, a copy of V that is already constrained by the same comparison gains nothing from new sigmas
+	bool redundant = PrunedSigmas && isConstrainedBySameComparison(TI, V);
+	
 	// Iterate over all successors of BB, checking if a sigma is needed
 	for (unsigned i = 0, e = TI->getNumSuccessors(); i < e; ++i) {
 		
@@ -142,39 +207,55 @@ void vSSA::insertSigmas(TerminatorInst *TI, Value *V)
 			if (verifySigmaExistance(V, BB_next, BB))
 				continue;
 			
+			// In pruned mode, skip sigmas that would not refine the range of any use below the branch
+			if (redundant) {
+				++numredundantsigmas;
+				continue;
+			}
+			if (PrunedSigmas && !hasUseBelow(BB_next, V)) {
+				++numdeadsigmas;
+				continue;
+			}
+			
 			PHINode *sigma = PHINode::Create(V->getType(), 1, Twine(vSSA_SIG), &(BB_next->front()));
 			sigma->addIncoming(V, BB);
 			
-			++numsigmas;
-			
-			// Rename uses of V to sigma(V)
-			renameUsesToSigma(V, sigma);
-			
-			// Get the dominance frontier of the successor
-			DominanceFrontier::iterator DF_BB = DF_->find(BB_next);
-			
+			sigmas.push_back(sigma);
 			
-			/*
-			 * Creation (or operand insertion) of the SSI_PHI
-			 */
+			++numsigmas;
+		}
+	}
+	
+	// Rename uses of V to the sigmas, all of them in a single pass over the uses
+	renameUsesToSigmas(V, sigmas);
+	
+	for (SmallVectorImpl<PHINode*>::iterator sit = sigmas.begin(), send = sigmas.end(); sit != send; ++sit) {
+		PHINode *sigma = *sit;
 		
-			// If BB_next has no dominance frontier, there is no need of SSI_PHI
-			if (DF_BB == DF_->end())
-				continue; 
-			
-			// If it was the first sigma created for V, phis may be needed, so we verify and create them
-			if (firstSigma) {
-				// Insert vSSA_phi, if necessary
-				vssaphi_created = insertPhisForSigma(V, sigma);
-			}
-			else {
-				// If it was not the first sigma created for V, then the phis already have been created and are stored in the deque, so we need only to insert the sigma as operand of them
-				insertSigmaAsOperandOfPhis(vssaphi_created, sigma);
-			}
+		// Get the dominance frontier of the successor
+		DominanceFrontier::iterator DF_BB = DF_->find(sigma->getParent());
+		
+		
+		/*
+		 * Creation (or operand insertion) of the SSI_PHI
+		 */
+	
+		// If the block of the sigma has no dominance frontier, there is no need of SSI_PHI
+		if (DF_BB == DF_->end())
+			continue; 
+		
+		// If it was the first sigma created for V, phis may be needed, so we verify and create them
+		if (firstSigma) {
+			// Insert vSSA_phi, if necessary
+			vssaphi_created = insertPhisForSigma(V, sigma);
+		}
+		else {
+			// If it was not the first sigma created for V, then the phis already have been created and are stored in the deque, so we need only to insert the sigma as operand of them
+			insertSigmaAsOperandOfPhis(vssaphi_created, sigma);
 		}
 		
 		// If phis were created, no more phis will be created, only operands will be inserted in them
-		if (firstSigma && !vssaphi_created.empty())
+		if (!vssaphi_created.empty())
 			firstSigma = false;
 	}
 	
@@ -190,19 +271,53 @@ void vSSA::insertSigmas(TerminatorInst *TI, Value *V)
 	}
 }
 
+static bool compareDFSNumber(const std::pair<unsigned, PHINode*> &a, const std::pair<unsigned, PHINode*> &b)
+{
+	return a.first < b.first;
+}
+
 /*
- * Renaming uses of V to uses of sigma
+ *  Returns the sigma, among the ones sorted by the DFS number of their blocks, whose block dominates BB, or NULL
+ */
+PHINode *vSSA::findDominatingSigma(ArrayRef<std::pair<unsigned, PHINode*> > sorted, BasicBlock *BB) const
+{
+	DenseMap<BasicBlock*, std::pair<unsigned, unsigned> >::const_iterator it = DFSIntervals_.find(BB);
+	
+	if (it == DFSIntervals_.end())
+		return NULL;
+	
+	// The only candidate is the last sigma whose block is numbered before BB
+	const std::pair<unsigned, PHINode*> *pos = std::upper_bound(sorted.begin(), sorted.end(), std::make_pair(it->second.first, (PHINode*)NULL), compareDFSNumber);
+	
+	if (pos == sorted.begin())
+		return NULL;
+	
+	--pos;
+	
+	return dominates(pos->second->getParent(), BB) ? pos->second : NULL;
+}
+
+/*
+ * Renaming uses of V to uses of the sigmas created for it
  * The rule of renaming is:
  *   - All uses of V in the dominator tree of sigma(V) are renamed, except for the sigma itself, of course
  *   - Uses of V in the dominance frontier of sigma(V) are renamed iff they are in PHI nodes (maybe this always happens)
+ * The sigmas are in distinct blocks that have a single predecessor, so their dominator trees are disjoint
+ * and each use is renamed to at most one of them. Each use of V is visited only once, whatever the number of sigmas.
  */
-void vSSA::renameUsesToSigma(Value *V, PHINode *sigma)
+void vSSA::renameUsesToSigmas(Value *V, ArrayRef<PHINode*> sigmas)
 {
-	BasicBlock *BB_next = sigma->getParent();
-
-	// Get the dominance frontier of the successor
-	DominanceFrontier::iterator DF_BB = DF_->find(BB_next);
+	if (sigmas.empty())
+		return;
+	
+	SmallVector<std::pair<unsigned, PHINode*>, 8> sorted;
 	
+	for (ArrayRef<PHINode*>::iterator sit = sigmas.begin(), send = sigmas.end(); sit != send; ++sit) {
+		sorted.push_back(std::make_pair(DFSIntervals_.lookup((*sit)->getParent()).first, *sit));
+	}
+	
+	std::sort(sorted.begin(), sorted.end(), compareDFSNumber);
+
 	// This vector of Instruction* points to the uses of V.
 	// This auxiliary vector of pointers is used because the use_iterators are invalidated when we do the renaming
 	SmallVector<Instruction*, 25> usepointers;
@@ -216,32 +331,31 @@ void vSSA::renameUsesToSigma(Value *V, PHINode *sigma)
 		if (usepointers[i] ==  NULL) {
 			continue;
 		}
-		if (usepointers[i] == sigma) {
-			continue;
-		}
 		if (isa<GetElementPtrInst>(usepointers[i])) {
 			continue;
 		}
 		
 		BasicBlock *BB_user = usepointers[i]->getParent();
 		
-		// Check if the use is in the dominator tree of sigma(V)
-		if (DT_->dominates(BB_next, BB_user)){
-			usepointers[i]->replaceUsesOfWith(V, sigma);
+		// Check if the use is in the dominator tree of some sigma(V)
+		if (PHINode *sigma = findDominatingSigma(sorted, BB_user)) {
+			if (usepointers[i] != sigma) {
+				usepointers[i]->replaceUsesOfWith(V, sigma);
+			}
 		}
-		// Check if the use is in the dominance frontier of sigma(V)
-		else if ((DF_BB != DF_->end()) && (DF_BB->second.find(BB_user) != DF_BB->second.end())) {
-			// Check if the user is a PHI node (it has to be, but only for precaution)
-			if (PHINode *phi = dyn_cast<PHINode>(usepointers[i])) {
-				for (unsigned i = 0, e = phi->getNumIncomingValues(); i < e; ++i) {
-					Value *operand = phi->getIncomingValue(i);
-					
-					if (operand != V)
-						continue;
-					
-					if (DT_->dominates(BB_next, phi->getIncomingBlock(i))) {
-						phi->setIncomingValue(i, sigma);
-					}
+		// Check if the use is in the dominance frontier of some sigma(V)
+		// Check if the user is a PHI node (it has to be, but only for precaution)
+		else if (PHINode *phi = dyn_cast<PHINode>(usepointers[i])) {
+			for (unsigned i = 0, e = phi->getNumIncomingValues(); i < e; ++i) {
+				Value *operand = phi->getIncomingValue(i);
+				
+				if (operand != V)
+					continue;
+				
+				PHINode *sigma = findDominatingSigma(sorted, phi->getIncomingBlock(i));
+				
+				if (sigma && inFrontier(sigma->getParent(), BB_user)) {
+					phi->setIncomingValue(i, sigma);
 				}
 			}
 		}
@@ -270,7 +384,7 @@ SmallVector<PHINode*, 25> vSSA::insertPhisForSigma(Value *V, PHINode *sigma)
 		bool condition = false;
 	
 		if (Instruction *I = dyn_cast<Instruction>(V)) {
-			condition = DT_->dominates(I->getParent(), BB_infrontier) && dominateAny(BB_infrontier, V);
+			condition = dominates(I->getParent(), BB_infrontier) && dominateAny(BB_infrontier, V);
 		}
 		else if (isa<Argument>(V)) {
 			condition = dominateAny(BB_infrontier, V);
@@ -286,7 +400,7 @@ SmallVector<PHINode*, 25> vSSA::insertPhisForSigma(Value *V, PHINode *sigma)
 //			for (pred_iterator PI = pred_begin(BB_infrontier), PE = pred_end(BB_infrontier); PI != PE; ++PI) {
 //				predBB = *PI;
 //			
-//				if (DT_->dominates(BB, predBB)) {
+//				if (dominates(BB, predBB)) {
 //					break;
 //				}
 //			}
@@ -325,7 +439,7 @@ void vSSA::insertPhisForPhi(Value *V, PHINode *phi)
 		bool condition = false;
 	
 		if (Instruction *I = dyn_cast<Instruction>(V)) {
-			condition = DT_->dominates(I->getParent(), BB_infrontier) && dominateAny(BB_infrontier, V);
+			condition = dominates(I->getParent(), BB_infrontier) && dominateAny(BB_infrontier, V);
 		}
 		else if (isa<Argument>(V)) {
 			condition = dominateAny(BB_infrontier, V);
@@ -341,7 +455,7 @@ void vSSA::insertPhisForPhi(Value *V, PHINode *phi)
 //			for (pred_iterator PI = pred_begin(BB_infrontier), PE = pred_end(BB_infrontier); PI != PE; ++PI) {
 //				predBB = *PI;
 //			
-//				if (DT_->dominates(BB, predBB)) {
+//				if (dominates(BB, predBB)) {
 //					break;
 //				}
 //			}
@@ -389,9 +503,6 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 	
 	BasicBlock *BB_next = phi->getParent();
 	
-	// Get the dominance frontier of the successor
-	DominanceFrontier::iterator DF_BB = DF_->find(BB_next);
-	
 	for (Value::user_iterator uit = V->user_begin(), uend = V->user_end(); uit != uend; ++uit, ++i)
 		usepointers[i] = dyn_cast<Instruction>(*uit);
 	
@@ -399,7 +510,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 	 
 	for (i = 0; i < n; ++i) {
 		// Check if the use is in the dominator tree of vSSA_PHI
-		if (DT_->dominates(BB_parent, usepointers[i]->getParent())) {
+		if (dominates(BB_parent, usepointers[i]->getParent())) {
 			if (BB_parent != usepointers[i]->getParent()) {
 				usepointers[i]->replaceUsesOfWith(V, phi);
 				
@@ -414,7 +525,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 				usepointers[i]->replaceUsesOfWith(V, phi);
 		}
 		// Check if the use is in the dominance frontier of phi
-	 	else if (DF_BB->second.find(usepointers[i]->getParent()) != DF_BB->second.end()) {
+	 	else if (inFrontier(BB_next, usepointers[i]->getParent())) {
 	 		// Check if the user is a PHI node (it has to be, but only for precaution)
 	 		if (PHINode *phiuser = dyn_cast<PHINode>(usepointers[i])) {
 	 			for (unsigned i = 0, e = phiuser->getNumIncomingValues(); i < e; ++i) {
@@ -423,7 +534,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 	 				if (operand != V)
 	 					continue;
 	 				
-	 				if (DT_->dominates(BB_next, phiuser->getIncomingBlock(i))) {
+	 				if (dominates(BB_next, phiuser->getIncomingBlock(i))) {
 	 					phiuser->setIncomingValue(i, phi);
 	 				}
 	 			}
@@ -449,7 +560,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 		 
 		for (i = 0; i < n; ++i) {
 			// Check if the use is in the dominator tree of vSSA_PHI
-			if (DT_->dominates(BB_parent, usepointers[i]->getParent())) {
+			if (dominates(BB_parent, usepointers[i]->getParent())) {
 				if (BB_parent != usepointers[i]->getParent()) {
 					usepointers[i]->replaceUsesOfWith(V, phi);
 				
@@ -464,7 +575,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 					usepointers[i]->replaceUsesOfWith(V, phi);
 			}
 			// Check if the use is in the dominance frontier of phi
-		 	else if (DF_BB->second.find(usepointers[i]->getParent()) != DF_BB->second.end()) {
+		 	else if (inFrontier(BB_next, usepointers[i]->getParent())) {
 		 		// Check if the user is a PHI node (it has to be, but only for precaution)
 		 		if (PHINode *phiuser = dyn_cast<PHINode>(usepointers[i])) {
 		 			for (unsigned i = 0, e = phiuser->getNumIncomingValues(); i < e; ++i) {
@@ -473,7 +584,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 		 				if (operand != V)
 		 					continue;
 		 				
-		 				if (DT_->dominates(BB_next, phiuser->getIncomingBlock(i))) {
+		 				if (dominates(BB_next, phiuser->getIncomingBlock(i))) {
 		 					phiuser->setIncomingValue(i, phi);
 		 				}
 		 			}
@@ -486,7 +597,7 @@ void vSSA::renameUsesToPhi(Value *V, PHINode *phi)
 	// Try to create phis again for the sigmas whose operand was renamed to vSSA_phi
 	// Also, renaming may need to be done again
 	for (SmallVectorImpl<PHINode*>::iterator vit = sigmasRenamed.begin(), vend = sigmasRenamed.end(); vit != vend; ++vit) {
-		renameUsesToSigma(phi, *vit);
+		renameUsesToSigmas(phi, *vit);
 		SmallVector<PHINode*, 25> vssaphis_created = insertPhisForSigma(phi, *vit);
 		//insertSigmaAsOperandOfPhis(vssaphis_created, *vit);
 		populatePhis(vssaphis_created, (*vit)->getIncomingValue(0));
@@ -513,7 +624,7 @@ void vSSA::insertSigmaAsOperandOfPhis(SmallVector<PHINode*, 25> &vssaphi_created
 		for (; PI != PE; ++PI) {
 			predBB = *PI;
 		
-			if (DT_->dominates(BB, predBB)/* && (vssaphi->getBasicBlockIndex(predBB) == -1)*/) {
+			if (dominates(BB, predBB)/* && (vssaphi->getBasicBlockIndex(predBB) == -1)*/) {
 				vssaphi->addIncoming(sigma, predBB);
 			}
 		}		
@@ -592,7 +703,7 @@ bool vSSA::dominateAny(BasicBlock *BB, Value *value) {
 		if (BB == BB_father && isa<PHINode>(I)) {
 			continue;
 		}
-		if (DT_->dominates(BB, BB_father)) {
+		if (dominates(BB, BB_father)) {
 			return true;
 		}
 	}
@@ -604,8 +715,6 @@ bool vSSA::dominateAny(BasicBlock *BB, Value *value) {
  *  or if BB_next has any use of value inside its dominance frontier
  */
 bool vSSA::dominateOrHasInFrontier(BasicBlock *BB, BasicBlock *BB_next, Value *value) {
-	DominanceFrontier::iterator DF_BB = DF_->find(BB_next);
-
 	for (Value::user_iterator begin = value->user_begin(), end = value->user_end(); begin != end; ++begin) {
 		Instruction *I = dyn_cast<Instruction>(*begin);
 		
@@ -618,17 +727,83 @@ bool vSSA::dominateOrHasInFrontier(BasicBlock *BB, BasicBlock *BB_next, Value *v
 		if (BB_next == BB_father && isa<PHINode>(I))
 			continue;
 		
-		if (DT_->dominates(BB_next, BB_father))
+		if (dominates(BB_next, BB_father))
 			return true;
 		
 		//If the BB_father is in the dominance frontier of BB then we need to create a sigma in BB_next 
 		//to split the lifetime of variables
-		if ((BB_father != BB) && (DF_BB != DF_->end()) && (DF_BB->second.find(BB_father) != DF_BB->second.end()))
+		if ((BB_father != BB) && inFrontier(BB_next, BB_father))
+			return true;
+	}
+	return false;
+}
+
+/*
+ *  Used by the pruned mode. Verifies if BB_next dominates any use of value
+ *  other than GEPs and phis at the beginning of BB_next
+ */
+bool vSSA::hasUseBelow(BasicBlock *BB_next, Value *value)
+{
+	for (Value::user_iterator begin = value->user_begin(), end = value->user_end(); begin != end; ++begin) {
+		Instruction *I = dyn_cast<Instruction>(*begin);
+		
+		if (I == NULL || isa<GetElementPtrInst>(I)) {
+			continue;
+		}
+		
+		BasicBlock *BB_father = I->getParent();
+		if (BB_next == BB_father && isa<PHINode>(I))
+			continue;
+		
+		if (dominates(BB_next, BB_father))
 			return true;
 	}
 	return false;
 }
 
+/*
+ *  Returns the value a chain of sigmas was created for
+ */
+static Value *stripSigmas(Value *V)
+{
+	while (PHINode *sigma = dyn_cast<PHINode>(V)) {
+		if (sigma->getNumIncomingValues() != 1 || !sigma->getName().startswith(vSSA_SIG))
+			break;
+		
+		V = sigma->getIncomingValue(0);
+	}
+	return V;
+}
+
+/*
+ *  Used by the pruned mode. Verifies if V is a sigma created for a comparison
+ *  identical to the one that controls TI, e.g. the inner test of
+ *  "if (x < n) if (x < n)". Both successors of TI would then get the range V
+ *  already has, or an empty one.
+ */
+bool vSSA::isConstrainedBySameComparison(TerminatorInst *TI, Value *V)
+{
+	BranchInst *bi = dyn_cast<BranchInst>(TI);
+	PHINode *sigma = dyn_cast<PHINode>(V);
+	
+	if (!bi || !bi->isConditional() || !sigma || sigma->getNumIncomingValues() != 1 || !sigma->getName().startswith(vSSA_SIG))
+		return false;
+	
+	BranchInst *prev = dyn_cast<BranchInst>(sigma->getIncomingBlock(0)->getTerminator());
+	
+	if (!prev || !prev->isConditional())
+		return false;
+	
+	ICmpInst *cmp = dyn_cast<ICmpInst>(bi->getCondition());
+	ICmpInst *prevcmp = dyn_cast<ICmpInst>(prev->getCondition());
+	
+	if (!cmp || !prevcmp || cmp->getPredicate() != prevcmp->getPredicate())
+		return false;
+	
+	return stripSigmas(cmp->getOperand(0)) == stripSigmas(prevcmp->getOperand(0))
+		&& stripSigmas(cmp->getOperand(1)) == stripSigmas(prevcmp->getOperand(1));
+}
+
 /*
  *  This function verifies if there is a sigma function inside BB whose incoming value is equal to V and whose incoming block is equal to BB_from
  */
@@ -12,6 +12,8 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/IR/Dominators.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Analysis/DominanceFrontier.h"
@@ -33,9 +35,18 @@ private:
 	DominatorTreeWrapperPass *DTw_;
 	DominatorTree *DT_;
 	DominanceFrontier *DF_;
+	// Interval of each block in a DFS of the dominator tree. A block
+	// dominates another iff its interval contains the other's.
+	DenseMap<BasicBlock*, std::pair<unsigned, unsigned> > DFSIntervals_;
+	// Pairs (BB, F) such that F is in the dominance frontier of BB
+	DenseSet<std::pair<BasicBlock*, BasicBlock*> > FrontierPairs_;
+	void buildDominanceTables(Function &F);
+	bool dominates(BasicBlock *A, BasicBlock *B) const;
+	bool inFrontier(BasicBlock *BB, BasicBlock *F) const;
 	void createSigmasIfNeeded(BasicBlock *BB);
 	void insertSigmas(TerminatorInst *TI, Value *V);
-	void renameUsesToSigma(Value *V, PHINode *sigma);
+	void renameUsesToSigmas(Value *V, ArrayRef<PHINode*> sigmas);
+	PHINode *findDominatingSigma(ArrayRef<std::pair<unsigned, PHINode*> > sorted, BasicBlock *BB) const;
 	SmallVector<PHINode*, 25> insertPhisForSigma(Value *V, PHINode *sigma);
 	void insertPhisForPhi(Value *V, PHINode *phi);
 	void renameUsesToPhi(Value *V, PHINode *phi);
@@ -44,6 +55,8 @@ private:
 	bool dominateAny(BasicBlock *BB, Value *value);
 	bool dominateOrHasInFrontier(BasicBlock *BB, BasicBlock *BB_next, Value *value);
 	bool verifySigmaExistance(Value *V, BasicBlock *BB, BasicBlock *from);
+	bool hasUseBelow(BasicBlock *BB_next, Value *value);
+	bool isConstrainedBySameComparison(TerminatorInst *TI, Value *V);
 };
 
 }
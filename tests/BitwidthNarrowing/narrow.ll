@@ -0,0 +1,122 @@
+; RUN: %opt -load %lib/BitwidthNarrowing.so -bitwidth-narrowing -bwn-ignore-cost \
+; RUN:     -S %s | %FileCheck %s
+
+; The phi takes values in [3, 10] and the product in [12, 40], so both are
+; computed in i8, and the product is sign extended where it leaves the chain.
+; CHECK-LABEL: define i32 @narrow(
+; CHECK: %p.nrw = phi i8 [ 3, %a ], [ 10, %b ]
+; CHECK-NEXT: %q.nrw = mul i8 %p.nrw, 4
+; CHECK-NEXT: %q.ext = sext i8 %q.nrw to i32
+; CHECK-NEXT: ret i32 %q.ext
+define i32 @narrow(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %q = mul i32 %p, 4
+  ret i32 %q
+}
+
+; Nothing is known about %x, so the product keeps its width.
+; CHECK-LABEL: define i32 @wide(
+; CHECK-NOT: .nrw
+; CHECK: %q = mul i32 %x, 4
+; CHECK-NEXT: ret i32 %q
+define i32 @wide(i32 %x) {
+entry:
+  %q = mul i32 %x, 4
+  ret i32 %q
+}
+
+; The phi takes values in [3, 5], but one of them is the result of the invoke
+; that ends its incoming block, where no truncation could read it, so the phi
+; keeps its width.
+; CHECK-LABEL: define i32 @invoked(
+; CHECK-NOT: phi i8
+; CHECK: %p = phi i32 [ 3, %entry ], [ %v, %call ]
+; CHECK-NOT: phi i8
+; CHECK: ret i32 0
+define internal i32 @five() {
+entry:
+  ret i32 5
+}
+
+declare i32 @__gxx_personality_v0(...)
+
+define i32 @invoked(i1 %c) {
+entry:
+  br i1 %c, label %call, label %join
+
+call:
+  %v = invoke i32 @five() to label %join unwind label %lpad
+
+join:
+  %p = phi i32 [ 3, %entry ], [ %v, %call ]
+  %q = mul i32 %p, 4
+  ret i32 %q
+
+lpad:
+  %lp = landingpad { i8*, i32 } personality i32 (...)* @__gxx_personality_v0
+          cleanup
+  ret i32 0
+}
+
+; The variable only holds values in [3, 10], so it is an i8 variable, and its
+; load is extended where it leaves the chain.
+; CHECK-LABEL: define i32 @local(
+; CHECK: %v.nrw = alloca i8
+; CHECK: %p.nrw = phi i8 [ 3, %a ], [ 10, %b ]
+; CHECK-NEXT: store i8 %p.nrw, i8* %v.nrw
+; CHECK-NEXT: %l.nrw = load i8* %v.nrw
+; CHECK-NEXT: %l.ext = sext i8 %l.nrw to i32
+; CHECK-NEXT: ret i32 %l.ext
+define i32 @local(i1 %c) {
+entry:
+  %v = alloca i32
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  store i32 %p, i32* %v
+  %l = load i32* %v
+  ret i32 %l
+}
+
+; The shift is in [12, 40]. The first comparison reads the narrow value, but
+; 1000 does not fit in i8, so the second one reads the extension.
+; CHECK-LABEL: define i1 @compare(
+; CHECK: %q.nrw = shl i8 %p.nrw, 2
+; CHECK-NEXT: %q.ext = sext i8 %q.nrw to i32
+; CHECK-NEXT: %lt = icmp slt i8 %q.nrw, 20
+; CHECK-NEXT: %gt = icmp slt i32 %q.ext, 1000
+define i1 @compare(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %q = shl i32 %p, 2
+  %lt = icmp slt i32 %q, 20
+  %gt = icmp slt i32 %q, 1000
+  %r = and i1 %lt, %gt
+  ret i1 %r
+}
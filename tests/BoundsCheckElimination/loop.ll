@@ -0,0 +1,145 @@
+; RUN: %opt -load %lib/vSSA.so -load %lib/BoundsCheckElimination.so \
+; RUN:     -vssa -ra-bce -S %s | %FileCheck %s
+; RUN: %opt -load %lib/vSSA.so -load %lib/BoundsCheckElimination.so \
+; RUN:     -vssa -ra-bce -bce-report -disable-output %s 2>&1 \
+; RUN:     | %FileCheck %s --check-prefix=REPORT
+
+declare void @abort() noreturn
+declare void @use(i32)
+
+; The loop is guarded by %i < %n, so the sigma of %i in %check is bounded by
+; %n, and the check of %i against %n always passes.
+; CHECK-LABEL: define void @loop(
+; CHECK: check:
+; CHECK-NOT: icmp
+; CHECK: br label %body
+; CHECK-NOT: call void @abort()
+define void @loop(i32 %n) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %check, label %exit
+
+check:
+  %ok = icmp slt i32 %i, %n
+  br i1 %ok, label %body, label %trap
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+body:
+  call void @use(i32 %i)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; The check is against %m, which nothing relates to %i, so it stays.
+; CHECK-LABEL: define void @other(
+; CHECK: check:
+; CHECK: %ok = icmp slt i32 {{.*}}, %m
+; CHECK-NEXT: br i1 %ok, label %body, label %trap
+; CHECK: call void @abort()
+define void @other(i32 %n, i32 %m) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %check, label %exit
+
+check:
+  %ok = icmp slt i32 %i, %m
+  br i1 %ok, label %body, label %trap
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+body:
+  call void @use(i32 %i)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; In the loop %i is in [0, %n - 1]. Its lower bound proves the check of %c1,
+; and the guard of the loop proves the unsigned check of %c2 and the check
+; of %i - 1 in %c3. %i - 1 may be negative, so the check of %c4 stays, and
+; the equality of %c5 is not a bounds check this pass understands.
+; CHECK-LABEL: define void @forms(
+; CHECK: c1:
+; CHECK-NOT: icmp
+; CHECK: br label %c2
+; CHECK: c2:
+; CHECK-NOT: icmp
+; CHECK: br label %c3
+; CHECK: c3:
+; CHECK-NOT: icmp
+; CHECK: br label %c4
+; CHECK: c4:
+; CHECK: %ok4 = icmp sge i32 {{.*}}, 0
+; CHECK-NEXT: br i1 %ok4, label %c5, label %trap
+; CHECK: c5:
+; CHECK: %ok5 = icmp eq i32 {{.*}}, {{.*}}
+; CHECK-NEXT: br i1 %ok5, label %trap, label %body
+; CHECK: call void @abort()
+define void @forms(i32 %n) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %c1, label %exit
+
+c1:
+  %ok1 = icmp sge i32 %i, 0
+  br i1 %ok1, label %c2, label %trap
+
+c2:
+  %ok2 = icmp ult i32 %i, %n
+  br i1 %ok2, label %c3, label %trap
+
+c3:
+  %j = add nsw i32 %i, -1
+  %ok3 = icmp slt i32 %j, %n
+  br i1 %ok3, label %c4, label %trap
+
+c4:
+  %ok4 = icmp sge i32 %j, 0
+  br i1 %ok4, label %c5, label %trap
+
+c5:
+  %ok5 = icmp eq i32 %i, %n
+  br i1 %ok5, label %trap, label %body
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+body:
+  call void @use(i32 %j)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; REPORT: loop{{.}}check{{.}}removed, a symbolic interval bounds the index
+; REPORT-NEXT: other{{.}}check{{.}}kept, the index may reach the length
+; REPORT-NEXT: forms{{.}}c1{{.}}removed, the ranges do not overlap
+; REPORT-NEXT: forms{{.}}c2{{.}}removed, a symbolic interval bounds the index
+; REPORT-NEXT: forms{{.}}c3{{.}}removed, a symbolic interval bounds the index
+; REPORT-NEXT: forms{{.}}c4{{.}}kept, the index may be negative
+; REPORT-NEXT: forms{{.}}c5{{.}}kept, the comparison is not understood
@@ -0,0 +1,291 @@
+#! /usr/bin/env python
+"""
+Generates synthetic LLVM modules for the DistributedRA passes.
+
+The passes only do something on modules where the net dependence graph
+finds network reads and writes: the sides of a distributed program are
+linked into one module, and the graph labels the sends and recvs of each
+side. This script writes such a module without needing a real program.
+
+Each process owns a few global message buffers. Its send sites fill a
+slice of a buffer with values of a known range and send it; its recv sites
+receive into a buffer and read the values back. Sites may pick their buffer
+through a chain of selects, which merges buffers into larger alias sets,
+and some buffers are structs whose array field is the payload.
+
+The passes tell the two sides apart by the "P1" in the names of the graph
+nodes, so process k is named P<side>_<k>, with side 1 for even k and 2 for
+odd k. Every name in the module carries the name of its process. Channel c
+of a send is the channel of the recv of the next process that uses the same
+number, so a matcher that pairs sites by channel sees a ring.
+
+The module is written for LLVM 3.5/3.6 by default. --explicit-types uses
+the syntax of LLVM 3.7 and later for loads and getelementptrs.
+"""
+
+from __future__ import print_function
+
+import optparse
+import random
+import sys
+
+
+class Module(object):
+    def __init__(self, opts):
+        self.opts = opts
+        self.rng = random.Random(opts.seed)
+        self.lines = []
+
+    def emit(self, line=""):
+        self.lines.append(line)
+
+    def load(self, dst, ty, ptr):
+        if self.opts.explicit_types:
+            return "  %s = load %s, %s* %s" % (dst, ty, ty, ptr)
+        return "  %s = load %s* %s" % (dst, ty, ptr)
+
+    def gep(self, dst, ty, ptr, indices):
+        idx = ", ".join("i32 %s" % i for i in indices)
+        if self.opts.explicit_types:
+            return "  %s = getelementptr inbounds %s, %s* %s, %s" % (
+                dst, ty, ty, ptr, idx)
+        return "  %s = getelementptr inbounds %s* %s, %s" % (dst, ty, ptr, idx)
+
+
+def process_name(k):
+    return "P%d_%d" % (k % 2 + 1, k)
+
+
+def buffer_type(opts, b):
+    """Buffers whose index is a multiple of the struct period are structs."""
+    if opts.struct_period and b % opts.struct_period == 0:
+        return "%%%s" % "msg_t", True
+    return "[%d x i32]" % opts.buffer_size, False
+
+
+def emit_declarations(m):
+    opts = m.opts
+    m.emit("; Synthetic module for the DistributedRA passes")
+    m.emit("; %s" % " ".join(sys.argv[1:]))
+    m.emit()
+    if opts.struct_period:
+        m.emit("%%msg_t = type { i32, [%d x i32], i64 }" % opts.buffer_size)
+        m.emit()
+    if opts.api == "mpi":
+        m.emit("declare i32 @MPI_Send(i8*, i32, i32, i32, i32, i32)")
+        m.emit("declare i32 @MPI_Recv(i8*, i32, i32, i32, i32, i32, i8*)")
+    else:
+        m.emit("declare i64 @send(i32, i8*, i64, i32)")
+        m.emit("declare i64 @recv(i32, i8*, i64, i32)")
+    m.emit()
+
+
+def emit_buffers(m, k):
+    opts = m.opts
+    p = process_name(k)
+    for b in range(opts.buffers):
+        ty, _ = buffer_type(opts, b)
+        m.emit("@%s.buf%d = global %s zeroinitializer" % (p, b, ty))
+    m.emit()
+
+
+def emit_pick_buffer(m, p, site):
+    """Picks the buffer of a site through a chain of selects. Returns the
+    pointer to the first payload element and the IR type of that buffer."""
+    opts = m.opts
+    width = max(1, min(opts.alias_width, opts.buffers))
+    first = m.rng.randrange(opts.buffers)
+    # All the buffers of a select chain must have the same type
+    candidates = [b for b in range(opts.buffers)
+                  if buffer_type(opts, b) == buffer_type(opts, first)]
+    m.rng.shuffle(candidates)
+    chosen = [first] + [b for b in candidates if b != first][:width - 1]
+    ty, is_struct = buffer_type(opts, first)
+
+    cur = "@%s.buf%d" % (p, chosen[0])
+    for i, b in enumerate(chosen[1:]):
+        m.emit("  %%%s.%s.sel%d = select i1 %%%s.%s.flag%d, %s* %s, %s* @%s.buf%d"
+               % (p, site, i, p, site, i % 2, ty, cur, ty, p, b))
+        cur = "%%%s.%s.sel%d" % (p, site, i)
+
+    if is_struct:
+        indices = ["0", "1", "0"]
+    else:
+        indices = ["0", "0"]
+    m.lines.append(m.gep("%%%s.%s.base" % (p, site), ty, cur, indices))
+    return "%%%s.%s.base" % (p, site)
+
+
+def emit_send_site(m, k, s):
+    opts = m.opts
+    p = process_name(k)
+    site = "send%d" % s
+    channel = s % opts.channels
+    lo = m.rng.randrange(opts.buffer_size)
+    length = m.rng.randint(1, opts.buffer_size - lo)
+    vbase = m.rng.randint(-1000, 1000)
+
+    m.emit("define void @%s.%s(i32 %%%s.%s.fd, i1 %%%s.%s.flag0, i1 %%%s.%s.flag1) {"
+           % (p, site, p, site, p, site, p, site))
+    m.emit("%s.%s.entry:" % (p, site))
+    base = emit_pick_buffer(m, p, site)
+    m.emit("  br label %%%s.%s.loop" % (p, site))
+    m.emit("%s.%s.loop:" % (p, site))
+    m.emit("  %%%s.%s.i = phi i32 [ 0, %%%s.%s.entry ], [ %%%s.%s.inext, %%%s.%s.loop ]"
+           % (p, site, p, site, p, site, p, site))
+    m.emit("  %%%s.%s.idx = add i32 %%%s.%s.i, %d" % (p, site, p, site, lo))
+    m.lines.append(m.gep("%%%s.%s.slot" % (p, site), "i32", base,
+                         ["%%%s.%s.idx" % (p, site)]))
+    m.emit("  %%%s.%s.v = add i32 %%%s.%s.i, %d" % (p, site, p, site, vbase))
+    m.emit("  store i32 %%%s.%s.v, i32* %%%s.%s.slot" % (p, site, p, site))
+    m.emit("  %%%s.%s.inext = add i32 %%%s.%s.i, 1" % (p, site, p, site))
+    m.emit("  %%%s.%s.c = icmp slt i32 %%%s.%s.inext, %d" % (p, site, p, site, length))
+    m.emit("  br i1 %%%s.%s.c, label %%%s.%s.loop, label %%%s.%s.done"
+           % (p, site, p, site, p, site))
+    m.emit("%s.%s.done:" % (p, site))
+    m.lines.append(m.gep("%%%s.%s.msg" % (p, site), "i32", base, [str(lo)]))
+    m.emit("  %%%s.%s.raw = bitcast i32* %%%s.%s.msg to i8*" % (p, site, p, site))
+    if opts.api == "mpi":
+        m.emit("  %%%s.%s.r = call i32 @MPI_Send(i8* %%%s.%s.raw, i32 %d, i32 0, "
+               "i32 %d, i32 %d, i32 0)" % (p, site, p, site, length,
+                                           (k + 1) % opts.processes, channel))
+    else:
+        m.emit("  %%%s.%s.r = call i64 @send(i32 %%%s.%s.fd, i8* %%%s.%s.raw, "
+               "i64 %d, i32 %d)" % (p, site, p, site, p, site, 4 * length, channel))
+    m.emit("  ret void")
+    m.emit("}")
+    m.emit()
+
+
+def emit_recv_site(m, k, r):
+    opts = m.opts
+    p = process_name(k)
+    site = "recv%d" % r
+    channel = r % opts.channels
+    lo = m.rng.randrange(opts.buffer_size)
+    length = m.rng.randint(1, opts.buffer_size - lo)
+
+    m.emit("define i32 @%s.%s(i32 %%%s.%s.fd, i1 %%%s.%s.flag0, i1 %%%s.%s.flag1) {"
+           % (p, site, p, site, p, site, p, site))
+    m.emit("%s.%s.entry:" % (p, site))
+    base = emit_pick_buffer(m, p, site)
+    m.lines.append(m.gep("%%%s.%s.msg" % (p, site), "i32", base, [str(lo)]))
+    m.emit("  %%%s.%s.raw = bitcast i32* %%%s.%s.msg to i8*" % (p, site, p, site))
+    if opts.api == "mpi":
+        m.emit("  %%%s.%s.r = call i32 @MPI_Recv(i8* %%%s.%s.raw, i32 %d, i32 0, "
+               "i32 %d, i32 %d, i32 0, i8* null)"
+               % (p, site, p, site, length, (k + opts.processes - 1) % opts.processes,
+                  channel))
+    else:
+        m.emit("  %%%s.%s.r = call i64 @recv(i32 %%%s.%s.fd, i8* %%%s.%s.raw, "
+               "i64 %d, i32 %d)" % (p, site, p, site, p, site, 4 * length, channel))
+    m.emit("  br label %%%s.%s.loop" % (p, site))
+    m.emit("%s.%s.loop:" % (p, site))
+    m.emit("  %%%s.%s.i = phi i32 [ 0, %%%s.%s.entry ], [ %%%s.%s.inext, %%%s.%s.loop ]"
+           % (p, site, p, site, p, site, p, site))
+    m.emit("  %%%s.%s.acc = phi i32 [ 0, %%%s.%s.entry ], [ %%%s.%s.sum, %%%s.%s.loop ]"
+           % (p, site, p, site, p, site, p, site))
+    m.emit("  %%%s.%s.idx = add i32 %%%s.%s.i, %d" % (p, site, p, site, lo))
+    m.lines.append(m.gep("%%%s.%s.slot" % (p, site), "i32", base,
+                         ["%%%s.%s.idx" % (p, site)]))
+    m.lines.append(m.load("%%%s.%s.v" % (p, site), "i32", "%%%s.%s.slot" % (p, site)))
+    m.emit("  %%%s.%s.sum = add i32 %%%s.%s.acc, %%%s.%s.v" % (p, site, p, site, p, site))
+    m.emit("  %%%s.%s.inext = add i32 %%%s.%s.i, 1" % (p, site, p, site))
+    m.emit("  %%%s.%s.c = icmp slt i32 %%%s.%s.inext, %d" % (p, site, p, site, length))
+    m.emit("  br i1 %%%s.%s.c, label %%%s.%s.loop, label %%%s.%s.done"
+           % (p, site, p, site, p, site))
+    m.emit("%s.%s.done:" % (p, site))
+    m.emit("  ret i32 %%%s.%s.sum" % (p, site))
+    m.emit("}")
+    m.emit()
+
+
+def emit_process_main(m, k):
+    """Calls every site of process k, so they are all reachable."""
+    opts = m.opts
+    p = process_name(k)
+    m.emit("define i32 @%s.main(i32 %%%s.fd, i1 %%%s.a, i1 %%%s.b) {"
+           % (p, p, p, p))
+    m.emit("%s.entry:" % p)
+    for s in range(opts.sends):
+        m.emit("  call void @%s.send%d(i32 %%%s.fd, i1 %%%s.a, i1 %%%s.b)"
+               % (p, s, p, p, p))
+    last = "0"
+    for r in range(opts.recvs):
+        m.emit("  %%%s.got%d = call i32 @%s.recv%d(i32 %%%s.fd, i1 %%%s.a, i1 %%%s.b)"
+               % (p, r, p, r, p, p, p))
+        m.emit("  %%%s.total%d = add i32 %s, %%%s.got%d" % (p, r, last, p, r))
+        last = "%%%s.total%d" % (p, r)
+    m.emit("  ret i32 %s" % last)
+    m.emit("}")
+    m.emit()
+
+
+def generate(opts):
+    m = Module(opts)
+    emit_declarations(m)
+    for k in range(opts.processes):
+        emit_buffers(m, k)
+    for k in range(opts.processes):
+        for s in range(opts.sends):
+            emit_send_site(m, k, s)
+        for r in range(opts.recvs):
+            emit_recv_site(m, k, r)
+        emit_process_main(m, k)
+    return "\n".join(m.lines)
+
+
+def parse_args(argv):
+    parser = optparse.OptionParser(usage="%prog [options]")
+    parser.add_option("-o", "--output", default="-",
+                      help="file to write the module to (default: stdout)")
+    parser.add_option("--processes", type="int", default=2,
+                      help="number of communicating processes (default: 2)")
+    parser.add_option("--buffers", type="int", default=4,
+                      help="message buffers of each process (default: 4)")
+    parser.add_option("--buffer-size", type="int", default=64,
+                      help="i32 elements of each buffer (default: 64)")
+    parser.add_option("--sends", type="int", default=4,
+                      help="send sites of each process (default: 4)")
+    parser.add_option("--recvs", type="int", default=4,
+                      help="recv sites of each process (default: 4)")
+    parser.add_option("--channels", type="int", default=2,
+                      help="channels the sites are spread over (default: 2)")
+    parser.add_option("--alias-width", type="int", default=2,
+                      help="buffers a site may point to; larger values "
+                      "build larger alias sets (default: 2)")
+    parser.add_option("--struct-period", type="int", default=3,
+                      help="every n-th buffer is a struct, 0 for none "
+                      "(default: 3)")
+    parser.add_option("--api", choices=["socket", "mpi"], default="socket",
+                      help="send/recv (socket) or MPI_Send/MPI_Recv (mpi)")
+    parser.add_option("--seed", type="int", default=0,
+                      help="random seed (default: 0)")
+    parser.add_option("--explicit-types", action="store_true", default=False,
+                      help="use the load/getelementptr syntax of LLVM >= 3.7")
+    opts, args = parser.parse_args(argv)
+
+    if args:
+        parser.error("unexpected arguments: %s" % " ".join(args))
+    for name in ["processes", "buffers", "buffer_size", "channels"]:
+        if getattr(opts, name) < 1:
+            parser.error("--%s must be at least 1" % name.replace("_", "-"))
+    for name in ["sends", "recvs", "alias_width", "struct_period"]:
+        if getattr(opts, name) < 0:
+            parser.error("--%s must not be negative" % name.replace("_", "-"))
+    return opts
+
+
+def main(argv):
+    opts = parse_args(argv)
+    text = generate(opts)
+    if opts.output == "-":
+        sys.stdout.write(text + "\n")
+    else:
+        with open(opts.output, "w") as f:
+            f.write(text + "\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
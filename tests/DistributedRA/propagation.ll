@@ -0,0 +1,60 @@
+; RUN: %opt -load %lib/DepGraph.so -load %lib/NetDepGraph.so \
+; RUN:     -load %lib/DistributedRA.so -as-set-propagation -disable-output %s \
+; RUN:     2>&1 | %FileCheck %s
+
+; The counts below are the decisions of the former dfsVisit loops on this
+; module, worked out by hand:
+; - @P2_1.buf0 reaches the send of P2 and gives it a table. @P2_1.buf1 is
+;   written but never sent, so it adds nothing to that table;
+; - the send of P2 reaches the recv of P1, which receives its table;
+; - the recv of P1 writes @P1_0.buf0, its only successor memory node, which
+;   gets the propagated table.
+
+; CHECK: === P1 ===
+; CHECK-NEXT: Sends: 0
+; CHECK-NEXT: Tables: 0
+; CHECK-NEXT: Recvs: 1
+; CHECK-NEXT: Tables received: 1
+; CHECK-NEXT: PropagatedTables: 1
+; CHECK-NEXT: === P2 ===
+; CHECK-NEXT: Sends: 1
+; CHECK-NEXT: Tables: 1
+; CHECK-NEXT: Recvs: 0
+; CHECK-NEXT: Tables received: 0
+; CHECK-NEXT: PropagatedTables: 0
+; CHECK-NEXT: AllPropagatedTables: 1
+
+declare i64 @send(i32, i8*, i64, i32)
+declare i64 @recv(i32, i8*, i64, i32)
+
+@P1_0.buf0 = global [8 x i32] zeroinitializer
+
+@P2_1.buf0 = global [8 x i32] zeroinitializer
+@P2_1.buf1 = global [8 x i32] zeroinitializer
+
+define i32 @P1_0.recv0(i32 %P1_0.recv0.fd) {
+P1_0.recv0.entry:
+  %P1_0.recv0.base = getelementptr inbounds [8 x i32]* @P1_0.buf0, i32 0, i32 0
+  %P1_0.recv0.raw = bitcast i32* %P1_0.recv0.base to i8*
+  %P1_0.recv0.r = call i64 @recv(i32 %P1_0.recv0.fd, i8* %P1_0.recv0.raw, i64 8, i32 0)
+  %P1_0.recv0.slot = getelementptr inbounds i32* %P1_0.recv0.base, i32 1
+  %P1_0.recv0.v = load i32* %P1_0.recv0.slot
+  ret i32 %P1_0.recv0.v
+}
+
+define void @P2_1.send0(i32 %P2_1.send0.fd, i32 %P2_1.send0.x) {
+P2_1.send0.entry:
+  %P2_1.send0.base = getelementptr inbounds [8 x i32]* @P2_1.buf0, i32 0, i32 0
+  %P2_1.send0.slot = getelementptr inbounds i32* %P2_1.send0.base, i32 1
+  store i32 %P2_1.send0.x, i32* %P2_1.send0.slot
+  %P2_1.send0.raw = bitcast i32* %P2_1.send0.base to i8*
+  %P2_1.send0.r = call i64 @send(i32 %P2_1.send0.fd, i8* %P2_1.send0.raw, i64 8, i32 0)
+  ret void
+}
+
+define void @P2_1.fill(i32 %P2_1.fill.x) {
+P2_1.fill.entry:
+  %P2_1.fill.slot = getelementptr inbounds [8 x i32]* @P2_1.buf1, i32 0, i32 2
+  store i32 %P2_1.fill.x, i32* %P2_1.fill.slot
+  ret void
+}
@@ -0,0 +1,241 @@
+#! /usr/bin/env python
+"""
+Times the DistributedRA pipeline on modules from gen_netmodule.py.
+
+For every configuration of the sweep, this script generates a module,
+optionally converts it to e-SSA, and runs opt with -dump-dist-ranges, which
+pulls in the whole pipeline: pointer analysis, alias sets, range analysis,
+segmentation tables, alias set segmentation and propagation over the net
+dependence graph. It prints one line per configuration with the time of
+each phase, as reported by -time-passes, the wall time and peak memory of
+the whole opt run, and the main counters of the passes.
+
+Example, scaling the number of processes and send/recv sites:
+
+    ./run_pipeline.py --lib-dir ~/llvm/Release/lib \\
+        --sweep processes=2,4,8 --sweep sends=4,16 --csv scaling.csv
+
+Options after "--" are passed to the generator for every configuration.
+"""
+
+from __future__ import print_function
+
+import itertools
+import optparse
+import os
+import re
+import subprocess
+import sys
+import tempfile
+import time
+
+import gen_netmodule
+
+# Libraries loaded into opt, in dependence order
+LIBRARIES = ["RangeAnalysis.so", "DepGraph.so", "NetDepGraph.so",
+             "DistributedRA.so"]
+
+# Columns of the report, and the pass descriptions each one adds up
+PHASES = [
+    ("PA", ["Pointer Analysis Driver Pass"]),
+    ("AliasSets", ["Get alias sets from pointer analysis pass"]),
+    ("RA", ["Range Analysis (Cousot - inter)"]),
+    ("SegTables", ["Get tables memory ranges and pointers that can point "
+                   "for such ranges"]),
+    ("ASSeg", ["Segmentation of Alias Sets"]),
+    ("ASProp", ["Propagation of segmentation of Alias Sets"]),
+    ("Dump", ["Dump of distributed value ranges"]),
+]
+
+# Counters printed by -stats, and the column they go to
+COUNTERS = [
+    ("Insts", "Number of instructions (of all types)"),
+    ("Sends", "The number of sends"),
+    ("Recvs", "The number of recvs"),
+    ("PropSegs", "The number of propagated segments"),
+]
+
+TIME_LINE = re.compile(r"^\s*((?:\d+\.\d+\s+\(\s*[\d.]+%\)\s+)+)(\S.*?)\s*$")
+STAT_LINE = re.compile(r"^\s*(\d+)\s+\S+\s+-\s+(.*?)\s*$")
+
+
+def parse_times(text):
+    """Wall time of each pass, the last column of -time-passes."""
+    times = {}
+    for line in text.splitlines():
+        m = TIME_LINE.match(line)
+        if m:
+            wall = float(re.findall(r"(\d+\.\d+)\s+\(", m.group(1))[-1])
+            times[m.group(2)] = times.get(m.group(2), 0.0) + wall
+    return times
+
+
+def parse_stats(text):
+    stats = {}
+    for line in text.splitlines():
+        m = STAT_LINE.match(line)
+        if m:
+            stats[m.group(2)] = stats.get(m.group(2), 0) + int(m.group(1))
+    return stats
+
+
+def run(cmd, log):
+    """Runs cmd, appending its stderr to log. Returns the wall time in
+    seconds and the peak resident memory of the process in KB."""
+    with tempfile.TemporaryFile() as err, open(os.devnull, "w") as out:
+        start = time.time()
+        proc = subprocess.Popen(cmd, stdout=out, stderr=err)
+        # wait4 gives the usage of this child alone
+        _, status, usage = os.wait4(proc.pid, 0)
+        elapsed = time.time() - start
+        # Already reaped, keep Popen from waiting for it again
+        proc.returncode = status
+        err.seek(0)
+        text = err.read().decode("utf-8", "replace")
+
+    log.append(text)
+    if status != 0:
+        sys.stderr.write(text)
+        raise RuntimeError("command failed: %s" % " ".join(cmd))
+
+    peak = usage.ru_maxrss
+    if sys.platform == "darwin":
+        peak //= 1024
+    return elapsed, peak
+
+
+def opt_command(opts, extra):
+    cmd = [opts.opt]
+    for lib in LIBRARIES:
+        cmd += ["-load", os.path.join(opts.lib_dir, lib)]
+    return cmd + extra
+
+
+def run_config(opts, config, gen_args, work_dir):
+    tag = "_".join("%s%s" % (k, v) for k, v in config) or "default"
+    module = os.path.join(work_dir, tag + ".ll")
+    gen_argv = list(gen_args)
+    for key, value in config:
+        gen_argv += ["--" + key.replace("_", "-"), str(value)]
+    gen_argv += ["-o", module]
+    gen_netmodule.main(gen_argv)
+
+    log = []
+    row = {"config": tag}
+
+    if opts.essa:
+        essa = os.path.join(work_dir, tag + ".essa.bc")
+        row["vSSA"], _ = run([opts.opt, "-load",
+                              os.path.join(opts.lib_dir, "vSSA.so"),
+                              "-break-crit-edges", "-vssa", module, "-o", essa],
+                             [])
+        module = essa
+
+    dump = os.path.join(work_dir, tag + ".drd")
+    row["Wall"], row["MaxRSS(KB)"] = run(
+        opt_command(opts, ["-dump-dist-ranges", "-dump-filename", dump,
+                           "-instcount", "-stats", "-time-passes",
+                           "-disable-output", module]), log)
+
+    text = "".join(log)
+    times = parse_times(text)
+    known = set()
+    for column, passes in PHASES:
+        row[column] = sum(times.get(p, 0.0) for p in passes)
+        known.update(passes)
+    # Everything else opt timed, net dependence graph included
+    row["Other"] = sum(t for p, t in times.items()
+                       if p not in known and not p.startswith("Total"))
+
+    stats = parse_stats(text)
+    for column, desc in COUNTERS:
+        row[column] = stats.get(desc, 0)
+
+    if opts.keep:
+        with open(os.path.join(work_dir, tag + ".log"), "w") as f:
+            f.write(text)
+    else:
+        for path in [module, dump, os.path.join(work_dir, tag + ".ll")]:
+            if os.path.exists(path):
+                os.remove(path)
+    return row
+
+
+def format_cell(value):
+    if isinstance(value, float):
+        return "%.4f" % value
+    return str(value)
+
+
+def parse_sweeps(parser, sweeps):
+    axes = []
+    for sweep in sweeps:
+        if "=" not in sweep:
+            parser.error("--sweep expects name=v1,v2,...: %s" % sweep)
+        name, values = sweep.split("=", 1)
+        axes.append([(name.replace("-", "_"), v) for v in values.split(",")])
+    return [list(c) for c in itertools.product(*axes)] or [[]]
+
+
+def main(argv):
+    if "--" in argv:
+        gen_args = argv[argv.index("--") + 1:]
+        argv = argv[:argv.index("--")]
+    else:
+        gen_args = []
+
+    parser = optparse.OptionParser(usage="%prog [options] [-- generator options]")
+    parser.add_option("--opt", default="opt", help="opt binary to run")
+    parser.add_option("--lib-dir", default=".",
+                      help="directory with the pass libraries: %s"
+                      % ", ".join(LIBRARIES))
+    parser.add_option("--sweep", action="append", default=[],
+                      help="generator option and the values to try, as "
+                      "name=v1,v2,...; may be repeated")
+    parser.add_option("--essa", action="store_true", default=False,
+                      help="convert the modules to e-SSA before the analysis")
+    parser.add_option("--work-dir", default=None,
+                      help="where modules and dumps are written "
+                      "(default: a temporary directory)")
+    parser.add_option("--keep", action="store_true", default=False,
+                      help="keep modules, dumps and opt logs")
+    parser.add_option("--csv", default=None, help="also write the report here")
+    opts, args = parser.parse_args(argv)
+    if args:
+        parser.error("unexpected arguments: %s" % " ".join(args))
+
+    configs = parse_sweeps(parser, opts.sweep)
+    work_dir = opts.work_dir or tempfile.mkdtemp(prefix="distra-")
+    if not os.path.isdir(work_dir):
+        os.makedirs(work_dir)
+
+    columns = ["config"] + (["vSSA"] if opts.essa else []) \
+        + [c for c, _ in PHASES] + ["Other", "Wall", "MaxRSS(KB)"] \
+        + [c for c, _ in COUNTERS]
+
+    rows = []
+    for config in configs:
+        row = run_config(opts, config, gen_args, work_dir)
+        rows.append(row)
+        if len(rows) == 1:
+            print("\t".join(columns))
+        print("\t".join(format_cell(row.get(c, "")) for c in columns))
+        sys.stdout.flush()
+
+    if opts.csv:
+        with open(opts.csv, "w") as f:
+            f.write(",".join(columns) + "\n")
+            for row in rows:
+                f.write(",".join(format_cell(row.get(c, "")) for c in columns)
+                        + "\n")
+
+    if not opts.keep and not opts.work_dir:
+        try:
+            os.rmdir(work_dir)
+        except OSError:
+            pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
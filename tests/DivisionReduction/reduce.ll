@@ -0,0 +1,140 @@
+; RUN: %opt -load %lib/DivisionReduction.so -range-div-reduction -S %s \
+; RUN:     | %FileCheck %s
+
+; %n is in [3, 100] and %d is always 8, so the signed division is a shift.
+; CHECK-LABEL: define i32 @shift(
+; CHECK: %q = lshr i32 %n, 3
+; CHECK-NEXT: ret i32 %q
+define i32 @shift(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %n = phi i32 [ 3, %a ], [ 100, %b ]
+  %d = phi i32 [ 8, %a ], [ 8, %b ]
+  %q = sdiv i32 %n, %d
+  ret i32 %q
+}
+
+; Nothing is known about the operands, so the division stays.
+; CHECK-LABEL: define i32 @keep(
+; CHECK: %q = sdiv i32 %x, %y
+define i32 @keep(i32 %x, i32 %y) {
+entry:
+  %q = sdiv i32 %x, %y
+  ret i32 %q
+}
+
+; The remainder of %n by 8 is a mask, and %n is below %big, so the division
+; by it is 0 and the remainder is %n.
+; CHECK-LABEL: define i32 @mask(
+; CHECK: %r = and i32 %n, 7
+; CHECK-NEXT: %s = add i32 0, %n
+define i32 @mask(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %n = phi i32 [ 3, %a ], [ 100, %b ]
+  %big = phi i32 [ 200, %a ], [ 300, %b ]
+  %r = srem i32 %n, 8
+  %q = udiv i32 %n, %big
+  %m = urem i32 %n, %big
+  %s = add i32 %q, %m
+  %t = add i32 %r, %s
+  ret i32 %t
+}
+
+; %n is in [3, 100] and %d in [60, 70], so the quotient is 0 or 1.
+; CHECK-LABEL: define i32 @compare(
+; CHECK: [[GE:%[0-9]+]] = icmp uge i32 %n, %d
+; CHECK-NEXT: %q = zext i1 [[GE]] to i32
+; CHECK-NEXT: [[GE2:%[0-9]+]] = icmp uge i32 %n, %d
+; CHECK-NEXT: [[SUB:%[0-9]+]] = sub i32 %n, %d
+; CHECK-NEXT: %r = select i1 [[GE2]], i32 [[SUB]], i32 %n
+define i32 @compare(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %n = phi i32 [ 3, %a ], [ 100, %b ]
+  %d = phi i32 [ 60, %a ], [ 70, %b ]
+  %q = udiv i32 %n, %d
+  %r = srem i32 %n, %d
+  %s = add i32 %q, %r
+  ret i32 %s
+}
+
+; Both operands are not negative, so the signed division is unsigned.
+; Negative dividends keep it signed in 32 bits.
+; CHECK-LABEL: define i32 @unsigned(
+; CHECK: %q = udiv i32 %n, %d
+; CHECK-NEXT: %r = sdiv i32 %m, %d
+define i32 @unsigned(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %n = phi i32 [ 3, %a ], [ 100, %b ]
+  %m = phi i32 [ -3, %a ], [ 100, %b ]
+  %d = phi i32 [ 3, %a ], [ 5, %b ]
+  %q = sdiv i32 %n, %d
+  %r = sdiv i32 %m, %d
+  %s = add i32 %q, %r
+  ret i32 %s
+}
+
+; The 64 bit operands fit in 32 bits, so the divisions are done in 32 bits,
+; unsigned if the dividend is not negative, and signed if it may be.
+; CHECK-LABEL: define i64 @narrow(
+; CHECK: %n.nrw = trunc i64 %n to i32
+; CHECK-NEXT: %d.nrw = trunc i64 %d to i32
+; CHECK-NEXT: %q.nrw = udiv i32 %n.nrw, %d.nrw
+; CHECK-NEXT: %q = zext i32 %q.nrw to i64
+; CHECK-NEXT: %m.nrw = trunc i64 %m to i32
+; CHECK-NEXT: %d.nrw1 = trunc i64 %d to i32
+; CHECK-NEXT: %r.nrw = sdiv i32 %m.nrw, %d.nrw1
+; CHECK-NEXT: %r = sext i32 %r.nrw to i64
+define i64 @narrow(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %n = phi i64 [ 3, %a ], [ 100000, %b ]
+  %m = phi i64 [ -100, %a ], [ 100, %b ]
+  %d = phi i64 [ 3, %a ], [ 7, %b ]
+  %q = sdiv i64 %n, %d
+  %r = sdiv i64 %m, %d
+  %s = add i64 %q, %r
+  ret i64 %s
+}
@@ -0,0 +1,56 @@
+; RUN: %opt -load %lib/ExtensionElimination.so -ra-essa-overlay \
+; RUN:     -range-ext-elimination -S %s | %FileCheck %s
+
+; %i is in [0, 100] and only compared, extended and used as an index, so it
+; is computed in i64 and is no longer extended in the loop.
+; CHECK-LABEL: define void @widen(
+; CHECK: %i.wide = phi i64 [ 0, %entry ], [ %inc.wide, %body ]
+; CHECK-NEXT: %cmp = icmp slt i64 %i.wide, 100
+; CHECK: %p = getelementptr inbounds i64* %a, i64 %i.wide
+; CHECK-NEXT: store i64 %i.wide, i64* %p
+; CHECK-NEXT: %inc.wide = add nsw i64 %i.wide, 1
+; CHECK-NOT: sext
+define void @widen(i64* %a) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, 100
+  br i1 %cmp, label %body, label %exit
+
+body:
+  %idx = sext i32 %i to i64
+  %p = getelementptr inbounds i64* %a, i64 %idx
+  store i64 %idx, i64* %p
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; %i starts at -5, so its zero extension does not agree with the wide
+; variable, and the loop stays as it is.
+; CHECK-LABEL: define void @negative(
+; CHECK: %i = phi i32 [ -5, %entry ], [ %inc, %body ]
+; CHECK: %idx = zext i32 %i to i64
+define void @negative(i64* %a) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ -5, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, 100
+  br i1 %cmp, label %body, label %exit
+
+body:
+  %idx = zext i32 %i to i64
+  %p = getelementptr inbounds i64* %a, i64 %idx
+  store i64 %idx, i64* %p
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
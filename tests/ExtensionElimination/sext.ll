@@ -0,0 +1,58 @@
+; RUN: %opt -load %lib/ExtensionElimination.so -range-ext-elimination -S %s \
+; RUN:     | %FileCheck %s
+
+; %p is in [3, 10], never negative, so its sign extension is a zero extension.
+; CHECK-LABEL: define i64 @positive(
+; CHECK: %e = zext i32 %p to i64
+; CHECK-NEXT: ret i64 %e
+define i64 @positive(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %e = sext i32 %p to i64
+  ret i64 %e
+}
+
+; %x may be negative, so the sign extension stays.
+; CHECK-LABEL: define i64 @keep(
+; CHECK: %e = sext i32 %x to i64
+define i64 @keep(i32 %x) {
+entry:
+  %e = sext i32 %x to i64
+  ret i64 %e
+}
+
+; %w is in [3, 10], so truncating it loses nothing, and extending the
+; truncation gives back %w, or a truncation of it to the wider type.
+; CHECK-LABEL: define i64 @truncated(
+; CHECK: %e = trunc i64 %w to i32
+; CHECK-NEXT: %z = zext i32 %e to i64
+; CHECK-NEXT: %s = add i64 %w, %z
+define i64 @truncated(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %w = phi i64 [ 3, %a ], [ 10, %b ]
+  %t = trunc i64 %w to i32
+  %x = sext i32 %t to i64
+  %n = trunc i64 %w to i8
+  %e = zext i8 %n to i32
+  %z = zext i32 %e to i64
+  %s = add i64 %x, %z
+  ret i64 %s
+}
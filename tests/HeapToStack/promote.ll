@@ -0,0 +1,146 @@
+; RUN: %opt -load %lib/DepGraph.so -load %lib/HeapToStack.so \
+; RUN:     -range-heap-to-stack -S %s | %FileCheck %s
+; RUN: %opt -load %lib/DepGraph.so -load %lib/HeapToStack.so \
+; RUN:     -range-heap-to-stack -h2s-max-frame=40 -S %s \
+; RUN:     | %FileCheck %s --check-prefix=FRAME
+
+@g = global i8* null
+
+declare noalias i8* @malloc(i64)
+declare void @free(i8*)
+
+; The size is in [16, 32], so the buffer takes 32 bytes of the frame, and
+; the free goes away with the malloc.
+; CHECK-LABEL: define void @small(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %buf.stack = alloca [32 x i8], align 16
+; CHECK-NEXT: %buf = bitcast [32 x i8]* %buf.stack to i8*
+; CHECK-NOT: @malloc
+; CHECK-NOT: @free
+; CHECK: ret void
+define void @small(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %size = phi i64 [ 16, %a ], [ 32, %b ]
+  %buf = call i8* @malloc(i64 %size)
+  store i8 0, i8* %buf
+  call void @free(i8* %buf)
+  ret void
+}
+
+; Nothing bounds %n, so the malloc stays on the heap.
+; CHECK-LABEL: define void @unbounded(
+; CHECK: %buf = call i8* @malloc(i64 %n)
+; CHECK: call void @free(i8* %buf)
+define void @unbounded(i64 %n) {
+entry:
+  %buf = call i8* @malloc(i64 %n)
+  store i8 0, i8* %buf
+  call void @free(i8* %buf)
+  ret void
+}
+
+; The malloc in the loop gets a single buffer in the entry block, which
+; every iteration uses.
+; CHECK-LABEL: define void @loop(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %buf.stack = alloca [8 x i8], align 16
+; CHECK-NEXT: %buf = bitcast [8 x i8]* %buf.stack to i8*
+; CHECK-NOT: @malloc
+; CHECK-NOT: @free
+; CHECK: ret void
+define void @loop(i32 %n) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %body, label %exit
+
+body:
+  %buf = call i8* @malloc(i64 8)
+  store i8 0, i8* %buf
+  call void @free(i8* %buf)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; @peek only reads through the pointer, so it does not escape.
+; CHECK-LABEL: define void @callee(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %buf.stack = alloca [8 x i8], align 16
+; CHECK-NOT: @malloc
+define internal i8 @peek(i8* %p) {
+entry:
+  %v = load i8* %p
+  ret i8 %v
+}
+
+define void @callee() {
+entry:
+  %buf = call i8* @malloc(i64 8)
+  store i8 0, i8* %buf
+  %v = call i8 @peek(i8* %buf)
+  call void @free(i8* %buf)
+  ret void
+}
+
+; The pointer is stored to a global, or returned, so it outlives the frame.
+; CHECK-LABEL: define void @stored(
+; CHECK: %buf = call i8* @malloc(i64 8)
+; CHECK-LABEL: define i8* @returned(
+; CHECK: %buf = call i8* @malloc(i64 8)
+define void @stored() {
+entry:
+  %buf = call i8* @malloc(i64 8)
+  store i8* %buf, i8** @g
+  ret void
+}
+
+define i8* @returned() {
+entry:
+  %buf = call i8* @malloc(i64 8)
+  ret i8* %buf
+}
+
+; 1000 bytes are more than -h2s-max-size.
+; CHECK-LABEL: define void @big(
+; CHECK: %buf = call i8* @malloc(i64 1000)
+define void @big() {
+entry:
+  %buf = call i8* @malloc(i64 1000)
+  store i8 0, i8* %buf
+  call void @free(i8* %buf)
+  ret void
+}
+
+; Both buffers fit in the frame, unless it only has 40 bytes for them.
+; CHECK-LABEL: define void @two(
+; CHECK-DAG: %a.stack = alloca [32 x i8], align 16
+; CHECK-DAG: %b.stack = alloca [32 x i8], align 16
+; CHECK-NOT: @malloc
+; FRAME-LABEL: define void @two(
+; FRAME: %a.stack = alloca [32 x i8], align 16
+; FRAME: %b = call i8* @malloc(i64 32)
+define void @two() {
+entry:
+  %a = call i8* @malloc(i64 32)
+  %b = call i8* @malloc(i64 32)
+  store i8 0, i8* %a
+  store i8 0, i8* %b
+  call void @free(i8* %a)
+  call void @free(i8* %b)
+  ret void
+}
@@ -0,0 +1,129 @@
+; RUN: %opt -load %lib/MemSpecialization.so -range-mem-specialization -S %s \
+; RUN:     | %FileCheck %s
+
+declare i8* @memcpy(i8*, i8*, i64)
+declare void @llvm.memmove.p0i8.p0i8.i64(i8*, i8*, i64, i32, i1)
+declare void @llvm.memset.p0i8.i64(i8*, i8, i64, i32, i1)
+
+; The length is 24 on both paths, so the call gets a constant length.
+; CHECK-LABEL: define void @constant(
+; CHECK: call i8* @memcpy(i8* %d, i8* %s, i64 24)
+define void @constant(i1 %c, i8* %d, i8* %s) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %len = phi i64 [ 24, %a ], [ 24, %b ]
+  %r = call i8* @memcpy(i8* %d, i8* %s, i64 %len)
+  ret void
+}
+
+; Nothing bounds %n, so the call stays as it is.
+; CHECK-LABEL: define void @unbounded(
+; CHECK: call i8* @memcpy(i8* %d, i8* %s, i64 %n)
+; CHECK-NOT: switch
+define void @unbounded(i64 %n, i8* %d, i8* %s) {
+entry:
+  %r = call i8* @memcpy(i8* %d, i8* %s, i64 %n)
+  ret void
+}
+
+; The length is in [5, 12], so it is in the class of 4 or in the class of 8.
+; Each class moves its first and last bytes, which may overlap, with both
+; loads before both stores, as memmove needs.
+; CHECK-LABEL: define void @classes(
+; CHECK: icmp ult i64 %len, 8
+; CHECK: mem.class4:
+; CHECK: [[F4:%[0-9]+]] = load i32* {{.*}}, align 1
+; CHECK: [[L4:%[0-9]+]] = load i32* {{.*}}, align 1
+; CHECK: store i32 [[F4]], i32* {{.*}}, align 1
+; CHECK: store i32 [[L4]], i32* {{.*}}, align 1
+; CHECK: br label %mem.tail
+; CHECK: mem.class8:
+; CHECK: [[F8:%[0-9]+]] = load i64* {{.*}}, align 1
+; CHECK: [[L8:%[0-9]+]] = load i64* {{.*}}, align 1
+; CHECK: store i64 [[F8]], i64* {{.*}}, align 1
+; CHECK: store i64 [[L8]], i64* {{.*}}, align 1
+; CHECK: br label %mem.tail
+; CHECK-NOT: call void @llvm.memmove
+define void @classes(i1 %c, i8* %d, i8* %s) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %len = phi i64 [ 5, %a ], [ 12, %b ]
+  call void @llvm.memmove.p0i8.p0i8.i64(i8* %d, i8* %s, i64 %len, i32 1, i1 false)
+  ret void
+}
+
+; The length is in [0, 3]. An empty length does nothing, and the others set
+; one byte, or the first and last two bytes to the byte repeated.
+; CHECK-LABEL: define void @set(
+; CHECK: icmp eq i64 %len, 0
+; CHECK: icmp ult i64 %len, 2
+; CHECK: mem.class1:
+; CHECK-NEXT: store i8 7, i8* %d, align 1
+; CHECK-NEXT: br label %mem.tail
+; CHECK: mem.class2:
+; CHECK: store i16 1799, i16* {{.*}}, align 1
+; CHECK: store i16 1799, i16* {{.*}}, align 1
+; CHECK-NOT: call void @llvm.memset
+define void @set(i1 %c, i8* %d) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %len = phi i64 [ 0, %a ], [ 3, %b ]
+  call void @llvm.memset.p0i8.i64(i8* %d, i8 7, i64 %len, i32 1, i1 false)
+  ret void
+}
+
+; The length is in [40, 42], too long for the classes, so the call is
+; repeated with each length, and kept for any other one.
+; CHECK-LABEL: define void @switch(
+; CHECK: switch i64 %len, label %mem.generic [
+; CHECK-NEXT: i64 40, label %mem.len40
+; CHECK-NEXT: i64 41, label %mem.len41
+; CHECK-NEXT: i64 42, label %mem.len42
+; CHECK-NEXT: ]
+; CHECK: mem.generic:
+; CHECK-NEXT: call i8* @memcpy(i8* %d, i8* %s, i64 %len)
+; CHECK: mem.len40:
+; CHECK-NEXT: call i8* @memcpy(i8* %d, i8* %s, i64 40)
+; CHECK-NEXT: br label %mem.tail
+; CHECK: mem.len42:
+; CHECK-NEXT: call i8* @memcpy(i8* %d, i8* %s, i64 42)
+; CHECK-NEXT: br label %mem.tail
+define void @switch(i1 %c, i8* %d, i8* %s) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %len = phi i64 [ 40, %a ], [ 42, %b ]
+  %r = call i8* @memcpy(i8* %d, i8* %s, i64 %len)
+  ret void
+}
@@ -0,0 +1,100 @@
+; RUN: echo 'spec.ll.work.n 0 7' > %t
+; RUN: echo 'spec.ll.other.m 0 100000' >> %t
+; RUN: echo 'spec.ll.merge.k 0 3' >> %t
+; RUN: echo 'spec.ll.merge.k 5 9' >> %t
+; RUN: echo 'spec.ll.fixed.f 0 7' >> %t
+; RUN: echo 'spec.ll.nocmp.z 0 7' >> %t
+; RUN: %opt -load %lib/ProfileSpecialization.so -profile-specialization \
+; RUN:     -ps-profile=%t -ps-budget=100 -S %s | %FileCheck %s
+; RUN: %opt -load %lib/ProfileSpecialization.so -profile-specialization \
+; RUN:     -ps-profile=%t -ps-budget=0 -S %s | %FileCheck %s --check-prefix=NONE
+; RUN: %opt -load %lib/ProfileSpecialization.so -profile-specialization \
+; RUN:     -ps-profile=%t -ps-budget=100 -ps-report -disable-output %s 2>&1 \
+; RUN:     | %FileCheck %s --check-prefix=REPORT
+
+; Without a budget for the clones nothing is specialized.
+; NONE-NOT: .spec
+
+; @work has 3 instructions and one call. Its comparison is only decided in
+; the clone.
+; REPORT-DAG: work{{.}}#0[0, 7]{{.}}3{{.}}1{{.}}0{{.}}1
+; REPORT-DAG: merge{{.}}#0[0, 9]{{.}}3{{.}}1{{.}}0{{.}}1
+
+; %n only took values in [0, 7], so @work gets a clone for that range, and
+; its call checks both bounds, with sigmas, before calling the clone. The
+; profile of %m is wider than -ps-max-range, so @other is not cloned.
+; CHECK-LABEL: define i32 @caller(
+; CHECK: %x.inrange = icmp sge i32 %x, 0
+; CHECK: icmp sle i32 %vSSA_sigma{{[0-9]*}}, 7
+; CHECK: call i32 @work.spec(i32 %vSSA_sigma
+; CHECK: call i32 @work(i32 %x)
+; CHECK: %r = phi i32
+; CHECK: call i32 @other(i32 %y)
+define i32 @caller(i32 %x, i32 %y) {
+entry:
+  %r = call i32 @work(i32 %x)
+  %s = call i32 @other(i32 %y)
+  %t = add i32 %r, %s
+  ret i32 %t
+}
+
+define i32 @work(i32 %n) {
+entry:
+  %cmp = icmp slt i32 %n, 8
+  %r = select i1 %cmp, i32 1, i32 2
+  ret i32 %r
+}
+
+define i32 @other(i32 %m) {
+entry:
+  %cmp = icmp slt i32 %m, 8
+  %r = select i1 %cmp, i32 1, i32 2
+  ret i32 %r
+}
+
+; The two lines of the profile of %k are merged into [0, 9]. The static
+; range of %f, [3, 3], is already narrower than its profile, and no
+; comparison depends on %z, so @fixed and @nocmp are not cloned.
+; CHECK-LABEL: define i32 @caller2(
+; CHECK: %x.inrange = icmp sge i32 %x, 0
+; CHECK: icmp sle i32 %vSSA_sigma{{[0-9]*}}, 9
+; CHECK: call i32 @merge.spec(i32 %vSSA_sigma
+; CHECK: call i32 @merge(i32 %x)
+; CHECK: call i32 @fixed(i32 3)
+; CHECK: call i32 @nocmp(i32 %y)
+define i32 @caller2(i32 %x, i32 %y) {
+entry:
+  %a = call i32 @merge(i32 %x)
+  %b = call i32 @fixed(i32 3)
+  %c = call i32 @nocmp(i32 %y)
+  %t = add i32 %a, %b
+  %u = add i32 %t, %c
+  ret i32 %u
+}
+
+define i32 @merge(i32 %k) {
+entry:
+  %cmp = icmp slt i32 %k, 12
+  %r = select i1 %cmp, i32 1, i32 2
+  ret i32 %r
+}
+
+define i32 @fixed(i32 %f) {
+entry:
+  %cmp = icmp slt i32 %f, 8
+  %r = select i1 %cmp, i32 1, i32 2
+  ret i32 %r
+}
+
+define i32 @nocmp(i32 %z) {
+entry:
+  %r = add i32 %z, 1
+  ret i32 %r
+}
+
+; CHECK-LABEL: define internal i32 @work.spec(i32 %n)
+; CHECK-NOT: @other.spec
+; CHECK-LABEL: define internal i32 @merge.spec(i32 %k)
+; CHECK-NOT: @other.spec
+; CHECK-NOT: @fixed.spec
+; CHECK-NOT: @nocmp.spec
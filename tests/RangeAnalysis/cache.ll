@@ -0,0 +1,45 @@
+; RUN: %opt -load %lib/RangeBranchFolding.so -load %lib/RangeMetadata.so \
+; RUN:     -range-branch-folding -range-metadata -S %s | %FileCheck %s
+; RUN: %opt -load %lib/RangeMetadata.so -range-metadata -S %s \
+; RUN:     | %FileCheck %s --check-prefix=ALONE
+
+; Before the folding %m may be 2^30, and %m * 4 may wrap. The folding
+; deletes %big, so the cache must give -range-metadata the ranges of the
+; folded function, where %m is in [3, 10].
+; CHECK-LABEL: define i32 @stale(
+; CHECK: %m = phi i32 [ %p, %s1 ], [ 5, %s2 ]
+; CHECK-NEXT: %q = mul nuw nsw i32 %m, 4
+; ALONE-LABEL: define i32 @stale(
+; ALONE: %q = mul i32 %m, 4
+define i32 @stale(i1 %c, i1 %d) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %cmp = icmp slt i32 %p, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  br i1 %d, label %s1, label %s2
+
+s1:
+  br label %merge
+
+s2:
+  br label %merge
+
+big:
+  br label %merge
+
+merge:
+  %m = phi i32 [ %p, %s1 ], [ 5, %s2 ], [ 1073741824, %big ]
+  %q = mul i32 %m, 4
+  ret i32 %q
+}
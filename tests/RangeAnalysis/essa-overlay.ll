@@ -0,0 +1,66 @@
+; RUN: %opt -load %lib/vSSA.so -vssa %s -o %t.vssa.bc
+; RUN: %opt -load %lib/RAPrinter.so -ra-printer-inter-cousot \
+; RUN:     -disable-output %t.vssa.bc
+; RUN: cp %s %t.overlay.ll
+; RUN: %opt -load %lib/RAPrinter.so -ra-essa-overlay \
+; RUN:     -ra-printer-inter-cousot -disable-output %t.overlay.ll
+; RUN: grep -v vSSA_ /tmp/RAEstimatedValues.$(basename %t.vssa.bc).txt \
+; RUN:     | sed 's/^[^ ]*\.vssa\.bc\.//' > %t.vssa.txt
+; RUN: sed 's/^[^ ]*\.overlay\.ll\.//' \
+; RUN:     /tmp/RAEstimatedValues.$(basename %t.overlay.ll).txt > %t.overlay.txt
+; RUN: rm -f /tmp/RAEstimatedValues.$(basename %t.vssa.bc).txt \
+; RUN:     /tmp/RAEstimatedValues.$(basename %t.overlay.ll).txt
+; RUN: diff %t.vssa.txt %t.overlay.txt
+; RUN: %FileCheck %s < %t.overlay.txt
+
+; The ranges of the virtual e-SSA overlay must be those of real vSSA, for
+; every instruction both forms have. The sigmas and phis that vSSA adds are
+; left out of the comparison. Like tests/compareEssaOverlay.py, the module
+; has no critical edges, so vSSA puts every sigma where the overlay does.
+
+; %x is below 10 in %low, and at least 0 in %in.
+; CHECK: clamp.y 1 10
+; CHECK: clamp.r 0 10
+define i32 @clamp(i32 %x) {
+entry:
+  %lt = icmp slt i32 %x, 10
+  br i1 %lt, label %low, label %big
+
+big:
+  br label %join
+
+low:
+  %ge = icmp sge i32 %x, 0
+  br i1 %ge, label %in, label %neg
+
+neg:
+  br label %join
+
+in:
+  %y = add nsw i32 %x, 1
+  br label %join
+
+join:
+  %r = phi i32 [ 0, %big ], [ 0, %neg ], [ %y, %in ]
+  ret i32 %r
+}
+
+; %i is below 100 in the body of the loop.
+; CHECK: count.i 0 100
+; CHECK: count.inc 1 100
+define i32 @count() {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, 100
+  br i1 %cmp, label %body, label %exit
+
+body:
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret i32 %i
+}
@@ -0,0 +1,24 @@
+; RUN: %opt -load %lib/RangeBasedAliasAnalysis.so -ranged-aa-metadata -S %s \
+; RUN:     | %FileCheck %s
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; The stores write the bytes 4 and 12 of %a, and the i64 load reads the
+; bytes 0 to 7. The load is noalias with the store to byte 12 alone, which
+; is the only scope in its !noalias list; the store to byte 4 may alias it.
+; CHECK-LABEL: define i64 @bytes(
+; CHECK: store i8 1, i8* %p4, !alias.scope ![[S4:[0-9]+]], !noalias ![[N4:[0-9]+]]
+; CHECK: store i8 2, i8* %p12, !alias.scope ![[S12:[0-9]+]], !noalias ![[N12:[0-9]+]]
+; CHECK: %v = load i64* %w, !alias.scope ![[SV:[0-9]+]], !noalias ![[S12]]{{$}}
+define i64 @bytes() {
+entry:
+  %a = alloca [16 x i8]
+  %p0 = getelementptr inbounds [16 x i8]* %a, i32 0, i32 0
+  %w = bitcast i8* %p0 to i64*
+  %p4 = getelementptr inbounds [16 x i8]* %a, i32 0, i32 4
+  %p12 = getelementptr inbounds [16 x i8]* %a, i32 0, i32 12
+  store i8 1, i8* %p4
+  store i8 2, i8* %p12
+  %v = load i64* %w
+  ret i64 %v
+}
@@ -0,0 +1,179 @@
+; RUN: %opt -load %lib/RangeBranchFolding.so -range-branch-folding -S %s \
+; RUN:     | %FileCheck %s
+; RUN: %opt -load %lib/RangeBranchFolding.so -range-branch-folding \
+; RUN:     -rbf-max-rounds=1 -S %s | %FileCheck %s --check-prefix=ONE
+
+; %p is in [3, 10], so it is always less than 20: the branch goes to %small
+; and %big becomes unreachable.
+; CHECK-LABEL: define i32 @fold(
+; CHECK: %p = phi i32 [ 3, %a ], [ 10, %b ]
+; CHECK-NEXT: br label %small
+; CHECK-NOT: icmp
+; CHECK-NOT: ret i32 0
+define i32 @fold(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %cmp = icmp slt i32 %p, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %p
+
+big:
+  ret i32 0
+}
+
+; Nothing is known about %x, so both destinations stay.
+; CHECK-LABEL: define i32 @keep(
+; CHECK: %cmp = icmp slt i32 %x, 20
+; CHECK-NEXT: br i1 %cmp, label %small, label %big
+; CHECK: ret i32 0
+define i32 @keep(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %x
+
+big:
+  ret i32 0
+}
+
+; %p is negative, so as an unsigned number it is greater than 5.
+; CHECK-LABEL: define i32 @unsigned(
+; CHECK: %p = phi i32 [ -2, %a ], [ -1, %b ]
+; CHECK-NEXT: br label %big
+; CHECK-NOT: icmp
+define i32 @unsigned(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ -2, %a ], [ -1, %b ]
+  %cmp = icmp ult i32 %p, 5
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %p
+
+big:
+  ret i32 0
+}
+
+; %p is never 20, so it is always different from it.
+; CHECK-LABEL: define i32 @different(
+; CHECK: %p = phi i32 [ 3, %a ], [ 10, %b ]
+; CHECK-NEXT: br label %small
+; CHECK-NOT: icmp
+; CHECK-NOT: ret i32 0
+define i32 @different(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %cmp = icmp ne i32 %p, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %p
+
+big:
+  ret i32 0
+}
+
+; %p can only be 4, so the switch always goes to %four.
+; CHECK-LABEL: define i32 @single(
+; CHECK: br label %four
+; CHECK-NOT: switch
+; CHECK-NOT: ret i32 5
+define i32 @single(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 4, %a ], [ 4, %b ]
+  switch i32 %p, label %other [
+    i32 4, label %four
+    i32 5, label %five
+  ]
+
+four:
+  ret i32 4
+
+five:
+  ret i32 5
+
+other:
+  ret i32 0
+}
+
+; %m is in [3, 1000] until %big is deleted, so the second comparison is only
+; decided by the second round.
+; CHECK-LABEL: define i32 @rounds(
+; CHECK-NOT: icmp
+; CHECK: ret i32 1
+; CHECK-NOT: ret i32 0
+; ONE-LABEL: define i32 @rounds(
+; ONE: %cmp2 = icmp slt i32
+; ONE: ret i32 0
+define i32 @rounds(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %cmp = icmp slt i32 %p, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  br label %merge
+
+big:
+  br label %merge
+
+merge:
+  %m = phi i32 [ %p, %small ], [ 1000, %big ]
+  %cmp2 = icmp slt i32 %m, 20
+  br i1 %cmp2, label %yes, label %no
+
+yes:
+  ret i32 1
+
+no:
+  ret i32 0
+}
@@ -0,0 +1,130 @@
+; RUN: %opt -load %lib/RangeBranchFolding.so -range-switch-lowering -S %s \
+; RUN:     | %FileCheck %s
+
+declare void @use(i32)
+
+; CHECK: @switch.table = private unnamed_addr constant [4 x i32] [i32 10, i32 20, i32 30, i32 40]
+
+; %p is in [1, 3]: case 9 goes away, cases 1 to 3 cover the whole range so
+; the last one becomes the default, and the cases are rebased to zero.
+; CHECK-LABEL: define void @lower(
+; CHECK: %p.idx = sub i32 %p, 1
+; CHECK-NEXT: switch i32 %p.idx, label %three [
+; CHECK-NEXT: i32 0, label %one
+; CHECK-NEXT: i32 1, label %two
+; CHECK-NEXT: ]
+; CHECK-NOT: call void @use(i32 9)
+; CHECK-NOT: call void @use(i32 0)
+define void @lower(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 1, %a ], [ 3, %b ]
+  switch i32 %p, label %other [
+    i32 1, label %one
+    i32 2, label %two
+    i32 3, label %three
+    i32 9, label %nine
+  ]
+
+one:
+  call void @use(i32 1)
+  ret void
+
+two:
+  call void @use(i32 2)
+  ret void
+
+three:
+  call void @use(i32 3)
+  ret void
+
+nine:
+  call void @use(i32 9)
+  ret void
+
+other:
+  call void @use(i32 0)
+  ret void
+}
+
+; Nothing is known about %x, so the switch stays as it is.
+; CHECK-LABEL: define void @keep(
+; CHECK: switch i32 %x, label %other [
+; CHECK-NEXT: i32 1, label %one
+; CHECK-NEXT: i32 9, label %nine
+; CHECK-NEXT: ]
+; CHECK: call void @use(i32 0)
+define void @keep(i32 %x) {
+entry:
+  switch i32 %x, label %other [
+    i32 1, label %one
+    i32 9, label %nine
+  ]
+
+one:
+  call void @use(i32 1)
+  ret void
+
+nine:
+  call void @use(i32 9)
+  ret void
+
+other:
+  call void @use(i32 0)
+  ret void
+}
+
+; %p is in [0, 3] and every case only selects a constant for %r, so the
+; switch becomes a load from a table, with no guard and no default.
+; CHECK-LABEL: define i32 @table(
+; CHECK: %p.ext = zext i32 %p to i64
+; CHECK-NEXT: %r.ptr = getelementptr inbounds [4 x i32]* @switch.table, i64 0, i64 %p.ext
+; CHECK-NEXT: %r.load = load i32* %r.ptr
+; CHECK-NEXT: br label %done
+; CHECK-NOT: switch
+define i32 @table(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 0, %a ], [ 3, %b ]
+  switch i32 %p, label %other [
+    i32 0, label %c0
+    i32 1, label %c1
+    i32 2, label %c2
+    i32 3, label %c3
+  ]
+
+c0:
+  br label %done
+
+c1:
+  br label %done
+
+c2:
+  br label %done
+
+c3:
+  br label %done
+
+other:
+  br label %done
+
+done:
+  %r = phi i32 [ 10, %c0 ], [ 20, %c1 ], [ 30, %c2 ], [ 40, %c3 ], [ 0, %other ]
+  ret i32 %r
+}
@@ -0,0 +1,54 @@
+; RUN: %opt -load %lib/vSSA.so -load %lib/RangeLoopVersioning.so \
+; RUN:     -vssa -range-loop-versioning -S %s | %FileCheck %s
+; RUN: %opt -load %lib/RangeLoopVersioning.so \
+; RUN:     -ra-essa-overlay -range-loop-versioning -S %s | %FileCheck %s
+
+declare void @abort() noreturn
+declare void @use(i32)
+
+; The loop starts at %s, which is only known to be below %n, so the check of
+; %i against 0 needs %s >= 0 before the loop. The start is seen through the
+; sigma of %s in %ph, which the overlay does not put in the function, so the
+; guard must compare %s itself.
+; CHECK-LABEL: define void @start(
+; CHECK-DAG: %version.guard{{[0-9]*}} = icmp sge i32 %s, 0
+; CHECK-DAG: %version.guard{{[0-9]*}} = icmp sle i32 %n, %len
+; CHECK: low.fast:
+; CHECK-NOT: icmp
+; CHECK: br label %high.fast
+; CHECK: high.fast:
+; CHECK-NOT: icmp
+; CHECK: br label %body.fast
+define void @start(i32 %s, i32 %n, i32 %len) {
+entry:
+  %enter = icmp slt i32 %s, %n
+  br i1 %enter, label %ph, label %exit
+
+ph:
+  br label %header
+
+header:
+  %i = phi i32 [ %s, %ph ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %low, label %exit
+
+low:
+  %pos = icmp sge i32 %i, 0
+  br i1 %pos, label %high, label %trap
+
+high:
+  %ok = icmp slt i32 %i, %len
+  br i1 %ok, label %body, label %trap
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+body:
+  call void @use(i32 %i)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
@@ -0,0 +1,134 @@
+; RUN: %opt -load %lib/vSSA.so -load %lib/RangeLoopVersioning.so \
+; RUN:     -vssa -range-loop-versioning -S %s | %FileCheck %s
+; RUN: %opt -load %lib/vSSA.so -load %lib/RangeLoopVersioning.so \
+; RUN:     -vssa -range-loop-versioning -rlv-max-guards=1 -S %s \
+; RUN:     | %FileCheck %s --check-prefix=ONE
+; RUN: %opt -load %lib/vSSA.so -load %lib/RangeLoopVersioning.so \
+; RUN:     -vssa -range-loop-versioning -rlv-report -disable-output %s 2>&1 \
+; RUN:     | %FileCheck %s --check-prefix=REPORT
+
+declare void @abort() noreturn
+declare void @use(i32)
+declare i32 @get()
+declare { i32, i1 } @llvm.sadd.with.overflow.i32(i32, i32)
+
+; REPORT: version{{.}}header{{.}}1 bounds checks, 0 overflow checks removed if n <= len
+; REPORT-NEXT: overflow{{.}}header{{.}}1 bounds checks, 1 overflow checks removed if n <= len and len <= 2147483646
+
+; The loop is guarded by %i < %n, so the check of %i against %len passes if
+; %n <= %len. The fast version, entered under that predicate, has no check.
+; CHECK-LABEL: define void @version(
+; CHECK: %version.guard = icmp sle i32 %n, %len
+; CHECK-NEXT: br i1 %version.guard, label %entry.fast, label %entry.slow
+; CHECK: check:
+; CHECK: br i1 %ok, label %body, label %trap
+; CHECK: check.fast:
+; CHECK-NOT: icmp
+; CHECK: br label %body.fast
+define void @version(i32 %n, i32 %len) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %check, label %exit
+
+check:
+  %ok = icmp slt i32 %i, %len
+  br i1 %ok, label %body, label %trap
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+body:
+  call void @use(i32 %i)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; The index is read in the loop, so nothing bounds it before the loop, and
+; the loop keeps a single version.
+; CHECK-LABEL: define void @keep(
+; CHECK-NOT: version.guard
+; CHECK-NOT: .fast
+define void @keep(i32 %n, i32 %len) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %check, label %exit
+
+check:
+  %j = call i32 @get()
+  %ok = icmp slt i32 %j, %len
+  br i1 %ok, label %body, label %trap
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+body:
+  call void @use(i32 %j)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
+
+; In %body, %i < %len, so %i + 2 does not overflow if %len <= MAX - 1. The
+; predicate checks both that and %n <= %len, and the fast version adds
+; without the overflow check. With a single comparison allowed, only the
+; bounds check is removed.
+; CHECK-LABEL: define void @overflow(
+; CHECK: %version.guard = icmp sle i32 %n, %len
+; CHECK-NEXT: %version.guard1 = icmp sle i32 %len, 2147483646
+; CHECK-NEXT: %version.cond = and i1 %version.guard, %version.guard1
+; CHECK-NEXT: br i1 %version.cond, label %entry.fast, label %entry.slow
+; CHECK: body.fast:
+; CHECK-NOT: sadd.with.overflow
+; CHECK: add nsw i32 {{.*}}, 2
+; CHECK-NOT: sadd.with.overflow
+; ONE-LABEL: define void @overflow(
+; ONE: %version.guard = icmp sle i32 %n, %len
+; ONE-NEXT: br i1 %version.guard, label %entry.fast, label %entry.slow
+; ONE: body.fast:
+; ONE: call { i32, i1 } @llvm.sadd.with.overflow.i32
+define void @overflow(i32 %n, i32 %len) {
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %next ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %check, label %exit
+
+check:
+  %ok = icmp slt i32 %i, %len
+  br i1 %ok, label %body, label %trap
+
+body:
+  %s = call { i32, i1 } @llvm.sadd.with.overflow.i32(i32 %i, i32 2)
+  %o = extractvalue { i32, i1 } %s, 1
+  br i1 %o, label %trap, label %next
+
+next:
+  %v = extractvalue { i32, i1 } %s, 0
+  call void @use(i32 %v)
+  %inc = add nsw i32 %i, 1
+  br label %header
+
+trap:
+  call void @abort() noreturn
+  unreachable
+
+exit:
+  ret void
+}
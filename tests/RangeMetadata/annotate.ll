@@ -0,0 +1,120 @@
+; RUN: %opt -load %lib/RangeMetadata.so -range-metadata -S %s | %FileCheck %s
+
+; @pick returns a value in [3, 10], so the product by 4, in [12, 40], wraps
+; neither as a signed nor as an unsigned number. The call gets no !range,
+; which the verifier of this LLVM only accepts on loads.
+; CHECK-LABEL: define i32 @annotate(
+; CHECK: %v = call i32 @pick(i1 %c){{$}}
+; CHECK-NEXT: %q = mul nuw nsw i32 %v, 4
+define i32 @annotate(i1 %c) {
+entry:
+  %v = call i32 @pick(i1 %c)
+  %q = mul i32 %v, 4
+  ret i32 %q
+}
+
+define internal i32 @pick(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  ret i32 %p
+}
+
+; Nothing is known about %x, or about what is loaded, so the addition may
+; wrap and the load gets no !range.
+; CHECK-LABEL: define i32 @keep(
+; CHECK: %r = add i32 %x, 1
+; CHECK: %l = load i32* %p{{$}}
+; CHECK-NOT: !range
+define i32 @keep(i32 %x, i32* %p) {
+entry:
+  %r = add i32 %x, 1
+  %l = load i32* %p
+  %s = add i32 %r, %l
+  ret i32 %s
+}
+
+; %p is in [-3, 10], so none of these operations wraps as a signed number,
+; but they may read or give negative numbers, so they do not get nuw.
+; CHECK-LABEL: define i32 @wrap(
+; CHECK: %m = mul nsw i32 %p, 4
+; CHECK-NEXT: %s = sub nsw i32 %p, 5
+; CHECK-NEXT: %a = add nsw i32 %p, 2
+; CHECK-NEXT: %t = shl nsw i32 %p, 2
+define i32 @wrap(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ -3, %a ], [ 10, %b ]
+  %m = mul i32 %p, 4
+  %s = sub i32 %p, 5
+  %a = add i32 %p, 2
+  %t = shl i32 %p, 2
+  %r1 = add i32 %m, %s
+  %r2 = xor i32 %a, %t
+  %r = xor i32 %r1, %r2
+  ret i32 %r
+}
+
+; %p is in [3, 10], so every operation below is in range as an unsigned
+; number too.
+; CHECK-LABEL: define i32 @unsigned(
+; CHECK: %s = sub nuw nsw i32 %p, 2
+; CHECK-NEXT: %t = shl nuw nsw i32 %p, 2
+define i32 @unsigned(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %s = sub i32 %p, 2
+  %t = shl i32 %p, 2
+  %r = xor i32 %s, %t
+  ret i32 %r
+}
+
+; %p can only be 12, which 4 divides and 5 does not.
+; CHECK-LABEL: define i32 @exact(
+; CHECK: %d = udiv exact i32 %p, 4
+; CHECK-NEXT: %h = lshr exact i32 %p, 2
+; CHECK-NEXT: %n = sdiv i32 %p, 5
+define i32 @exact(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 12, %a ], [ 12, %b ]
+  %d = udiv i32 %p, 4
+  %h = lshr i32 %p, 2
+  %n = sdiv i32 %p, 5
+  %r1 = add i32 %d, %h
+  %r = add i32 %r1, %n
+  ret i32 %r
+}
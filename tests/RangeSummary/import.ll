@@ -0,0 +1,82 @@
+; RUN: printf 'RangeIndex 1\nR lookup 0 5\nA scale 0 0 9\n' > %t
+; RUN: %opt -load %lib/RangeBranchFolding.so -ra-summary-index=%t \
+; RUN:     -range-branch-folding -S %s | %FileCheck %s
+; RUN: printf 'RangeIndex 1\nR lookup 0 5\nR other five\n' > %t.bad
+; RUN: %opt -load %lib/RangeBranchFolding.so -ra-summary-index=%t.bad \
+; RUN:     -range-branch-folding -S %s 2>&1 | %FileCheck %s --check-prefix=BAD
+; RUN: %opt -load %lib/RangeBranchFolding.so -ra-separate-modules \
+; RUN:     -range-branch-folding -S %s | %FileCheck %s --check-prefix=SEP
+
+; An index that cannot be read is not imported at all, not even the lines
+; before the error.
+; BAD: Error reading range summary index
+; BAD-LABEL: define i32 @fold(
+; BAD: %cmp = icmp slt i32 %r, 20
+
+; The index says that @lookup, defined in another module, returns [0, 5],
+; so %r is always less than 20.
+; CHECK-LABEL: define i32 @fold(
+; CHECK: %r = call i32 @lookup()
+; CHECK-NEXT: br label %small
+; CHECK-NOT: icmp
+; CHECK-NOT: ret i32 0
+define i32 @fold() {
+entry:
+  %r = call i32 @lookup()
+  %cmp = icmp slt i32 %r, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %r
+
+big:
+  ret i32 0
+}
+
+; @other is not in the index, so it may return anything.
+; CHECK-LABEL: define i32 @keep(
+; CHECK: %cmp = icmp slt i32 %r, 20
+; CHECK-NEXT: br i1 %cmp, label %small, label %big
+; CHECK: ret i32 0
+define i32 @keep() {
+entry:
+  %r = call i32 @other()
+  %cmp = icmp slt i32 %r, 20
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %r
+
+big:
+  ret i32 0
+}
+
+; @scale may be called from other modules, and the index says that all its
+; call sites pass [0, 9]. Without an index, the call in @use is not the only
+; one, so %x may take any value.
+; SEP-LABEL: define i32 @scale(
+; SEP: %cmp = icmp slt i32 %x, 10
+; CHECK-LABEL: define i32 @scale(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: br label %small
+; CHECK-NOT: ret i32 0
+define i32 @scale(i32 %x) {
+entry:
+  %cmp = icmp slt i32 %x, 10
+  br i1 %cmp, label %small, label %big
+
+small:
+  ret i32 %x
+
+big:
+  ret i32 0
+}
+
+define internal i32 @use() {
+entry:
+  %r = call i32 @scale(i32 3)
+  ret i32 %r
+}
+
+declare i32 @lookup()
+declare i32 @other()
@@ -0,0 +1,47 @@
+; RUN: %opt -ra-separate-modules -ra-summary -ra-summary-file=%t \
+; RUN:     -disable-output %s
+; RUN: %FileCheck %s < %t
+
+; @pick returns [3, 10], and @caller passes its own parameter to @sink.
+; @helper is internal: other modules cannot call it, so it has no record of
+; its own, and its calls are listed under "-".
+; CHECK: RangeSummary 1
+; CHECK-NOT: helper
+; CHECK: F pick 0 1 1
+; CHECK-NOT: helper
+; CHECK: F caller 0 1 32
+; CHECK-NOT: helper
+; CHECK: R pick 32 3 10
+; CHECK-NOT: helper
+; CHECK: C - sink 0 32 7 7
+; CHECK-NEXT: C caller sink 0 32 -inf +inf p 0 0 0
+; CHECK-NOT: helper
+
+declare void @sink(i32)
+
+define i32 @pick(i1 %c) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  ret i32 %p
+}
+
+define void @caller(i32 %n) {
+entry:
+  call void @sink(i32 %n)
+  ret void
+}
+
+define internal void @helper() {
+entry:
+  call void @sink(i32 7)
+  ret void
+}
@@ -0,0 +1,197 @@
+; RUN: %opt -load %lib/StructFieldShrinking.so -struct-field-shrinking -S %s \
+; RUN:     | %FileCheck %s
+; RUN: %opt -load %lib/StructFieldShrinking.so -struct-field-shrinking \
+; RUN:     -sfs-report -disable-output %s 2>&1 | %FileCheck %s --check-prefix=REPORT
+
+target datalayout = "e-m:e-i64:64-f80:128-n8:16:32:64-S128"
+
+; Only values in [3, 10] are stored to the first field of S, so it becomes an
+; i8, placed after the wider fields: S goes from 24 to 16 bytes.
+; CHECK-DAG: %struct.S = type { i64, i32, i8 }
+%struct.S = type { i32, i64, i32 }
+
+; U could be shrunk in the same way, but a pointer to a pointer to U is cast
+; to i8**, and the code may read the object through it.
+; CHECK-DAG: %struct.U = type { i32, i64, i32 }
+%struct.U = type { i32, i64, i32 }
+
+; M and E could be shrunk too, but the address of their i64 field, which
+; would move, is passed to memset and to a function the pass does not see.
+; CHECK-DAG: %struct.M = type { i32, i64, i32 }
+; CHECK-DAG: %struct.E = type { i32, i64, i32 }
+%struct.M = type { i32, i64, i32 }
+%struct.E = type { i32, i64, i32 }
+
+; H is allocated with malloc, and its allocations shrink with it. The last
+; field is never stored, so it only holds zeros or garbage, and needs no
+; more than a byte.
+; CHECK-DAG: %struct.H = type { i64, i8, i8 }
+%struct.H = type { i32, i64, i32 }
+
+; Nothing is known about the value stored to the first field of K, so only
+; the last one shrinks.
+; CHECK-DAG: %struct.K = type { i64, i32, i8 }
+%struct.K = type { i32, i64, i16 }
+
+; REPORT: Type{{.}}Old size{{.}}New size{{.}}Fields shrunk{{.}}Allocations resized
+; REPORT-DAG: struct.S{{.}}24{{.}}16{{.}}1{{.}}0
+; REPORT-DAG: struct.H{{.}}24{{.}}16{{.}}2{{.}}2
+; REPORT-DAG: struct.K{{.}}24{{.}}16{{.}}1{{.}}0
+
+declare void @llvm.memset.p0i8.i64(i8*, i8, i64, i32, i1)
+declare i8* @malloc(i64)
+declare void @use(i64*)
+
+; CHECK-LABEL: define i32 @shrink(
+; CHECK: %f0 = getelementptr inbounds {{.*}}%s, i32 0, i32 2
+; CHECK-NEXT: [[T:%[0-9]+]] = trunc i32 %p to i8
+; CHECK-NEXT: store i8 [[T]], i8* %f0
+; CHECK: %f1 = getelementptr inbounds {{.*}}%s, i32 0, i32 0
+; CHECK-NEXT: store i64 %big, i64* %f1
+; CHECK: %v.nrw = load i8{{.*}} %f0
+; CHECK-NEXT: %v = sext i8 %v.nrw to i32
+define i32 @shrink(i1 %c, i64 %big, i32 %x) {
+entry:
+  %s = alloca %struct.S
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %f0 = getelementptr inbounds %struct.S* %s, i32 0, i32 0
+  store i32 %p, i32* %f0
+  %f1 = getelementptr inbounds %struct.S* %s, i32 0, i32 1
+  store i64 %big, i64* %f1
+  %f2 = getelementptr inbounds %struct.S* %s, i32 0, i32 2
+  store i32 %x, i32* %f2
+  %v = load i32* %f0
+  ret i32 %v
+}
+
+; CHECK-LABEL: define i8* @punned(
+; CHECK: %f0 = getelementptr inbounds {{.*}}%u, i32 0, i32 0
+; CHECK-NEXT: store i32 %p, i32* %f0
+define i8* @punned(i1 %c, i64 %big, i32 %x) {
+entry:
+  %u = alloca %struct.U
+  %pp = alloca %struct.U*
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %f0 = getelementptr inbounds %struct.U* %u, i32 0, i32 0
+  store i32 %p, i32* %f0
+  %f1 = getelementptr inbounds %struct.U* %u, i32 0, i32 1
+  store i64 %big, i64* %f1
+  %f2 = getelementptr inbounds %struct.U* %u, i32 0, i32 2
+  store i32 %x, i32* %f2
+  store %struct.U* %u, %struct.U** %pp
+  %cast = bitcast %struct.U** %pp to i8**
+  %raw = load i8** %cast
+  ret i8* %raw
+}
+
+; CHECK-LABEL: define void @cleared(
+; CHECK: %f0 = getelementptr inbounds {{.*}}%m, i32 0, i32 0
+; CHECK-NEXT: store i32 %p, i32* %f0
+; CHECK: %f1 = getelementptr inbounds {{.*}}%m, i32 0, i32 1
+; CHECK: call void @llvm.memset
+define void @cleared(i1 %c) {
+entry:
+  %m = alloca %struct.M
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %f0 = getelementptr inbounds %struct.M* %m, i32 0, i32 0
+  store i32 %p, i32* %f0
+  %f1 = getelementptr inbounds %struct.M* %m, i32 0, i32 1
+  %raw = bitcast i64* %f1 to i8*
+  call void @llvm.memset.p0i8.i64(i8* %raw, i8 0, i64 8, i32 8, i1 false)
+  ret void
+}
+
+; CHECK-LABEL: define void @external(
+; CHECK: %f0 = getelementptr inbounds {{.*}}%e, i32 0, i32 0
+; CHECK-NEXT: store i32 %p, i32* %f0
+; CHECK: %f1 = getelementptr inbounds {{.*}}%e, i32 0, i32 1
+; CHECK-NEXT: call void @use(i64* %f1)
+define void @external(i1 %c) {
+entry:
+  %e = alloca %struct.E
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %f0 = getelementptr inbounds %struct.E* %e, i32 0, i32 0
+  store i32 %p, i32* %f0
+  %f1 = getelementptr inbounds %struct.E* %e, i32 0, i32 1
+  call void @use(i64* %f1)
+  ret void
+}
+
+; CHECK-LABEL: define void @heap(
+; CHECK: %raw = call i8* @malloc(i64 32)
+; CHECK: [[BYTES:%bytes[0-9]*]] = mul i64 %n, 16
+; CHECK-NEXT: %raw2 = call i8* @malloc(i64 [[BYTES]])
+define void @heap(i1 %c, i64 %n, i64 %big) {
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  br label %join
+
+b:
+  br label %join
+
+join:
+  %p = phi i32 [ 3, %a ], [ 10, %b ]
+  %raw = call i8* @malloc(i64 48)
+  %h = bitcast i8* %raw to %struct.H*
+  %f0 = getelementptr inbounds %struct.H* %h, i32 0, i32 0
+  store i32 %p, i32* %f0
+  %f1 = getelementptr inbounds %struct.H* %h, i32 0, i32 1
+  store i64 %big, i64* %f1
+  %bytes = mul i64 %n, 24
+  %raw2 = call i8* @malloc(i64 %bytes)
+  %h2 = bitcast i8* %raw2 to %struct.H*
+  %g0 = getelementptr inbounds %struct.H* %h2, i32 0, i32 0
+  store i32 %p, i32* %g0
+  ret void
+}
+
+; CHECK-LABEL: define void @unknown(
+; CHECK: %k0 = getelementptr inbounds {{.*}}%k, i32 0, i32 1
+; CHECK-NEXT: store i32 %x, i32* %k0{{$}}
+define void @unknown(i32 %x, i64 %big) {
+entry:
+  %k = alloca %struct.K
+  %k0 = getelementptr inbounds %struct.K* %k, i32 0, i32 0
+  store i32 %x, i32* %k0, align 4
+  %k1 = getelementptr inbounds %struct.K* %k, i32 0, i32 1
+  store i64 %big, i64* %k1
+  ret void
+}
@@ -0,0 +1,126 @@
+#! /usr/bin/env python
+"""
+Compares the ranges of the virtual e-SSA overlay with those of real vSSA.
+
+For every C file given, this script compiles it, puts it in SSA form, and
+runs RAPrinter twice:
+ - on the output of -vssa, the form the analysis was written for;
+ - on the SSA module itself, with -ra-essa-overlay.
+Both runs print the range of every integer instruction of the program. The
+sigmas and phis that vSSA adds only exist in the first run, so the script
+compares the instructions that both runs print, and reports those whose
+ranges differ. It exits with status 1 if any range differs.
+
+Example, on the bitwise benchmarks:
+
+    ./compareEssaOverlay.py --lib-dir ~/llvm/Release/lib \\
+        bitwise-benchmarks/Bitwise/*.c t*.c
+"""
+
+from __future__ import print_function
+
+import optparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+
+def run(cmd):
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT)
+    out = proc.communicate()[0]
+    if proc.returncode != 0:
+        sys.stderr.write(out.decode("utf-8", "replace"))
+        raise RuntimeError("command failed: %s" % " ".join(cmd))
+
+
+def print_ranges(opts, module, extra):
+    """Runs RAPrinter on module and returns the range of each instruction,
+    keyed by function and name."""
+    ident = os.path.basename(module)
+    output = "/tmp/RAEstimatedValues." + ident + ".txt"
+    if os.path.exists(output):
+        os.remove(output)
+
+    run([opts.opt,
+         "-load", os.path.join(opts.lib_dir, "RangeAnalysis.so"),
+         "-load", os.path.join(opts.lib_dir, "RAPrinter.so")]
+        + extra + ["-ra-printer-inter-cousot", "-disable-output", module])
+
+    ranges = {}
+    seen = set()
+    with open(output) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) != 3:
+                continue
+            key = fields[0][len(ident) + 1:]
+            # Instructions without a name cannot be matched across runs
+            if key.endswith(".") or key in seen:
+                ranges.pop(key, None)
+                continue
+            seen.add(key)
+            ranges[key] = (fields[1], fields[2])
+    os.remove(output)
+    return ranges
+
+
+def compare(opts, source, work_dir):
+    name = os.path.splitext(os.path.basename(source))[0]
+    bc = os.path.join(work_dir, name + ".bc")
+    ssa = os.path.join(work_dir, name + ".ssa.bc")
+    essa = os.path.join(work_dir, name + ".essa.bc")
+
+    run([opts.clang, "-c", "-emit-llvm", "-O0", source, "-o", bc])
+    run([opts.opt, "-instnamer", "-mem2reg", "-break-crit-edges", bc,
+         "-o", ssa])
+    run([opts.opt, "-load", os.path.join(opts.lib_dir, "vSSA.so"), "-vssa",
+         ssa, "-o", essa])
+
+    real = print_ranges(opts, essa, [])
+    overlay = print_ranges(opts, ssa, ["-ra-essa-overlay"])
+
+    common = sorted(set(real) & set(overlay))
+    differ = [k for k in common if real[k] != overlay[k]]
+
+    print("%s\t%d\t%d\t%d" % (name, len(common), len(differ),
+                              len(set(overlay) - set(real))))
+    for key in differ[:opts.show]:
+        print("\t%-40s vssa [%s, %s]  overlay [%s, %s]"
+              % ((key,) + real[key] + overlay[key]))
+    return len(differ)
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog [options] file.c...")
+    parser.add_option("--opt", default="opt", help="opt binary to run")
+    parser.add_option("--clang", default="clang", help="clang binary to run")
+    parser.add_option("--lib-dir", default=".",
+                      help="directory with vSSA.so, RangeAnalysis.so and "
+                      "RAPrinter.so")
+    parser.add_option("--show", type="int", default=10,
+                      help="differences listed per file")
+    parser.add_option("--keep", default=None,
+                      help="keep the modules in this directory")
+    opts, sources = parser.parse_args(argv)
+    if not sources:
+        parser.error("no input files")
+
+    work_dir = opts.keep or tempfile.mkdtemp(prefix="essa-overlay-")
+    if not os.path.isdir(work_dir):
+        os.makedirs(work_dir)
+
+    print("file\tcompared\tdiffer\tonly-overlay")
+    differ = 0
+    for source in sources:
+        differ += compare(opts, source, work_dir)
+
+    if not opts.keep:
+        shutil.rmtree(work_dir, ignore_errors=True)
+    return 1 if differ else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
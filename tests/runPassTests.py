@@ -0,0 +1,116 @@
+#! /usr/bin/env python
+"""
+Runs the small input files that check the passes driven by range analysis.
+
+Every test is an .ll file in a directory of tests/ named after its pass. Its
+"; RUN:" lines are shell commands, usually opt piped into FileCheck, which
+checks the output against the "; CHECK" lines of the same file. Each file
+has a case that the pass must transform and one it must leave as it is.
+
+The RUN lines may use:
+    %s          the test file
+    %t          a temporary file name, unique to the test
+    %opt        opt, with RangeAnalysis.so loaded
+    %lib        the directory of the libraries of the passes
+    %FileCheck  FileCheck
+
+Example:
+
+    ./runPassTests.py --lib-dir ~/llvm/Release/lib
+    ./runPassTests.py --lib-dir ~/llvm/Release/lib BoundsCheckElimination
+"""
+
+from __future__ import print_function
+
+import glob
+import optparse
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def run_lines(path):
+    """The commands of the RUN lines of path, with continuations joined."""
+    commands = []
+    current = ""
+    with open(path) as f:
+        for line in f:
+            pos = line.find("RUN:")
+            if not line.lstrip().startswith(";") or pos < 0:
+                continue
+            text = line[pos + len("RUN:"):].strip()
+            if text.endswith("\\"):
+                current += text[:-1] + " "
+                continue
+            commands.append(current + text)
+            current = ""
+    return commands
+
+
+def run_test(opts, path, work_dir):
+    commands = run_lines(path)
+    if not commands:
+        return "NORUN", ""
+
+    name = os.path.splitext(os.path.basename(path))[0]
+    subst = [
+        ("%FileCheck", opts.filecheck),
+        ("%opt", "%s -load %s" % (opts.opt,
+                                  os.path.join(opts.lib_dir,
+                                               "RangeAnalysis.so"))),
+        ("%lib", opts.lib_dir),
+        ("%s", path),
+        ("%t", os.path.join(work_dir, name + ".tmp")),
+    ]
+
+    for command in commands:
+        for key, value in subst:
+            command = command.replace(key, value)
+        proc = subprocess.Popen(["/bin/sh", "-c", command],
+                                stdout=subprocess.PIPE,
+                                stderr=subprocess.STDOUT, cwd=work_dir)
+        out = proc.communicate()[0]
+        if proc.returncode != 0:
+            return "FAIL", command + "\n" + out.decode("utf-8", "replace")
+
+    return "PASS", ""
+
+
+def main(argv):
+    parser = optparse.OptionParser(usage="%prog [options] [pass-dir...]")
+    parser.add_option("--opt", default="opt", help="opt binary to run")
+    parser.add_option("--filecheck", default="FileCheck",
+                      help="FileCheck binary to run")
+    parser.add_option("--lib-dir", default=".",
+                      help="directory with RangeAnalysis.so and the passes")
+    opts, dirs = parser.parse_args(argv)
+    opts.lib_dir = os.path.abspath(os.path.expanduser(opts.lib_dir))
+
+    if dirs:
+        tests = []
+        for d in dirs:
+            tests += sorted(glob.glob(os.path.join(TESTS_DIR, d, "*.ll")))
+    else:
+        tests = sorted(glob.glob(os.path.join(TESTS_DIR, "*", "*.ll")))
+
+    work_dir = tempfile.mkdtemp(prefix="pass-tests-")
+    failed = 0
+    for path in tests:
+        status, log = run_test(opts, path, work_dir)
+        print("%s: %s" % (status, os.path.relpath(path, TESTS_DIR)))
+        if status != "PASS":
+            failed += 1
+            if log:
+                print(log)
+
+    shutil.rmtree(work_dir, ignore_errors=True)
+    print("%d tests, %d failed" % (len(tests), failed))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))